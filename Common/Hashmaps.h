@@ -61,8 +61,12 @@ class DenseHashMap {
 	// Returns false if we already had the key! Which is a bit different.
 	bool Insert(const Key &key, Value value) {
 		// Check load factor, resize if necessary. We never shrink.
+		// Removed buckets count too, or a map with steady erase/insert churn
+		// runs out of FREE buckets and Get() on a missing key never ends.
 		if (count_ > capacity_ / 2) {
 			Grow(2);
+		} else if (count_ + removedCount_ > capacity_ / 2) {
+			Grow(1);
 		}
 		uint32_t mask = capacity_ - 1;
 		uint32_t pos = HashKey(key) & mask;
@@ -212,8 +216,12 @@ class PrehashMap {
 	// Returns false if we already had the key! Which is a bit different.
 	bool Insert(uint32_t hash, Value value) {
 		// Check load factor, resize if necessary. We never shrink.
+		// Removed buckets count too, or a map with steady erase/insert churn
+		// runs out of FREE buckets and Get() on a missing key never ends.
 		if (count_ > capacity_ / 2) {
 			Grow(2);
+		} else if (count_ + removedCount_ > capacity_ / 2) {
+			Grow(1);
 		}
 		uint32_t mask = capacity_ - 1;
 		uint32_t pos = hash & mask;
@@ -4,12 +4,22 @@
 
 std::shared_ptr<ThreadPool> GlobalThreadPool::pool;
 bool  GlobalThreadPool::initialized = false;
+std::shared_ptr<WorkStealingPool> GlobalThreadPool::tilePool;
+std::once_flag GlobalThreadPool::tilePoolOnce;
 
 void GlobalThreadPool::Loop(const std::function<void(int,int)>& loop, int lower, int upper) {
 	Inititialize();
 	pool->ParallelLoop(loop, lower, upper);
 }
 
+void GlobalThreadPool::TiledLoop(const std::function<void(int,int)>& loop, int lower, int upper, int tileSize, bool highPriority) {
+	// This one may be called from several threads at once.
+	std::call_once(tilePoolOnce, [] {
+		tilePool = std::make_shared<WorkStealingPool>(g_Config.iNumWorkerThreads);
+	});
+	tilePool->TiledLoop(loop, lower, upper, tileSize, highPriority);
+}
+
 void GlobalThreadPool::Inititialize() {
 	if(!initialized) {
 		pool = std::make_shared<ThreadPool>(g_Config.iNumWorkerThreads);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "thread/threadpool.h"
 
 class GlobalThreadPool {
@@ -7,9 +9,14 @@ class GlobalThreadPool {
 	// will execute slices of "loop" from "lower" to "upper"
 	// in parallel on the global thread pool
 	static void Loop(const std::function<void(int,int)>& loop, int lower, int upper);
+	// like Loop, but split into tiles of tileSize iterations on a work stealing pool,
+	// so that loops from different threads don't wait on each other (each still blocks its caller)
+	static void TiledLoop(const std::function<void(int,int)>& loop, int lower, int upper, int tileSize, bool highPriority);
 
 private:
 	static std::shared_ptr<ThreadPool> pool;
+	static std::shared_ptr<WorkStealingPool> tilePool;
+	static std::once_flag tilePoolOnce;
 	static bool initialized;
 	static void Inititialize();
 };
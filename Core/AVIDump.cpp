@@ -8,9 +8,15 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <cstdint>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #ifdef USE_FFMPEG
 
@@ -23,6 +29,7 @@ extern "C" {
 
 #endif
 
+#include "thread/threadutil.h"
 #include "Common/FileUtil.h"
 #include "Common/MsgHandler.h"
 #include "Common/ColorConv.h"
@@ -47,12 +54,29 @@ extern "C" {
 
 static AVFormatContext* s_format_context = nullptr;
 static AVStream* s_stream = nullptr;
+static AVStream* s_audio_stream = nullptr;
 static AVFrame* s_src_frame = nullptr;
 static AVFrame* s_scaled_frame = nullptr;
 static SwsContext* s_sws_context = nullptr;
 
 #endif
 
+enum {
+	// Captured frames waiting to be encoded, at most.  Past this, frames are dropped.
+	MAX_QUEUED_FRAMES = 8,
+	// Audio is handed to the encoder thread in chunks of this many stereo frames.
+	AUDIO_CHUNK_FRAMES = 2048,
+	AUDIO_SAMPLE_RATE = 44100,
+};
+
+// Either a captured frame or a chunk of audio.
+struct EncodeJob {
+	bool isFrame;
+	GPUDebugBuffer frame;
+	s64 frameIndex;
+	std::vector<s16> audio;
+};
+
 static int s_bytes_per_pixel;
 static int s_width;
 static int s_height;
@@ -62,6 +86,30 @@ static int s_current_height;
 static int s_file_index = 0;
 static GPUDebugBuffer buf;
 
+// Owned by the emu thread.
+static bool s_running = false;
+static bool s_with_audio = false;
+static std::string s_base_filename;
+static s64 s_frames_captured;
+static int s_frames_dropped;
+static std::vector<s16> s_audio_chunk;
+
+static std::thread s_encode_thread;
+static std::mutex s_queue_lock;
+static std::condition_variable s_queue_cond;
+static std::deque<EncodeJob> s_queue;
+static std::vector<GPUDebugBuffer> s_free_buffers;
+static int s_buffer_count;
+static bool s_quit;
+
+// Owned by the encoder thread while it runs.
+static bool s_file_failed;
+// Frame index the current file started at (-1 until its first frame), since a resolution change
+// starts a new file.
+static s64 s_file_first_frame;
+static s64 s_next_frame_pts;
+static s64 s_audio_pts;
+
 static void InitAVCodec() {
 	static bool first_run = true;
 	if (first_run) {
@@ -74,25 +122,52 @@ static void InitAVCodec() {
 
 bool AVIDump::Start(int w, int h)
 {
+	if (s_running)
+		Stop();
+
 	s_width = w;
 	s_height = h;
 	s_current_width = w;
 	s_current_height = h;
+	s_file_index = 0;
+
+	// Use gameID_EmulatedTimestamp for filename
+	std::string discID = g_paramSFO.GetDiscID();
+	s_base_filename = StringFromFormat("%s%s_%s", GetSysDirectory(DIRECTORY_VIDEO).c_str(), discID.c_str(), KernelTimeNowFormatted().c_str());
+	s_with_audio = g_Config.bDumpAudio;
 
 	InitAVCodec();
 	bool success = CreateAVI();
-	if (!success)
+	if (!success) {
 		CloseFile();
-	return success;
+		return false;
+	}
+
+	s_frames_captured = 0;
+	s_frames_dropped = 0;
+	s_audio_chunk.clear();
+	s_file_failed = false;
+	s_file_first_frame = -1;
+	s_next_frame_pts = 0;
+#ifdef USE_FFMPEG
+	s_audio_pts = AV_NOPTS_VALUE;
+#endif
+
+	s_quit = false;
+	s_buffer_count = 0;
+	s_running = true;
+	s_encode_thread = std::thread(&AVIDump::EncodeThread);
+	return true;
 }
 
 bool AVIDump::CreateAVI() {
 #ifdef USE_FFMPEG
 	AVCodec* codec = nullptr;
 
-	// Use gameID_EmulatedTimestamp for filename
-	std::string discID = g_paramSFO.GetDiscID();
-	std::string video_file_name = StringFromFormat("%s%s_%s.avi", GetSysDirectory(DIRECTORY_VIDEO).c_str(), discID.c_str(), KernelTimeNowFormatted().c_str()).c_str();
+	std::string video_file_name = s_base_filename;
+	if (s_file_index != 0)
+		video_file_name += StringFromFormat("_%d", s_file_index);
+	video_file_name += ".avi";
 
 	s_format_context = avformat_alloc_context();
 	std::stringstream s_file_index_str;
@@ -129,6 +204,23 @@ bool AVIDump::CreateAVI() {
 		return false;
 	}
 
+	if (s_with_audio) {
+		// Same samples as the WAV dump, stored as is.
+		if (!(s_audio_stream = avformat_new_stream(s_format_context, nullptr)))
+			return false;
+		s_audio_stream->codec->codec_id = AV_CODEC_ID_PCM_S16LE;
+		s_audio_stream->codec->codec_type = AVMEDIA_TYPE_AUDIO;
+		s_audio_stream->codec->sample_fmt = AV_SAMPLE_FMT_S16;
+		s_audio_stream->codec->sample_rate = AUDIO_SAMPLE_RATE;
+		s_audio_stream->codec->channels = 2;
+		s_audio_stream->codec->channel_layout = AV_CH_LAYOUT_STEREO;
+		s_audio_stream->codec->block_align = 4;
+		s_audio_stream->codec->bit_rate = AUDIO_SAMPLE_RATE * 4 * 8;
+		s_audio_stream->codec->time_base.num = 1;
+		s_audio_stream->codec->time_base.den = AUDIO_SAMPLE_RATE;
+		s_audio_stream->time_base = s_audio_stream->codec->time_base;
+	}
+
 	s_src_frame = av_frame_alloc();
 	s_scaled_frame = av_frame_alloc();
 
@@ -169,30 +261,154 @@ static void PreparePacket(AVPacket* pkt) {
 
 void AVIDump::AddFrame()
 {
-	gpuDebug->GetCurrentFramebuffer(buf, GPU_DBG_FRAMEBUF_DISPLAY);
-	u32 w = buf.GetStride();
-	u32 h = buf.GetHeight();
+	if (!s_running)
+		return;
+
+	// Counted even if it can't be captured, to keep the timing.
+	const s64 frameIndex = s_frames_captured++;
+	// Grab the frame now, everything else happens on the encoder thread.
+	if (!gpuDebug->GetCurrentFramebuffer(buf, GPU_DBG_FRAMEBUF_DISPLAY) || !buf.GetData())
+		return;
+
+	EncodeJob job;
+	job.isFrame = true;
+	job.frameIndex = frameIndex;
+	{
+		std::lock_guard<std::mutex> guard(s_queue_lock);
+		if (!s_free_buffers.empty()) {
+			job.frame = std::move(s_free_buffers.back());
+			s_free_buffers.pop_back();
+		} else if (s_buffer_count < MAX_QUEUED_FRAMES) {
+			s_buffer_count++;
+		} else {
+			// The encoder is behind.  The gap shows up as a repeated frame, so the timing stays right.
+			s_frames_dropped++;
+			return;
+		}
+	}
+
+	// The buffer may point straight at emulated memory, so it has to be copied.
+	job.frame.Allocate(buf.GetStride(), buf.GetHeight(), buf.GetFormat(), buf.GetFlipped());
+	memcpy(job.frame.GetData(), buf.GetData(), buf.GetDataSize());
+
+	std::lock_guard<std::mutex> guard(s_queue_lock);
+	s_queue.push_back(std::move(job));
+	s_queue_cond.notify_one();
+}
+
+void AVIDump::AddAudio(const s16 *samples, int frames) {
+	if (!s_running || !s_with_audio)
+		return;
+
+	s_audio_chunk.insert(s_audio_chunk.end(), samples, samples + frames * 2);
+	if ((int)s_audio_chunk.size() < AUDIO_CHUNK_FRAMES * 2)
+		return;
+
+	EncodeJob job;
+	job.isFrame = false;
+	job.frameIndex = 0;
+	job.audio.swap(s_audio_chunk);
+
+	std::lock_guard<std::mutex> guard(s_queue_lock);
+	s_queue.push_back(std::move(job));
+	s_queue_cond.notify_one();
+}
+
+void AVIDump::EncodeThread() {
+	setCurrentThreadName("AVIDump");
+
+	std::unique_lock<std::mutex> guard(s_queue_lock);
+	while (true) {
+		s_queue_cond.wait(guard, [] { return s_quit || !s_queue.empty(); });
+		// Finish everything that was captured before stopping.
+		if (s_queue.empty())
+			break;
+
+		EncodeJob job = std::move(s_queue.front());
+		s_queue.pop_front();
+		guard.unlock();
+
+		if (job.isFrame)
+			EncodeFrame(job.frame, job.frameIndex);
+		else
+			EncodeAudio(job.audio.data(), (int)job.audio.size() / 2);
+
+		guard.lock();
+		if (job.isFrame)
+			s_free_buffers.push_back(std::move(job.frame));
+	}
+}
+
+void AVIDump::EncodeFrame(const GPUDebugBuffer &frame, s64 frameIndex)
+{
+	u32 w = frame.GetStride();
+	u32 h = frame.GetHeight();
 	CheckResolution(w, h);
-	u8 *flipbuffer = nullptr;
-	const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
+	if (s_file_failed)
+		return;
+	if (s_file_first_frame < 0)
+		s_file_first_frame = frameIndex;
 
 #ifdef USE_FFMPEG
+	// Hand the common formats straight to swscale, which has SIMD paths for them, rather than
+	// converting pixel by pixel to RGB24 first.
+	AVPixelFormat srcFormat = AV_PIX_FMT_NONE;
+	int bytesPerPixel = 0;
+	switch (frame.GetFormat()) {
+	case GPU_DBG_FORMAT_8888:
+		srcFormat = AV_PIX_FMT_RGBA;
+		bytesPerPixel = 4;
+		break;
+	case GPU_DBG_FORMAT_8888_BGRA:
+		srcFormat = AV_PIX_FMT_BGRA;
+		bytesPerPixel = 4;
+		break;
+	case GPU_DBG_FORMAT_888_RGB:
+		srcFormat = AV_PIX_FMT_RGB24;
+		bytesPerPixel = 3;
+		break;
+	default:
+		break;
+	}
 
-	s_src_frame->data[0] = const_cast<u8*>(buffer);
-	s_src_frame->linesize[0] = w * 3;
-	s_src_frame->format = AV_PIX_FMT_RGB24;
+	u8 *flipbuffer = nullptr;
+	if (srcFormat != AV_PIX_FMT_NONE) {
+		const u8 *buffer = frame.GetData();
+		int linesize = w * bytesPerPixel;
+		if (frame.GetFlipped()) {
+			// Read it bottom up.
+			buffer += (h - 1) * linesize;
+			linesize = -linesize;
+		}
+		s_src_frame->data[0] = const_cast<u8*>(buffer);
+		s_src_frame->linesize[0] = linesize;
+	} else {
+		const u8 *buffer = ConvertBufferToScreenshot(frame, false, flipbuffer, w, h);
+		if (!buffer) {
+			delete[] flipbuffer;
+			return;
+		}
+		srcFormat = AV_PIX_FMT_RGB24;
+		s_src_frame->data[0] = const_cast<u8*>(buffer);
+		s_src_frame->linesize[0] = w * 3;
+	}
+	s_src_frame->format = srcFormat;
 	s_src_frame->width = s_width;
 	s_src_frame->height = s_height;
 
-	// Convert image from BGR24 to desired pixel format, and scale to initial width and height
-	if ((s_sws_context = sws_getCachedContext(s_sws_context, w, h, AV_PIX_FMT_RGB24, s_width, s_height, s_stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr)))
+	// Convert image to desired pixel format, and scale to initial width and height
+	if ((s_sws_context = sws_getCachedContext(s_sws_context, w, h, srcFormat, s_width, s_height, s_stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr)))
 	{
 		sws_scale(s_sws_context, s_src_frame->data, s_src_frame->linesize, 0, h, s_scaled_frame->data, s_scaled_frame->linesize);
 	}
+	delete[] flipbuffer;
 
 	s_scaled_frame->format = s_stream->codec->pix_fmt;
 	s_scaled_frame->width = s_width;
 	s_scaled_frame->height = s_height;
+	// Dropped frames leave a gap, which the AVI muxer fills.
+	s_scaled_frame->pts = frameIndex - s_file_first_frame;
+	s_next_frame_pts = s_scaled_frame->pts + 1;
 
 	// Encode and write the image.
 	AVPacket pkt;
@@ -224,13 +440,66 @@ void AVIDump::AddFrame()
 	if (error)
 		ERROR_LOG(G3D, "Error while encoding video: %d", error);
 #endif
-	delete[] flipbuffer;
+}
+
+void AVIDump::EncodeAudio(const s16 *samples, int frames) {
+#ifdef USE_FFMPEG
+	if (s_file_failed || !s_audio_stream)
+		return;
+
+	const AVRational sampleTimeBase = { 1, AUDIO_SAMPLE_RATE };
+	if (s_audio_pts == (s64)AV_NOPTS_VALUE) {
+		// Line the first samples up with the video, audio dumping may start a bit later.
+		s_audio_pts = av_rescale_q(s_next_frame_pts, s_stream->codec->time_base, sampleTimeBase);
+	}
+
+	AVPacket pkt;
+	PreparePacket(&pkt);
+	pkt.data = (uint8_t *)samples;
+	pkt.size = frames * 2 * sizeof(s16);
+	pkt.pts = av_rescale_q(s_audio_pts, sampleTimeBase, s_audio_stream->time_base);
+	pkt.dts = pkt.pts;
+	pkt.duration = (int)av_rescale_q(frames, sampleTimeBase, s_audio_stream->time_base);
+	pkt.flags |= AV_PKT_FLAG_KEY;
+	pkt.stream_index = s_audio_stream->index;
+	// Not refcounted, so this copies the samples.
+	int error = av_interleaved_write_frame(s_format_context, &pkt);
+	if (error)
+		ERROR_LOG(G3D, "Error while writing audio: %d", error);
+	s_audio_pts += frames;
+#endif
 }
 
 void AVIDump::Stop() {
+	if (s_running) {
+		if (!s_audio_chunk.empty()) {
+			EncodeJob job;
+			job.isFrame = false;
+			job.frameIndex = 0;
+			job.audio.swap(s_audio_chunk);
+			std::lock_guard<std::mutex> guard(s_queue_lock);
+			s_queue.push_back(std::move(job));
+		}
+		{
+			std::lock_guard<std::mutex> guard(s_queue_lock);
+			s_quit = true;
+			s_queue_cond.notify_one();
+		}
+		s_encode_thread.join();
+		s_running = false;
+
+		std::lock_guard<std::mutex> guard(s_queue_lock);
+		s_free_buffers.clear();
+		s_buffer_count = 0;
+
+		if (s_frames_dropped != 0)
+			WARN_LOG(G3D, "Frame dump dropped %d of %lld frames, encoding couldn't keep up", s_frames_dropped, (long long)s_frames_captured);
+	}
+
 #ifdef USE_FFMPEG
 
-	av_write_trailer(s_format_context);
+	if (s_format_context && !s_file_failed)
+		av_write_trailer(s_format_context);
 	CloseFile();
 	s_file_index = 0;
 #endif
@@ -251,6 +520,8 @@ void AVIDump::CloseFile() {
 		}
 		av_freep(&s_stream);
 	}
+	if (s_audio_stream)
+		av_freep(&s_audio_stream);
 
 	av_frame_free(&s_src_frame);
 	av_frame_free(&s_scaled_frame);
@@ -276,12 +547,24 @@ void AVIDump::CheckResolution(int width, int height) {
 	// was dumped, then create a new file accordingly. However, is it possible for the width and height
 	// to have a value of zero. If this is the case, simply keep the last known resolution of the video
 	// for the added frame.
+	// This runs on the encoder thread, so it reopens the file directly rather than through Stop()/Start().
 	if ((width != s_current_width || height != s_current_height) && (width > 0 && height > 0))
 	{
-		int temp_file_index = s_file_index;
-		Stop();
-		s_file_index = temp_file_index + 1;
-		Start(width, height);
+		if (s_format_context && !s_file_failed)
+			av_write_trailer(s_format_context);
+		CloseFile();
+
+		// If nothing was written yet (usually the very first frame), just replace the file.
+		if (s_next_frame_pts != 0)
+			s_file_index++;
+		s_width = width;
+		s_height = height;
+		s_file_first_frame = -1;
+		s_next_frame_pts = 0;
+		s_audio_pts = AV_NOPTS_VALUE;
+		s_file_failed = !CreateAVI();
+		if (s_file_failed)
+			CloseFile();
 		s_current_width = width;
 		s_current_height = height;
 	}
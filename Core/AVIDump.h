@@ -7,16 +7,26 @@
 
 #include "Common/CommonTypes.h"
 
+struct GPUDebugBuffer;
+
+// Frames are captured on the emu thread into a small pool of buffers, and converted and encoded
+// on a separate thread.  If that falls too far behind, frames get dropped instead of slowing down
+// the game.
 class AVIDump
 {
 private:
 	static bool CreateAVI();
 	static void CloseFile();
 	static void CheckResolution(int width, int height);
+	static void EncodeFrame(const GPUDebugBuffer &frame, s64 frameIndex);
+	static void EncodeAudio(const s16 *samples, int frames);
+	static void EncodeThread();
 
 public:
 	static bool Start(int w, int h);
 	static void AddFrame();
+	// Stereo samples at 44100 Hz, muxed into the video if audio dumping was also on at Start().
+	static void AddAudio(const s16 *samples, int frames);
 	static void Stop();
 };
 #endif
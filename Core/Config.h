@@ -95,6 +95,9 @@ struct Config {
 	bool bPreloadFunctions;
 
 	bool bSeparateSASThread;
+	bool bParallelSasVoices;  // Render SAS voices on the worker threads.
+	bool bVideoDecodeAhead;  // Decode the next movie frame on a separate thread.
+	bool bAtracPCMCache;  // Keep decoded Atrac frames around for loops, and decode ahead on a thread.
 	bool bSeparateIOThread;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
@@ -158,8 +161,11 @@ struct Config {
 	int iWindowHeight;
 
 	bool bVertexCache;
+	bool bGeometryCache;  // GL only, on top of bVertexCache: keep decoded geometry on the GPU across frames.  Experimental.
+	bool bDisplayListCache;  // Run pre-decoded display list blocks, validated by hash.
 	bool bTextureBackoffCache;
 	bool bTextureSecondaryCache;
+	int iTexCacheBudgetMB;  // 0 = no hard limit, only age based decimation.
 	bool bVertexDecoderJit;
 	bool bFullScreen;
 	bool bFullScreenMulti;
@@ -173,6 +179,7 @@ struct Config {
 	int iTexScalingLevel; // 0 = auto, 1 = off, 2 = 2x, ..., 5 = 5x
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
+	bool bTexScalingAsync;  // Scale on a worker thread, showing the unscaled texture meanwhile.
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iForceMaxEmulatedFPS;
@@ -188,6 +195,7 @@ struct Config {
 	int iBloomHack; //0 = off, 1 = safe, 2 = balanced, 3 = aggressive
 	bool bTimerHack;
 	bool bBlockTransferGPU;
+	int iAsyncReadbackFrames; // 0 = off, otherwise frames a non-urgent framebuffer download may lag behind
 	bool bDisableSlowFramebufEffects;
 	bool bFragmentTestCache;
 	int iSplineBezierQuality; // 0 = low , 1 = Intermediate , 2 = High
@@ -202,6 +210,7 @@ struct Config {
 	int iAudioBackend;
 	int iGlobalVolume;
 	bool bExtraAudioBuffering;  // For bluetooth
+	bool bHighQualityResampler;  // Polyphase FIR instead of linear interpolation
 
 	// Audio Hack
 	bool bSoundSpeedHack;
@@ -0,0 +1,56 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+
+#include "base/timeutil.h"
+#include "Core/System.h"
+
+// Adds the time spent in its scope to a stats counter, only while coreCollectDebugStats is set.
+class DebugStatsTimer {
+public:
+	// Adds milliseconds, like the gpuStats timers.
+	explicit DebugStatsTimer(double *ms) : ms_(coreCollectDebugStats ? ms : nullptr) {
+		if (ms_)
+			start_ = real_time_now();
+	}
+	// Adds microseconds, for counters updated from more than one thread.
+	explicit DebugStatsTimer(std::atomic<int64_t> *us) : us_(coreCollectDebugStats ? us : nullptr) {
+		if (us_)
+			start_ = real_time_now();
+	}
+	~DebugStatsTimer() {
+		Stop();
+	}
+
+	// Stops counting early, for the parts of the scope that shouldn't be included.
+	void Stop() {
+		if (ms_)
+			*ms_ += (real_time_now() - start_) * 1000.0;
+		if (us_)
+			*us_ += (int64_t)((real_time_now() - start_) * 1000000.0);
+		ms_ = nullptr;
+		us_ = nullptr;
+	}
+
+private:
+	double *ms_ = nullptr;
+	std::atomic<int64_t> *us_ = nullptr;
+	double start_ = 0.0;
+};
@@ -29,11 +29,13 @@
 
 #include "Core/Config.h"
 #include "Core/CoreTiming.h"
+#include "Core/DebugStatsTimer.h"
 #include "Core/Host.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #ifndef MOBILE_DEVICE
+#include "Core/AVIDump.h"
 #include "Core/WaveFile.h"
 #include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/sceKernelTime.h"
@@ -48,6 +50,7 @@
 
 StereoResampler resampler;
 AudioDebugStats g_AudioDebugStats;
+AudioStageStats g_AudioStageStats;
 
 // Should be used to lock anything related to the outAudioQueue.
 // atomic locks are used on the lock. TODO: make this lock-free
@@ -76,6 +79,9 @@ static s16 *clampedMixBuffer;
 #ifndef MOBILE_DEVICE
 WaveFileWriter g_wave_writer;
 static bool m_logAudio;
+static WaveFileWriter renderWriter;
+static bool renderAudio;
+static u64 renderedFrames;
 #endif
 
 // High and low watermarks, basically.  For perfect emulation, the correct values are 0 and 1, respectively.
@@ -336,6 +342,7 @@ void __AudioUpdate(bool resetRecording) {
 	// Audio throttle doesn't really work on the PSP since the mixing intervals are so closely tied
 	// to the CPU. Much better to throttle the frame rate on frame display and just throw away audio
 	// if the buffer somehow gets full.
+	DebugStatsTimer timer(&g_AudioStageStats.usMix);
 	bool firstChannel = true;
 
 	for (u32 i = 0; i < PSP_AUDIO_CHANNEL_MAX + 1; i++)	{
@@ -381,6 +388,18 @@ void __AudioUpdate(bool resetRecording) {
 		// Nothing was written above, let's memset.
 		memset(mixBuffer, 0, hwBlockSize * 2 * sizeof(s32));
 	}
+	// Only the mixing, not writing it out below.
+	timer.Stop();
+
+#ifndef MOBILE_DEVICE
+	if (renderAudio) {
+		for (int i = 0; i < hwBlockSize * 2; i++) {
+			clampedMixBuffer[i] = clamp_s16(mixBuffer[i]);
+		}
+		renderWriter.AddStereoSamples(clampedMixBuffer, hwBlockSize);
+		renderedFrames += hwBlockSize;
+	}
+#endif
 
 	if (g_Config.bEnableSound) {
 		resampler.PushSamples(mixBuffer, hwBlockSize);
@@ -413,6 +432,8 @@ void __AudioUpdate(bool resetRecording) {
 					clampedMixBuffer[i] = clamp_s16(mixBuffer[i]);
 				}
 				g_wave_writer.AddStereoSamples(clampedMixBuffer, hwBlockSize);
+				// Also goes into the video, if one is being dumped.
+				AVIDump::AddAudio(clampedMixBuffer, hwBlockSize);
 			} else {
 				__StopLogAudio();
 			}
@@ -432,6 +453,13 @@ const AudioDebugStats *__AudioGetDebugStats() {
 	return &g_AudioDebugStats;
 }
 
+void __AudioResetStageStats() {
+	g_AudioStageStats.usSas = 0;
+	g_AudioStageStats.usAtrac = 0;
+	g_AudioStageStats.usMpeg = 0;
+	g_AudioStageStats.usMix = 0;
+}
+
 void __PushExternalAudio(const s32 *audio, int numSamples) {
 	if (audio) {
 		resampler.PushSamples(audio, numSamples);
@@ -460,6 +488,28 @@ void __StopLogAudio() {
 		WARN_LOG(SCEAUDIO, "Audio logging has already been stopped");
 	}
 }
+
+bool __AudioStartOfflineRender(const std::string &filename) {
+	if (renderAudio) {
+		WARN_LOG(SCEAUDIO, "Offline audio render has already been started");
+		return false;
+	}
+	// The mix is always at the hardware rate, whatever the output frequency.
+	if (!renderWriter.Start(filename, hwSampleRate))
+		return false;
+	renderWriter.SetSkipSilence(false);
+	renderAudio = true;
+	renderedFrames = 0;
+	return true;
+}
+
+u64 __AudioStopOfflineRender() {
+	if (renderAudio) {
+		renderAudio = false;
+		renderWriter.Stop();
+	}
+	return renderedFrames;
+}
 #endif
 
 void WAVDump::Reset() {
@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "sceAudio.h"
 
+// Buffer sizes are in stereo frames.
 struct AudioDebugStats {
 	int buffered;
 	int watermark;
@@ -27,8 +30,27 @@ struct AudioDebugStats {
 	int overrunCount;
 	int instantSampleRate;
 	int lastPushSize;
+	// Fill level seen by the audio callback since the previous query.
+	int minBuffered;
+	int maxBuffered;
+	int avgBuffered;
+};
+
+// CPU time spent producing sound, in microseconds.  Only collected while coreCollectDebugStats
+// is set, and unlike gpuStats it keeps adding up until reset.  SAS includes the ATRAC voices it
+// decodes, which are also counted under ATRAC.  Updated from the SAS thread too, so atomic.
+struct AudioStageStats {
+	std::atomic<int64_t> usSas;
+	std::atomic<int64_t> usAtrac;
+	std::atomic<int64_t> usMpeg;
+	std::atomic<int64_t> usMix;
 };
 
+// Use DebugStatsTimer to add to these.
+extern AudioStageStats g_AudioStageStats;
+
+void __AudioResetStageStats();
+
 // Easy interface for sceAudio to write to, to keep the complexity in check.
 
 void __AudioInit();
@@ -50,6 +72,13 @@ void __PushExternalAudio(const s32 *audio, int numSamples);  // Should not be us
 void __StartLogAudio(const std::string& filename);
 void __StopLogAudio();
 
+// Writes every block of the final mix to a WAV file as it's produced, at emulated time, whether
+// or not sound is enabled.  Unlike __StartLogAudio, nothing depends on host timing or the output
+// resampler, so the same run always gives the same file.  Returns false if the file can't be created.
+bool __AudioStartOfflineRender(const std::string &filename);
+// Returns the number of stereo frames written.
+u64 __AudioStopOfflineRender();
+
 class WAVDump
 {
 public:
@@ -24,7 +24,9 @@
 #include "Core/MemMapHelpers.h"
 #include "Core/Reporting.h"
 #include "Core/Config.h"
+#include "Core/DebugStatsTimer.h"
 #include "Core/Debugger/Breakpoints.h"
+#include "Core/HW/AtracCache.h"
 #include "Core/HW/MediaEngine.h"
 #include "Core/HW/BufferQueue.h"
 #include "Common/ChunkFile.h"
@@ -33,6 +35,7 @@
 #include "Core/HLE/sceUtility.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/HLE/sceAtrac.h"
+#include "Core/HLE/__sceAudio.h"
 
 // Notes about sceAtrac buffer management
 //
@@ -115,6 +118,8 @@ const u32 ATRAC3_MAX_SAMPLES = 0x400;
 const u32 ATRAC3PLUS_MAX_SAMPLES = 0x800;
 
 static const int atracDecodeDelay = 2300;
+// How many packets at a time the PCM cache decodes on its thread.
+static const int ATRAC_DECODE_AHEAD_PACKETS = 16;
 
 #ifdef USE_FFMPEG
 
@@ -438,6 +443,12 @@ struct Atrac {
 	SwrContext      *swrCtx_ = nullptr;
 	AVFrame         *frame_ = nullptr;
 	AVPacket        *packet_ = nullptr;
+
+	// With the PCM cache, frames are output from here rather than frame_.
+	std::vector<s16> cachedPCM_;
+	int cachedSamples_ = 0;
+	// File offset of the last packet the decoder saw, or -1 after a flush.
+	int lastDecodedPos_ = -1;
 #endif // USE_FFMPEG
 
 #ifdef USE_FFMPEG
@@ -470,6 +481,7 @@ struct Atrac {
 	void ForceSeekToSample(int sample) {
 #ifdef USE_FFMPEG
 		avcodec_flush_buffers(codecCtx_);
+		lastDecodedPos_ = -1;
 
 		// Discard any pending packet data.
 		packet_->size = 0;
@@ -493,25 +505,17 @@ struct Atrac {
 		int seekFrame = sample + offsetSamples - unalignedSamples;
 
 		if ((sample != currentSample_ || sample == 0) && codecCtx_ != nullptr) {
-			// Prefill the decode buffer with packets before the first sample offset.
-			avcodec_flush_buffers(codecCtx_);
-
-			int adjust = 0;
-			if (sample == 0) {
-				int offsetSamples = firstSampleOffset_ + FirstOffsetExtra();
-				adjust = -(int)(offsetSamples % SamplesPerFrame());
-			}
-			const u32 off = FileOffsetBySample(sample + adjust);
-			const u32 backfill = bytesPerFrame_ * 2;
-			const u32 start = off - dataOff_ < backfill ? dataOff_ : off - backfill;
-			for (u32 pos = start; pos < off; pos += bytesPerFrame_) {
-				av_init_packet(packet_);
-				packet_->data = BufferStart() + pos;
-				packet_->size = bytesPerFrame_;
-				packet_->pos = pos;
-
-				// Process the packet, we don't care about success.
-				DecodePacket();
+			if (UsePCMCache()) {
+				// The next frame might be cached, so only prime the decoder once it's needed.
+				avcodec_flush_buffers(codecCtx_);
+				lastDecodedPos_ = -1;
+			} else {
+				int adjust = 0;
+				if (sample == 0) {
+					int offsetSamples = firstSampleOffset_ + FirstOffsetExtra();
+					adjust = -(int)(offsetSamples % SamplesPerFrame());
+				}
+				PrimeDecoder(FileOffsetBySample(sample + adjust));
 			}
 		}
 #endif // USE_FFMPEG
@@ -519,6 +523,30 @@ struct Atrac {
 		currentSample_ = sample;
 	}
 
+#ifdef USE_FFMPEG
+	// Prefills the decode buffer with the packets before off, so the decoder is ready for the one at off.
+	void PrimeDecoder(u32 off) {
+		avcodec_flush_buffers(codecCtx_);
+		lastDecodedPos_ = -1;
+
+		const u32 backfill = bytesPerFrame_ * 2;
+		const u32 start = off - dataOff_ < backfill ? dataOff_ : off - backfill;
+		for (u32 pos = start; pos < off; pos += bytesPerFrame_) {
+			av_init_packet(packet_);
+			packet_->data = BufferStart() + pos;
+			packet_->size = bytesPerFrame_;
+			packet_->pos = pos;
+
+			// Process the packet, we don't care about success.
+			DecodePacket();
+		}
+	}
+#endif // USE_FFMPEG
+
+	bool UsePCMCache() const {
+		return g_Config.bAtracPCMCache && bufferState_ != ATRAC_STATUS_LOW_LEVEL;
+	}
+
 	bool FillPacket(int adjust = 0) {
 		u32 off = FileOffsetBySample(currentSample_ + adjust);
 		if (off < first_.size) {
@@ -555,6 +583,7 @@ struct Atrac {
 		}
 
 		int got_frame = 0;
+		lastDecodedPos_ = (int)packet_->pos;
 		int bytes_read = avcodec_decode_audio4(codecCtx_, frame_, &got_frame, packet_);
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
 		av_packet_unref(packet_);
@@ -578,6 +607,81 @@ struct Atrac {
 #endif // USE_FFMPEG
 	}
 
+	// Like DecodePacket() for the packet FillPacket() set up, but through the PCM cache.  When it gets
+	// a frame, it's always in cachedPCM_.
+	AtracDecodeResult DecodeCachedPacket() {
+#ifdef USE_FFMPEG
+		if (codecCtx_ == nullptr || swrCtx_ == nullptr) {
+			return ATDECODE_FAILED;
+		}
+
+		u8 *data = packet_->data;
+		const int size = packet_->size;
+		const u32 off = (u32)packet_->pos;
+		const AtracCache::CodecParams params = CacheParams();
+		// Same two packets PrimeDecoder() backfills, so the key covers everything the output depends on.
+		const u8 *prev = off >= (u32)dataOff_ + bytesPerFrame_ ? data - bytesPerFrame_ : nullptr;
+		const u8 *prev2 = off >= (u32)dataOff_ + 2 * bytesPerFrame_ ? data - 2 * bytesPerFrame_ : nullptr;
+		const u64 key = AtracCache::PacketKey(params, prev2, prev, data, size);
+		if (AtracCache::Lookup(key, &cachedPCM_)) {
+			cachedSamples_ = (int)cachedPCM_.size() / outputChannels_;
+			packet_->size = 0;
+			return ATDECODE_GOTFRAME;
+		}
+
+		if (lastDecodedPos_ < 0 || (u32)lastDecodedPos_ + bytesPerFrame_ != off) {
+			// The frames before this one came from the cache, so the decoder has catching up to do.
+			PrimeDecoder(off);
+			av_init_packet(packet_);
+			packet_->data = data;
+			packet_->size = size;
+			packet_->pos = off;
+		}
+
+		AtracDecodeResult res = DecodePacket();
+		if (res == ATDECODE_GOTFRAME) {
+			cachedSamples_ = frame_->nb_samples;
+			cachedPCM_.resize(cachedSamples_ * outputChannels_);
+			u8 *out = (u8 *)&cachedPCM_[0];
+			int avret = swr_convert(swrCtx_, &out, cachedSamples_, (const u8 **)frame_->extended_data, cachedSamples_);
+			if (avret < 0) {
+				ERROR_LOG(ME, "swr_convert: Error while converting %d", avret);
+				return res;
+			}
+			AtracCache::Insert(key, &cachedPCM_[0], cachedSamples_, outputChannels_);
+			QueueDecodeAhead(off);
+		}
+		return res;
+#else
+		return ATDECODE_BADFRAME;
+#endif // USE_FFMPEG
+	}
+
+#ifdef USE_FFMPEG
+
+	// Has the worker decode the packets after off that are already loaded.  It starts one packet
+	// before off, so the first new packet gets the same two packets of warm up as PrimeDecoder().
+	void QueueDecodeAhead(u32 off) {
+		const u32 start = off >= (u32)dataOff_ + bytesPerFrame_ ? off - bytesPerFrame_ : off;
+		const int primeCount = (off - start) / bytesPerFrame_ + 1;
+		const u32 loaded = std::min(first_.size, first_.filesize);
+		int count = primeCount + ATRAC_DECODE_AHEAD_PACKETS;
+		if (start + count * bytesPerFrame_ > loaded)
+			count = (loaded - start) / bytesPerFrame_;
+		AtracCache::DecodeAhead(CacheParams(), BufferStart() + start, count, primeCount);
+	}
+
+	AtracCache::CodecParams CacheParams() const {
+		AtracCache::CodecParams params;
+		params.codecType = codecType_;
+		params.channels = channels_;
+		params.outputChannels = outputChannels_;
+		params.bytesPerFrame = bytesPerFrame_;
+		params.jointStereo = jointStereo_;
+		return params;
+	}
+#endif // USE_FFMPEG
+
 	void CalculateStreamInfo(u32 *readOffset);
 
 	u32 StreamBufferEnd() const {
@@ -664,6 +768,7 @@ void __AtracShutdown() {
 		delete atracIDs[i];
 		atracIDs[i] = NULL;
 	}
+	AtracCache::Shutdown();
 }
 
 static Atrac *getAtrac(int atracID) {
@@ -1138,6 +1243,7 @@ static u32 sceAtracAddStreamData(int atracID, u32 bytesToAdd) {
 }
 
 u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u32 *finish, int *remains) {
+	DebugStatsTimer timer(&g_AudioStageStats.usAtrac);
 	Atrac *atrac = getAtrac(atracID);
 
 	u32 ret = 0;
@@ -1181,9 +1287,10 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 			if (!atrac->failedDecode_ && (atrac->codecType_ == PSP_MODE_AT_3 || atrac->codecType_ == PSP_MODE_AT_3_PLUS)) {
 				atrac->SeekToSample(atrac->currentSample_);
 
+				const bool useCache = atrac->UsePCMCache();
 				AtracDecodeResult res = ATDECODE_FEEDME;
 				while (atrac->FillPacket(-skipSamples)) {
-					res = atrac->DecodePacket();
+					res = useCache ? atrac->DecodeCachedPacket() : atrac->DecodePacket();
 					if (res == ATDECODE_FAILED) {
 						*SamplesNum = 0;
 						*finish = 1;
@@ -1193,9 +1300,10 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 					if (res == ATDECODE_GOTFRAME) {
 #ifdef USE_FFMPEG
 						// got a frame
-						int skipped = std::min(skipSamples, atrac->frame_->nb_samples);
+						const int frameSamples = useCache ? atrac->cachedSamples_ : atrac->frame_->nb_samples;
+						int skipped = std::min(skipSamples, frameSamples);
 						skipSamples -= skipped;
-						numSamples = atrac->frame_->nb_samples - skipped;
+						numSamples = frameSamples - skipped;
 
 						// If we're at the end, clamp to samples we want.  It always returns a full chunk.
 						numSamples = std::min(maxSamples, numSamples);
@@ -1205,7 +1313,13 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 							res = ATDECODE_FEEDME;
 						}
 
-						if (outbuf != NULL && numSamples != 0) {
+						if (outbuf != NULL && numSamples != 0 && useCache) {
+							u32 outBytes = numSamples * atrac->outputChannels_ * sizeof(s16);
+							memcpy(outbuf, &atrac->cachedPCM_[skipped * atrac->outputChannels_], outBytes);
+							if (outbufPtr != 0) {
+								CBreakPoints::ExecMemCheck(outbufPtr, true, outBytes, currentMIPS->pc);
+							}
+						} else if (outbuf != NULL && numSamples != 0) {
 							int inbufOffset = 0;
 							if (skipped != 0) {
 								AVSampleFormat fmt = (AVSampleFormat)atrac->frame_->format;
@@ -1854,6 +1968,7 @@ int __AtracSetContext(Atrac *atrac) {
 #endif
 	// reinit decodePos, because ffmpeg had changed it.
 	atrac->decodePos_ = 0;
+	atrac->lastDecodedPos_ = -1;
 #endif
 
 	return 0;
@@ -2421,6 +2536,7 @@ static int sceAtracLowLevelDecode(int atracID, u32 sourceAddr, u32 sourceBytesCo
 	auto outp = PSPPointer<u8>::Create(samplesAddr);
 	auto outWritten = PSPPointer<u32>::Create(sampleBytesAddr);
 
+	DebugStatsTimer timer(&g_AudioStageStats.usAtrac);
 	Atrac *atrac = getAtrac(atracID);
 	if (!atrac) {
 		return hleLogError(ME, ATRAC_ERROR_BAD_ATRACID, "bad atrac ID");
@@ -34,6 +34,7 @@
 #include "Core/Reporting.h"
 #include "Core/SaveState.h"
 #include "Core/System.h"
+#include "Core/HW/SimpleAudioDec.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 
@@ -185,6 +186,8 @@ void __KernelShutdown()
 	__DisplayShutdown();
 	__AtracShutdown();
 	__AudioShutdown();
+	// After everything that might have released a decoder into the pool.
+	AudioClearDecoderPool();
 	__IoShutdown();
 	__KernelMutexShutdown();
 	__KernelThreadingShutdown();
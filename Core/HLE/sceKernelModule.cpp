@@ -517,6 +517,7 @@ void __KernelModuleDoState(PointerWrap &p)
 
 void __KernelModuleShutdown()
 {
+	GPURecord::CloseMountedReplay();
 	loadedModules.clear();
 	MIPSAnalyst::Reset();
 }
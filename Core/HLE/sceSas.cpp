@@ -38,6 +38,7 @@
 #include "Common/Log.h"
 #include "Core/Config.h"
 #include "Core/CoreTiming.h"
+#include "Core/DebugStatsTimer.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
@@ -46,6 +47,7 @@
 #include "Core/Reporting.h"
 
 #include "Core/HLE/sceSas.h"
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelThread.h"
 
@@ -107,6 +109,7 @@ int __SasThread() {
 	while (sasThreadState != SasThreadState::DISABLED) {
 		sasWake.wait(guard);
 		if (sasThreadState == SasThreadState::QUEUED) {
+			DebugStatsTimer timer(&g_AudioStageStats.usSas);
 			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol);
 
 			sasDoneMutex.lock();
@@ -127,6 +130,7 @@ static void __SasDrain() {
 static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0) {
 	if (sasThreadState == SasThreadState::DISABLED) {
 		// No thread, call it immediately.
+		DebugStatsTimer timer(&g_AudioStageStats.usSas);
 		sas->Mix(outAddr, inAddr, leftVol, rightVol);
 		return;
 	}
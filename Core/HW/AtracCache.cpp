@@ -0,0 +1,214 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ext/xxhash.h"
+#include "thread/threadutil.h"
+#include "Core/HW/AtracCache.h"
+#include "Core/HW/SimpleAudioDec.h"
+
+namespace AtracCache {
+
+enum {
+	// About six minutes of stereo music.
+	MAX_CACHED_BYTES = 64 * 1024 * 1024,
+	// Enough for one ATRAC3+ frame, even upmixed to stereo.
+	MAX_FRAME_SAMPLES = 0x800,
+};
+
+struct Entry {
+	std::vector<s16> pcm;
+	std::list<u64>::iterator lru;
+};
+
+struct Job {
+	CodecParams params;
+	std::vector<u8> data;
+	int count;
+	int primeCount;
+	// For the packets after primeCount.
+	std::vector<u64> keys;
+};
+
+static std::mutex cacheLock;
+static std::condition_variable cacheCond;
+static std::unordered_map<u64, Entry> entries;
+// Most recently used first.
+static std::list<u64> lruOrder;
+static size_t cachedBytes;
+// Keys queued or being decoded on the worker, once per job (jobs can overlap.)
+static std::unordered_multiset<u64> pendingKeys;
+
+static std::thread worker;
+static std::deque<Job> jobs;
+static bool workerQuit;
+
+u64 PacketKey(const CodecParams &params, const u8 *prev2, const u8 *prev, const u8 *packet, int size) {
+	// The parameters all change what comes out.
+	u64 seed = ((u64)params.codecType << 32) ^ ((u64)params.channels << 24) ^ ((u64)params.outputChannels << 16) ^ ((u64)params.jointStereo << 15) ^ (u64)params.bytesPerFrame;
+	u64 hash = XXH64(packet, size, seed);
+	if (prev)
+		hash = XXH64(prev, params.bytesPerFrame, hash);
+	if (prev2)
+		hash = XXH64(prev2, params.bytesPerFrame, hash);
+	return hash;
+}
+
+// Lock must be held.
+static void InsertLocked(u64 key, const s16 *pcm, size_t count) {
+	if (entries.find(key) != entries.end())
+		return;
+
+	lruOrder.push_front(key);
+	Entry &entry = entries[key];
+	entry.pcm.assign(pcm, pcm + count);
+	entry.lru = lruOrder.begin();
+	cachedBytes += count * sizeof(s16);
+
+	while (cachedBytes > MAX_CACHED_BYTES && lruOrder.size() > 1) {
+		auto oldest = entries.find(lruOrder.back());
+		cachedBytes -= oldest->second.pcm.size() * sizeof(s16);
+		entries.erase(oldest);
+		lruOrder.pop_back();
+	}
+}
+
+bool Lookup(u64 key, std::vector<s16> *pcm) {
+	std::unique_lock<std::mutex> guard(cacheLock);
+	// The result must not depend on how fast the worker is.
+	cacheCond.wait(guard, [&] { return pendingKeys.find(key) == pendingKeys.end(); });
+
+	auto it = entries.find(key);
+	if (it == entries.end())
+		return false;
+	lruOrder.splice(lruOrder.begin(), lruOrder, it->second.lru);
+	*pcm = it->second.pcm;
+	return true;
+}
+
+void Insert(u64 key, const s16 *pcm, int samples, int channels) {
+	std::lock_guard<std::mutex> guard(cacheLock);
+	InsertLocked(key, pcm, (size_t)samples * channels);
+}
+
+static void RunJob(const Job &job) {
+	const CodecParams &params = job.params;
+	SimpleAudio decoder(params.codecType, 44100, params.channels);
+	if (params.codecType == PSP_CODEC_AT3) {
+		// Same as the extradata sceAtrac sets up.
+		u8 extraData[14]{};
+		extraData[0] = 1;
+		extraData[3] = params.channels << 3;
+		extraData[6] = params.jointStereo;
+		extraData[8] = params.jointStereo;
+		extraData[10] = 1;
+		decoder.SetExtraData(extraData, sizeof(extraData), params.bytesPerFrame);
+	}
+
+	s16 pcm[MAX_FRAME_SAMPLES * 2];
+	for (int i = 0; i < job.count; ++i) {
+		int outBytes = 0;
+		u8 *packet = (u8 *)job.data.data() + i * params.bytesPerFrame;
+		if (!decoder.Decode(packet, params.bytesPerFrame, (u8 *)pcm, &outBytes))
+			break;
+		if (i >= job.primeCount && outBytes > 0)
+			Insert(job.keys[i - job.primeCount], pcm, outBytes / (2 * (int)sizeof(s16)), 2);
+	}
+}
+
+static void WorkerThread() {
+	setCurrentThreadName("AtracDecode");
+
+	std::unique_lock<std::mutex> guard(cacheLock);
+	while (true) {
+		cacheCond.wait(guard, [] { return workerQuit || !jobs.empty(); });
+		if (workerQuit)
+			break;
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		guard.unlock();
+		RunJob(job);
+		guard.lock();
+
+		// Even if it failed, so nothing waits forever.
+		for (u64 key : job.keys)
+			pendingKeys.erase(pendingKeys.find(key));
+		cacheCond.notify_all();
+	}
+}
+
+void DecodeAhead(const CodecParams &params, const u8 *data, int count, int primeCount) {
+	if (params.outputChannels != 2 || count <= primeCount || primeCount < 1)
+		return;
+
+	Job job;
+	job.params = params;
+	job.count = count;
+	job.primeCount = primeCount;
+
+	std::lock_guard<std::mutex> guard(cacheLock);
+	bool needed = false;
+	for (int i = primeCount; i < count; ++i) {
+		const u8 *packet = data + i * params.bytesPerFrame;
+		const u8 *prev2 = i >= 2 ? packet - 2 * params.bytesPerFrame : nullptr;
+		u64 key = PacketKey(params, prev2, packet - params.bytesPerFrame, packet, params.bytesPerFrame);
+		job.keys.push_back(key);
+		if (entries.find(key) == entries.end() && pendingKeys.find(key) == pendingKeys.end())
+			needed = true;
+	}
+	// Probably already playing from the cache.
+	if (!needed)
+		return;
+
+	for (u64 key : job.keys)
+		pendingKeys.insert(key);
+	job.data.assign(data, data + count * params.bytesPerFrame);
+	jobs.push_back(std::move(job));
+
+	if (!worker.joinable()) {
+		workerQuit = false;
+		worker = std::thread(&WorkerThread);
+	}
+	cacheCond.notify_all();
+}
+
+void Shutdown() {
+	{
+		std::lock_guard<std::mutex> guard(cacheLock);
+		workerQuit = true;
+		cacheCond.notify_all();
+	}
+	if (worker.joinable())
+		worker.join();
+
+	std::lock_guard<std::mutex> guard(cacheLock);
+	jobs.clear();
+	pendingKeys.clear();
+	entries.clear();
+	lruOrder.clear();
+	cachedBytes = 0;
+}
+
+}  // namespace AtracCache
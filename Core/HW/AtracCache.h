@@ -0,0 +1,54 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Decoded ATRAC3/ATRAC3+ frames, shared by every Atrac ID, so looping music (or the same sound on
+// several IDs) only gets decoded once.  Frames are keyed by the contents of the packet and the two
+// before it, the same packets the decoder is primed with when it starts mid-stream, so a cached frame
+// matches what a fresh decode would give.  Not save stated, it's only a cache.
+namespace AtracCache {
+
+struct CodecParams {
+	// PSP_CODEC_AT3 or PSP_CODEC_AT3PLUS.
+	int codecType;
+	int channels;
+	int outputChannels;
+	int bytesPerFrame;
+	int jointStereo;
+};
+
+// prev2 (two packets back) and prev may be null near the start of the data.
+u64 PacketKey(const CodecParams &params, const u8 *prev2, const u8 *prev, const u8 *packet, int size);
+
+// Copies out the frame as interleaved s16, outputChannels per sample.  If it's still being decoded on
+// the worker thread, waits for it.
+bool Lookup(u64 key, std::vector<s16> *pcm);
+void Insert(u64 key, const s16 *pcm, int samples, int channels);
+
+// Decodes count consecutive full packets on the worker thread, and caches all but the first
+// primeCount (which only set up the decoder's state.)  Only for stereo output.  The data is copied.
+void DecodeAhead(const CodecParams &params, const u8 *data, int count, int primeCount);
+
+// Stops the worker and frees everything.
+void Shutdown();
+
+}  // namespace AtracCache
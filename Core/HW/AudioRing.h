@@ -0,0 +1,82 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+
+// Ring of interleaved stereo s16 frames between exactly one producer thread (the emu thread) and
+// one consumer thread (the host audio callback.)  Neither side ever waits: each only writes its own
+// index, with release ordering, so the other side sees the samples before it sees the index move.
+// Indices count frames and run freely, wrapping at 2^32 (CAPACITY divides that evenly.)
+class AudioRing {
+public:
+	enum {
+		// In stereo frames, must be a power of two.
+		CAPACITY = 8192,
+		MASK = CAPACITY - 1,
+	};
+
+	AudioRing() {
+		memset(buffer_, 0, sizeof(buffer_));
+	}
+
+	// Frames ready to be read.  From the producer this may overstate, which is the safe direction.
+	u32 Buffered() const {
+		return writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_acquire);
+	}
+
+	// Producer.  Fill frames starting at WriteIndex() (Frame() handles the wrap), then Commit().
+	u32 WriteIndex() const {
+		return writeIndex_.load(std::memory_order_relaxed);
+	}
+	void Commit(u32 frames) {
+		writeIndex_.store(writeIndex_.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+	}
+
+	// Consumer.  Read frames starting at ReadIndex(), then Consume() them.
+	u32 ReadIndex() const {
+		return readIndex_.load(std::memory_order_relaxed);
+	}
+	void Consume(u32 frames) {
+		readIndex_.store(readIndex_.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+	}
+
+	s16 *Frame(u32 index) {
+		return &buffer_[(index & MASK) * 2];
+	}
+	const s16 *Frame(u32 index) const {
+		return &buffer_[(index & MASK) * 2];
+	}
+	// How many frames from index can be accessed through one pointer.
+	u32 ContiguousFrom(u32 index) const {
+		return CAPACITY - (index & MASK);
+	}
+
+	// Silences the contents without moving either index, so it's safe from either side.
+	void Silence() {
+		memset(buffer_, 0, sizeof(buffer_));
+	}
+
+private:
+	s16 buffer_[CAPACITY * 2];
+	std::atomic<u32> writeIndex_{ 0 };
+	std::atomic<u32> readIndex_{ 0 };
+};
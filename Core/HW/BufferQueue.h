@@ -108,17 +108,23 @@ struct BufferQueue {
 		return bytesgot;
 	}
 
-	int get_front(unsigned char *buf, int wantedsize) {
+	// Copies without removing anything, optionally skipping the first offset bytes.
+	int get_front(unsigned char *buf, int wantedsize, int offset = 0) {
 		if (wantedsize <= 0)
 			return 0;
-		int bytesgot = getQueueSize();
+		int bytesgot = getQueueSize() - offset;
+		if (bytesgot <= 0)
+			return 0;
 		if (wantedsize < bytesgot)
 			bytesgot = wantedsize;
-		if (start + bytesgot <= bufQueueSize) {
-			memcpy(buf, bufQueue + start, bytesgot);
+		int pos = start + offset;
+		if (pos >= bufQueueSize)
+			pos -= bufQueueSize;
+		if (pos + bytesgot <= bufQueueSize) {
+			memcpy(buf, bufQueue + pos, bytesgot);
 		} else {
-			int size = bufQueueSize - start;
-			memcpy(buf, bufQueue + start, size);
+			int size = bufQueueSize - pos;
+			memcpy(buf, bufQueue + pos, size);
 			memcpy(buf + size, bufQueue, bytesgot - size);
 		}
 		return bytesgot;
@@ -16,7 +16,9 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "Core/Config.h"
+#include "Core/DebugStatsTimer.h"
 #include "Core/Debugger/Breakpoints.h"
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HW/MediaEngine.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
@@ -25,8 +27,13 @@
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/GPUInterface.h"
 #include "Core/HW/SimpleAudioDec.h"
+#include "Core/HW/YUVConvert.h"
+#include "thread/threadutil.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #ifdef USE_FFMPEG
 
@@ -116,6 +123,48 @@ static int getPixelFormatBytes(int pspFormat)
 	}
 }
 
+#ifdef USE_FFMPEG
+// Most videos can skip swscale, and be converted straight into PSP memory by ConvertYUV420ToPSP().
+static bool CanConvertDirectly(const AVFrame *frame, int width, int height) {
+	return frame && frame->data[0] && frame->format == AV_PIX_FMT_YUV420P && frame->width == width && frame->height == height;
+}
+#endif
+
+#ifdef USE_FFMPEG
+// The next frame gets decoded on a separate thread right after the game takes the current one, from
+// the data that's already in the ringbuffer.  Nothing is popped from m_pdata until stepVideo() is
+// called for real, and when the decoder wants more data than has arrived, it waits for either more
+// data or that call.  This way every read returns exactly what it would have synchronously, so the
+// results (and everything the game can see) don't depend on thread timing.
+struct MediaEngine::DecodeAhead {
+	std::thread thread;
+	std::mutex lock;
+	std::condition_variable cond;
+
+	// Set by the emu thread.
+	bool start = false;
+	// stepVideo() was called, so reads can't wait for more data anymore.
+	bool caughtUp = false;
+	bool quit = false;
+	// A frame has been requested and not yet taken.
+	bool pending = false;
+	int pixelMode = GE_CMODE_32BIT_ABGR8888;
+
+	// Set by the decode thread.
+	bool done = false;
+	bool gotFrame = false;
+	bool hitEnd = false;
+	// Bytes read from m_pdata but not popped yet, and the size of the last read (for m_decodingsize.)
+	int consumed = 0;
+	int lastReadSize = 0;
+
+	AVFrame *frame = nullptr;
+	// Converted ahead as well, in the last used format.  rgbFormat is -1 if it wasn't.
+	u8 *rgbBuffer = nullptr;
+	int rgbFormat = -1;
+};
+#endif
+
 MediaEngine::MediaEngine(): m_pdata(0) {
 #ifdef USE_FFMPEG
 	m_pFormatCtx = 0;
@@ -126,7 +175,9 @@ MediaEngine::MediaEngine(): m_pdata(0) {
 	m_sws_ctx = 0;
 #endif
 	m_sws_fmt = 0;
+	m_deferredPixelMode = -1;
 	m_buffer = 0;
+	m_decodeAhead = nullptr;
 
 	m_videoStream = -1;
 	m_audioStream = -1;
@@ -172,6 +223,12 @@ void MediaEngine::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+#ifdef USE_FFMPEG
+	// The decode thread reads m_pdata, which is about to be replaced.
+	if (p.mode == p.MODE_READ)
+		stopDecodeAhead();
+#endif
+
 	p.Do(m_videoStream);
 	p.Do(m_audioStream);
 
@@ -228,16 +285,37 @@ void MediaEngine::DoState(PointerWrap &p) {
 
 static int MpegReadbuffer(void *opaque, uint8_t *buf, int buf_size) {
 	MediaEngine *mpeg = (MediaEngine *)opaque;
+	return mpeg->readStreamData(buf, buf_size);
+}
+
+int MediaEngine::readStreamData(u8 *buf, int buf_size) {
+#ifdef USE_FFMPEG
+	if (m_decodeAhead && std::this_thread::get_id() == m_decodeAhead->thread.get_id()) {
+		DecodeAhead *ahead = m_decodeAhead;
+		std::unique_lock<std::mutex> guard(ahead->lock);
+		// Only return short when a synchronous read at the time of stepVideo() would have.
+		ahead->cond.wait(guard, [&] {
+			return m_pdata->getQueueSize() - ahead->consumed >= buf_size || ahead->caughtUp || ahead->quit;
+		});
+		if (ahead->quit)
+			return 0;
+		int size = m_pdata->get_front(buf, buf_size, ahead->consumed);
+		ahead->consumed += size;
+		if (size > 0)
+			ahead->lastReadSize = size;
+		return size;
+	}
+#endif
 
 	int size = buf_size;
-	if (mpeg->m_mpegheaderReadPos < mpeg->m_mpegheaderSize) {
-		size = std::min(buf_size, mpeg->m_mpegheaderSize - mpeg->m_mpegheaderReadPos);
-		memcpy(buf, mpeg->m_mpegheader + mpeg->m_mpegheaderReadPos, size);
-		mpeg->m_mpegheaderReadPos += size;
+	if (m_mpegheaderReadPos < m_mpegheaderSize) {
+		size = std::min(buf_size, m_mpegheaderSize - m_mpegheaderReadPos);
+		memcpy(buf, m_mpegheader + m_mpegheaderReadPos, size);
+		m_mpegheaderReadPos += size;
 	} else {
-		size = mpeg->m_pdata->pop_front(buf, buf_size);
+		size = m_pdata->pop_front(buf, buf_size);
 		if (size > 0)
-			mpeg->m_decodingsize = size;
+			m_decodingsize = size;
 	}
 	return size;
 }
@@ -331,6 +409,18 @@ bool MediaEngine::openContext(bool keepReadPos) {
 	if (!setVideoStream(m_videoStream, true))
 		return false;
 
+	int videoStreams = 0;
+	for (int i = 0; i < (int)m_pFormatCtx->nb_streams; i++) {
+		if (m_pFormatCtx->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+			videoStreams++;
+	}
+	// With more than one, the game might switch streams while we're decoding ahead.
+	if (g_Config.bVideoDecodeAhead && videoStreams == 1) {
+		m_decodeAhead = new DecodeAhead();
+		m_decodeAhead->frame = av_frame_alloc();
+		m_decodeAhead->thread = std::thread(&MediaEngine::decodeAheadThread, this);
+	}
+
 	setVideoDim();
 	m_audioContext = new SimpleAudio(m_audioType, 44100, 2);
 	m_isVideoEnd = false;
@@ -341,6 +431,7 @@ bool MediaEngine::openContext(bool keepReadPos) {
 void MediaEngine::closeContext()
 {
 #ifdef USE_FFMPEG
+	stopDecodeAhead();
 	if (m_buffer)
 		av_free(m_buffer);
 	if (m_pFrameRGB)
@@ -361,6 +452,7 @@ void MediaEngine::closeContext()
 	m_pIOContext = 0;
 #endif
 	m_buffer = 0;
+	m_deferredPixelMode = -1;
 }
 
 bool MediaEngine::loadStream(const u8 *buffer, int readSize, int RingbufferSize)
@@ -388,6 +480,14 @@ bool MediaEngine::reloadStream()
 int MediaEngine::addStreamData(const u8 *buffer, int addSize) {
 	int size = addSize;
 	if (size > 0 && m_pdata) {
+#ifdef USE_FFMPEG
+		if (m_decodeAhead) {
+			std::lock_guard<std::mutex> guard(m_decodeAhead->lock);
+			if (!m_pdata->push(buffer, size))
+				size = 0;
+			m_decodeAhead->cond.notify_all();
+		} else
+#endif
 		if (!m_pdata->push(buffer, size)) 
 			size  = 0;
 		if (m_demux) {
@@ -473,6 +573,10 @@ bool MediaEngine::setVideoStream(int streamNum, bool force) {
 		AVDictionary *opt = nullptr;
 		// Allow ffmpeg to use any number of threads it wants.  Without this, it doesn't use threads.
 		av_dict_set(&opt, "threads", "0", 0);
+		// Frame threading gives the most parallelism for H.264, slices only help with sliced streams.
+		m_pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+		// m_pFrame may still be converted while the next frame decodes ahead, so it must own its buffers.
+		m_pCodecCtx->refcounted_frames = 1;
 		int openResult = avcodec_open2(m_pCodecCtx, pCodec, &opt);
 		av_dict_free(&opt);
 		if (openResult < 0) {
@@ -515,6 +619,7 @@ bool MediaEngine::setVideoDim(int width, int height)
 	sws_freeContext(m_sws_ctx);
 	m_sws_ctx = NULL;
 	m_sws_fmt = -1;
+	m_deferredPixelMode = -1;
 
 	if (m_desWidth == 0 || m_desHeight == 0) {
 		// Can't setup SWS yet, so stop for now.
@@ -531,6 +636,12 @@ bool MediaEngine::setVideoDim(int width, int height)
 	int numBytes = avpicture_get_size((AVPixelFormat)m_sws_fmt, m_desWidth, m_desHeight);
 #endif
 	m_buffer = (u8*)av_malloc(numBytes * sizeof(uint8_t));
+	if (m_decodeAhead) {
+		if (m_decodeAhead->rgbBuffer)
+			av_free(m_decodeAhead->rgbBuffer);
+		m_decodeAhead->rgbBuffer = (u8 *)av_malloc(numBytes * sizeof(uint8_t));
+		m_decodeAhead->rgbFormat = -1;
+	}
 
 	// Assign appropriate parts of buffer to image planes in m_pFrameRGB
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
@@ -579,22 +690,18 @@ void MediaEngine::updateSwsFormat(int videoPixelMode) {
 #endif
 }
 
-bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #ifdef USE_FFMPEG
-	auto codecIter = m_pCodecCtxs.find(m_videoStream);
-	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
-
-	if (!m_pFormatCtx)
-		return false;
-	if (!m_pCodecCtx)
-		return false;
-	if (!m_pFrame)
-		return false;
+// Reads and decodes until a frame comes out, or the data runs out (then hitEnd is set.)
+bool MediaEngine::decodeFrame(AVFrame *frame, bool *hitEnd) {
+	AVCodecContext *m_pCodecCtx = m_pCodecCtxs[m_videoStream];
 
 	AVPacket packet;
 	av_init_packet(&packet);
 	int frameFinished;
 	bool bGetFrame = false;
+	*hitEnd = false;
+	// Frames are refcounted, so let go of the last one before decoding into it.
+	av_frame_unref(frame);
 	while (!bGetFrame) {
 		bool dataEnd = av_read_frame(m_pFormatCtx, &packet) < 0;
 		// Even if we've read all frames, some may have been re-ordered frames at the end.
@@ -609,33 +716,12 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 				av_free_packet(&packet);
 #endif
 
-			int result = avcodec_decode_video2(m_pCodecCtx, m_pFrame, &frameFinished, &packet);
+			int result = avcodec_decode_video2(m_pCodecCtx, frame, &frameFinished, &packet);
 			if (frameFinished) {
-				if (!m_pFrameRGB) {
-					setVideoDim();
-				}
-				if (m_pFrameRGB && !skipFrame) {
-					updateSwsFormat(videoPixelMode);
-					// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
-					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
-					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
-
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
-				}
-
-				if (av_frame_get_best_effort_timestamp(m_pFrame) != AV_NOPTS_VALUE)
-					m_videopts = av_frame_get_best_effort_timestamp(m_pFrame) + av_frame_get_pkt_duration(m_pFrame) - m_firstTimeStamp;
-				else
-					m_videopts += av_frame_get_pkt_duration(m_pFrame);
 				bGetFrame = true;
 			}
 			if (result <= 0 && dataEnd) {
-				// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
-				// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
-				m_isVideoEnd = !bGetFrame && (m_pdata->getQueueSize() == 0);
-				if (m_isVideoEnd)
-					m_decodingsize = 0;
+				*hitEnd = true;
 				break;
 			}
 		}
@@ -646,6 +732,180 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #endif
 	}
 	return bGetFrame;
+}
+
+void MediaEngine::decodeAheadThread() {
+	setCurrentThreadName("MediaDecode");
+
+	DecodeAhead *ahead = m_decodeAhead;
+	std::unique_lock<std::mutex> guard(ahead->lock);
+	while (true) {
+		ahead->cond.wait(guard, [&] { return ahead->start || ahead->quit; });
+		if (ahead->quit)
+			break;
+		ahead->start = false;
+		const int pixelMode = ahead->pixelMode;
+		guard.unlock();
+
+		bool hitEnd = false;
+		bool gotFrame = decodeFrame(ahead->frame, &hitEnd);
+		// Convert too, guessing the game wants the same format as last time.
+		int rgbFormat = -1;
+		if (gotFrame && ahead->rgbBuffer && m_sws_ctx && m_sws_fmt == getSwsFormat(pixelMode) && !CanConvertDirectly(ahead->frame, m_desWidth, m_desHeight)) {
+			uint8_t *data[4] = { ahead->rgbBuffer };
+			int linesize[4] = { getPixelFormatBytes(pixelMode) * m_desWidth };
+			AVCodecContext *m_pCodecCtx = m_pCodecCtxs[m_videoStream];
+			sws_scale(m_sws_ctx, ahead->frame->data, ahead->frame->linesize, 0, m_pCodecCtx->height, data, linesize);
+			rgbFormat = m_sws_fmt;
+		}
+
+		guard.lock();
+		ahead->gotFrame = gotFrame;
+		ahead->hitEnd = hitEnd;
+		ahead->rgbFormat = rgbFormat;
+		ahead->done = true;
+		ahead->cond.notify_all();
+	}
+}
+
+void MediaEngine::startDecodeAhead(int videoPixelMode) {
+	DecodeAhead *ahead = m_decodeAhead;
+	// Still reading the header from m_mpegheader, not worth the trouble.
+	if (m_mpegheaderReadPos < m_mpegheaderSize)
+		return;
+
+	std::lock_guard<std::mutex> guard(ahead->lock);
+	ahead->pixelMode = videoPixelMode;
+	ahead->pending = true;
+	ahead->start = true;
+	ahead->cond.notify_all();
+}
+
+// Waits for the frame decoded ahead, and takes it as if it had just been decoded here.
+bool MediaEngine::finishDecodeAhead(bool *hitEnd, int *rgbFormat) {
+	DecodeAhead *ahead = m_decodeAhead;
+	std::unique_lock<std::mutex> guard(ahead->lock);
+	ahead->caughtUp = true;
+	ahead->cond.notify_all();
+	ahead->cond.wait(guard, [&] { return ahead->done; });
+
+	// Now the data has been read for real.
+	m_pdata->pop_front(nullptr, ahead->consumed);
+	if (ahead->lastReadSize > 0)
+		m_decodingsize = ahead->lastReadSize;
+	std::swap(m_pFrame, ahead->frame);
+
+	*hitEnd = ahead->hitEnd;
+	*rgbFormat = ahead->rgbFormat;
+	ahead->done = false;
+	ahead->caughtUp = false;
+	ahead->pending = false;
+	ahead->consumed = 0;
+	ahead->lastReadSize = 0;
+	return ahead->gotFrame;
+}
+
+void MediaEngine::stopDecodeAhead() {
+	DecodeAhead *ahead = m_decodeAhead;
+	if (!ahead)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(ahead->lock);
+		ahead->quit = true;
+		ahead->cond.notify_all();
+	}
+	ahead->thread.join();
+	// Whatever it read was never popped, so there's nothing to undo.
+	av_frame_free(&ahead->frame);
+	if (ahead->rgbBuffer)
+		av_free(ahead->rgbBuffer);
+	delete ahead;
+	m_decodeAhead = nullptr;
+}
+#endif
+
+// Fills m_pFrameRGB from a frame that was left for writeVideoImage(), for anything else that needs it.
+void MediaEngine::convertDeferredFrame() {
+#ifdef USE_FFMPEG
+	const int pixelMode = m_deferredPixelMode;
+	m_deferredPixelMode = -1;
+	if (pixelMode < 0 || !m_pFrameRGB || !CanConvertDirectly(m_pFrame, m_desWidth, m_desHeight))
+		return;
+
+	const int lineSize = getPixelFormatBytes(pixelMode) * m_desWidth;
+	const u8 *const planes[3] = { m_pFrame->data[0], m_pFrame->data[1], m_pFrame->data[2] };
+	ConvertYUV420ToPSP(m_pFrameRGB->data[0], lineSize, planes, m_pFrame->linesize, 0, 0, m_desWidth, m_desHeight, pixelMode);
+	m_pFrameRGB->linesize[0] = lineSize;
+#endif
+}
+
+bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
+#ifdef USE_FFMPEG
+	auto codecIter = m_pCodecCtxs.find(m_videoStream);
+	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+
+	if (!m_pFormatCtx)
+		return false;
+	if (!m_pCodecCtx)
+		return false;
+	if (!m_pFrame)
+		return false;
+
+	// The previous frame is about to be replaced, and a skipped frame won't replace the image.
+	if (skipFrame)
+		convertDeferredFrame();
+
+	bool hitEnd = false;
+	int aheadFormat = -1;
+	bool bGetFrame;
+	if (m_decodeAhead && m_decodeAhead->pending) {
+		bGetFrame = finishDecodeAhead(&hitEnd, &aheadFormat);
+	} else {
+		bGetFrame = decodeFrame(m_pFrame, &hitEnd);
+	}
+
+	if (bGetFrame) {
+		if (!m_pFrameRGB) {
+			setVideoDim();
+		}
+		if (m_pFrameRGB && !skipFrame && CanConvertDirectly(m_pFrame, m_desWidth, m_desHeight)) {
+			// Saves a pass over the frame, writeVideoImage() will convert it into the game's buffer.
+			m_deferredPixelMode = videoPixelMode;
+		} else if (m_pFrameRGB && !skipFrame) {
+			m_deferredPixelMode = -1;
+			updateSwsFormat(videoPixelMode);
+			// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
+			// Update the linesize for the new format too.  We started with the largest size, so it should fit.
+			m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+
+			if (aheadFormat == m_sws_fmt && m_pFrameRGB->data[0] == m_buffer) {
+				// Already converted on the decode thread, just swap it in.
+				std::swap(m_buffer, m_decodeAhead->rgbBuffer);
+				m_pFrameRGB->data[0] = m_buffer;
+			} else {
+				sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
+					m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+			}
+		}
+
+		if (av_frame_get_best_effort_timestamp(m_pFrame) != AV_NOPTS_VALUE)
+			m_videopts = av_frame_get_best_effort_timestamp(m_pFrame) + av_frame_get_pkt_duration(m_pFrame) - m_firstTimeStamp;
+		else
+			m_videopts += av_frame_get_pkt_duration(m_pFrame);
+	}
+	if (hitEnd) {
+		// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
+		// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
+		m_isVideoEnd = !bGetFrame && (m_pdata->getQueueSize() == 0);
+		if (m_isVideoEnd)
+			m_decodingsize = 0;
+	}
+
+	if (m_decodeAhead && bGetFrame && !hitEnd) {
+		startDecodeAhead(videoPixelMode);
+	}
+	return bGetFrame;
 #else
 	// If video engine is not available, just add to the timestamp at least.
 	m_videopts += 3003;
@@ -730,7 +990,11 @@ int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMo
 		imgbuf = new u8[videoImageSize];
 	}
 
-	switch (videoPixelMode) {
+	const bool direct = m_deferredPixelMode >= 0 && videoLineSize != 0 && CanConvertDirectly(m_pFrame, width, height);
+	if (direct) {
+		const u8 *const planes[3] = { m_pFrame->data[0], m_pFrame->data[1], m_pFrame->data[2] };
+		ConvertYUV420ToPSP(imgbuf, videoLineSize, planes, m_pFrame->linesize, 0, 0, width, height, videoPixelMode);
+	} else switch (videoPixelMode) {
 	case GE_CMODE_32BIT_ABGR8888:
 		for (int y = 0; y < height; y++) {
 			writeVideoLineRGBA(imgbuf + videoLineSize * y, data, width);
@@ -822,7 +1086,14 @@ int MediaEngine::writeVideoImageWithRange(u32 bufferPtr, int frameWidth, int vid
 	if (height > m_desHeight - ypos)
 		height = m_desHeight - ypos;
 
-	switch (videoPixelMode) {
+	const bool direct = m_deferredPixelMode >= 0 && videoLineSize != 0 && CanConvertDirectly(m_pFrame, m_desWidth, m_desHeight);
+	if (direct) {
+		const u8 *const planes[3] = { m_pFrame->data[0], m_pFrame->data[1], m_pFrame->data[2] };
+		ConvertYUV420ToPSP(imgbuf, videoLineSize, planes, m_pFrame->linesize, xpos, ypos, width, height, videoPixelMode);
+		for (int y = 0; y < height; y++) {
+			CBreakPoints::ExecMemCheck(bufferPtr + y * videoLineSize, true, width * getPixelFormatBytes(videoPixelMode), currentMIPS->pc);
+		}
+	} else switch (videoPixelMode) {
 	case GE_CMODE_32BIT_ABGR8888:
 		data += (ypos * m_desWidth + xpos) * sizeof(u32);
 		for (int y = 0; y < height; y++) {
@@ -888,6 +1159,7 @@ int MediaEngine::writeVideoImageWithRange(u32 bufferPtr, int frameWidth, int vid
 
 u8 *MediaEngine::getFrameImage() {
 #ifdef USE_FFMPEG
+	convertDeferredFrame();
 	return m_pFrameRGB->data[0];
 #else
 	return NULL;
@@ -926,6 +1198,7 @@ int MediaEngine::getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2)
 }
 
 int MediaEngine::getAudioSamples(u32 bufferPtr) {
+	DebugStatsTimer timer(&g_AudioStageStats.usMpeg);
 	if (!Memory::IsValidAddress(bufferPtr)) {
 		ERROR_LOG_REPORT(ME, "Ignoring bad audio decode address %08x during video playback", bufferPtr);
 	}
@@ -92,12 +92,28 @@ class MediaEngine
 
 	void DoState(PointerWrap &p);
 
+	// Called by FFmpeg through the IO context, on the decode thread when decoding ahead.
+	int readStreamData(u8 *buf, int size);
+
 private:
 	bool SetupStreams();
 	bool setVideoDim(int width = 0, int height = 0);
 	void updateSwsFormat(int videoPixelMode);
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2);
 
+#ifdef USE_FFMPEG
+	bool decodeFrame(AVFrame *frame, bool *hitEnd);
+	void startDecodeAhead(int videoPixelMode);
+	bool finishDecodeAhead(bool *hitEnd, int *rgbFormat);
+	void stopDecodeAhead();
+	void decodeAheadThread();
+#endif
+	void convertDeferredFrame();
+
+	// Decodes the next frame on another thread while the game runs, see MediaEngine.cpp.
+	struct DecodeAhead;
+	DecodeAhead *m_decodeAhead;
+
 public:  // TODO: Very little of this below should be public.
 
 	// Video ffmpeg context - not used for audio
@@ -111,6 +127,9 @@ class MediaEngine
 #endif
 
 	int m_sws_fmt;
+	// When >= 0, m_pFrame was not converted into m_pFrameRGB, writeVideoImage() converts it straight
+	// into PSP memory instead.  This is the pixel mode it was decoded for.
+	int m_deferredPixelMode;
 	u8 *m_buffer;
 	int m_videoStream;
 
@@ -17,9 +17,11 @@
 
 #include <algorithm>
 
+#include "ppsspp_config.h"
 #include "base/basictypes.h"
 #include "profiler/profiler.h"
 
+#include "Common/ThreadPools.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/HLE/sceAtrac.h"
 #include "Core/Config.h"
@@ -27,8 +29,20 @@
 #include "Core/Util/AudioFormat.h"
 #include "SasAudio.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // #define AUDIO_TO_FILE
 
+enum {
+	// Below this, handing the voices to other threads costs more than it saves.
+	SAS_PARALLEL_MIN_VOICES = 8,
+};
+
 static const u8 f[16][2] = {
 	{   0,   0 },
 	{  60,   0 },
@@ -474,7 +488,59 @@ bool SasVoice::HaveSamplesEnded() const {
 	}
 }
 
-void SasInstance::MixVoice(SasVoice &voice) {
+// Adds one voice's output to the interleaved stereo mix and send buffers.
+static void AccumulateVoice(int *mix, int *send, const s16 *samples, int start, int end, const SasVoice &voice) {
+	int i = start;
+#if defined(_M_SSE)
+	// Volumes are at most PSP_SAS_VOL_MAX, so 16x16 bit products are exact.
+	const __m128i vol = _mm_set_epi16(voice.volumeRight, voice.volumeLeft, voice.volumeRight, voice.volumeLeft, voice.volumeRight, voice.volumeLeft, voice.volumeRight, voice.volumeLeft);
+	const __m128i eff = _mm_set_epi16(voice.effectRight, voice.effectLeft, voice.effectRight, voice.effectLeft, voice.effectRight, voice.effectLeft, voice.effectRight, voice.effectLeft);
+	for (; i + 4 <= end; i += 4) {
+		__m128i s = _mm_loadl_epi64((const __m128i *)(samples + i));
+		// s0 s0 s1 s1 s2 s2 s3 s3, to line up with L R L R.
+		__m128i ss = _mm_unpacklo_epi16(s, s);
+
+		__m128i lo = _mm_mullo_epi16(ss, vol);
+		__m128i hi = _mm_mulhi_epi16(ss, vol);
+		__m128i *m = (__m128i *)(mix + i * 2);
+		_mm_storeu_si128(m, _mm_add_epi32(_mm_loadu_si128(m), _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 12)));
+		_mm_storeu_si128(m + 1, _mm_add_epi32(_mm_loadu_si128(m + 1), _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 12)));
+
+		lo = _mm_mullo_epi16(ss, eff);
+		hi = _mm_mulhi_epi16(ss, eff);
+		__m128i *e = (__m128i *)(send + i * 2);
+		_mm_storeu_si128(e, _mm_add_epi32(_mm_loadu_si128(e), _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 12)));
+		_mm_storeu_si128(e + 1, _mm_add_epi32(_mm_loadu_si128(e + 1), _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 12)));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const int16_t volData[4] = { (int16_t)voice.volumeLeft, (int16_t)voice.volumeRight, (int16_t)voice.volumeLeft, (int16_t)voice.volumeRight };
+	const int16_t effData[4] = { (int16_t)voice.effectLeft, (int16_t)voice.effectRight, (int16_t)voice.effectLeft, (int16_t)voice.effectRight };
+	const int16x4_t vol = vld1_s16(volData);
+	const int16x4_t eff = vld1_s16(effData);
+	for (; i + 4 <= end; i += 4) {
+		int16x4_t s = vld1_s16(samples + i);
+		int16x4x2_t ss = vzip_s16(s, s);
+		int32_t *m = mix + i * 2;
+		int32_t *e = send + i * 2;
+		vst1q_s32(m, vaddq_s32(vld1q_s32(m), vshrq_n_s32(vmull_s16(ss.val[0], vol), 12)));
+		vst1q_s32(m + 4, vaddq_s32(vld1q_s32(m + 4), vshrq_n_s32(vmull_s16(ss.val[1], vol), 12)));
+		vst1q_s32(e, vaddq_s32(vld1q_s32(e), vshrq_n_s32(vmull_s16(ss.val[0], eff), 12)));
+		vst1q_s32(e + 4, vaddq_s32(vld1q_s32(e + 4), vshrq_n_s32(vmull_s16(ss.val[1], eff), 12)));
+	}
+#endif
+	for (; i < end; i++) {
+		int sample = samples[i];
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		mix[i * 2] += (sample * voice.volumeLeft) >> 12;
+		mix[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
+		send[i * 2] += sample * voice.effectLeft >> 12;
+		send[i * 2 + 1] += sample * voice.effectRight >> 12;
+	}
+}
+
+int SasInstance::RenderVoice(SasVoice &voice, s16 *out, int16_t *mixTemp) {
 	switch (voice.type) {
 	case VOICETYPE_VAG:
 		if (voice.type == VOICETYPE_VAG && !voice.vagAddr)
@@ -500,22 +566,22 @@ void SasInstance::MixVoice(SasVoice &voice) {
 		// TODO: Special case no-resample case (and 2x and 0.5x) for speed, it's not uncommon
 
 		// Two passes: First read, then resample.
-		mixTemp_[0] = voice.resampleHist[0];
-		mixTemp_[1] = voice.resampleHist[1];
+		mixTemp[0] = voice.resampleHist[0];
+		mixTemp[1] = voice.resampleHist[1];
 
 		int voicePitch = voice.pitch;
 		u32 sampleFrac = voice.sampleFrac;
 		int samplesToRead = (sampleFrac + voicePitch * std::max(0, grainSize - delay)) >> PSP_SAS_PITCH_BASE_SHIFT;
-		if (samplesToRead > ARRAY_SIZE(mixTemp_) - 2) {
+		if (samplesToRead > MIX_TEMP_SIZE - 2) {
 			ERROR_LOG(SCESAS, "Too many samples to read (%d)! This shouldn't happen.", samplesToRead);
-			samplesToRead = ARRAY_SIZE(mixTemp_) - 2;
+			samplesToRead = MIX_TEMP_SIZE - 2;
 		}
 		int readPos = 2;
 		if (voice.envelope.NeedsKeyOn()) {
 			readPos = 0;
 			samplesToRead += 2;
 		}
-		voice.ReadSamples(&mixTemp_[readPos], samplesToRead);
+		voice.ReadSamples(&mixTemp[readPos], samplesToRead);
 		int tempPos = readPos + samplesToRead;
 
 		for (int i = 0; i < delay; ++i) {
@@ -526,7 +592,7 @@ void SasInstance::MixVoice(SasVoice &voice) {
 
 		const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
 		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+			const int16_t *s = mixTemp + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
 
 			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
 			int sample = s[0];
@@ -544,19 +610,12 @@ void SasInstance::MixVoice(SasVoice &voice) {
 
 			// We just scale by the envelope before we scale by volumes.
 			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
+			// This always fits in 16 bits unless the envelope height went negative.
+			out[i] = clamp_s16(((sample * envelopeValue) + (1 << 14)) >> 15);
 		}
 
-		voice.resampleHist[0] = mixTemp_[tempPos - 2];
-		voice.resampleHist[1] = mixTemp_[tempPos - 1];
+		voice.resampleHist[0] = mixTemp[tempPos - 2];
+		voice.resampleHist[1] = mixTemp[tempPos - 1];
 
 		voice.sampleFrac = sampleFrac - (tempPos - 2) * PSP_SAS_PITCH_BASE;
 
@@ -567,18 +626,54 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			voice.playing = false;
 			voice.on = false;
 		}
+		return delay;
 	}
+	return -1;
+}
+
+void SasInstance::MixVoice(SasVoice &voice) {
+	int start = RenderVoice(voice, voiceTemp_, mixTemp_);
+	if (start >= 0 && start < grainSize)
+		AccumulateVoice(mixBuffer, sendBuffer, voiceTemp_, start, grainSize, voice);
 }
 
 void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
+	SasVoice *active[PSP_SAS_VOICES_MAX];
 	int voicesPlayingCount = 0;
 
 	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
 		SasVoice &voice = voices[v];
 		if (!voice.playing || voice.paused)
 			continue;
-		voicesPlayingCount++;
-		MixVoice(voice);
+		active[voicesPlayingCount++] = &voice;
+	}
+
+	if (g_Config.bParallelSasVoices && g_Config.iNumWorkerThreads > 1 && voicesPlayingCount >= SAS_PARALLEL_MIN_VOICES) {
+		// Render each voice into its own buffer, in parallel, then add them up in order.
+		voiceSamples_.resize(PSP_SAS_VOICES_MAX * grainSize);
+		int starts[PSP_SAS_VOICES_MAX];
+
+		// Atrac voices go through sceAtrac, which isn't thread safe, so they stay on this thread.
+		for (int i = 0; i < voicesPlayingCount; i++) {
+			if (active[i]->type == VOICETYPE_ATRAC3)
+				starts[i] = RenderVoice(*active[i], &voiceSamples_[i * grainSize], mixTemp_);
+		}
+		GlobalThreadPool::TiledLoop([&](int lower, int upper) {
+			int16_t mixTemp[MIX_TEMP_SIZE];
+			for (int i = lower; i < upper; i++) {
+				if (active[i]->type != VOICETYPE_ATRAC3)
+					starts[i] = RenderVoice(*active[i], &voiceSamples_[i * grainSize], mixTemp);
+			}
+		}, 0, voicesPlayingCount, 4, true);
+
+		for (int i = 0; i < voicesPlayingCount; i++) {
+			if (starts[i] >= 0 && starts[i] < grainSize)
+				AccumulateVoice(mixBuffer, sendBuffer, &voiceSamples_[i * grainSize], starts[i], grainSize, *active[i]);
+		}
+	} else {
+		for (int i = 0; i < voicesPlayingCount; i++) {
+			MixVoice(*active[i]);
+		}
 	}
 
 	// Then mix the send buffer in with the rest.
@@ -610,6 +705,38 @@ void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
 #endif
 }
 
+// Writes clamp_s16(a[i] + b[i]) for count interleaved samples, b may be null.
+static void ClampMixToS16(s16 *outp, const int *a, const s16 *b, int count) {
+	int i = 0;
+#if defined(_M_SSE)
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(a + i + 4));
+		if (b) {
+			__m128i bs = _mm_loadu_si128((const __m128i *)(b + i));
+			// Sign extend by unpacking into the high halves and shifting back down.
+			lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(bs, bs), 16));
+			hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(bs, bs), 16));
+		}
+		_mm_storeu_si128((__m128i *)(outp + i), _mm_packs_epi32(lo, hi));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 8 <= count; i += 8) {
+		int32x4_t lo = vld1q_s32(a + i);
+		int32x4_t hi = vld1q_s32(a + i + 4);
+		if (b) {
+			int16x8_t bs = vld1q_s16(b + i);
+			lo = vaddw_s16(lo, vget_low_s16(bs));
+			hi = vaddw_s16(hi, vget_high_s16(bs));
+		}
+		vst1q_s16(outp + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+#endif
+	for (; i < count; i++) {
+		outp[i] = clamp_s16(b ? a[i] + b[i] : a[i]);
+	}
+}
+
 void SasInstance::WriteMixedOutput(s16 *outp, const s16 *inp, int leftVol, int rightVol) {
 	const bool dry = waveformEffect.isDryOn != 0;
 	const bool wet = waveformEffect.isWetOn != 0;
@@ -635,15 +762,9 @@ void SasInstance::WriteMixedOutput(s16 *outp, const s16 *inp, int leftVol, int r
 	} else {
 		// These are the optimal cases.
 		if (dry && wet) {
-			for (int i = 0; i < grainSize * 2; i += 2) {
-				*outp++ = clamp_s16(mixBuffer[i + 0] + sendBufferProcessed[i + 0]);
-				*outp++ = clamp_s16(mixBuffer[i + 1] + sendBufferProcessed[i + 1]);
-			}
+			ClampMixToS16(outp, mixBuffer, sendBufferProcessed, grainSize * 2);
 		} else if (dry) {
-			for (int i = 0; i < grainSize * 2; i += 2) {
-				*outp++ = clamp_s16(mixBuffer[i + 0]);
-				*outp++ = clamp_s16(mixBuffer[i + 1]);
-			}
+			ClampMixToS16(outp, mixBuffer, nullptr, grainSize * 2);
 		} else {
 			// This is another uncommon case, dry must be off but let's keep it for clarity.
 			for (int i = 0; i < grainSize * 2; i += 2) {
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/HW/BufferQueue.h"
 #include "Core/HW/SasReverb.h"
@@ -309,7 +311,19 @@ class SasInstance {
 	WaveformEffect waveformEffect;
 
 private:
+	enum {
+		MIX_TEMP_SIZE = PSP_SAS_MAX_GRAIN * 4 + 2 + 8,  // some extra margin for very high pitches.
+	};
+
+	// Decodes, resamples and applies the envelope for one grain, into out.  Returns the first sample
+	// written (after the keyon delay), or -1 if the voice had nothing to play.  Only touches the
+	// voice and the buffers passed in, so different voices can be rendered in parallel.
+	int RenderVoice(SasVoice &voice, s16 *out, int16_t *mixTemp);
+
 	SasReverb reverb_;
 	int grainSize;
-	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	int16_t mixTemp_[MIX_TEMP_SIZE];
+	s16 voiceTemp_[PSP_SAS_MAX_GRAIN];
+	// One grain per voice, when voices are rendered in parallel.
+	std::vector<s16> voiceSamples_;
 };
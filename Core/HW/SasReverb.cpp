@@ -15,13 +15,22 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 
+#include "ppsspp_config.h"
 #include "base/basictypes.h"
 #include "Core/HW/SasReverb.h"
 #include "Core/Util/AudioFormat.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // This is under the assumption that the reverb used in Sas is the same as the PSX SPU reverb.
 
 // Source: http://problemkaputt.de/psx-spx.htm#spureverbformula
@@ -152,8 +161,27 @@ static const SasReverbData presets[10] = {
 	},
 };
 
+enum ReverbTap {
+	TAP_LSAME, TAP_LSAME_IN, TAP_LSAME_PREV,
+	TAP_RSAME, TAP_RSAME_IN, TAP_RSAME_PREV,
+	TAP_LDIFF, TAP_LDIFF_IN, TAP_LDIFF_PREV,
+	TAP_RDIFF, TAP_RDIFF_IN, TAP_RDIFF_PREV,
+	TAP_LCOMB1, TAP_LCOMB2, TAP_LCOMB3, TAP_LCOMB4,
+	TAP_RCOMB1, TAP_RCOMB2, TAP_RCOMB3, TAP_RCOMB4,
+	TAP_LAPF1, TAP_LAPF1_IN, TAP_RAPF1, TAP_RAPF1_IN,
+	TAP_LAPF2, TAP_LAPF2_IN, TAP_RAPF2, TAP_RAPF2_IN,
+	TAP_COUNT,
+};
+
+enum {
+	// Samples processed at once (at 22khz.)  Limited further by the taps, see SetPreset().
+	REVERB_BLOCK = 256,
+};
+
 SasReverb::SasReverb() : preset_(-1), pos_(0) {
+	static_assert((int)TAP_COUNT <= (int)MAX_TAPS, "Not enough room for the reverb taps");
 	workspace_ = new int16_t[BUFSIZE];
+	memset(taps_, 0, sizeof(taps_));
 }
 
 SasReverb::~SasReverb() {
@@ -175,6 +203,165 @@ void SasReverb::SetPreset(int preset) {
 		memset(workspace_, 0, sizeof(int16_t) * BUFSIZE);
 	} else {
 		pos_ = 0;
+		return;
+	}
+
+	// Where each step reads and writes, relative to the current position.
+	const SasReverbData &d = presets[preset_];
+	const int taps[TAP_COUNT] = {
+		d.mLSAME, d.dLSAME, d.mLSAME - 1,
+		d.mRSAME, d.dRSAME, d.mRSAME - 1,
+		d.mLDIFF, d.dRDIFF, d.mLDIFF - 1,
+		d.mRDIFF, d.dLDIFF, d.mRDIFF - 1,
+		d.mLCOMB1, d.mLCOMB2, d.mLCOMB3, d.mLCOMB4,
+		d.mRCOMB1, d.mRCOMB2, d.mRCOMB3, d.mRCOMB4,
+		d.mLAPF1, d.mLAPF1 - d.dAPF1, d.mRAPF1, d.mRAPF1 - d.dAPF1,
+		d.mLAPF2, d.mLAPF2 - d.dAPF2, d.mRAPF2, d.mRAPF2 - d.dAPF2,
+	};
+	memcpy(taps_, taps, sizeof(taps));
+
+	// The comb filter only reads, so it can be computed for a whole block up front, as long as no
+	// sample in the block reads something written earlier in the same block.
+	const int16_t combCoefs[4] = { d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4 };
+	const int earlyWrites[] = { d.mLSAME, d.mRSAME, d.mLDIFF, d.mRDIFF };
+	const int lateWrites[] = { d.mLAPF1, d.mRAPF1, d.mLAPF2, d.mRAPF2 };
+	combAhead_ = REVERB_BLOCK;
+	for (int i = 0; i < 8; ++i) {
+		// Nothing it reads matters if the coefficient is zero.
+		if (combCoefs[i & 3] == 0)
+			continue;
+		const int c = taps[TAP_LCOMB1 + i];
+		for (int w : earlyWrites) {
+			if (w == c)
+				combAhead_ = 0;
+			else if (w > c)
+				combAhead_ = std::min(combAhead_, w - c);
+		}
+		// These are written after the comb filter reads in the same sample.
+		for (int w : lateWrites) {
+			if (w > c)
+				combAhead_ = std::min(combAhead_, w - c);
+		}
+	}
+}
+
+// Computes (c1 * b1 + c2 * b2 + c3 * b3 + c4 * b4) >> 15 for count consecutive samples.
+static void CombFilter(int32_t *out, int16_t *const *b, const SasReverbData &d, int count) {
+	int j = 0;
+#if defined(_M_SSE)
+	// Pairs of coefficients, to line up with interleaved pairs of taps for madd.
+	const __m128i c12 = _mm_set1_epi32((uint16_t)d.vCOMB1 | ((uint32_t)(uint16_t)d.vCOMB2 << 16));
+	const __m128i c34 = _mm_set1_epi32((uint16_t)d.vCOMB3 | ((uint32_t)(uint16_t)d.vCOMB4 << 16));
+	for (; j + 8 <= count; j += 8) {
+		const __m128i b1 = _mm_loadu_si128((const __m128i *)(b[0] + j));
+		const __m128i b2 = _mm_loadu_si128((const __m128i *)(b[1] + j));
+		const __m128i b3 = _mm_loadu_si128((const __m128i *)(b[2] + j));
+		const __m128i b4 = _mm_loadu_si128((const __m128i *)(b[3] + j));
+		__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b1, b2), c12), _mm_madd_epi16(_mm_unpacklo_epi16(b3, b4), c34));
+		__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b1, b2), c12), _mm_madd_epi16(_mm_unpackhi_epi16(b3, b4), c34));
+		_mm_storeu_si128((__m128i *)(out + j), _mm_srai_epi32(lo, 15));
+		_mm_storeu_si128((__m128i *)(out + j + 4), _mm_srai_epi32(hi, 15));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; j + 4 <= count; j += 4) {
+		int32x4_t sum = vmull_n_s16(vld1_s16(b[0] + j), d.vCOMB1);
+		sum = vmlal_n_s16(sum, vld1_s16(b[1] + j), d.vCOMB2);
+		sum = vmlal_n_s16(sum, vld1_s16(b[2] + j), d.vCOMB3);
+		sum = vmlal_n_s16(sum, vld1_s16(b[3] + j), d.vCOMB4);
+		vst1q_s32(out + j, vshrq_n_s32(sum, 15));
+	}
+#endif
+	for (; j < count; ++j) {
+		out[j] = (d.vCOMB1 * b[0][j] + d.vCOMB2 * b[1][j] + d.vCOMB3 * b[2][j] + d.vCOMB4 * b[3][j]) >> 15;
+	}
+}
+
+void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight) {
+	// This means replicate the input signal in the processed buffer.
+	// Can also be used to verify that the error is in here...
+	if (preset_ == -1) {
+		// Strangely, OFF is not filled with zeroes every other.  Seems special cased.
+		for (size_t i = 0; i < inputSize; ++i) {
+			output[i * 4 + 0] = clamp_s16((int)input[i * 2 + 0] * volLeft >> 15);
+			output[i * 4 + 1] = clamp_s16((int)input[i * 2 + 1] * volRight >> 15);
+			output[i * 4 + 2] = clamp_s16((int)input[i * 2 + 0] * volLeft >> 15);
+			output[i * 4 + 3] = clamp_s16((int)input[i * 2 + 1] * volRight >> 15);
+		}
+		return;
+	}
+
+	const SasReverbData &d = presets[preset_];
+	const int size = d.size;
+	const int base = BUFSIZE - size;
+	const bool combAhead = combAhead_ > 0;
+
+	int32_t combL[REVERB_BLOCK];
+	int32_t combR[REVERB_BLOCK];
+	int16_t *t[TAP_COUNT];
+
+	// This runs at 22khz.
+	// Same as ProcessReverbReference, but in blocks where none of the taps wrap around the buffer,
+	// so they can be plain pointers.
+	size_t i = 0;
+	while (i < inputSize) {
+		int count = (int)std::min(inputSize - i, (size_t)REVERB_BLOCK);
+		count = std::min(count, BUFSIZE - pos_);
+		for (int k = 0; k < TAP_COUNT; ++k) {
+			int offset = (pos_ - base + taps_[k]) % size;
+			if (offset < 0)
+				offset += size;
+			t[k] = workspace_ + base + offset;
+			count = std::min(count, size - offset);
+		}
+
+		if (combAhead) {
+			count = std::min(count, combAhead_);
+			CombFilter(combL, &t[TAP_LCOMB1], d, count);
+			CombFilter(combR, &t[TAP_RCOMB1], d, count);
+		}
+
+		for (int j = 0; j < count; ++j, ++i) {
+			// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
+			int16_t Lin = input[i * 2] >> 1;
+			int16_t Rin = input[i * 2 + 1] >> 1;
+
+			// ____Same Side Reflection(left - to - left and right - to - right)___________________
+			t[TAP_LSAME][j] = clamp_s16(Lin + (t[TAP_LSAME_IN][j] * d.vWALL >> 15) - (t[TAP_LSAME_PREV][j] * d.vIIR >> 15) + t[TAP_LSAME_PREV][j]);
+			t[TAP_RSAME][j] = clamp_s16(Rin + (t[TAP_RSAME_IN][j] * d.vWALL >> 15) - (t[TAP_RSAME_PREV][j] * d.vIIR >> 15) + t[TAP_RSAME_PREV][j]);
+			// ___Different Side Reflection(left - to - right and right - to - left)_______________
+			t[TAP_LDIFF][j] = clamp_s16(Lin + (t[TAP_LDIFF_IN][j] * d.vWALL >> 15) - (t[TAP_LDIFF_PREV][j] * d.vIIR >> 15) + t[TAP_LDIFF_PREV][j]);
+			t[TAP_RDIFF][j] = clamp_s16(Rin + (t[TAP_RDIFF_IN][j] * d.vWALL >> 15) - (t[TAP_RDIFF_PREV][j] * d.vIIR >> 15) + t[TAP_RDIFF_PREV][j]);
+			// ___Early Echo(Comb Filter, with input from buffer)__________________________
+			int32_t Lout;
+			int32_t Rout;
+			if (combAhead) {
+				Lout = combL[j];
+				Rout = combR[j];
+			} else {
+				Lout = (d.vCOMB1 * t[TAP_LCOMB1][j] + d.vCOMB2 * t[TAP_LCOMB2][j] + d.vCOMB3 * t[TAP_LCOMB3][j] + d.vCOMB4 * t[TAP_LCOMB4][j]) >> 15;
+				Rout = (d.vCOMB1 * t[TAP_RCOMB1][j] + d.vCOMB2 * t[TAP_RCOMB2][j] + d.vCOMB3 * t[TAP_RCOMB3][j] + d.vCOMB4 * t[TAP_RCOMB4][j]) >> 15;
+			}
+			// ___Late Reverb APF1(All Pass Filter 1, with input from COMB)________________
+			t[TAP_LAPF1][j] = clamp_s16(Lout - (d.vAPF1 * t[TAP_LAPF1_IN][j] >> 15));
+			Lout = t[TAP_LAPF1_IN][j] + (t[TAP_LAPF1][j] * d.vAPF1 >> 15);
+			t[TAP_RAPF1][j] = clamp_s16(Rout - (d.vAPF1 * t[TAP_RAPF1_IN][j] >> 15));
+			Rout = t[TAP_RAPF1_IN][j] + (t[TAP_RAPF1][j] * d.vAPF1 >> 15);
+			// ___Late Reverb APF2(All Pass Filter 2, with input from APF1)________________
+			t[TAP_LAPF2][j] = clamp_s16(Lout - (d.vAPF2 * t[TAP_LAPF2_IN][j] >> 15));
+			Lout = t[TAP_LAPF2_IN][j] + (t[TAP_LAPF2][j] * d.vAPF2 >> 15);
+			t[TAP_RAPF2][j] = clamp_s16(Rout - (d.vAPF2 * t[TAP_RAPF2_IN][j] >> 15));
+			Rout = t[TAP_RAPF2_IN][j] + (t[TAP_RAPF2][j] * d.vAPF2 >> 15);
+			// ___Output to Mixer(Output volume multiplied with input from APF2)___________
+			output[i * 4 + 0] = clamp_s16(Lout * volLeft >> 15);
+			output[i * 4 + 1] = clamp_s16(Rout * volRight >> 15);
+			output[i * 4 + 2] = 0;
+			output[i * 4 + 3] = 0;
+		}
+
+		pos_ += count;
+		if (pos_ >= BUFSIZE) {
+			pos_ -= size;
+		}
 	}
 }
 
@@ -206,7 +393,7 @@ class BufferWrapper {
 	int size_;
 };
 
-void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight) {
+void SasReverb::ProcessReverbReference(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight) {
 	// This means replicate the input signal in the processed buffer.
 	// Can also be used to verify that the error is in here...
 	if (preset_ == -1) {
@@ -226,8 +413,7 @@ void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inpu
 	BufferWrapper<BUFSIZE> b(workspace_, pos_, d.size);
 
 	// This runs at 22khz.
-	// Very unoptimized, straight from the description. Can probably be reformulated into something way more efficient.
-	// Or we could actually template the whole thing with the parameters as template arguments, as the presets are fixed.
+	// Very unoptimized, straight from the description.  Kept to check ProcessReverb against.
 	for (size_t i = 0; i < inputSize; i++) {
 		// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
 		int16_t LeftInput = input[i * 2] >> 1;
@@ -32,13 +32,20 @@ class SasReverb {
 	// Input should be a mixdown of all the channels that have reverb enabled, at 22khz.
 	// Output is written back at 44khz.
 	void ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight);
+	// Same output, one sample at a time straight from the formula.  For testing.
+	void ProcessReverbReference(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight);
 
 private:
 	enum {
 		BUFSIZE = 0x20000,
+		MAX_TAPS = 32,
 	};
 
 	int16_t *workspace_;
 	int preset_;
 	int pos_;
-};
\ No newline at end of file
+	// Offsets from pos_ that each step of the filter reads or writes, see ReverbTap.
+	int taps_[MAX_TAPS];
+	// How many samples of the comb filter can be computed ahead, 0 if it has to go sample by sample.
+	int combAhead_ = 0;
+};
@@ -16,6 +16,8 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <mutex>
+#include <vector>
 
 #include "Core/Config.h"
 #include "Core/HLE/FunctionWrappers.h"
@@ -33,6 +35,63 @@ extern "C" {
 
 #endif  // USE_FFMPEG
 
+#ifdef USE_FFMPEG
+
+enum {
+	MAX_POOLED_DECODERS = 8,
+};
+
+// An opened decoder left over from a deleted SimpleAudio.  Games that create and delete codec
+// handles all the time (sceAudiocodec, sceMp3) then don't pay for avcodec_open2() every time.
+struct PooledDecoder {
+	int audioType;
+	int sampleRate;
+	int channels;
+	AVCodec *codec;
+	AVCodecContext *codecCtx;
+	AVFrame *frame;
+	SwrContext *swrCtx;
+	SimpleAudio::SwrParams swrParams;
+};
+
+static std::mutex decoderPoolLock;
+// Most recently released last.
+static std::vector<PooledDecoder> decoderPool;
+
+// Only for codecs where avcodec_flush_buffers() resets all the state that matters, so a reused
+// decoder sounds the same as a new one.  FFmpeg's ATRAC decoders don't implement flush.
+static bool CanPoolDecoder(int audioType) {
+	return audioType == PSP_CODEC_MP3 || audioType == PSP_CODEC_AAC;
+}
+
+static void FreeDecoder(AVCodecContext *&codecCtx, AVFrame *&frame, SwrContext *&swrCtx) {
+	swr_free(&swrCtx);
+	av_frame_free(&frame);
+	if (!codecCtx)
+		return;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 52, 0)
+	avcodec_free_context(&codecCtx);
+#else
+	// Future versions may add other things to free, but avcodec_free_context didn't exist yet here.
+	avcodec_close(codecCtx);
+	av_freep(&codecCtx->extradata);
+	av_freep(&codecCtx->subtitle_header);
+	av_freep(&codecCtx);
+#endif
+}
+
+#endif  // USE_FFMPEG
+
+void AudioClearDecoderPool() {
+#ifdef USE_FFMPEG
+	std::lock_guard<std::mutex> guard(decoderPoolLock);
+	for (PooledDecoder &pooled : decoderPool) {
+		FreeDecoder(pooled.codecCtx, pooled.frame, pooled.swrCtx);
+	}
+	decoderPool.clear();
+#endif  // USE_FFMPEG
+}
+
 int SimpleAudio::GetAudioCodecID(int audioType) {
 #ifdef USE_FFMPEG
 	switch (audioType) {
@@ -55,7 +114,7 @@ int SimpleAudio::GetAudioCodecID(int audioType) {
 SimpleAudio::SimpleAudio(int audioType, int sample_rate, int channels)
 : ctxPtr(0xFFFFFFFF), audioType(audioType), sample_rate_(sample_rate), channels_(channels),
   outSamples(0), srcPos(0), wanted_resample_freq(44100), frame_(0), codec_(0), codecCtx_(0), swrCtx_(0),
-  codecOpen_(false) {
+  codecOpen_(false), canPool_(false) {
 	Init();
 }
 
@@ -65,8 +124,6 @@ void SimpleAudio::Init() {
 	av_register_all();
 	InitFFmpeg();
 
-	frame_ = av_frame_alloc();
-
 	// Get Audio Codec ctx
 	int audioCodecId = GetAudioCodecID(audioType);
 	if (!audioCodecId) {
@@ -95,6 +152,16 @@ void SimpleAudio::Init() {
 
 bool SimpleAudio::OpenCodec(int block_align) {
 #ifdef USE_FFMPEG
+	codecOpen_ = true;
+	if (CanPoolDecoder(audioType) && AcquirePooledDecoder()) {
+		canPool_ = true;
+		return true;
+	}
+
+	if (!frame_) {
+		frame_ = av_frame_alloc();
+	}
+
 	// Some versions of FFmpeg require this set.  May be set in SetExtraData(), but optional.
 	// When decoding, we decode by packet, so we know the size.
 	if (codecCtx_->block_align == 0) {
@@ -107,7 +174,7 @@ bool SimpleAudio::OpenCodec(int block_align) {
 		ERROR_LOG(ME, "Failed to open codec: retval = %i", retval);
 	}
 	av_dict_free(&opts);
-	codecOpen_ = true;
+	canPool_ = retval >= 0 && CanPoolDecoder(audioType);
 	return retval >= 0;
 #else
 	return false;
@@ -148,21 +215,77 @@ void SimpleAudio::SetChannels(int channels) {
 
 SimpleAudio::~SimpleAudio() {
 #ifdef USE_FFMPEG
-	swr_free(&swrCtx_);
-	av_frame_free(&frame_);
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 52, 0)
-	avcodec_free_context(&codecCtx_);
-#else
-	// Future versions may add other things to free, but avcodec_free_context didn't exist yet here.
-	avcodec_close(codecCtx_);
-	av_freep(&codecCtx_->extradata);
-	av_freep(&codecCtx_->subtitle_header);
-	av_freep(&codecCtx_);
-#endif
+	if (canPool_ && codec_) {
+		ReleaseToPool();
+	}
+	FreeDecoder(codecCtx_, frame_, swrCtx_);
 	codec_ = 0;
 #endif  // USE_FFMPEG
 }
 
+bool SimpleAudio::AcquirePooledDecoder() {
+#ifdef USE_FFMPEG
+	PooledDecoder found;
+	{
+		std::lock_guard<std::mutex> guard(decoderPoolLock);
+		auto match = [&](const PooledDecoder &pooled) {
+			return pooled.audioType == audioType && pooled.sampleRate == sample_rate_ && pooled.channels == channels_;
+		};
+		auto it = std::find_if(decoderPool.rbegin(), decoderPool.rend(), match);
+		if (it == decoderPool.rend())
+			return false;
+		found = *it;
+		decoderPool.erase(std::next(it).base());
+	}
+
+	// Our own context was never opened, so this is cheap.
+	FreeDecoder(codecCtx_, frame_, swrCtx_);
+	codec_ = found.codec;
+	codecCtx_ = found.codecCtx;
+	frame_ = found.frame;
+	swrCtx_ = found.swrCtx;
+	swrParams_ = found.swrParams;
+
+	avcodec_flush_buffers(codecCtx_);
+	// The decoder overwrites these from the stream, put back what a new one would start with.
+	codecCtx_->channels = channels_;
+	codecCtx_->channel_layout = channels_ == 2 ? AV_CH_LAYOUT_STEREO : AV_CH_LAYOUT_MONO;
+	codecCtx_->sample_rate = sample_rate_;
+	if (swrCtx_ && swr_init(swrCtx_) < 0) {
+		// Drops any samples it was holding back, but if that fails just make a new one.
+		swr_free(&swrCtx_);
+	}
+	return true;
+#else
+	return false;
+#endif  // USE_FFMPEG
+}
+
+void SimpleAudio::ReleaseToPool() {
+#ifdef USE_FFMPEG
+	PooledDecoder pooled;
+	pooled.audioType = audioType;
+	pooled.sampleRate = sample_rate_;
+	pooled.channels = channels_;
+	pooled.codec = codec_;
+	pooled.codecCtx = codecCtx_;
+	pooled.frame = frame_;
+	pooled.swrCtx = swrCtx_;
+	pooled.swrParams = swrParams_;
+	codecCtx_ = nullptr;
+	frame_ = nullptr;
+	swrCtx_ = nullptr;
+
+	std::lock_guard<std::mutex> guard(decoderPoolLock);
+	decoderPool.push_back(pooled);
+	if (decoderPool.size() > MAX_POOLED_DECODERS) {
+		PooledDecoder &oldest = decoderPool.front();
+		FreeDecoder(oldest.codecCtx, oldest.frame, oldest.swrCtx);
+		decoderPool.erase(decoderPool.begin());
+	}
+#endif  // USE_FFMPEG
+}
+
 bool SimpleAudio::IsOK() const {
 #ifdef USE_FFMPEG
 	return codec_ != 0;
@@ -207,7 +330,14 @@ bool SimpleAudio::Decode(void *inbuf, int inbytes, uint8_t *outbuf, int *outbyte
 		int64_t wanted_channel_layout = AV_CH_LAYOUT_STEREO; // we want stereo output layout
 		int64_t dec_channel_layout = frame_->channel_layout; // decoded channel layout
 
+		SwrParams params{ dec_channel_layout, (int)codecCtx_->sample_fmt, codecCtx_->sample_rate, wanted_resample_freq };
+		bool paramsChanged = params.inLayout != swrParams_.inLayout || params.inFormat != swrParams_.inFormat || params.inRate != swrParams_.inRate || params.outRate != swrParams_.outRate;
+		if (swrCtx_ && paramsChanged) {
+			// A reused decoder, or the stream changed.
+			swr_free(&swrCtx_);
+		}
 		if (!swrCtx_) {
+			swrParams_ = params;
 			swrCtx_ = swr_alloc_set_opts(
 				swrCtx_,
 				wanted_channel_layout,
@@ -223,6 +353,7 @@ bool SimpleAudio::Decode(void *inbuf, int inbytes, uint8_t *outbuf, int *outbyte
 				ERROR_LOG(ME, "swr_init: Failed to initialize the resampling context");
 				avcodec_close(codecCtx_);
 				codec_ = 0;
+				canPool_ = false;
 				return false;
 			}
 		}
@@ -309,6 +440,7 @@ AuCtx::AuCtx() {
 	realReadSize = 0;
 	audioType = 0;
 	FrameNum = 0;
+	sourcePos = 0;
 };
 
 AuCtx::~AuCtx(){
@@ -337,15 +469,16 @@ u32 AuCtx::AuDecode(u32 pcmAddr)
 	int i = 0;
 	// decode frames in sourcebuff and output into PCMBuf (each time, we decode one or two frames)
 	// some games as Miku like one frame each time, some games like DOA like two frames each time
-	while (sourcebuff.size() > 0 && outpcmbufsize < PCMBufSize && i < repeat){
+	while (sourcebuff.size() > sourcePos && outpcmbufsize < PCMBufSize && i < repeat){
 		i++;
 		int pcmframesize;
 		// decode
-		decoder->Decode((void*)sourcebuff.c_str(), (int)sourcebuff.size(), outbuf, &pcmframesize);
+		decoder->Decode((void*)(sourcebuff.data() + sourcePos), (int)(sourcebuff.size() - sourcePos), outbuf, &pcmframesize);
 		if (pcmframesize == 0){
 			// no output pcm, we are at the end of the stream
 			AuBufAvailable = 0;
 			sourcebuff.clear();
+			sourcePos = 0;
 			if (LoopNum != 0){
 				// if we loop, reset readPos
 				readPos = startPos;
@@ -358,8 +491,8 @@ u32 AuCtx::AuDecode(u32 pcmAddr)
 		SumDecodedSamples += decoder->GetOutSamples();
 		// get consumed source length
 		int srcPos = decoder->GetSourcePos();
-		// remove the consumed source
-		sourcebuff.erase(0, srcPos);
+		// skip the consumed source, it's removed when more data gets added
+		sourcePos += srcPos;
 		// reduce the available Aubuff size
 		// (the available buff size is now used to know if we can read again from file and how many to read)
 		AuBufAvailable -= srcPos;
@@ -404,7 +537,9 @@ u32 AuCtx::AuNotifyAddStreamData(int size)
 		AuBufAvailable += diffsize;
 	}
 
-	// append AuBuf into sourcebuff
+	// append AuBuf into sourcebuff, after dropping what's been decoded (once here, not every frame.)
+	sourcebuff.erase(0, sourcePos);
+	sourcePos = 0;
 	sourcebuff.append((const char*)Memory::GetPointer(AuBuf), size);
 
 	if (readPos >= (int)endPos && LoopNum != 0){
@@ -66,9 +66,19 @@ class SimpleAudio {
 	void SetCtxPtr(u32 ptr) { ctxPtr = ptr;  }
 	u32 GetCtxPtr() const { return ctxPtr; }
 
+	// What swrCtx_ was set up for.
+	struct SwrParams {
+		int64_t inLayout;
+		int inFormat;
+		int inRate;
+		int outRate;
+	};
+
 private:
 	void Init();
 	bool OpenCodec(int block_align);
+	bool AcquirePooledDecoder();
+	void ReleaseToPool();
 
 	u32 ctxPtr;
 	int audioType;
@@ -82,11 +92,16 @@ class SimpleAudio {
 	AVCodec *codec_;
 	AVCodecContext  *codecCtx_;
 	SwrContext      *swrCtx_;
+	SwrParams swrParams_{};
 
 	bool codecOpen_;
+	// Opened fine and can be reused by the next SimpleAudio for the same codec.
+	bool canPool_;
 };
 
 void AudioClose(SimpleAudio **ctx);
+// Frees the opened decoders kept around for reuse.
+void AudioClearDecoderPool();
 const char *GetCodecName(int codec);  // audioType
 bool IsValidCodec(int codec);
 
@@ -117,7 +132,8 @@ class AuCtx {
 	void DoState(PointerWrap &p);
 
 	void EatSourceBuff(int amount) {
-		sourcebuff.erase(0, amount);
+		sourcebuff.erase(0, sourcePos + amount);
+		sourcePos = 0;
 		AuBufAvailable -= amount;
 	}
 	// Au source information. Written to from for example sceAacInit so public for now.
@@ -153,6 +169,7 @@ class AuCtx {
 
 private:
 	std::string sourcebuff; // source buffer
+	size_t sourcePos; // already decoded bytes at the start of sourcebuff
 };
 
 
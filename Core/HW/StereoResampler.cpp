@@ -29,13 +29,21 @@
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
 
+// The polyphase filter's coefficients are fixed point with this many fractional bits.
+#define FIR_SHIFT       14
+// Fraction of the Nyquist frequency to keep, the rest is the transition band.
+#define FIR_CUTOFF      0.9
+#define FIR_KAISER_BETA 7.0
+
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include "base/logging.h"
 #include "base/NativeApp.h"
+#include "math/math_util.h"
 #include "Common/ChunkFile.h"
 #include "Common/MathUtil.h"
-#include "Common/Atomics.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/HW/StereoResampler.h"
@@ -54,16 +62,13 @@ StereoResampler::StereoResampler()
 		: m_bufsize(MAX_SAMPLES_DEFAULT)
 	  , m_lowwatermark(LOW_WATERMARK_DEFAULT)
 		, m_input_sample_rate(44100)
-		, m_indexW(0)
-		, m_indexR(0)
 		, m_numLeftI(0.0f)
 		, m_frac(0)
 		, underrunCount_(0)
 		, overrunCount_(0)
 		, sample_rate_(0.0f)
 		, lastBufSize_(0) {
-	// Need to have space for the worst case in case it changes.
-	m_buffer = new int16_t[MAX_SAMPLES_EXTRA * 2]();
+	static_assert(MAX_SAMPLES_EXTRA <= AudioRing::CAPACITY, "Audio ring too small for the extra buffering");
 
 	// Some Android devices are v-synced to non-60Hz framerates. We simply timestretch audio to fit.
 	// TODO: should only do this if auto frameskip is off?
@@ -78,10 +83,9 @@ StereoResampler::StereoResampler()
 }
 
 StereoResampler::~StereoResampler() {
-	delete[] m_buffer;
-	m_buffer = nullptr;
 }
 
+// The ring itself doesn't change size, this only moves the limits, so it's fine at any time.
 void StereoResampler::UpdateBufferSize() {
 	if (g_Config.bExtraAudioBuffering) {
 		m_bufsize = MAX_SAMPLES_EXTRA;
@@ -143,7 +147,99 @@ inline void ClampBufferToS16WithVolume(s16 *out, const s32 *in, size_t size) {
 }
 
 void StereoResampler::Clear() {
-	memset(m_buffer, 0, m_bufsize * 2 * sizeof(int16_t));
+	ring_.Silence();
+}
+
+static double BesselI0(double x) {
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		const double t = x / (2.0 * k);
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+// Kaiser windowed sinc, one phase per fraction of an input sample.  Only done when the rates change.
+void StereoResampler::BuildFilterBank(int inputRate, int outputRate) {
+	// When downsampling, also cut off what the output can't represent.
+	const double cutoff = std::min(1.0, (double)outputRate / (double)inputRate) * FIR_CUTOFF;
+	const double halfWidth = FIR_TAPS / 2;
+	const double windowScale = 1.0 / BesselI0(FIR_KAISER_BETA);
+
+	for (int phase = 0; phase < FIR_PHASES; ++phase) {
+		const double frac = (double)phase / FIR_PHASES;
+		double h[FIR_TAPS];
+		double sum = 0.0;
+		for (int k = 0; k < FIR_TAPS; ++k) {
+			// The output is between taps FIR_TAPS / 2 - 1 and FIR_TAPS / 2.
+			const double x = k - (FIR_TAPS / 2 - 1) - frac;
+			const double sinc = x == 0.0 ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			const double r = x / halfWidth;
+			const double window = r * r < 1.0 ? BesselI0(FIR_KAISER_BETA * sqrt(1.0 - r * r)) * windowScale : 0.0;
+			h[k] = sinc * window;
+			sum += h[k];
+		}
+
+		// Normalize for unity gain, and put the rounding error on the largest tap.
+		int total = 0;
+		int largest = 0;
+		for (int k = 0; k < FIR_TAPS; ++k) {
+			const int c = (int)floor(h[k] / sum * (1 << FIR_SHIFT) + 0.5);
+			filterBank_[phase][k] = (s16)c;
+			total += c;
+			if (abs(c) > abs(filterBank_[phase][largest]))
+				largest = k;
+		}
+		filterBank_[phase][largest] += (1 << FIR_SHIFT) - total;
+	}
+
+	filterInputRate_ = inputRate;
+	filterOutputRate_ = outputRate;
+}
+
+// Applies one phase of the filter to taps interleaved stereo samples.
+static inline void FilterStereo(s16 *out, const s16 *in, const s16 *coefs, int taps) {
+#ifdef _M_SSE
+	__m128i acc = _mm_set_epi32(0, 0, 1 << (FIR_SHIFT - 1), 1 << (FIR_SHIFT - 1));
+	for (int k = 0; k < taps; k += 4) {
+		// L0 R0 L1 R1 L2 R2 L3 R3 -> L0 L1 R0 R1 L2 L3 R2 R3, to line up with c0 c1 c0 c1 c2 c3 c2 c3.
+		__m128i s = _mm_loadu_si128((const __m128i *)(in + k * 2));
+		s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i c = _mm_loadl_epi64((const __m128i *)(coefs + k));
+		c = _mm_unpacklo_epi32(c, c);
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s, c));
+	}
+	// Now L R L R, add the halves together.
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_packs_epi32(_mm_srai_epi32(acc, FIR_SHIFT), acc);
+	u32 lr = (u32)_mm_cvtsi128_si32(acc);
+	memcpy(out, &lr, sizeof(lr));
+#elif PPSSPP_ARCH(ARM_NEON)
+	int32x4_t accL = vdupq_n_s32(0);
+	int32x4_t accR = vdupq_n_s32(0);
+	for (int k = 0; k < taps; k += 4) {
+		int16x4x2_t s = vld2_s16(in + k * 2);
+		int16x4_t c = vld1_s16(coefs + k);
+		accL = vmlal_s16(accL, s.val[0], c);
+		accR = vmlal_s16(accR, s.val[1], c);
+	}
+	int32x2_t l = vadd_s32(vget_low_s32(accL), vget_high_s32(accL));
+	int32x2_t r = vadd_s32(vget_low_s32(accR), vget_high_s32(accR));
+	int32x2_t lr = vpadd_s32(l, r);
+	int16x4_t packed = vqrshrn_n_s32(vcombine_s32(lr, lr), FIR_SHIFT);
+	vst1_lane_s32((int32_t *)out, vreinterpret_s32_s16(packed), 0);
+#else
+	int sumL = 1 << (FIR_SHIFT - 1);
+	int sumR = 1 << (FIR_SHIFT - 1);
+	for (int k = 0; k < taps; ++k) {
+		sumL += in[k * 2] * coefs[k];
+		sumR += in[k * 2 + 1] * coefs[k];
+	}
+	out[0] = clamp_s16(sumL >> FIR_SHIFT);
+	out[1] = clamp_s16(sumR >> FIR_SHIFT);
+#endif
 }
 
 // Executed from sound stream thread
@@ -153,31 +249,39 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 
 	unsigned int currentSample = 0;
 
-	// Cache access in non-volatile variable
-	// This is the only function changing the read value, so it's safe to
-	// cache it locally although it's written here.
-	// The writing pointer will be modified outside, but it will only increase,
-	// so we will just ignore new written data while interpolating.
-	// Without this cache, the compiler wouldn't be allowed to optimize the
-	// interpolation loop.
-	u32 indexR = Common::AtomicLoad(m_indexR);
-	u32 indexW = Common::AtomicLoad(m_indexW);
-
-	const int INDEX_MASK = (m_bufsize * 2 - 1);
+	// Only this thread moves the read index, so it's safe to work on a local copy and publish it at
+	// the end.  The write index may move on meanwhile, we just won't see those samples until next time.
+	const u32 startR = ring_.ReadIndex();
+	const u32 buffered = ring_.Buffered();
+	u32 indexR = startR;
+	const u32 indexW = startR + buffered;
+
+	if (fillResetPending_.exchange(false)) {
+		fillCount_.store(0, std::memory_order_relaxed);
+		fillSum_.store(0, std::memory_order_relaxed);
+		fillMax_.store(0, std::memory_order_relaxed);
+	}
+	const int fillCount = fillCount_.load(std::memory_order_relaxed);
+	if (fillCount == 0 || (int)buffered < fillMin_.load(std::memory_order_relaxed))
+		fillMin_.store(buffered, std::memory_order_relaxed);
+	if ((int)buffered > fillMax_.load(std::memory_order_relaxed))
+		fillMax_.store(buffered, std::memory_order_relaxed);
+	fillSum_.store(fillSum_.load(std::memory_order_relaxed) + buffered, std::memory_order_relaxed);
+	// Published last, so a reader that sees the count sees at least the values that went with it.
+	fillCount_.store(fillCount + 1, std::memory_order_release);
 
 	// We force on the audio resampler if the output sample rate doesn't match the input.
 	if (!g_Config.bAudioResampler && sample_rate == (int)m_input_sample_rate) {
-		for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > 2; currentSample += 2) {
-			s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-			s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-			samples[currentSample] = l1;
-			samples[currentSample + 1] = r1;
-			indexR += 2;
+		for (; currentSample < numSamples * 2 && indexW - indexR > 1; currentSample += 2) {
+			const s16 *cur = ring_.Frame(indexR);
+			samples[currentSample] = cur[0];
+			samples[currentSample + 1] = cur[1];
+			indexR++;
 		}
 		sample_rate_ = (float)sample_rate;
 	} else {
 		// Drift prevention mechanism
-		float numLeft = (float)(((indexW - indexR) & INDEX_MASK) / 2);
+		float numLeft = (float)buffered;
 		m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG - 1)) / CONTROL_AVG;
 		float offset = (m_numLeftI - m_lowwatermark) * CONTROL_FACTOR;
 		if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
@@ -186,21 +290,41 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 		sample_rate_ = (float)(m_input_sample_rate + offset);
 		const u32 ratio = (u32)(65536.0 * sample_rate_ / (double)sample_rate);
 
-		// TODO: consider a higher-quality resampling algorithm.
-		// TODO: Add a fast path for 1:1.
-		for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > 2; currentSample += 2) {
-			u32 indexR2 = indexR + 2; //next sample
-			s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-			s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-			s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
-			s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
-			int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
-			int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
-			samples[currentSample] = sampleL;
-			samples[currentSample + 1] = sampleR;
-			m_frac += ratio;
-			indexR += 2 * (u16)(m_frac >> 16);
-			m_frac &= 0xffff;
+		if (g_Config.bHighQualityResampler) {
+			if (filterInputRate_ != (int)m_input_sample_rate || filterOutputRate_ != sample_rate)
+				BuildFilterBank(m_input_sample_rate, sample_rate);
+
+			// The output lags FIR_TAPS / 2 samples behind, so we never read behind indexR.
+			s16 wrapped[FIR_TAPS * 2];
+			for (; currentSample < numSamples * 2 && indexW - indexR > FIR_TAPS; currentSample += 2) {
+				const s16 *in = ring_.Frame(indexR);
+				if (ring_.ContiguousFrom(indexR) < FIR_TAPS) {
+					for (int i = 0; i < FIR_TAPS; ++i)
+						memcpy(&wrapped[i * 2], ring_.Frame(indexR + i), 2 * sizeof(s16));
+					in = wrapped;
+				}
+				FilterStereo(&samples[currentSample], in, filterBank_[(u16)m_frac >> (16 - FIR_PHASE_BITS)], FIR_TAPS);
+				m_frac += ratio;
+				indexR += (u16)(m_frac >> 16);
+				m_frac &= 0xffff;
+			}
+		} else {
+			// TODO: Add a fast path for 1:1.
+			for (; currentSample < numSamples * 2 && indexW - indexR > 1; currentSample += 2) {
+				const s16 *cur = ring_.Frame(indexR);
+				const s16 *next = ring_.Frame(indexR + 1);
+				s16 l1 = cur[0];
+				s16 r1 = cur[1];
+				s16 l2 = next[0];
+				s16 r2 = next[1];
+				int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
+				int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
+				samples[currentSample] = sampleL;
+				samples[currentSample + 1] = sampleR;
+				m_frac += ratio;
+				indexR += (u16)(m_frac >> 16);
+				m_frac &= 0xffff;
+			}
 		}
 	}
 
@@ -209,56 +333,45 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 		underrunCount_++;
 
 	// Padding with the last value to reduce clicking
+	const s16 *last = ring_.Frame(indexR - 1);
 	short s[2];
-	s[0] = clamp_s16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = clamp_s16(m_buffer[(indexR - 2) & INDEX_MASK]);
+	s[0] = last[0];
+	s[1] = last[1];
 	for (; currentSample < numSamples * 2; currentSample += 2) {
 		samples[currentSample] = s[0];
 		samples[currentSample + 1] = s[1];
 	}
 
-	// Flush cached variable
-	Common::AtomicStore(m_indexR, indexR);
-
-	//if (realSamples != numSamples * 2) {
-	//	ILOG("Underrun! %i / %i", realSamples / 2, numSamples);
-	//}
-	lastBufSize_ = (m_indexW - m_indexR) & INDEX_MASK;
+	ring_.Consume(indexR - startR);
+	lastBufSize_ = ring_.Buffered();
 
 	return realSamples / 2;
 }
 
 void StereoResampler::PushSamples(const s32 *samples, unsigned int num_samples) {
 	UpdateBufferSize();
-	const int INDEX_MASK = (m_bufsize * 2 - 1);
-	// Cache access in non-volatile variable
-	// indexR isn't allowed to cache in the audio throttling loop as it
-	// needs to get updates to not deadlock.
-	u32 indexW = Common::AtomicLoad(m_indexW);
 
-	u32 cap = m_bufsize * 2;
+	u32 cap = m_bufsize;
 	// If unthottling, no need to fill up the entire buffer, just screws up timing after releasing unthrottle.
 	if (PSP_CoreParameter().unthrottle)
-		cap = m_lowwatermark * 2;
+		cap = m_lowwatermark;
 
-	// Check if we have enough free space
-	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= cap) {
+	// Check if we have enough free space.  The reader can only make more room meanwhile.
+	if (num_samples + ring_.Buffered() >= cap) {
 		if (!PSP_CoreParameter().unthrottle)
 			overrunCount_++;
 		// TODO: "Timestretch" by doing a windowed overlap with existing buffer content?
 		return;
 	}
 
-	int over_bytes = num_samples * 4 - (m_bufsize * 2 - (indexW & INDEX_MASK)) * sizeof(short);
-	if (over_bytes > 0) {
-		ClampBufferToS16WithVolume(&m_buffer[indexW & INDEX_MASK], samples, (num_samples * 4 - over_bytes) / 2);
-		ClampBufferToS16WithVolume(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes / 2);
-	} else {
-		ClampBufferToS16WithVolume(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 2);
+	const u32 indexW = ring_.WriteIndex();
+	const u32 first = std::min((u32)num_samples, ring_.ContiguousFrom(indexW));
+	ClampBufferToS16WithVolume(ring_.Frame(indexW), samples, first * 2);
+	if (first < num_samples) {
+		ClampBufferToS16WithVolume(ring_.Frame(indexW + first), samples + first * 2, (num_samples - first) * 2);
 	}
 
-	Common::AtomicAdd(m_indexW, num_samples * 2);
+	ring_.Commit(num_samples);
 	lastPushSize_ = num_samples;
 }
 
@@ -269,9 +382,17 @@ void StereoResampler::GetAudioDebugStats(AudioDebugStats *stats) {
 	stats->overrunCount += overrunCount_;
 	overrunCount_ = 0;
 	stats->watermark = m_lowwatermark;
-	stats->bufsize = m_bufsize * 2;
+	stats->bufsize = m_bufsize;
 	stats->instantSampleRate = (int)sample_rate_;
 	stats->lastPushSize = lastPushSize_;
+	const int fillCount = fillCount_.load(std::memory_order_acquire);
+	if (fillCount != 0 && !fillResetPending_.load()) {
+		stats->minBuffered = fillMin_.load(std::memory_order_relaxed);
+		stats->maxBuffered = fillMax_.load(std::memory_order_relaxed);
+		stats->avgBuffered = (int)(fillSum_.load(std::memory_order_relaxed) / fillCount);
+	}
+	// Mix does the reset, since it's the only writer.
+	fillResetPending_ = true;
 }
 
 void StereoResampler::SetInputSampleRate(unsigned int rate) {
@@ -19,10 +19,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Core/HW/AudioRing.h"
 
 struct AudioDebugStats;
 
@@ -45,15 +47,22 @@ class StereoResampler {
 	void GetAudioDebugStats(AudioDebugStats *stats);
 
 protected:
+	enum {
+		// Input samples per output sample for the polyphase filter, must be a multiple of 4.
+		FIR_TAPS = 16,
+		FIR_PHASE_BITS = 8,
+		FIR_PHASES = 1 << FIR_PHASE_BITS,
+	};
+
 	void UpdateBufferSize();
 	void SetInputSampleRate(unsigned int rate);
+	void BuildFilterBank(int inputRate, int outputRate);
 
+	// In stereo frames.  Most we let the ring fill up to, and the fill level the rate control aims for.
 	int m_bufsize;
 	int m_lowwatermark;
 	unsigned int m_input_sample_rate;
-	int16_t *m_buffer;
-	volatile u32 m_indexW;
-	volatile u32 m_indexR;
+	AudioRing ring_;
 	float m_numLeftI;
 	u32 m_frac;
 	int underrunCount_;
@@ -61,4 +70,16 @@ class StereoResampler {
 	float sample_rate_;
 	int lastBufSize_;
 	int lastPushSize_;
+	// Fill level seen by Mix since the last GetAudioDebugStats.  Only Mix writes these, including
+	// the reset GetAudioDebugStats asks for, so the other thread only ever reads them.
+	std::atomic<int> fillMin_{ 0 };
+	std::atomic<int> fillMax_{ 0 };
+	std::atomic<int64_t> fillSum_{ 0 };
+	std::atomic<int> fillCount_{ 0 };
+	std::atomic<bool> fillResetPending_{ false };
+
+	// One set of FIR_TAPS coefficients for each fraction of a sample, for the current rates.
+	s16 filterBank_[FIR_PHASES][FIR_TAPS];
+	int filterInputRate_ = 0;
+	int filterOutputRate_ = 0;
 };
@@ -0,0 +1,287 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdint>
+
+#include "ppsspp_config.h"
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+#include "Core/HW/YUVConvert.h"
+#include "GPU/ge_constants.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// BT.601 with MPEG range (Y 16-235, UV 16-240), which is what swscale was set up for before.
+// All paths compute exactly the same thing: each product is (a << 7) * coef >> 16 like a signed
+// 16-bit high multiply, which leaves 4 fractional bits, then the sum is rounded.
+enum {
+	// 13 fractional bits.
+	COEF_Y = 9538,  // 255 / 219
+	COEF_RV = 13075,  // 1.596
+	COEF_GU = 3209,  // 0.392
+	COEF_GV = 6660,  // 0.813
+	COEF_BU = 16525,  // 2.017
+};
+
+static inline int MulHi(int a, int coef) {
+	return (a * 128 * coef) >> 16;
+}
+
+static inline int Clamp8(int v) {
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+template <int fmt>
+static inline void WritePixel(u8 *dst, int r, int g, int b) {
+	switch (fmt) {
+	case GE_CMODE_16BIT_BGR5650:
+		*(u16_le *)dst = (r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11);
+		break;
+	case GE_CMODE_16BIT_ABGR5551:
+		*(u16_le *)dst = (r >> 3) | ((g >> 3) << 5) | ((b >> 3) << 10);
+		break;
+	case GE_CMODE_16BIT_ABGR4444:
+		*(u16_le *)dst = (r >> 4) | ((g >> 4) << 4) | ((b >> 4) << 8);
+		break;
+	case GE_CMODE_32BIT_ABGR8888:
+		*(u32_le *)dst = r | (g << 8) | (b << 16);
+		break;
+	}
+}
+
+// Converts count pixels starting at column x.  The plane pointers are to the start of the row.
+template <int fmt>
+static void ConvertRowScalar(u8 *dst, const u8 *yp, const u8 *up, const u8 *vp, int x, int count) {
+	const int bpp = fmt == GE_CMODE_32BIT_ABGR8888 ? 4 : 2;
+	for (int i = 0; i < count; ++i) {
+		const int col = x + i;
+		const int yy = MulHi(yp[col] - 16, COEF_Y);
+		const int u = up[col >> 1] - 128;
+		const int v = vp[col >> 1] - 128;
+		const int r = Clamp8((yy + MulHi(v, COEF_RV) + 8) >> 4);
+		const int g = Clamp8((yy - (MulHi(u, COEF_GU) + MulHi(v, COEF_GV)) + 8) >> 4);
+		const int b = Clamp8((yy + MulHi(u, COEF_BU) + 8) >> 4);
+		WritePixel<fmt>(dst + i * bpp, r, g, b);
+	}
+}
+
+#if defined(_M_SSE)
+#define HAVE_CONVERT_BLOCK
+
+// r, g, b are 8 pixels in 16-bit lanes, already clamped to 0-255.
+template <int fmt>
+static inline void WritePixels8(u8 *dst, __m128i r, __m128i g, __m128i b) {
+	switch (fmt) {
+	case GE_CMODE_16BIT_BGR5650:
+		r = _mm_srli_epi16(r, 3);
+		g = _mm_slli_epi16(_mm_srli_epi16(g, 2), 5);
+		b = _mm_slli_epi16(_mm_srli_epi16(b, 3), 11);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_or_si128(r, g), b));
+		break;
+	case GE_CMODE_16BIT_ABGR5551:
+		r = _mm_srli_epi16(r, 3);
+		g = _mm_slli_epi16(_mm_srli_epi16(g, 3), 5);
+		b = _mm_slli_epi16(_mm_srli_epi16(b, 3), 10);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_or_si128(r, g), b));
+		break;
+	case GE_CMODE_16BIT_ABGR4444:
+		r = _mm_srli_epi16(r, 4);
+		g = _mm_slli_epi16(_mm_srli_epi16(g, 4), 4);
+		b = _mm_slli_epi16(_mm_srli_epi16(b, 4), 8);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_or_si128(r, g), b));
+		break;
+	case GE_CMODE_32BIT_ABGR8888:
+		{
+			__m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+			_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, b));
+			_mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(rg, b));
+		}
+		break;
+	}
+}
+
+// Converts 16 pixels starting at column x, which must be even.
+template <int fmt>
+static inline void ConvertBlock16(u8 *dst, const u8 *yp, const u8 *up, const u8 *vp, int x) {
+	const int bpp = fmt == GE_CMODE_32BIT_ABGR8888 ? 4 : 2;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c16 = _mm_set1_epi16(16);
+	const __m128i c128 = _mm_set1_epi16(128);
+	const __m128i round = _mm_set1_epi16(8);
+	const __m128i max = _mm_set1_epi16(255);
+
+	const __m128i y8 = _mm_loadu_si128((const __m128i *)(yp + x));
+	const __m128i u = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(up + x / 2)), zero), c128), 7);
+	const __m128i v = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vp + x / 2)), zero), c128), 7);
+
+	// One chroma value per two pixels.
+	const __m128i rv = _mm_mulhi_epi16(v, _mm_set1_epi16(COEF_RV));
+	const __m128i guv = _mm_add_epi16(_mm_mulhi_epi16(u, _mm_set1_epi16(COEF_GU)), _mm_mulhi_epi16(v, _mm_set1_epi16(COEF_GV)));
+	const __m128i bu = _mm_mulhi_epi16(u, _mm_set1_epi16(COEF_BU));
+
+	for (int half = 0; half < 2; ++half) {
+		__m128i yy, rvh, guvh, buh;
+		if (half == 0) {
+			yy = _mm_unpacklo_epi8(y8, zero);
+			rvh = _mm_unpacklo_epi16(rv, rv);
+			guvh = _mm_unpacklo_epi16(guv, guv);
+			buh = _mm_unpacklo_epi16(bu, bu);
+		} else {
+			yy = _mm_unpackhi_epi8(y8, zero);
+			rvh = _mm_unpackhi_epi16(rv, rv);
+			guvh = _mm_unpackhi_epi16(guv, guv);
+			buh = _mm_unpackhi_epi16(bu, bu);
+		}
+		yy = _mm_add_epi16(_mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(yy, c16), 7), _mm_set1_epi16(COEF_Y)), round);
+
+		__m128i r = _mm_srai_epi16(_mm_add_epi16(yy, rvh), 4);
+		__m128i g = _mm_srai_epi16(_mm_sub_epi16(yy, guvh), 4);
+		__m128i b = _mm_srai_epi16(_mm_add_epi16(yy, buh), 4);
+		r = _mm_max_epi16(_mm_min_epi16(r, max), zero);
+		g = _mm_max_epi16(_mm_min_epi16(g, max), zero);
+		b = _mm_max_epi16(_mm_min_epi16(b, max), zero);
+		WritePixels8<fmt>(dst + half * 8 * bpp, r, g, b);
+	}
+}
+
+#elif PPSSPP_ARCH(ARM_NEON)
+#define HAVE_CONVERT_BLOCK
+
+template <int fmt>
+static inline void WritePixels8(u8 *dst, uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+	uint16x8_t p;
+	switch (fmt) {
+	case GE_CMODE_16BIT_BGR5650:
+		p = vmovl_u8(vshr_n_u8(r, 3));
+		p = vorrq_u16(p, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 2)), 5));
+		p = vorrq_u16(p, vshlq_n_u16(vmovl_u8(vshr_n_u8(b, 3)), 11));
+		vst1q_u16((uint16_t *)dst, p);
+		break;
+	case GE_CMODE_16BIT_ABGR5551:
+		p = vmovl_u8(vshr_n_u8(r, 3));
+		p = vorrq_u16(p, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 3)), 5));
+		p = vorrq_u16(p, vshlq_n_u16(vmovl_u8(vshr_n_u8(b, 3)), 10));
+		vst1q_u16((uint16_t *)dst, p);
+		break;
+	case GE_CMODE_16BIT_ABGR4444:
+		p = vmovl_u8(vshr_n_u8(r, 4));
+		p = vorrq_u16(p, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 4)), 4));
+		p = vorrq_u16(p, vshlq_n_u16(vmovl_u8(vshr_n_u8(b, 4)), 8));
+		vst1q_u16((uint16_t *)dst, p);
+		break;
+	case GE_CMODE_32BIT_ABGR8888:
+		{
+			uint8x8x4_t rgba;
+			rgba.val[0] = r;
+			rgba.val[1] = g;
+			rgba.val[2] = b;
+			rgba.val[3] = vdup_n_u8(0);
+			vst4_u8(dst, rgba);
+		}
+		break;
+	}
+}
+
+// Converts 16 pixels starting at column x, which must be even.
+// vqdmulh doubles, so shifting by 6 instead of 7 gives the same products as the other paths.
+template <int fmt>
+static inline void ConvertBlock16(u8 *dst, const u8 *yp, const u8 *up, const u8 *vp, int x) {
+	const int bpp = fmt == GE_CMODE_32BIT_ABGR8888 ? 4 : 2;
+	const uint8x16_t y8 = vld1q_u8(yp + x);
+	const int16x8_t u = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(up + x / 2))), vdupq_n_s16(128)), 6);
+	const int16x8_t v = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(vp + x / 2))), vdupq_n_s16(128)), 6);
+
+	// One chroma value per two pixels.
+	const int16x8x2_t rv = vzipq_s16(vqdmulhq_n_s16(v, COEF_RV), vqdmulhq_n_s16(v, COEF_RV));
+	const int16x8_t guv1 = vaddq_s16(vqdmulhq_n_s16(u, COEF_GU), vqdmulhq_n_s16(v, COEF_GV));
+	const int16x8x2_t guv = vzipq_s16(guv1, guv1);
+	const int16x8x2_t bu = vzipq_s16(vqdmulhq_n_s16(u, COEF_BU), vqdmulhq_n_s16(u, COEF_BU));
+
+	for (int half = 0; half < 2; ++half) {
+		const uint8x8_t yh = half == 0 ? vget_low_u8(y8) : vget_high_u8(y8);
+		const int16x8_t yy = vqdmulhq_n_s16(vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yh)), vdupq_n_s16(16)), 6), COEF_Y);
+
+		const uint8x8_t r = vqmovun_s16(vrshrq_n_s16(vaddq_s16(yy, rv.val[half]), 4));
+		const uint8x8_t g = vqmovun_s16(vrshrq_n_s16(vsubq_s16(yy, guv.val[half]), 4));
+		const uint8x8_t b = vqmovun_s16(vrshrq_n_s16(vaddq_s16(yy, bu.val[half]), 4));
+		WritePixels8<fmt>(dst + half * 8 * bpp, r, g, b);
+	}
+}
+#endif
+
+template <int fmt, bool simd>
+static void ConvertRows(u8 *dst, int dstStride, const u8 *const planes[3], const int strides[3], int x, int y, int width, int height) {
+	const int bpp = fmt == GE_CMODE_32BIT_ABGR8888 ? 4 : 2;
+	const int end = x + width;
+	for (int row = 0; row < height; ++row) {
+		const u8 *yp = planes[0] + (y + row) * strides[0];
+		const u8 *up = planes[1] + ((y + row) >> 1) * strides[1];
+		const u8 *vp = planes[2] + ((y + row) >> 1) * strides[2];
+		u8 *d = dst + row * dstStride;
+		int col = x;
+
+#ifdef HAVE_CONVERT_BLOCK
+		if (simd) {
+			// Blocks have to start on a chroma sample.
+			if (col & 1) {
+				ConvertRowScalar<fmt>(d, yp, up, vp, col, 1);
+				d += bpp;
+				col++;
+			}
+			for (; col + 16 <= end; col += 16) {
+				ConvertBlock16<fmt>(d, yp, up, vp, col);
+				d += 16 * bpp;
+			}
+		}
+#endif
+		ConvertRowScalar<fmt>(d, yp, up, vp, col, end - col);
+	}
+}
+
+template <bool simd>
+static void ConvertAnyFormat(u8 *dst, int dstStride, const u8 *const planes[3], const int strides[3], int x, int y, int width, int height, int pspFormat) {
+	if (width <= 0 || height <= 0)
+		return;
+
+	switch (pspFormat) {
+	case GE_CMODE_16BIT_BGR5650:
+		ConvertRows<GE_CMODE_16BIT_BGR5650, simd>(dst, dstStride, planes, strides, x, y, width, height);
+		break;
+	case GE_CMODE_16BIT_ABGR5551:
+		ConvertRows<GE_CMODE_16BIT_ABGR5551, simd>(dst, dstStride, planes, strides, x, y, width, height);
+		break;
+	case GE_CMODE_16BIT_ABGR4444:
+		ConvertRows<GE_CMODE_16BIT_ABGR4444, simd>(dst, dstStride, planes, strides, x, y, width, height);
+		break;
+	case GE_CMODE_32BIT_ABGR8888:
+		ConvertRows<GE_CMODE_32BIT_ABGR8888, simd>(dst, dstStride, planes, strides, x, y, width, height);
+		break;
+	}
+}
+
+void ConvertYUV420ToPSP(u8 *dst, int dstStride, const u8 *const planes[3], const int strides[3], int x, int y, int width, int height, int pspFormat) {
+	ConvertAnyFormat<true>(dst, dstStride, planes, strides, x, y, width, height, pspFormat);
+}
+
+void ConvertYUV420ToPSPReference(u8 *dst, int dstStride, const u8 *const planes[3], const int strides[3], int x, int y, int width, int height, int pspFormat) {
+	ConvertAnyFormat<false>(dst, dstStride, planes, strides, x, y, width, height, pspFormat);
+}
@@ -0,0 +1,29 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Converts the width x height rectangle at (x, y) of a planar YUV 4:2:0 image (MPEG range, BT.601,
+// as the PSP's AVC decoder outputs) into one of the PSP's pixel formats (GEPaletteFormat), writing
+// rows dstStride bytes apart.  Alpha is always zero, like the real thing.
+// planes and strides are Y, U, V, as in an AVFrame.
+void ConvertYUV420ToPSP(u8 *dst, int dstStride, const u8 *const planes[3], const int strides[3], int x, int y, int width, int height, int pspFormat);
+
+// Same results one pixel at a time, for testing.
+void ConvertYUV420ToPSPReference(u8 *dst, int dstStride, const u8 *const planes[3], const int strides[3], int x, int y, int width, int height, int pspFormat);
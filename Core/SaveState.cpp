@@ -45,6 +45,7 @@
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "HW/MemoryStick.h"
+#include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 
 #ifndef MOBILE_DEVICE
@@ -277,6 +278,10 @@ namespace SaveState
 		// Gotta do CoreTiming first since we'll restore into it.
 		CoreTiming::DoState(p);
 
+		// Async framebuffer downloads mustn't land after memory is saved, or over a loaded state.
+		if (gpu)
+			gpu->SyncPendingReadbacks(p.mode == p.MODE_READ);
+
 		// Memory is a bit tricky when jit is enabled, since there's emuhacks in it.
 		auto savedReplacements = SaveAndClearReplacements();
 		if (MIPSComp::jit && p.mode == p.MODE_WRITE)
@@ -0,0 +1,103 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdint>
+#include <cstring>
+
+#include "GPU/Common/BlockTransfer.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+enum {
+	// Above this, the destination likely won't be read again before it's evicted anyway, and
+	// streaming it saves reading it into the cache first.  A full 480x272x32 screen is ~510KB.
+	NONTEMPORAL_MIN_BYTES = 256 * 1024,
+};
+
+#ifdef _M_SSE
+static void CopyRowNonTemporal(u8 *dst, const u8 *src, int bytes) {
+	// Align the destination, stores have to be aligned.
+	int head = (int)((16 - ((uintptr_t)dst & 15)) & 15);
+	if (head > bytes)
+		head = bytes;
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	bytes -= head;
+
+	while (bytes >= 64) {
+		__m128i a = _mm_loadu_si128((const __m128i *)src);
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+		__m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+		_mm_stream_si128((__m128i *)dst, a);
+		_mm_stream_si128((__m128i *)(dst + 16), b);
+		_mm_stream_si128((__m128i *)(dst + 32), c);
+		_mm_stream_si128((__m128i *)(dst + 48), d);
+		src += 64;
+		dst += 64;
+		bytes -= 64;
+	}
+	while (bytes >= 16) {
+		_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+		src += 16;
+		dst += 16;
+		bytes -= 16;
+	}
+	memcpy(dst, src, bytes);
+}
+#endif
+
+void CopyBlockRows(u8 *dst, int dstPitch, const u8 *src, int srcPitch, int rowBytes, int rows) {
+	if (rows <= 0 || rowBytes <= 0)
+		return;
+
+	const u8 *srcEnd = src + (rows - 1) * srcPitch + rowBytes;
+	const u8 *dstEnd = dst + (rows - 1) * dstPitch + rowBytes;
+	const bool overlaps = dst < srcEnd && src < dstEnd;
+	if (overlaps) {
+		// Scrolling within a buffer.  Rare, so just keep it correct.
+		if (dst > src) {
+			for (int y = rows - 1; y >= 0; --y)
+				memmove(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+		} else {
+			for (int y = 0; y < rows; ++y)
+				memmove(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+		}
+		return;
+	}
+
+#ifdef _M_SSE
+	if ((size_t)rowBytes * rows >= NONTEMPORAL_MIN_BYTES) {
+		for (int y = 0; y < rows; ++y)
+			CopyRowNonTemporal(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+		// Make the streamed stores visible before anything else reads the memory.
+		_mm_sfence();
+		return;
+	}
+#endif
+
+	if (dstPitch == rowBytes && srcPitch == rowBytes) {
+		// Common case in God of War, let's do it all in one chunk.
+		memcpy(dst, src, rowBytes * rows);
+		return;
+	}
+	for (int y = 0; y < rows; ++y)
+		memcpy(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+}
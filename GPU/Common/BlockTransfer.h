@@ -0,0 +1,25 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Copies rows of rowBytes each between two pitched images, as a block transfer does.
+// Overlapping source and destination are fine (the copy behaves as if done row by row from the
+// side that doesn't overwrite unread data.) Large copies bypass the cache on SSE2.
+void CopyBlockRows(u8 *dst, int dstPitch, const u8 *src, int srcPitch, int rowBytes, int rows);
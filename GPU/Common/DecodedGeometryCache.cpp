@@ -0,0 +1,337 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "GPU/Common/DecodedGeometryCache.h"
+#include "GPU/Common/TextureDecoder.h"
+
+enum {
+	// Drawn by the GPU up to this many frames later.
+	GEOMETRY_FRAMES_IN_FLIGHT = 4,
+	GEOMETRY_DECIMATE_INTERVAL = 30,
+	GEOMETRY_KILL_AGE = 120,
+	GEOMETRY_UNRELIABLE_RETRY_AGE = 240,
+	GEOMETRY_REHASH_BYTES_PER_FRAME = 512 * 1024,
+};
+
+static inline u32 AlignUp16(u32 x) {
+	return (x + 15) & ~15;
+}
+
+DecodedGeometryCache::DecodedGeometryCache() : entryMap_(256), firstSeen_(256), blobMap_(256) {
+	for (int i = 0; i < NUM_SEGMENTS; i++) {
+		segments_[i].lastUsedFrame = -GEOMETRY_FRAMES_IN_FLIGHT - 1;
+		segments_[i].used = 0;
+	}
+}
+
+DecodedGeometryCache::~DecodedGeometryCache() {
+	Clear();
+	if (ring_)
+		FreeAlignedMemory(ring_);
+}
+
+u64 DecodedGeometryCache::HashSources(const std::vector<GeometrySource> &sources) {
+	u64 hash = 0;
+	for (const GeometrySource &src : sources) {
+		hash = hash * 31 + DoReliableHash64(src.ptr, src.size, 0x3A44B9C4);
+	}
+	return hash;
+}
+
+DecodedGeometryCache::Entry *DecodedGeometryCache::GetEntry(u64 key, int frame) {
+	Entry *entry = entryMap_.Get(key);
+	if (!entry) {
+		entry = new Entry();
+		entry->key = key;
+		entry->contentHash = 0;
+		entry->miniHash = 0;
+		entry->status = Status::NEW;
+		entry->hashFrame = -1;
+		entry->statusFrame = frame;
+		entry->blob = nullptr;
+		entry->index = (int)entries_.size();
+		entries_.push_back(entry);
+		entryMap_.Insert(key, entry);
+	}
+	entry->lastFrame = frame;
+	return entry;
+}
+
+void DecodedGeometryCache::ReleaseBlob(Entry *entry) {
+	Blob *blob = entry->blob;
+	if (!blob)
+		return;
+	// The blob stays in its segment until that's recycled, since other flushes may dedup to it.
+	auto it = std::find(blob->users.begin(), blob->users.end(), entry);
+	if (it != blob->users.end()) {
+		*it = blob->users.back();
+		blob->users.pop_back();
+	}
+	entry->blob = nullptr;
+}
+
+void DecodedGeometryCache::RemoveEntry(Entry *entry) {
+	ReleaseBlob(entry);
+	entryMap_.Remove(entry->key);
+	Entry *last = entries_.back();
+	entries_[entry->index] = last;
+	last->index = entry->index;
+	entries_.pop_back();
+	delete entry;
+}
+
+const CachedGeometry *DecodedGeometryCache::Lookup(u64 key, u32 miniHash, int frame) {
+	Entry *entry = entryMap_.Get(key);
+	if (!entry)
+		return nullptr;
+	entry->lastFrame = frame;
+	if (entry->status != Status::CACHED || !entry->blob)
+		return nullptr;
+	if (entry->miniHash != miniHash) {
+		// Changed under us - probably animated or streamed data, stop trying for a while.
+		ReleaseBlob(entry);
+		entry->status = Status::UNRELIABLE;
+		entry->statusFrame = frame;
+		return nullptr;
+	}
+	segments_[entry->blob->segment].lastUsedFrame = frame;
+	return &entry->blob->geom;
+}
+
+bool DecodedGeometryCache::NeedsContentHash(u64 key, int frame) {
+	Entry *entry = entryMap_.Get(key);
+	if (!entry) {
+		// Same key drawn twice in one frame doesn't tell us anything, and most keys seen
+		// for the first time are never seen again.
+		const int seenFrame = firstSeen_.Get(key);
+		if (seenFrame < 0) {
+			firstSeen_.Insert(key, frame);
+			return false;
+		}
+		if (seenFrame == frame)
+			return false;
+		firstSeen_.Remove(key);
+		GetEntry(key, frame);
+		return true;
+	}
+
+	entry->lastFrame = frame;
+	switch (entry->status) {
+	case Status::UNRELIABLE:
+		if (frame - entry->statusFrame < GEOMETRY_UNRELIABLE_RETRY_AGE)
+			return false;
+		entry->status = Status::NEW;
+		entry->hashFrame = -1;
+		return true;
+
+	case Status::CACHED:
+		// Lost its blob to a recycled segment.  Start over from the next frame.
+		ReleaseBlob(entry);
+		entry->status = Status::NEW;
+		entry->statusFrame = frame;
+		entry->hashFrame = -1;
+		return false;
+
+	case Status::NEW:
+	default:
+		if (entry->hashFrame == frame)
+			return false;
+		return entry->hashFrame >= 0 || entry->statusFrame != frame;
+	}
+}
+
+bool DecodedGeometryCache::ShouldStore(u64 key, u64 contentHash, u32 maxSize, int frame) {
+	Entry *entry = GetEntry(key, frame);
+	_dbg_assert_msg_(G3D, entry->status == Status::NEW, "ShouldStore() without NeedsContentHash()");
+	if (entry->hashFrame < 0) {
+		entry->contentHash = contentHash;
+		entry->hashFrame = frame;
+		return false;
+	}
+	if (entry->contentHash != contentHash) {
+		entry->status = Status::UNRELIABLE;
+		entry->statusFrame = frame;
+		return false;
+	}
+	if (maxSize > SEGMENT_SIZE || FindSegment(maxSize, frame) < 0) {
+		// Try again next frame.
+		entry->hashFrame = frame;
+		return false;
+	}
+	return true;
+}
+
+int DecodedGeometryCache::FindSegment(u32 size, int frame) const {
+	size = AlignUp16(size);
+	if (currentSegment_ >= 0 && segments_[currentSegment_].used + size <= SEGMENT_SIZE)
+		return currentSegment_;
+
+	// Recycle the least recently drawn segment, if the GPU is done with it.
+	int best = -1;
+	for (int i = 0; i < NUM_SEGMENTS; i++) {
+		if (i == currentSegment_ || segments_[i].lastUsedFrame >= frame - GEOMETRY_FRAMES_IN_FLIGHT)
+			continue;
+		if (best < 0 || segments_[i].lastUsedFrame < segments_[best].lastUsedFrame)
+			best = i;
+	}
+	return best;
+}
+
+u32 DecodedGeometryCache::Allocate(u32 size, int frame, int *segment) {
+	int seg = FindSegment(size, frame);
+	_dbg_assert_msg_(G3D, seg >= 0, "Geometry ring allocation without room");
+	if (seg != currentSegment_) {
+		ReclaimSegment(seg);
+		currentSegment_ = seg;
+	}
+	Segment &s = segments_[seg];
+	u32 offset = seg * SEGMENT_SIZE + s.used;
+	s.used += AlignUp16(size);
+	s.lastUsedFrame = frame;
+	*segment = seg;
+	return offset;
+}
+
+void DecodedGeometryCache::ReclaimSegment(int segment) {
+	Segment &s = segments_[segment];
+	for (Blob *blob : s.blobs) {
+		for (Entry *entry : blob->users) {
+			// Has to look the same for another frame before it's stored again.
+			entry->blob = nullptr;
+			entry->status = Status::NEW;
+			entry->hashFrame = -1;
+		}
+		blobMap_.Remove(blob->dedupKey);
+		delete blob;
+	}
+	s.blobs.clear();
+	s.used = 0;
+}
+
+const CachedGeometry *DecodedGeometryCache::Store(u64 key, u64 dedupKey, u32 miniHash, const std::vector<GeometrySource> &sources, const CachedGeometry &geom,
+		const u8 *verts, int vertsSize, const u16 *inds, int indsSize, int frame) {
+	Entry *entry = GetEntry(key, frame);
+	ReleaseBlob(entry);
+
+	Blob *blob = blobMap_.Get(dedupKey);
+	if (!blob) {
+		if (!ring_)
+			ring_ = (u8 *)AllocateAlignedMemory(RING_SIZE, 16);
+
+		const u32 indexStart = AlignUp16(vertsSize);
+		blob = new Blob();
+		blob->dedupKey = dedupKey;
+		blob->geom = geom;
+		const u32 offset = Allocate(indexStart + indsSize, frame, &blob->segment);
+		blob->geom.vertexOffset = offset;
+		blob->geom.indexOffset = offset + indexStart;
+		memcpy(ring_ + offset, verts, vertsSize);
+		if (indsSize)
+			memcpy(ring_ + offset + indexStart, inds, indsSize);
+
+		// Merge with the previous upload if contiguous, which is the common case.
+		const u32 size = AlignUp16(indexStart + indsSize);
+		if (!uploads_.empty() && uploads_.back().offset + uploads_.back().size == offset) {
+			uploads_.back().size += size;
+		} else {
+			uploads_.push_back({ offset, size });
+		}
+		segments_[blob->segment].blobs.push_back(blob);
+		blobMap_.Insert(dedupKey, blob);
+	}
+	segments_[blob->segment].lastUsedFrame = frame;
+
+	blob->users.push_back(entry);
+	entry->blob = blob;
+	entry->status = Status::CACHED;
+	entry->miniHash = miniHash;
+	entry->sources = sources;
+	return &blob->geom;
+}
+
+void DecodedGeometryCache::FlushUploads(const std::function<void(u32 offset, u32 size, const u8 *data)> &upload) {
+	for (const Upload &u : uploads_) {
+		upload(u.offset, u.size, ring_ + u.offset);
+	}
+	uploads_.clear();
+}
+
+void DecodedGeometryCache::Tick(int frame) {
+	if (frame - lastDecimateFrame_ >= GEOMETRY_DECIMATE_INTERVAL) {
+		lastDecimateFrame_ = frame;
+		for (size_t i = entries_.size(); i > 0; i--) {
+			Entry *entry = entries_[i - 1];
+			if (entry->lastFrame < frame - GEOMETRY_KILL_AGE)
+				RemoveEntry(entry);
+		}
+		std::vector<u64> stale;
+		firstSeen_.Iterate([&](u64 key, int seenFrame) {
+			if (seenFrame < frame - GEOMETRY_DECIMATE_INTERVAL)
+				stale.push_back(key);
+		});
+		for (u64 key : stale)
+			firstSeen_.Remove(key);
+		entryMap_.Maintain();
+		firstSeen_.Maintain();
+		blobMap_.Maintain();
+	}
+
+	// The mini hash only samples, so walk through the cached entries fully rehashing a few.
+	// The data is still in PSP memory so this is just as accurate as hashing on every draw.
+	u32 hashed = 0;
+	for (size_t visited = 0; visited < entries_.size() && hashed < GEOMETRY_REHASH_BYTES_PER_FRAME; visited++) {
+		if (rehashCursor_ >= entries_.size())
+			rehashCursor_ = 0;
+		Entry *entry = entries_[rehashCursor_++];
+		if (entry->status != Status::CACHED || !entry->blob)
+			continue;
+		for (const GeometrySource &src : entry->sources)
+			hashed += src.size;
+		u64 hash = HashSources(entry->sources);
+		if (hash != entry->contentHash) {
+			// Will be stored again if the new data stays put.
+			ReleaseBlob(entry);
+			entry->status = Status::NEW;
+			entry->contentHash = hash;
+			entry->hashFrame = frame;
+		}
+	}
+}
+
+void DecodedGeometryCache::Clear() {
+	for (Entry *entry : entries_)
+		delete entry;
+	entries_.clear();
+	entryMap_.Clear();
+	firstSeen_.Clear();
+	for (int i = 0; i < NUM_SEGMENTS; i++) {
+		for (Blob *blob : segments_[i].blobs)
+			delete blob;
+		segments_[i].blobs.clear();
+		// Keep lastUsedFrame, the GPU may still be drawing from the segment.
+		segments_[i].used = 0;
+	}
+	blobMap_.Clear();
+	uploads_.clear();
+	currentSegment_ = -1;
+	rehashCursor_ = 0;
+}
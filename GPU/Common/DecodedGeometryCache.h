@@ -0,0 +1,163 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hashmaps.h"
+
+// A range of PSP memory that a cached flush was decoded from.
+struct GeometrySource {
+	const u8 *ptr;
+	u32 size;
+};
+
+// Where a cached flush lives in the geometry ring, and how to draw it.
+struct CachedGeometry {
+	u32 vertexOffset;
+	// Only valid if useElements.
+	u32 indexOffset;
+	// Vertices (or indices, if useElements) to draw.
+	int vertexCount;
+	// Decoded vertices in the ring.
+	int numDecodedVerts;
+	u8 prim;
+	bool useElements;
+	bool vertexFullAlpha;
+};
+
+// Backend-neutral cache of decoded vertices and generated indices for flushes that stay the same
+// from frame to frame, which is most static geometry.
+//
+// Flushes are keyed by their draw calls (vertex and index addresses, vertex type, counts and so on)
+// and checked against a hash of the vertex and index data they read. Decoded data is deduplicated by
+// that content hash, so the same model drawn from two copies of the data is only stored once.
+//
+// The decoded data is kept in a ring that backends mirror into a single GPU buffer, uploading only
+// what was added (see FlushUploads()), so a cached flush needs neither decoding nor uploading.
+// The ring is split into segments that are recycled as a whole, once nothing in them has been
+// drawn for a few frames.
+//
+// Cached entries are fully rehashed in the background, a little every frame, since the cheap
+// per-draw check only samples the data.
+class DecodedGeometryCache {
+public:
+	DecodedGeometryCache();
+	~DecodedGeometryCache();
+
+	enum {
+		SEGMENT_SIZE = 1024 * 1024,
+		NUM_SEGMENTS = 8,
+		RING_SIZE = SEGMENT_SIZE * NUM_SEGMENTS,
+	};
+
+	// Returns the geometry for key if it's cached and the mini hash still matches.
+	const CachedGeometry *Lookup(u64 key, u32 miniHash, int frame);
+
+	// Call on a miss, before hashing the sources. Returns false if the flush can't be stored this
+	// time anyway (first sighting, drawn again in the same frame, or recently found unreliable), so
+	// the full content hash can be skipped.
+	bool NeedsContentHash(u64 key, int frame);
+
+	// Call after NeedsContentHash() returned true, with the full content hash. Returns true if the
+	// flush has now looked the same for two frames and there's room for maxSize bytes of decoded
+	// data, in which case it must be decoded and passed to Store() before the next call.
+	bool ShouldStore(u64 key, u64 contentHash, u32 maxSize, int frame);
+
+	// Copies decoded vertices and indices into the ring, or reuses an identical copy (same dedupKey.)
+	const CachedGeometry *Store(u64 key, u64 dedupKey, u32 miniHash, const std::vector<GeometrySource> &sources, const CachedGeometry &geom,
+		const u8 *verts, int vertsSize, const u16 *inds, int indsSize, int frame);
+
+	// Ring ranges written since the last call, for the backend to upload to its copy.
+	void FlushUploads(const std::function<void(u32 offset, u32 size, const u8 *data)> &upload);
+
+	// Decimation and incremental rehashing.  Called once per frame.
+	void Tick(int frame);
+
+	void Clear();
+
+	static u64 HashSources(const std::vector<GeometrySource> &sources);
+
+	int NumEntries() const { return (int)entries_.size(); }
+
+private:
+	struct Blob;
+
+	enum class Status : u8 {
+		NEW,
+		CACHED,
+		UNRELIABLE,
+	};
+
+	struct Entry {
+		u64 key;
+		u64 contentHash;
+		u32 miniHash;
+		Status status;
+		int lastFrame;
+		// Frame contentHash was taken in, or -1.
+		int hashFrame;
+		// Frame the entry became UNRELIABLE.
+		int statusFrame;
+		Blob *blob;
+		std::vector<GeometrySource> sources;
+		// Position in entries_.
+		int index;
+	};
+
+	struct Blob {
+		u64 dedupKey;
+		CachedGeometry geom;
+		int segment;
+		std::vector<Entry *> users;
+	};
+
+	struct Segment {
+		int lastUsedFrame;
+		u32 used;
+		std::vector<Blob *> blobs;
+	};
+
+	Entry *GetEntry(u64 key, int frame);
+	void RemoveEntry(Entry *entry);
+	void ReleaseBlob(Entry *entry);
+	int FindSegment(u32 size, int frame) const;
+	u32 Allocate(u32 size, int frame, int *segment);
+	void ReclaimSegment(int segment);
+
+	u8 *ring_ = nullptr;
+	Segment segments_[NUM_SEGMENTS];
+	int currentSegment_ = -1;
+
+	DenseHashMap<u64, Entry *, nullptr> entryMap_;
+	// Frame each key was first drawn in, until it's drawn in another frame and gets an Entry.
+	// Most keys are never seen again, so they don't get one.
+	DenseHashMap<u64, int, -1> firstSeen_;
+	DenseHashMap<u64, Blob *, nullptr> blobMap_;
+	std::vector<Entry *> entries_;
+	struct Upload {
+		u32 offset;
+		u32 size;
+	};
+	std::vector<Upload> uploads_;
+
+	size_t rehashCursor_ = 0;
+	int lastDecimateFrame_ = 0;
+};
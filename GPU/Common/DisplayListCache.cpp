@@ -0,0 +1,179 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/MemMap.h"
+#include "GPU/GPUCommon.h"
+#include "GPU/Common/DisplayListCache.h"
+#include "GPU/Common/TextureDecoder.h"
+
+enum {
+	DL_BLOCK_MAX_OPS = 256,
+	// Rebuilds within DL_REBUILD_WINDOW frames before giving up on a block.
+	DL_MAX_REBUILDS = 4,
+	DL_REBUILD_WINDOW = 60,
+	DL_UNCACHEABLE_RETRY_AGE = 300,
+	DL_DECIMATE_INTERVAL = 60,
+	DL_KILL_AGE = 120,
+};
+
+static const u32 DL_DROPPED = 0xFFFFFFFF;
+
+DisplayListCache::DisplayListCache() : blocks_(1024) {
+}
+
+DisplayListCache::~DisplayListCache() {
+	Clear();
+}
+
+void DisplayListCache::SetCommandFlags(const u64 flags[256]) {
+	memcpy(flags_, flags, sizeof(flags_));
+	Clear();
+}
+
+void DisplayListCache::Clear() {
+	blocks_.Iterate([&](u32 pc, DisplayListBlock *block) {
+		delete block;
+	});
+	blocks_.Clear();
+}
+
+void DisplayListCache::Decimate(int frame) {
+	if (frame - lastDecimateFrame_ < DL_DECIMATE_INTERVAL)
+		return;
+	lastDecimateFrame_ = frame;
+
+	const int threshold = frame - DL_KILL_AGE;
+	blocks_.Iterate([&](u32 pc, DisplayListBlock *block) {
+		if (block->lastFrame < threshold) {
+			blocks_.Remove(pc);
+			delete block;
+		}
+	});
+	blocks_.Maintain();
+}
+
+bool DisplayListCache::Build(DisplayListBlock *block, int maxOps) {
+	const int limit = std::min(maxOps, (int)DL_BLOCK_MAX_OPS);
+	if (limit <= 0 || !Memory::IsValidRange(block->startPC, limit * 4))
+		return false;
+	const u32 *ops = (const u32 *)Memory::GetPointerUnchecked(block->startPC);
+
+	// Last write to each register since anything that could read it.
+	int lastWrite[256];
+	memset(lastWrite, 0xFF, sizeof(lastWrite));
+
+	std::vector<DisplayListCommand> &commands = block->commands;
+	commands.clear();
+	int n = 0;
+	bool dropped = false;
+	while (n < limit) {
+		const u32 op = ops[n];
+		const u32 cmd = op >> 24;
+		const u64 flags = flags_[cmd];
+		commands.push_back({ op, (u32)n });
+		n++;
+
+		if (flags & FLAG_EXECUTE) {
+			// May draw, move the PC, or read ahead in the list - the block ends here.
+			break;
+		}
+		if (flags & FLAG_EXECUTEONCHANGE) {
+			// The handler may look at any register.
+			memset(lastWrite, 0xFF, sizeof(lastWrite));
+			continue;
+		}
+
+		// Nothing looked at the previous write, so only the last value matters. Flushing and
+		// dirtying for it happens before the next draw either way.
+		if (lastWrite[cmd] >= 0) {
+			commands[lastWrite[cmd]].index = DL_DROPPED;
+			dropped = true;
+		}
+		lastWrite[cmd] = (int)commands.size() - 1;
+	}
+
+	if (dropped) {
+		commands.erase(std::remove_if(commands.begin(), commands.end(), [](const DisplayListCommand &c) {
+			return c.index == DL_DROPPED;
+		}), commands.end());
+	}
+	block->numOps = n;
+	block->hash = DoReliableHash32(ops, n * 4, 0x4D4C5043);
+	block->validEpoch = epoch_;
+	return true;
+}
+
+const DisplayListBlock *DisplayListCache::Get(u32 pc, int maxOps, int frame) {
+	DisplayListBlock *block = blocks_.Get(pc);
+	if (!block) {
+		block = new DisplayListBlock();
+		block->startPC = pc;
+		block->lastFrame = frame;
+		block->buildFrame = frame;
+		block->rebuilds = 0;
+		block->uncacheable = false;
+		if (!Build(block, maxOps)) {
+			delete block;
+			return nullptr;
+		}
+		blocks_.Insert(pc, block);
+		return block;
+	}
+
+	block->lastFrame = frame;
+	if (block->uncacheable) {
+		if (frame - block->buildFrame < DL_UNCACHEABLE_RETRY_AGE)
+			return nullptr;
+		block->uncacheable = false;
+		block->rebuilds = 0;
+	} else if ((int)block->numOps <= maxOps) {
+		// Nothing could have written to it since it was last checked.
+		if (block->validEpoch == epoch_)
+			return block;
+
+		// Memory::IsValidRange was checked on build, and the range can't become invalid.
+		const u8 *ptr = Memory::GetPointerUnchecked(pc);
+		if (DoReliableHash32(ptr, block->numOps * 4, 0x4D4C5043) == block->hash) {
+			block->validEpoch = epoch_;
+			return block;
+		}
+
+		// Rewritten (or a different list built in the same place.)
+		if (frame - block->buildFrame > DL_REBUILD_WINDOW) {
+			block->rebuilds = 0;
+		}
+		if (++block->rebuilds > DL_MAX_REBUILDS) {
+			block->uncacheable = true;
+			block->buildFrame = frame;
+			block->commands.clear();
+			return nullptr;
+		}
+	}
+
+	// Either changed, or would run into the stall address as built. Maybe the list is still being
+	// written behind the stall address, so rebuild it for what's there now.
+	block->buildFrame = frame;
+	if (!Build(block, maxOps)) {
+		block->uncacheable = true;
+		block->commands.clear();
+		return nullptr;
+	}
+	return block;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hashmaps.h"
+
+struct DisplayListCommand {
+	u32 op;
+	// Position in the display list relative to the start of the block, in commands.
+	u32 index;
+};
+
+// A pre-decoded run of display list commands: state writes up to and including the next command
+// that executes something (like PRIM or JUMP.)  Writes that are overwritten before anything could
+// look at them are left out.
+struct DisplayListBlock {
+	u32 startPC;
+	// Commands covered in PSP memory, including the ones left out.
+	u32 numOps;
+	u32 hash;
+	int lastFrame;
+	int buildFrame;
+	int rebuilds;
+	// Epoch the hash was last checked in.
+	int validEpoch;
+	bool uncacheable;
+	std::vector<DisplayListCommand> commands;
+};
+
+// Caches DisplayListBlocks by address, for lists that games submit again every frame.
+// Blocks are checked against a hash of their memory before they're used, so a CALL or JUMP into
+// memory that has been written since just rebuilds the block (or stops caching it if that keeps
+// happening.)  The check is done once per epoch: Invalidate() must be called whenever PSP memory
+// may have changed, so sublists called many times in one run aren't rehashed every time.
+class DisplayListCache {
+public:
+	DisplayListCache();
+	~DisplayListCache();
+
+	// Flags for each command, as in GPUCommon's command table. Clears the cache.
+	void SetCommandFlags(const u64 flags[256]);
+
+	// Returns the block starting at pc, if there is one that's still valid and doesn't cover more
+	// than maxOps commands (the distance to the stall address.)
+	const DisplayListBlock *Get(u32 pc, int maxOps, int frame);
+
+	// Call when the CPU may have run, or the GE wrote to memory.
+	void Invalidate() {
+		epoch_++;
+	}
+
+	void Decimate(int frame);
+	void Clear();
+
+	int NumBlocks() const { return (int)blocks_.size(); }
+
+private:
+	bool Build(DisplayListBlock *block, int maxOps);
+
+	u64 flags_[256]{};
+	DenseHashMap<u32, DisplayListBlock *, nullptr> blocks_;
+	int lastDecimateFrame_ = 0;
+	int epoch_ = 0;
+};
@@ -19,7 +19,9 @@
 
 #include "profiler/profiler.h"
 #include "Common/ColorConv.h"
+#include "Common/ThreadPools.h"
 #include "Core/Config.h"
+#include "Core/DebugStatsTimer.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -90,10 +92,13 @@ int DrawEngineCommon::ComputeNumVertsToDecode() const {
 }
 
 void DrawEngineCommon::DecodeVerts(u8 *dest) {
+	DebugStatsTimer timer(&gpuStats.msDecodingVertices);
 	const UVScale origUV = gstate_c.uv;
-	for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
-		gstate_c.uv = drawCalls[decodeCounter_].uvScale;
-		DecodeVertsStep(dest, decodeCounter_, decodedVerts_);  // NOTE! DecodeVertsStep can modify decodeCounter_!
+	if (!DecodeVertsParallel(dest)) {
+		for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
+			gstate_c.uv = drawCalls[decodeCounter_].uvScale;
+			DecodeVertsStep(dest, decodeCounter_, decodedVerts_);  // NOTE! DecodeVertsStep can modify decodeCounter_!
+		}
 	}
 	gstate_c.uv = origUV;
 
@@ -105,6 +110,73 @@ void DrawEngineCommon::DecodeVerts(u8 *dest) {
 	}
 }
 
+bool DrawEngineCommon::DecodeVertsParallel(u8 *dest) {
+	if (decodeCounter_ >= numDrawCalls || vertexCountInDrawCalls_ < PARALLEL_DECODE_MIN_VERTS)
+		return false;
+	if (g_Config.iNumWorkerThreads <= 1 || !dec_->CanDecodeInParallel())
+		return false;
+
+	// The decoders read the UV scale from gstate_c, so it has to be the same for all of them.
+	const UVScale &uvScale = drawCalls[decodeCounter_].uvScale;
+	for (int i = decodeCounter_ + 1; i < numDrawCalls; i++) {
+		if (memcmp(&drawCalls[i].uvScale, &uvScale, sizeof(uvScale)) != 0)
+			return false;
+	}
+
+	PROFILE_THIS_SCOPE("vertdec");
+
+	// Figure out where everything goes first, that's cheap.
+	const int firstDecodedVert = decodedVerts_;
+	decodeRanges_.clear();
+	for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
+		DecodeRange range;
+		PlanDecodeRange(decodeCounter_, decodedVerts_, range);
+		decodeRanges_.push_back(range);
+	}
+
+	// Then split the vertex ranges so that large draws spread over several threads too.
+	decodeChunks_.clear();
+	for (int r = 0; r < (int)decodeRanges_.size(); r++) {
+		const DecodeRange &range = decodeRanges_[r];
+		if (!range.decode)
+			continue;
+		for (int lower = range.lowerBound; lower <= range.upperBound; lower += PARALLEL_DECODE_CHUNK_VERTS) {
+			decodeChunks_.push_back(DecodeChunk{ r, lower, std::min(lower + PARALLEL_DECODE_CHUNK_VERTS - 1, range.upperBound) });
+		}
+	}
+
+	gstate_c.uv = uvScale;
+	const int stride = dec_->GetDecVtxFmt().stride;
+	if (decodedVerts_ - firstDecodedVert < PARALLEL_DECODE_MIN_VERTS) {
+		// Lots of shared vertices, not worth it.
+		for (const DecodeChunk &chunk : decodeChunks_) {
+			const DecodeRange &range = decodeRanges_[chunk.range];
+			dec_->DecodeVerts(dest + (range.decodedVerts + chunk.lowerBound - range.lowerBound) * stride,
+				drawCalls[range.firstCall].verts, chunk.lowerBound, chunk.upperBound);
+		}
+		for (const DecodeRange &range : decodeRanges_)
+			GenerateIndices(range);
+		return true;
+	}
+
+	// Work item 0 generates all the indices (in order, IndexGenerator isn't thread safe), the rest
+	// decode one chunk each. That way the index translation overlaps with the decoding.
+	GlobalThreadPool::TiledLoop([&](int lower, int upper) {
+		for (int w = lower; w < upper; w++) {
+			if (w == 0) {
+				for (const DecodeRange &range : decodeRanges_)
+					GenerateIndices(range);
+				continue;
+			}
+			const DecodeChunk &chunk = decodeChunks_[w - 1];
+			const DecodeRange &range = decodeRanges_[chunk.range];
+			dec_->DecodeVerts(dest + (range.decodedVerts + chunk.lowerBound - range.lowerBound) * stride,
+				drawCalls[range.firstCall].verts, chunk.lowerBound, chunk.upperBound);
+		}
+	}, 0, (int)decodeChunks_.size() + 1, 1, true);
+	return true;
+}
+
 std::vector<std::string> DrawEngineCommon::DebugGetVertexLoaderIDs() {
 	std::vector<std::string> ids;
 	decoderMap_.Iterate([&](const uint32_t vtype, VertexDecoder *decoder) {
@@ -170,6 +242,7 @@ void DrawEngineCommon::Resized() {
 		delete decoder;
 	});
 	decoderMap_.Clear();
+	geometryCache_.Clear();
 	ClearTrackedVertexArrays();
 }
 
@@ -507,89 +580,107 @@ bool DrawEngineCommon::ApplyShaderBlending() {
 void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 	PROFILE_THIS_SCOPE("vertdec");
 
+	DecodeRange range;
+	PlanDecodeRange(i, decodedVerts, range);
+	if (range.decode) {
+		dec_->DecodeVerts(dest + range.decodedVerts * (int)dec_->GetDecVtxFmt().stride,
+			drawCalls[range.firstCall].verts, range.lowerBound, range.upperBound);
+	}
+	GenerateIndices(range);
+}
+
+void DrawEngineCommon::PlanDecodeRange(int &i, int &decodedVerts, DecodeRange &range) {
 	const DeferredDrawCall &dc = drawCalls[i];
 
-	indexGen.SetIndex(decodedVerts);
-	int indexLowerBound = dc.indexLowerBound;
-	int indexUpperBound = dc.indexUpperBound;
+	range.firstCall = i;
+	range.lastCall = i;
+	range.lowerBound = dc.indexLowerBound;
+	range.upperBound = dc.indexUpperBound;
+	range.decodedVerts = decodedVerts;
+	range.decode = true;
 
-	void *inds = dc.inds;
 	if (dc.indexType == GE_VTYPE_IDX_NONE >> GE_VTYPE_IDX_SHIFT) {
 		// Decode the verts and apply morphing. Simple.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
-			dc.verts, indexLowerBound, indexUpperBound);
-		decodedVerts += indexUpperBound - indexLowerBound + 1;
-		
-		bool clockwise = true;
-		if (dc.cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != dc.cullMode) {
-			clockwise = false;
-		}
-		indexGen.AddPrim(dc.prim, dc.vertexCount, clockwise);
+		decodedVerts += range.upperBound - range.lowerBound + 1;
 	} else {
 		// It's fairly common that games issue long sequences of PRIM calls, with differing
 		// inds pointer but the same base vertex pointer. We'd like to reuse vertices between
 		// these as much as possible, so we make sure here to combine as many as possible
 		// into one nice big drawcall, sharing data.
 
-		// 1. Look ahead to find the max index, only looking as "matching" drawcalls.
-		//    Expand the lower and upper bounds as we go.
-		int lastMatch = i;
+		// Look ahead to find the max index, only looking as "matching" drawcalls.
+		// Expand the lower and upper bounds as we go.
 		const int total = numDrawCalls;
 		for (int j = i + 1; j < total; ++j) {
 			if (drawCalls[j].verts != dc.verts)
 				break;
 
-			indexLowerBound = std::min(indexLowerBound, (int)drawCalls[j].indexLowerBound);
-			indexUpperBound = std::max(indexUpperBound, (int)drawCalls[j].indexUpperBound);
-			lastMatch = j;
-		}
-
-		// 2. Loop through the drawcalls, translating indices as we go.
-		switch (dc.indexType) {
-		case GE_VTYPE_IDX_8BIT >> GE_VTYPE_IDX_SHIFT:
-			for (int j = i; j <= lastMatch; j++) {
-				bool clockwise = true;
-				if (drawCalls[j].cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
-					clockwise = false;
-				}
-				indexGen.TranslatePrim(drawCalls[j].prim, drawCalls[j].vertexCount, (const u8 *)drawCalls[j].inds, indexLowerBound, clockwise);
-			}
-			break;
-		case GE_VTYPE_IDX_16BIT >> GE_VTYPE_IDX_SHIFT:
-			for (int j = i; j <= lastMatch; j++) {
-				bool clockwise = true;
-				if (drawCalls[j].cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
-					clockwise = false;
-				}
-				indexGen.TranslatePrim(drawCalls[j].prim, drawCalls[j].vertexCount, (const u16_le *)drawCalls[j].inds, indexLowerBound, clockwise);
-			}
-			break;
-		case GE_VTYPE_IDX_32BIT >> GE_VTYPE_IDX_SHIFT:
-			for (int j = i; j <= lastMatch; j++) {
-				bool clockwise = true;
-				if (drawCalls[j].cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
-					clockwise = false;
-				}
-				indexGen.TranslatePrim(drawCalls[j].prim, drawCalls[j].vertexCount, (const u32_le *)drawCalls[j].inds, indexLowerBound, clockwise);
-			}
-			break;
+			range.lowerBound = std::min(range.lowerBound, (int)drawCalls[j].indexLowerBound);
+			range.upperBound = std::max(range.upperBound, (int)drawCalls[j].indexUpperBound);
+			range.lastCall = j;
 		}
 
-		const int vertexCount = indexUpperBound - indexLowerBound + 1;
+		const int vertexCount = range.upperBound - range.lowerBound + 1;
 
 		// This check is a workaround for Pangya Fantasy Golf, which sends bogus index data when switching items in "My Room" sometimes.
+		// The indices are still translated, but nothing is decoded.
 		if (decodedVerts + vertexCount > VERTEX_BUFFER_MAX) {
+			range.decode = false;
 			return;
 		}
 
-		// 3. Decode that range of vertex data.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
-			dc.verts, indexLowerBound, indexUpperBound);
 		decodedVerts += vertexCount;
+		i = range.lastCall;
+	}
+}
+
+void DrawEngineCommon::GenerateIndices(const DecodeRange &range) {
+	const DeferredDrawCall &dc = drawCalls[range.firstCall];
 
-		// 4. Advance indexgen vertex counter.
-		indexGen.Advance(vertexCount);
-		i = lastMatch;
+	indexGen.SetIndex(range.decodedVerts);
+	if (dc.indexType == GE_VTYPE_IDX_NONE >> GE_VTYPE_IDX_SHIFT) {
+		bool clockwise = true;
+		if (dc.cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != dc.cullMode) {
+			clockwise = false;
+		}
+		indexGen.AddPrim(dc.prim, dc.vertexCount, clockwise);
+		return;
+	}
+
+	// Loop through the drawcalls, translating indices as we go.
+	switch (dc.indexType) {
+	case GE_VTYPE_IDX_8BIT >> GE_VTYPE_IDX_SHIFT:
+		for (int j = range.firstCall; j <= range.lastCall; j++) {
+			bool clockwise = true;
+			if (drawCalls[j].cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
+				clockwise = false;
+			}
+			indexGen.TranslatePrim(drawCalls[j].prim, drawCalls[j].vertexCount, (const u8 *)drawCalls[j].inds, range.lowerBound, clockwise);
+		}
+		break;
+	case GE_VTYPE_IDX_16BIT >> GE_VTYPE_IDX_SHIFT:
+		for (int j = range.firstCall; j <= range.lastCall; j++) {
+			bool clockwise = true;
+			if (drawCalls[j].cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
+				clockwise = false;
+			}
+			indexGen.TranslatePrim(drawCalls[j].prim, drawCalls[j].vertexCount, (const u16_le *)drawCalls[j].inds, range.lowerBound, clockwise);
+		}
+		break;
+	case GE_VTYPE_IDX_32BIT >> GE_VTYPE_IDX_SHIFT:
+		for (int j = range.firstCall; j <= range.lastCall; j++) {
+			bool clockwise = true;
+			if (drawCalls[j].cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != drawCalls[j].cullMode) {
+				clockwise = false;
+			}
+			indexGen.TranslatePrim(drawCalls[j].prim, drawCalls[j].vertexCount, (const u32_le *)drawCalls[j].inds, range.lowerBound, clockwise);
+		}
+		break;
+	}
+
+	// Advance indexgen vertex counter.
+	if (range.decode) {
+		indexGen.Advance(range.upperBound - range.lowerBound + 1);
 	}
 }
 
@@ -674,6 +765,125 @@ ReliableHashType DrawEngineCommon::ComputeHash() {
 	return fullhash;
 }
 
+// Identifies a flush by its draw calls, without looking at the data. Without the addresses, this is
+// everything besides the data that decides what the decoded vertices and indices look like.
+u64 DrawEngineCommon::ComputeGeometryKey(bool withAddresses) const {
+	struct DrawCallKey {
+		uintptr_t verts;
+		uintptr_t inds;
+		UVScale uvScale;
+		u32 vertexCount;
+		u16 indexLowerBound;
+		u16 indexUpperBound;
+		u8 indexType;
+		s8 prim;
+		u8 clockwise;
+		u8 sameVerts;
+	};
+
+	u64 hash = XXH64(&lastVType_, sizeof(lastVType_), numDrawCalls);
+	for (int i = 0; i < numDrawCalls; i++) {
+		const DeferredDrawCall &dc = drawCalls[i];
+		DrawCallKey key;
+		memset(&key, 0, sizeof(key));
+		if (withAddresses) {
+			key.verts = (uintptr_t)dc.verts;
+			key.inds = (uintptr_t)dc.inds;
+		}
+		key.uvScale = dc.uvScale;
+		key.vertexCount = dc.vertexCount;
+		key.indexLowerBound = dc.indexLowerBound;
+		key.indexUpperBound = dc.indexUpperBound;
+		key.indexType = dc.indexType;
+		key.prim = dc.prim;
+		key.clockwise = !(dc.cullMode != -1 && gstate.isCullEnabled() && gstate.getCullMode() != dc.cullMode);
+		// Decides how draw calls are merged.
+		key.sameVerts = i > 0 && drawCalls[i - 1].verts == dc.verts;
+		hash = XXH64(&key, sizeof(key), hash);
+	}
+	return hash;
+}
+
+// The PSP memory a flush decodes from, merged like DecodeVerts() does. Returns false if the flush
+// can't be cached.
+bool DrawEngineCommon::GatherGeometrySources(std::vector<GeometrySource> &sources) {
+	const int vertexSize = dec_->VertexSize();
+	const int indexSize = IndexSize(dec_->VertexType());
+
+	sources.clear();
+	int decodedVerts = 0;
+	for (int i = 0; i < numDrawCalls; i++) {
+		DecodeRange range;
+		PlanDecodeRange(i, decodedVerts, range);
+		if (!range.decode)
+			return false;
+		const DeferredDrawCall &dc = drawCalls[range.firstCall];
+		const int numVerts = range.upperBound - range.lowerBound + 1;
+		sources.push_back({ (const u8 *)dc.verts + range.lowerBound * vertexSize, (u32)(numVerts * vertexSize) });
+		if (dc.inds) {
+			for (int j = range.firstCall; j <= range.lastCall; j++) {
+				sources.push_back({ (const u8 *)drawCalls[j].inds, (u32)(drawCalls[j].vertexCount * indexSize) });
+			}
+		}
+	}
+	return true;
+}
+
+const CachedGeometry *DrawEngineCommon::DecodeVertsCached() {
+	// Morphing and software skinning depend on more than the vertex data, and through mode needs
+	// the texcoord bounds from decoding.
+	if (decodeCounter_ != 0 || (lastVType_ & (GE_VTYPE_MORPHCOUNT_MASK | GE_VTYPE_THROUGH_MASK)) != 0)
+		return nullptr;
+	if (g_Config.bSoftwareSkinning && (lastVType_ & GE_VTYPE_WEIGHT_MASK))
+		return nullptr;
+
+	const int frame = gpuStats.numFlips;
+	if (frame != geometryCacheFrame_) {
+		geometryCache_.Tick(frame);
+		geometryCacheFrame_ = frame;
+	}
+	gpuStats.numTrackedVertexArrays = geometryCache_.NumEntries();
+
+	const u64 key = ComputeGeometryKey(true);
+	const u32 miniHash = ComputeMiniHash();
+	const CachedGeometry *geom = geometryCache_.Lookup(key, miniHash, frame);
+	if (geom) {
+		// Nothing left to decode.
+		decodeCounter_ = numDrawCalls;
+		gstate_c.vertexFullAlpha = gstate_c.vertexFullAlpha && geom->vertexFullAlpha;
+		gpuStats.numCachedDrawCalls++;
+		gpuStats.numCachedVertsDrawn += geom->vertexCount;
+		return geom;
+	}
+
+	if (!geometryCache_.NeedsContentHash(key, frame))
+		return nullptr;
+	if (!GatherGeometrySources(geometrySources_))
+		return nullptr;
+	const u64 contentHash = DecodedGeometryCache::HashSources(geometrySources_);
+	// Strips and fans can turn into up to three indices per vertex.
+	const u32 maxSize = 16 + ComputeNumVertsToDecode() * dec_->GetDecVtxFmt().stride + vertexCountInDrawCalls_ * 3 * sizeof(u16);
+	if (!geometryCache_.ShouldStore(key, contentHash, maxSize, frame))
+		return nullptr;
+
+	DecodeVerts(decoded);
+	CachedGeometry newGeom{};
+	newGeom.numDecodedVerts = decodedVerts_;
+	newGeom.prim = indexGen.Prim();
+	newGeom.useElements = !indexGen.SeenOnlyPurePrims();
+	newGeom.vertexCount = indexGen.VertexCount();
+	if (!newGeom.useElements && indexGen.PureCount())
+		newGeom.vertexCount = indexGen.PureCount();
+	newGeom.vertexFullAlpha = gstate_c.vertexFullAlpha;
+	gpuStats.numUncachedVertsDrawn += indexGen.VertexCount();
+
+	// Flushes with the same data and the same draw calls decode to the same thing, wherever the data is.
+	const u64 dedupKey = XXH64(&contentHash, sizeof(contentHash), ComputeGeometryKey(false));
+	const int vertsSize = decodedVerts_ * (int)dec_->GetDecVtxFmt().stride;
+	const int indsSize = newGeom.useElements ? indexGen.VertexCount() * (int)sizeof(u16) : 0;
+	return geometryCache_.Store(key, dedupKey, miniHash, geometrySources_, newGeom, decoded, vertsSize, decIndex, indsSize, frame);
+}
+
 // vertTypeID is the vertex type but with the UVGen mode smashed into the top bits.
 void DrawEngineCommon::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim, int vertexCount, u32 vertTypeID, int cullMode, int *bytesRead) {
 	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
@@ -24,6 +24,7 @@
 #include "Common/Hashmaps.h"
 
 #include "GPU/GPUState.h"
+#include "GPU/Common/DecodedGeometryCache.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "GPU/Common/IndexGenerator.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -34,6 +35,10 @@ enum {
 	VERTEX_BUFFER_MAX = 65536,
 	DECODED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * 64,
 	DECODED_INDEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * 16,
+
+	// Flushes with fewer vertices than this are decoded on the GPU thread.
+	PARALLEL_DECODE_MIN_VERTS = 4096,
+	PARALLEL_DECODE_CHUNK_VERTS = 1024,
 };
 
 // Avoiding the full include of TextureDecoder.h.
@@ -112,9 +117,34 @@ class DrawEngineCommon {
 	u32 ComputeMiniHash();
 	ReliableHashType ComputeHash();
 
+	// Looks the flush up in geometryCache_, decoding and storing it if it has stayed the same.
+	// Returns nullptr if it should be decoded as usual, otherwise there's nothing left to decode.
+	const CachedGeometry *DecodeVertsCached();
+	u64 ComputeGeometryKey(bool withAddresses) const;
+	bool GatherGeometrySources(std::vector<GeometrySource> &sources);
+
 	// Vertex decoding
 	void DecodeVertsStep(u8 *dest, int &i, int &decodedVerts);
 
+	// A run of deferred draw calls that share vertex data, decoded as one range.
+	struct DecodeRange {
+		int firstCall;
+		int lastCall;
+		int lowerBound;
+		int upperBound;
+		// Where the range starts in the decoded buffer, in vertices.
+		int decodedVerts;
+		bool decode;
+	};
+	struct DecodeChunk {
+		int range;
+		int lowerBound;
+		int upperBound;
+	};
+	void PlanDecodeRange(int &i, int &decodedVerts, DecodeRange &range);
+	void GenerateIndices(const DecodeRange &range);
+	bool DecodeVertsParallel(u8 *dest);
+
 	bool ApplyShaderBlending();
 
 	inline int IndexSize(u32 vtype) const {
@@ -167,6 +197,13 @@ class DrawEngineCommon {
 	// Vertex collector state
 	IndexGenerator indexGen;
 	int decodedVerts_ = 0;
+	std::vector<DecodeRange> decodeRanges_;
+	std::vector<DecodeChunk> decodeChunks_;
+
+	// Decoded geometry that stays the same across frames. Backends mirror its ring on the GPU.
+	DecodedGeometryCache geometryCache_;
+	std::vector<GeometrySource> geometrySources_;
+	int geometryCacheFrame_ = -1;
 	GEPrimitiveType prevPrim_ = GE_PRIM_INVALID;
 
 	// Shader blending state
@@ -121,6 +121,7 @@ FramebufferManagerCommon::FramebufferManagerCommon(Draw::DrawContext *draw)
 }
 
 FramebufferManagerCommon::~FramebufferManagerCommon() {
+	DiscardPendingReadbacks();
 	DecimateFBOs();
 	for (auto vfb : vfbs_) {
 		DestroyFramebuf(vfb);
@@ -161,6 +162,8 @@ bool FramebufferManagerCommon::UpdateSize() {
 }
 
 void FramebufferManagerCommon::BeginFrame() {
+	FlushPendingUploads();
+	FinishPendingReadbacks();
 	DecimateFBOs();
 	currentRenderVfb_ = nullptr;
 }
@@ -519,6 +522,9 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 }
 
 void FramebufferManagerCommon::DestroyFramebuf(VirtualFramebuffer *v) {
+	pendingUploads_.erase(std::remove_if(pendingUploads_.begin(), pendingUploads_.end(), [=](const PendingUpload &upload) {
+		return upload.vfb == v;
+	}), pendingUploads_.end());
 	textureCache_->NotifyFramebuffer(v->fb_address, v, NOTIFY_FB_DESTROYED);
 	if (v->fbo) {
 		v->fbo->Release();
@@ -827,7 +833,8 @@ void FramebufferManagerCommon::DownloadFramebufferOnSwitch(VirtualFramebuffer *v
 		// To support this, we save the first frame to memory when we have a safe w/h.
 		// Saving each frame would be slow.
 		if (!g_Config.bDisableSlowFramebufEffects) {
-			ReadFramebufferToMemory(vfb, true, 0, 0, vfb->safeWidth, vfb->safeHeight);
+			// Only read back later as a texture, so this doesn't need to stall.
+			ReadFramebufferToMemory(vfb, false, 0, 0, vfb->safeWidth, vfb->safeHeight);
 			vfb->usageFlags = (vfb->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
 			vfb->firstFrameSaved = true;
 			vfb->safeWidth = 0;
@@ -842,6 +849,7 @@ void FramebufferManagerCommon::SetViewport2D(int x, int y, int w, int h) {
 }
 
 void FramebufferManagerCommon::CopyDisplayToOutput() {
+	FlushPendingUploads();
 	DownloadFramebufferOnSwitch(currentRenderVfb_);
 	shaderManager_->DirtyLastShader();
 
@@ -1092,8 +1100,7 @@ void FramebufferManagerCommon::DecimateFBOs() {
 		int age = frameLastFramebufUsed_ - std::max(vfb->last_frame_render, vfb->last_frame_used);
 
 		if (ShouldDownloadFramebuffer(vfb) && age == 0 && !vfb->memoryUpdated) {
-			bool sync = gl_extensions.IsGLES;
-			ReadFramebufferToMemory(vfb, sync, 0, 0, vfb->width, vfb->height);
+			ReadFramebufferToMemory(vfb, false, 0, 0, vfb->width, vfb->height);
 			vfb->usageFlags = (vfb->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
 		}
 
@@ -1229,6 +1236,12 @@ bool FramebufferManagerCommon::NotifyFramebufferCopy(u32 src, u32 dst, int size,
 	dst &= 0x3FFFFFFF;
 	src &= 0x3FFFFFFF;
 
+	// The copy reads this memory, so any downloads into it have to land first.
+	if (!isMemset)
+		FlushPendingReadbacks(src, size);
+	// And downloads landing after the copy would undo it.  A memset has already been done.
+	FlushPendingReadbacks(dst, size, isMemset);
+
 	VirtualFramebuffer *dstBuffer = 0;
 	VirtualFramebuffer *srcBuffer = 0;
 	u32 dstY = (u32)-1;
@@ -1600,6 +1613,9 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 		return false;
 	}
 
+	FlushPendingReadbacks(srcBasePtr + (srcY * srcStride + srcX) * bpp, ((height - 1) * srcStride + width) * bpp);
+	FlushPendingReadbacks(dstBasePtr + (dstY * dstStride + dstX) * bpp, ((height - 1) * dstStride + width) * bpp);
+
 	// Skip checking if there's no framebuffers in that area.
 	if (!MayIntersectFramebuffer(srcBasePtr) && !MayIntersectFramebuffer(dstBasePtr)) {
 		return false;
@@ -1683,6 +1699,8 @@ void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstS
 	}
 
 	if (MayIntersectFramebuffer(srcBasePtr) || MayIntersectFramebuffer(dstBasePtr)) {
+		// Before dstX and dstY are made relative to the framebuffer.
+		const u32 dstAddr = dstBasePtr + (dstX + dstY * dstStride) * bpp;
 		VirtualFramebuffer *dstBuffer = 0;
 		VirtualFramebuffer *srcBuffer = 0;
 		int srcWidth = width;
@@ -1698,11 +1716,10 @@ void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstS
 		if (dstBuffer && !srcBuffer) {
 			WARN_LOG_ONCE(btu, G3D, "Block transfer upload %08x -> %08x", srcBasePtr, dstBasePtr);
 			if (g_Config.bBlockTransferGPU) {
-				FlushBeforeCopy();
-				const u8 *srcBase = Memory::GetPointerUnchecked(srcBasePtr) + (srcX + srcY * srcStride) * bpp;
 				int dstBpp = dstBuffer->format == GE_FORMAT_8888 ? 4 : 2;
 				float dstXFactor = (float)bpp / dstBpp;
 				if (dstWidth > dstBuffer->width || dstHeight > dstBuffer->height) {
+					FlushBeforeCopy();
 					// The buffer isn't big enough, and we have a clear hint of size.  Resize.
 					// This happens in Valkyrie Profile when uploading video at the ending.
 					ResizeFramebufFBO(dstBuffer, dstWidth, dstHeight, false, true);
@@ -1712,15 +1729,58 @@ void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstS
 					dstBuffer->lastFrameNewSize = gpuStats.numFlips;
 					// Resizing may change the viewport/etc.
 					gstate_c.Dirty(DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_CULLRANGE);
+					RebindFramebuffer();
 				}
-				DrawPixels(dstBuffer, static_cast<int>(dstX * dstXFactor), dstY, srcBase, dstBuffer->format, static_cast<int>(srcStride * dstXFactor), static_cast<int>(dstWidth * dstXFactor), dstHeight);
+				// The transfer was already copied to the framebuffer's memory, so upload from there.
+				// That way, transfers into neighbouring rows can be drawn together.
+				QueueUpload(dstBuffer, dstAddr, static_cast<int>(dstStride * dstXFactor), static_cast<int>(dstX * dstXFactor), dstY, static_cast<int>(dstWidth * dstXFactor), dstHeight);
 				SetColorUpdated(dstBuffer, skipDrawReason);
-				RebindFramebuffer();
 			}
 		}
 	}
 }
 
+void FramebufferManagerCommon::QueueUpload(VirtualFramebuffer *vfb, u32 address, int stride, int x, int y, int w, int h) {
+	const int bpp = vfb->format == GE_FORMAT_8888 ? 4 : 2;
+	for (PendingUpload &upload : pendingUploads_) {
+		if (upload.vfb != vfb || upload.stride != stride)
+			continue;
+
+		const bool contains = x >= upload.x && y >= upload.y && x + w <= upload.x + upload.w && y + h <= upload.y + upload.h;
+		if (contains) {
+			// Already covered, the memory has the latest data anyway.
+			return;
+		}
+		// Merge overlapping or neighbouring rows of the same columns, like uploads split into strips.
+		if (x == upload.x && w == upload.w && y <= upload.y + upload.h && upload.y <= y + h) {
+			const int top = std::min(y, upload.y);
+			const int bottom = std::max(y + h, upload.y + upload.h);
+			upload.address -= (upload.y - top) * stride * bpp;
+			upload.y = top;
+			upload.h = bottom - top;
+			gpuStats.numMergedUploads++;
+			return;
+		}
+	}
+	pendingUploads_.push_back({ vfb, address, stride, x, y, w, h });
+}
+
+void FramebufferManagerCommon::FlushPendingUploads() {
+	if (pendingUploads_.empty())
+		return;
+
+	// DrawPixels may end up back here, so take the list first.
+	std::vector<PendingUpload> uploads;
+	uploads.swap(pendingUploads_);
+
+	// Anything drawn before the transfers has to land first.
+	drawEngine_->DispatchFlush();
+	for (const PendingUpload &upload : uploads) {
+		DrawPixels(upload.vfb, upload.x, upload.y, Memory::GetPointerUnchecked(upload.address), upload.vfb->format, upload.stride, upload.w, upload.h);
+	}
+	RebindFramebuffer();
+}
+
 void FramebufferManagerCommon::SetRenderSize(VirtualFramebuffer *vfb) {
 	float renderWidthFactor = renderWidth_ / 480.0f;
 	float renderHeightFactor = renderHeight_ / 272.0f;
@@ -2087,21 +2147,145 @@ void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int
 	gpuStats.numReadbacks++;
 }
 
+// Ignores the cache bits and VRAM mirrors, so ranges can be compared.
+static u32 NormalizeReadbackAddress(u32 addr) {
+	addr &= 0x3FFFFFFF;
+	if ((addr & 0x3F800000) == 0x04000000)
+		addr = 0x04000000 | (addr & 0x001FFFFF);
+	return addr;
+}
+
+void FramebufferManagerCommon::PackFramebufferAsync_(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+	Draw::AsyncReadback *readback = nullptr;
+	const u32 fb_address = (0x04000000) | vfb->fb_address;
+	const Draw::DataFormat destFormat = GEFormatToThin3D(vfb->format);
+	const int dstBpp = (int)DataFormatSizeInBytes(destFormat);
+	const u32 dstAddress = fb_address + (y * vfb->fb_stride + x) * dstBpp;
+	const u32 dstSize = ((h - 1) * vfb->fb_stride + w) * dstBpp;
+	if (vfb->fbo && w > 0 && h > 0 && Memory::IsValidRange(dstAddress, dstSize)) {
+		readback = draw_->CopyFramebufferToMemoryAsync(vfb->fbo, x, y, w, h, destFormat);
+	}
+	if (!readback) {
+		// Not supported by the backend (or bad inputs, which this will report.)
+		PackFramebufferSync_(vfb, x, y, w, h);
+		return;
+	}
+
+	DEBUG_LOG(G3D, "Queued async framebuffer download to %08x, %dx%d", dstAddress, w, h);
+	pendingReadbacks_.push_back({ readback, NormalizeReadbackAddress(dstAddress), dstSize, vfb->fb_stride, gpuStats.numFlips });
+
+	// Like the sync path, this ends the current render pass.
+	gstate_c.Dirty(DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_BLEND_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_RASTER_STATE);
+	gpuStats.numReadbacks++;
+}
+
+void FramebufferManagerCommon::FinishPendingReadbacks() {
+	const int maxLag = std::max(1, g_Config.iAsyncReadbackFrames);
+	size_t done = 0;
+	for (; done < pendingReadbacks_.size(); ++done) {
+		PendingReadback &pending = pendingReadbacks_[done];
+		const bool wait = gpuStats.numFlips - pending.frame >= maxLag;
+		if (!draw_->ReadAsyncReadback(pending.readback, wait, Memory::GetPointer(pending.address), pending.stride)) {
+			if (!wait) {
+				// Keep the order, later downloads may cover the same memory.
+				break;
+			}
+			ERROR_LOG(G3D, "Async framebuffer download to %08x failed", pending.address);
+		}
+		pending.readback->Release();
+	}
+	pendingReadbacks_.erase(pendingReadbacks_.begin(), pendingReadbacks_.begin() + done);
+}
+
+void FramebufferManagerCommon::FlushPendingReadbacks(u32 addr, u32 size, bool alreadyWritten) {
+	if (pendingReadbacks_.empty() || size == 0)
+		return;
+
+	addr = NormalizeReadbackAddress(addr);
+
+	// Only the last overlapping one matters, but everything before it has to land first.
+	size_t last = 0;
+	bool found = false;
+	for (size_t i = 0; i < pendingReadbacks_.size(); ++i) {
+		const PendingReadback &pending = pendingReadbacks_[i];
+		if (addr < pending.address + pending.size && pending.address < addr + size) {
+			last = i;
+			found = true;
+		}
+	}
+	if (!found)
+		return;
+
+	std::vector<u8> scratch;
+	for (size_t i = 0; i <= last; ++i) {
+		PendingReadback &pending = pendingReadbacks_[i];
+		u8 *dest = Memory::GetPointer(pending.address);
+		const bool overlaps = addr < pending.address + pending.size && pending.address < addr + size;
+		if (alreadyWritten && overlaps) {
+			// Land it in a copy (with the row gaps as they are now), then write back all but the range.
+			scratch.assign(dest, dest + pending.size);
+			if (draw_->ReadAsyncReadback(pending.readback, true, scratch.data(), pending.stride)) {
+				const u32 keepStart = std::max(addr, pending.address) - pending.address;
+				const u32 keepEnd = std::min(addr + size, pending.address + pending.size) - pending.address;
+				memcpy(dest, scratch.data(), keepStart);
+				memcpy(dest + keepEnd, scratch.data() + keepEnd, pending.size - keepEnd);
+			} else {
+				ERROR_LOG(G3D, "Async framebuffer download to %08x failed", pending.address);
+			}
+		} else if (!draw_->ReadAsyncReadback(pending.readback, true, dest, pending.stride)) {
+			ERROR_LOG(G3D, "Async framebuffer download to %08x failed", pending.address);
+		}
+		pending.readback->Release();
+	}
+	pendingReadbacks_.erase(pendingReadbacks_.begin(), pendingReadbacks_.begin() + last + 1);
+	gpuStats.numReadbackStalls++;
+}
+
+void FramebufferManagerCommon::FlushAllPendingReadbacks() {
+	for (PendingReadback &pending : pendingReadbacks_) {
+		if (!draw_->ReadAsyncReadback(pending.readback, true, Memory::GetPointer(pending.address), pending.stride)) {
+			ERROR_LOG(G3D, "Async framebuffer download to %08x failed", pending.address);
+		}
+		pending.readback->Release();
+	}
+	pendingReadbacks_.clear();
+}
+
+void FramebufferManagerCommon::DiscardPendingReadbacks() {
+	for (PendingReadback &pending : pendingReadbacks_) {
+		pending.readback->Release();
+	}
+	pendingReadbacks_.clear();
+}
+
 void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb, bool sync, int x, int y, int w, int h) {
 	// Clamp to bufferWidth. Sometimes block transfers can cause this to hit.
 	if (x + w >= vfb->bufferWidth) {
 		w = vfb->bufferWidth - x;
 	}
 	if (vfb && vfb->fbo) {
+		FlushPendingUploads();
+		const bool async = !sync && g_Config.iAsyncReadbackFrames > 0;
+		if (!async) {
+			// An older download landing after this one would undo it.
+			FlushPendingReadbacks(vfb->fb_address | 0x04000000, FramebufferByteSize(vfb));
+		}
+
 		// We'll pseudo-blit framebuffers here to get a resized version of vfb.
 		OptimizeDownloadRange(vfb, x, y, w, h);
 		if (vfb->renderWidth == vfb->width && vfb->renderHeight == vfb->height) {
 			// No need to blit
-			PackFramebufferSync_(vfb, x, y, w, h);
+			if (async)
+				PackFramebufferAsync_(vfb, x, y, w, h);
+			else
+				PackFramebufferSync_(vfb, x, y, w, h);
 		} else {
 			VirtualFramebuffer *nvfb = FindDownloadTempBuffer(vfb);
 			BlitFramebuffer(nvfb, x, y, vfb, x, y, w, h, 0);
-			PackFramebufferSync_(nvfb, x, y, w, h);
+			if (async)
+				PackFramebufferAsync_(nvfb, x, y, w, h);
+			else
+				PackFramebufferSync_(nvfb, x, y, w, h);
 		}
 
 		textureCache_->ForgetLastTexture();
@@ -2121,6 +2305,8 @@ void FramebufferManagerCommon::FlushBeforeCopy() {
 }
 
 void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 loadBytes) {
+	FlushPendingReadbacks(fb_address, loadBytes);
+
 	VirtualFramebuffer *vfb = GetVFBAt(fb_address);
 	if (vfb && vfb->fb_stride != 0) {
 		const u32 bpp = vfb->drawnFormat == GE_FORMAT_8888 ? 4 : 2;
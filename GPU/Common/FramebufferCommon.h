@@ -199,6 +199,8 @@ class FramebufferManagerCommon {
 
 	VirtualFramebuffer *DoSetRenderFrameBuffer(const FramebufferHeuristicParams &params, u32 skipDrawReason);	
 	VirtualFramebuffer *SetRenderFrameBuffer(bool framebufChanged, int skipDrawReason) {
+		if (!pendingUploads_.empty())
+			FlushPendingUploads();
 		// Inlining this part since it's so frequent.
 		if (!framebufChanged && currentRenderVfb_) {
 			currentRenderVfb_->last_frame_render = gpuStats.numFlips;
@@ -269,6 +271,15 @@ class FramebufferManagerCommon {
 	VirtualFramebuffer *GetCurrentRenderVFB() const {
 		return currentRenderVfb_;
 	}
+
+	// Waits for and writes any async downloads overlapping the range, before something reads or
+	// writes it.  If the range was already written (and so is newer than the downloads), pass
+	// alreadyWritten to leave it alone and only write the rest of them.
+	void FlushPendingReadbacks(u32 addr, u32 size, bool alreadyWritten = false);
+	// Waits for and writes all async downloads, like before saving a state.
+	void FlushAllPendingReadbacks();
+	// For when memory is about to be replaced anyway, like loading a state.
+	void DiscardPendingReadbacks();
 	// TODO: Break out into some form of FBO manager
 	VirtualFramebuffer *GetVFBAt(u32 addr);
 	VirtualFramebuffer *GetDisplayVFB() {
@@ -310,6 +321,12 @@ class FramebufferManagerCommon {
 
 protected:
 	virtual void PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h);
+	void PackFramebufferAsync_(VirtualFramebuffer *vfb, int x, int y, int w, int h);
+	// Writes finished async downloads to memory, and waits for any that have lagged too long.
+	void FinishPendingReadbacks();
+	// Block transfer uploads are queued and merged, then drawn before anything else uses framebuffers.
+	void QueueUpload(VirtualFramebuffer *vfb, u32 address, int stride, int x, int y, int w, int h);
+	void FlushPendingUploads();
 	virtual void SetViewport2D(int x, int y, int w, int h);
 	void CalculatePostShaderUniforms(int bufferWidth, int bufferHeight, int renderWidth, int renderHeight, PostShaderUniforms *uniforms);
 	virtual void MakePixelTexture(const u8 *srcPixels, GEBufferFormat srcPixelFormat, int srcStride, int width, int height, float &u1, float &v1) = 0;
@@ -419,6 +436,26 @@ class FramebufferManagerCommon {
 
 	std::vector<Draw::Framebuffer *> fbosToDelete_;
 
+	struct PendingReadback {
+		Draw::AsyncReadback *readback;
+		u32 address;
+		u32 size;
+		int stride;
+		int frame;
+	};
+	// In submission order, so later downloads of the same memory land last.
+	std::vector<PendingReadback> pendingReadbacks_;
+
+	struct PendingUpload {
+		VirtualFramebuffer *vfb;
+		// Of the top left pixel.  The transfer was already copied there, so this is the latest data.
+		u32 address;
+		// In framebuffer pixels, like x and w.
+		int stride;
+		int x, y, w, h;
+	};
+	std::vector<PendingUpload> pendingUploads_;
+
 	// Aggressively delete unused FBOs to save gpu memory.
 	enum {
 		FBO_OLD_AGE = 5,
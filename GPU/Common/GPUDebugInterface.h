@@ -161,6 +161,11 @@ struct GPUDebugBuffer {
 		return fmt_;
 	}
 
+	// In bytes, for stride * height pixels.
+	u32 GetDataSize() const {
+		return PixelSize(fmt_) * stride_ * height_;
+	}
+
 private:
 	u32 PixelSize(GPUDebugBufferFormat fmt) const;
 
@@ -18,15 +18,36 @@
 #include <string.h>
 #include <algorithm>
 
+#include "ppsspp_config.h"
 #include "profiler/profiler.h"
 
 #include "Common/CPUDetect.h"
+#include "Common/ThreadPools.h"
 
+#include "GPU/GPU.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"  // only needed for UVScale stuff
+#include "ext/xxhash.h"
+
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+enum {
+	// Surfaces with fewer vertices than this are tessellated on the GPU thread.
+	PARALLEL_TESS_MIN_VERTS = 2048,
+	PARALLEL_TESS_TILE_VERTS = 512,
+
+	TESS_CACHE_MAX_BYTES = 8 * 1024 * 1024,
+	TESS_CACHE_DECIMATE_INTERVAL = 30,
+	TESS_CACHE_KILL_AGE = 60,
+};
 
 bool CanUseHardwareTessellation(GEPatchPrimType prim) {
 	if (g_Config.bHardwareTessellation && !g_Config.bSoftwareRendering) {
@@ -285,6 +306,60 @@ class Spline3DWeight {
 WeightCache<Bezier3DWeight> Bezier3DWeight::weightsCache;
 WeightCache<Spline3DWeight> Spline3DWeight::weightsCache;
 
+// Linear combination of 4 consecutive points.
+// On SSE, Vec3f and Vec4f already use vector math.
+template<typename T>
+inline T SampleBasis(const T p[4], const float w[4]) {
+	return p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+}
+
+#if defined(_M_SSE)
+template<>
+inline Vec2f SampleBasis(const Vec2f p[4], const float w[4]) {
+	// Vec2f is padded to a full vector here, but has no SSE operators of its own.
+	__m128 res = _mm_mul_ps(p[0].vec, _mm_set1_ps(w[0]));
+	res = _mm_add_ps(res, _mm_mul_ps(p[1].vec, _mm_set1_ps(w[1])));
+	res = _mm_add_ps(res, _mm_mul_ps(p[2].vec, _mm_set1_ps(w[2])));
+	res = _mm_add_ps(res, _mm_mul_ps(p[3].vec, _mm_set1_ps(w[3])));
+	return Vec2f(res);
+}
+#elif PPSSPP_ARCH(ARM_NEON)
+template<>
+inline Vec2f SampleBasis(const Vec2f p[4], const float w[4]) {
+	float32x2_t res = vmul_n_f32(vld1_f32(p[0].AsArray()), w[0]);
+	res = vmla_n_f32(res, vld1_f32(p[1].AsArray()), w[1]);
+	res = vmla_n_f32(res, vld1_f32(p[2].AsArray()), w[2]);
+	res = vmla_n_f32(res, vld1_f32(p[3].AsArray()), w[3]);
+	Vec2f out;
+	vst1_f32(out.AsArray(), res);
+	return out;
+}
+
+template<>
+inline Vec3f SampleBasis(const Vec3f p[4], const float w[4]) {
+	// Without SSE, Vec3f is only 12 bytes, so do xy as a pair and z separately.
+	float32x2_t xy = vmul_n_f32(vld1_f32(p[0].AsArray()), w[0]);
+	xy = vmla_n_f32(xy, vld1_f32(p[1].AsArray()), w[1]);
+	xy = vmla_n_f32(xy, vld1_f32(p[2].AsArray()), w[2]);
+	xy = vmla_n_f32(xy, vld1_f32(p[3].AsArray()), w[3]);
+	Vec3f out;
+	vst1_f32(out.AsArray(), xy);
+	out.z = p[0].z * w[0] + p[1].z * w[1] + p[2].z * w[2] + p[3].z * w[3];
+	return out;
+}
+
+template<>
+inline Vec4f SampleBasis(const Vec4f p[4], const float w[4]) {
+	float32x4_t res = vmulq_n_f32(vld1q_f32(p[0].AsArray()), w[0]);
+	res = vmlaq_n_f32(res, vld1q_f32(p[1].AsArray()), w[1]);
+	res = vmlaq_n_f32(res, vld1q_f32(p[2].AsArray()), w[2]);
+	res = vmlaq_n_f32(res, vld1q_f32(p[3].AsArray()), w[3]);
+	Vec4f out;
+	vst1q_f32(out.AsArray(), res);
+	return out;
+}
+#endif
+
 // Tessellate single patch (4x4 control points)
 template<typename T>
 class Tessellator {
@@ -296,7 +371,7 @@ class Tessellator {
 
 	// Linear combination
 	T Sample(const T p[4], const float w[4]) {
-		return p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+		return SampleBasis(p, w);
 	}
 
 	void SampleEdgeU(int idx) {
@@ -338,81 +413,192 @@ void ControlPoints::Convert(const SimpleVertex *const *points, int size) {
 		col[i] = Vec4f::FromRGBA(points[i]->color_32);
 	}
 	defcolor = points[0]->color_32;
+	count = size;
+}
+
+// Keeps tessellated surfaces whose control points don't change, like terrain.
+// Only stored once the same surface is seen again, so animated surfaces aren't copied around.
+class TessellationCache {
+public:
+	~TessellationCache() {
+		Clear();
+	}
+
+	bool Lookup(u64 key, OutputBuffers &output, int numVerts, int frame);
+	void Store(u64 key, const OutputBuffers &output, int numVerts, int frame);
+	void Clear();
+
+private:
+	struct Entry {
+		std::vector<SimpleVertex> verts;
+		std::vector<u16> indices;
+		int lastFrame;
+		bool stored;
+	};
+
+	void Decimate(int frame);
+
+	std::unordered_map<u64, Entry> entries_;
+	size_t bytes_ = 0;
+	int lastDecimateFrame_ = 0;
+};
+
+bool TessellationCache::Lookup(u64 key, OutputBuffers &output, int numVerts, int frame) {
+	if (frame - lastDecimateFrame_ >= TESS_CACHE_DECIMATE_INTERVAL)
+		Decimate(frame);
+
+	auto it = entries_.find(key);
+	if (it == entries_.end() || !it->second.stored || (int)it->second.verts.size() != numVerts) {
+		return false;
+	}
+
+	Entry &entry = it->second;
+	entry.lastFrame = frame;
+	memcpy(output.vertices, entry.verts.data(), entry.verts.size() * sizeof(SimpleVertex));
+	memcpy(output.indices + output.count, entry.indices.data(), entry.indices.size() * sizeof(u16));
+	output.count += (int)entry.indices.size();
+	return true;
+}
+
+void TessellationCache::Store(u64 key, const OutputBuffers &output, int numVerts, int frame) {
+	auto it = entries_.find(key);
+	if (it == entries_.end()) {
+		Entry &entry = entries_[key];
+		entry.lastFrame = frame;
+		entry.stored = false;
+		return;
+	}
+
+	Entry &entry = it->second;
+	if (!entry.stored && entry.lastFrame != frame) {
+		size_t size = numVerts * sizeof(SimpleVertex) + output.count * sizeof(u16);
+		if (bytes_ + size <= TESS_CACHE_MAX_BYTES) {
+			entry.verts.assign(output.vertices, output.vertices + numVerts);
+			entry.indices.assign(output.indices, output.indices + output.count);
+			entry.stored = true;
+			bytes_ += size;
+		}
+	}
+	entry.lastFrame = frame;
+}
+
+void TessellationCache::Decimate(int frame) {
+	lastDecimateFrame_ = frame;
+	for (auto it = entries_.begin(); it != entries_.end(); ) {
+		if (it->second.lastFrame < frame - TESS_CACHE_KILL_AGE) {
+			bytes_ -= it->second.verts.size() * sizeof(SimpleVertex) + it->second.indices.size() * sizeof(u16);
+			it = entries_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void TessellationCache::Clear() {
+	entries_.clear();
+	bytes_ = 0;
+}
+
+static TessellationCache tessCache;
+
+static u64 TessellationKey(const SurfaceInfo &surface, u32 origVertType, const ControlPoints &points) {
+	const u32 params[] = {
+		(u32)surface.tess_u, (u32)surface.tess_v,
+		(u32)surface.num_points_u, (u32)surface.num_points_v,
+		(u32)surface.num_patches_u, (u32)surface.num_patches_v,
+		(u32)surface.type_u, (u32)surface.type_v,
+		(u32)surface.primType, (u32)surface.patchFacing,
+		origVertType & (GE_VTYPE_NRM_MASK | GE_VTYPE_COL_MASK | GE_VTYPE_TC_MASK),
+		points.defcolor,
+	};
+	const bool useTex = (origVertType & GE_VTYPE_TC_MASK) != 0;
+	const bool useCol = (origVertType & GE_VTYPE_COL_MASK) != 0;
+	u64 hash = XXH64(params, sizeof(params), 0);
+	for (int i = 0; i < points.count; ++i) {
+		// The Vec types may have padding, so only hash the components.
+		const float data[9] = {
+			points.pos[i].x, points.pos[i].y, points.pos[i].z,
+			useTex ? points.tex[i].x : 0.0f, useTex ? points.tex[i].y : 0.0f,
+			useCol ? points.col[i].x : 0.0f, useCol ? points.col[i].y : 0.0f, useCol ? points.col[i].z : 0.0f, useCol ? points.col[i].w : 0.0f,
+		};
+		hash = XXH64(data, sizeof(data), hash);
+	}
+	return hash;
 }
 
 template<class Surface>
 class SubdivisionSurface {
 public:
+	// Tessellates patches [firstPatch, lastPatch), numbered u-major.  Every output vertex belongs to
+	// exactly one patch, so ranges can run in parallel.
 	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
-	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, int firstPatch, int lastPatch) {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
+		for (int patch = firstPatch; patch < lastPatch; ++patch) {
+			const int patch_u = patch / surface.num_patches_v;
+			const int patch_v = patch % surface.num_patches_v;
 			const int start_u = surface.GetTessStart(patch_u);
-			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
-				const int start_v = surface.GetTessStart(patch_v);
-
-				// Prepare 4x4 control points to tessellate
-				const int idx = surface.GetPointIndex(patch_u, patch_v);
-				const int idx_v[4] = { idx, idx + surface.num_points_u, idx + surface.num_points_u * 2, idx + surface.num_points_u * 3 };
-				Tessellator<Vec3f> tess_pos(points.pos, idx_v);
-				Tessellator<Vec4f> tess_col(points.col, idx_v);
-				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
-				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
-
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
-
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
-
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
-
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
-
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
-						if (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
-						} else {
-							vert.color_32 = points.defcolor;
-						}
-						if (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
-						} else {
-							// Generate texcoord
-							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
-						}
-						if (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if (patchFacing)
-								vert.nrm *= -1.0f;
-						} else {
-							vert.nrm.SetZero();
-						}
+			const int start_v = surface.GetTessStart(patch_v);
+
+			// Prepare 4x4 control points to tessellate
+			const int idx = surface.GetPointIndex(patch_u, patch_v);
+			const int idx_v[4] = { idx, idx + surface.num_points_u, idx + surface.num_points_u * 2, idx + surface.num_points_u * 3 };
+			Tessellator<Vec3f> tess_pos(points.pos, idx_v);
+			Tessellator<Vec4f> tess_col(points.col, idx_v);
+			Tessellator<Vec2f> tess_tex(points.tex, idx_v);
+			Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
+
+			for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
+				const int index_u = surface.GetIndexU(patch_u, tile_u);
+				const Weight &wu = weights.u[index_u];
+
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
+
+				for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const Weight &wv = weights.v[index_v];
+
+					SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+
+					// Tessellate
+					vert.pos = tess_pos.SampleV(wv.basis);
+					if (sampleCol) {
+						vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+					} else {
+						vert.color_32 = points.defcolor;
+					}
+					if (sampleTex) {
+						tess_tex.SampleV(wv.basis).Write(vert.uv);
+					} else {
+						// Generate texcoord
+						vert.uv[0] = patch_u + tile_u * inv_u;
+						vert.uv[1] = patch_v + tile_v * inv_v;
+					}
+					if (sampleNrm) {
+						const Vec3f derivU = tess_nrm.SampleV(wv.basis);
+						const Vec3f derivV = tess_pos.SampleV(wv.deriv);
+
+						vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
+						if (patchFacing)
+							vert.nrm *= -1.0f;
+					} else {
+						vert.nrm.SetZero();
 					}
 				}
 			}
 		}
-
-		surface.BuildIndex(output.indices, output.count);
 	}
 
-	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &);
+	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &, int, int);
 	TEMPLATE_PARAMETER_DISPATCHER_FUNCTION(Tess, SubdivisionSurface::Tessellate, TessFunc);
 
 	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, u32 origVertType) {
@@ -426,18 +612,36 @@ class SubdivisionSurface {
 		static TemplateParameterDispatcher<TessFunc, ARRAY_SIZE(params), Tess> dispatcher; // Initialize only once
 
 		TessFunc func = dispatcher.GetFunc(params);
-		func(output, surface, points, weights);
+		const int numPatches = surface.num_patches_u * surface.num_patches_v;
+		if (surface.GetNumVertices() >= PARALLEL_TESS_MIN_VERTS && numPatches > 1 && g_Config.iNumWorkerThreads > 1) {
+			const int vertsPerPatch = (surface.tess_u + 1) * (surface.tess_v + 1);
+			const int tileSize = std::max(1, PARALLEL_TESS_TILE_VERTS / vertsPerPatch);
+			GlobalThreadPool::TiledLoop([&](int lower, int upper) {
+				func(output, surface, points, weights, lower, upper);
+			}, 0, numPatches, tileSize, true);
+		} else {
+			func(output, surface, points, weights, 0, numPatches);
+		}
+
+		surface.BuildIndex(output.indices, output.count);
 	}
 };
 
 template<class Surface>
 void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType, const ControlPoints &points) {
+	const int numVerts = surface.GetNumVertices();
+	const u64 cacheKey = TessellationKey(surface, origVertType, points);
+	const int frame = gpuStats.numFlips;
+	if (tessCache.Lookup(cacheKey, output, numVerts, frame))
+		return;
+
 	using WeightType = typename Surface::WeightType;
 	u32 key_u = WeightType::ToKey(surface.tess_u, surface.num_points_u, surface.type_u);
 	u32 key_v = WeightType::ToKey(surface.tess_v, surface.num_points_v, surface.type_v);
 	Weight2D weights(WeightType::weightsCache, key_u, key_v);
 
 	SubdivisionSurface<Surface>::Tessellate(output, surface, points, weights, origVertType);
+	tessCache.Store(cacheKey, output, numVerts, frame);
 }
 
 template<class Surface>
@@ -486,6 +690,7 @@ using namespace Spline;
 void DrawEngineCommon::ClearSplineBezierWeights() {
 	Bezier3DWeight::weightsCache.Clear();
 	Spline3DWeight::weightsCache.Clear();
+	tessCache.Clear();
 }
 
 void DrawEngineCommon::SubmitSpline(const void *control_points, const void *indices, int tess_u, int tess_v, int count_u, int count_v, int type_u, int type_v, GEPatchPrimType prim_type, bool computeNormals, bool patchFacing, u32 vertType, int *bytesRead) {
@@ -98,6 +98,7 @@ struct BezierSurface : public SurfaceInfo {
 	}
 
 	int GetTessStart(int patch) const { return 0; }
+	int GetNumVertices() const { return num_verts_per_patch * num_patches_u * num_patches_v; }
 
 	int GetPointIndex(int patch_u, int patch_v) const { return patch_v * 3 * num_points_u + patch_u * 3; }
 
@@ -136,6 +137,7 @@ struct SplineSurface : public SurfaceInfo {
 	}
 
 	int GetTessStart(int patch) const { return (patch == 0) ? 0 : 1; }
+	int GetNumVertices() const { return num_vertices_u * (num_patches_v * tess_v + 1); }
 
 	int GetPointIndex(int patch_u, int patch_v) const { return patch_v * num_points_u + patch_u; }
 
@@ -190,6 +192,7 @@ struct ControlPoints {
 	Vec2f *tex;
 	Vec4f *col;
 	u32_le defcolor;
+	int count;
 
 	ControlPoints() {}
 	ControlPoints(const SimpleVertex *const *points, int size, SimpleBufferManager &managedBuf);
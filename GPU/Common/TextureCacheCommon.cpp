@@ -20,11 +20,13 @@
 #include "Common/ColorConv.h"
 #include "Common/MemoryUtil.h"
 #include "Core/Config.h"
+#include "Core/DebugStatsTimer.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #include "GPU/Common/FramebufferCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/TextureScalerCommon.h"
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Debugger/Debugger.h"
@@ -57,6 +59,12 @@
 #define TEXCACHE_MIN_PRESSURE 16 * 1024 * 1024  // Total in VRAM
 #define TEXCACHE_SECOND_MIN_PRESSURE 4 * 1024 * 1024
 
+// Unused decode scratch buffers we keep around between frames.
+#define TEXCACHE_SCRATCH_MAX_CACHED 8 * 1024 * 1024
+
+// When the budget can't be met (everything left is in use), wait this many frames before retrying.
+#define TEXCACHE_BUDGET_RETRY_INTERVAL 10
+
 // Just for reference
 
 // PSP Color formats:
@@ -88,6 +96,7 @@ TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw)
 		lowMemoryMode_(false),
 		texelsScaledThisFrame_(0),
 		cacheSizeEstimate_(0),
+		secondCache_(false),
 		secondCacheSizeEstimate_(0),
 		nextTexture_(nullptr),
 		clutLastFormat_(0xFFFFFFFF),
@@ -97,6 +106,7 @@ TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw)
 		clutAlphaLinear_(false),
 		isBgraBackend_(false) {
 	decimationCounter_ = TEXCACHE_DECIMATION_INTERVAL;
+	budgetRetryCounter_ = 0;
 
 	// TODO: Clamp down to 256/1KB?  Need to check mipmapShareClut and clamp loadclut.
 	clutBufRaw_ = (u32 *)AllocateAlignedMemory(1024 * sizeof(u32), 16);  // 4KB
@@ -258,16 +268,13 @@ void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode)
 	// If the texture is >= 512 pixels tall...
 	if (entry->dim >= 0x900) {
 		if (entry->cluthash != 0 && entry->maxSeenV == 0) {
-			const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
-			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-			for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
+			cache_.IterateAddress(entry->addr, [&](u64 cachekey, TexCacheEntry *other) {
 				// They should all be the same, just make sure we take any that has already increased.
 				// This is for a new texture.
-				if (it->second->maxSeenV != 0) {
-					entry->maxSeenV = it->second->maxSeenV;
-					break;
+				if (other->maxSeenV != 0) {
+					entry->maxSeenV = other->maxSeenV;
 				}
-			}
+			});
 		}
 
 		// Texture scale/offset and gen modes don't apply in through.
@@ -291,11 +298,9 @@ void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode)
 		// We need to keep all CLUT variants in sync so we detect changes properly.
 		// See HandleTextureChange / STATUS_CLUT_RECHECK.
 		if (entry->cluthash != 0) {
-			const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
-			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-			for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
-				it->second->maxSeenV = entry->maxSeenV;
-			}
+			cache_.IterateAddress(entry->addr, [&](u64 cachekey, TexCacheEntry *other) {
+				other->maxSeenV = entry->maxSeenV;
+			});
 		}
 	}
 }
@@ -354,8 +359,7 @@ void TextureCacheCommon::SetTexture(bool force) {
 
 	u32 texhash = MiniHash((const u32 *)Memory::GetPointerUnchecked(texaddr));
 
-	TexCache::iterator iter = cache_.find(cachekey);
-	TexCacheEntry *entry = nullptr;
+	TexCacheEntry *entry = cache_.Get(cachekey);
 
 	// Note: It's necessary to reset needshadertexclamp, for otherwise DIRTY_TEXCLAMP won't get set later.
 	// Should probably revisit how this works..
@@ -366,8 +370,7 @@ void TextureCacheCommon::SetTexture(bool force) {
 	}
 	gstate_c.bgraTexture = isBgraBackend_;
 
-	if (iter != cache_.end()) {
-		entry = iter->second.get();
+	if (entry) {
 		// Validate the texture still matches the cache entry.
 		bool match = entry->Matches(dim, format, maxLevel);
 		const char *reason = "different params";
@@ -434,7 +437,7 @@ void TextureCacheCommon::SetTexture(bool force) {
 		}
 
 		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
-			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0 && !AsyncScalePending(entry)) {
 				// INFO_LOG(G3D, "Reloading texture to do the scaling we skipped..");
 				match = false;
 				reason = "scaling";
@@ -468,7 +471,7 @@ void TextureCacheCommon::SetTexture(bool force) {
 	} else {
 		VERBOSE_LOG(G3D, "No texture in cache, decoding...");
 		TexCacheEntry *entryNew = new TexCacheEntry{};
-		cache_[cachekey].reset(entryNew);
+		cache_.Insert(cachekey, entryNew);
 
 		if (hasClut && clutRenderAddress_ != 0xFFFFFFFF) {
 			WARN_LOG_REPORT_ONCE(clutUseRender, G3D, "Using texture with rendered CLUT: texfmt=%d, clutfmt=%d", gstate.getTextureFormat(), gstate.getClutPaletteFormat());
@@ -482,18 +485,15 @@ void TextureCacheCommon::SetTexture(bool force) {
 		}
 
 		if (hasClut && clutRenderAddress_ == 0xFFFFFFFF) {
-			const u64 cachekeyMin = (u64)(texaddr & 0x3FFFFFFF) << 32;
-			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-
 			int found = 0;
-			for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
+			cache_.IterateAddress(texaddr, [&](u64 cachekey, TexCacheEntry *other) {
 				found++;
-			}
+			});
 
 			if (found >= TEXTURE_CLUT_VARIANTS_MIN) {
-				for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
-					it->second->status |= TexCacheEntry::STATUS_CLUT_VARIANTS;
-				}
+				cache_.IterateAddress(texaddr, [&](u64 cachekey, TexCacheEntry *other) {
+					other->status |= TexCacheEntry::STATUS_CLUT_VARIANTS;
+				});
 
 				entry->status |= TexCacheEntry::STATUS_CLUT_VARIANTS;
 			}
@@ -540,6 +540,11 @@ void TextureCacheCommon::SetTexture(bool force) {
 
 // Removes old textures.
 void TextureCacheCommon::Decimate(bool forcePressure) {
+	// The hard budget is checked every frame, the age based decimation below only every so often.
+	if (g_Config.iTexCacheBudgetMB > 0) {
+		DecimateToBudget((u64)g_Config.iTexCacheBudgetMB * 1024 * 1024);
+	}
+
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = TEXCACHE_DECIMATION_INTERVAL;
 	} else {
@@ -551,15 +556,18 @@ void TextureCacheCommon::Decimate(bool forcePressure) {
 
 		ForgetLastTexture();
 		int killAgeBase = lowMemoryMode_ ? TEXTURE_KILL_AGE_LOWMEM : TEXTURE_KILL_AGE;
-		for (TexCache::iterator iter = cache_.begin(); iter != cache_.end(); ) {
-			bool hasClut = (iter->second->status & TexCacheEntry::STATUS_CLUT_VARIANTS) != 0;
+		std::vector<u64> toDelete;
+		cache_.Iterate([&](u64 cachekey, TexCacheEntry *entry) {
+			bool hasClut = (entry->status & TexCacheEntry::STATUS_CLUT_VARIANTS) != 0;
 			int killAge = hasClut ? TEXTURE_KILL_AGE_CLUT : killAgeBase;
-			if (iter->second->lastFrame + killAge < gpuStats.numFlips) {
-				DeleteTexture(iter++);
-			} else {
-				++iter;
+			if (entry->lastFrame + killAge < gpuStats.numFlips) {
+				toDelete.push_back(cachekey);
 			}
+		});
+		for (u64 cachekey : toDelete) {
+			DeleteTexture(cachekey);
 		}
+		cache_.Maintain();
 
 		VERBOSE_LOG(G3D, "Decimated texture cache, saved %d estimated bytes - now %d bytes", had - cacheSizeEstimate_, cacheSizeEstimate_);
 	}
@@ -568,21 +576,89 @@ void TextureCacheCommon::Decimate(bool forcePressure) {
 	if (g_Config.bTextureSecondaryCache && (forcePressure || secondCacheSizeEstimate_ >= TEXCACHE_SECOND_MIN_PRESSURE)) {
 		const u32 had = secondCacheSizeEstimate_;
 
-		for (TexCache::iterator iter = secondCache_.begin(); iter != secondCache_.end(); ) {
+		std::vector<u64> toDelete;
+		secondCache_.Iterate([&](u64 secondKey, TexCacheEntry *entry) {
 			// In low memory mode, we kill them all since secondary cache is disabled.
-			if (lowMemoryMode_ || iter->second->lastFrame + TEXTURE_SECOND_KILL_AGE < gpuStats.numFlips) {
-				ReleaseTexture(iter->second.get(), true);
-				secondCacheSizeEstimate_ -= EstimateTexMemoryUsage(iter->second.get());
-				secondCache_.erase(iter++);
-			} else {
-				++iter;
+			if (lowMemoryMode_ || entry->lastFrame + TEXTURE_SECOND_KILL_AGE < gpuStats.numFlips) {
+				toDelete.push_back(secondKey);
 			}
+		});
+		for (u64 secondKey : toDelete) {
+			TexCacheEntry *entry = secondCache_.Get(secondKey);
+			ReleaseTexture(entry, true);
+			secondCacheSizeEstimate_ -= EstimateTexMemoryUsage(entry);
+			secondCache_.Erase(secondKey);
 		}
+		secondCache_.Maintain();
 
 		VERBOSE_LOG(G3D, "Decimated second texture cache, saved %d estimated bytes - now %d bytes", had - secondCacheSizeEstimate_, secondCacheSizeEstimate_);
 	}
 
 	DecimateVideos();
+	scratchPool_.Trim(lowMemoryMode_ ? 0 : TEXCACHE_SCRATCH_MAX_CACHED);
+}
+
+// Evicts least recently used textures until the estimate fits the budget.
+// Textures used this frame are kept even if that means we stay over.
+void TextureCacheCommon::DecimateToBudget(u64 budget) {
+	if (cacheSizeEstimate_ + secondCacheSizeEstimate_ <= budget) {
+		budgetRetryCounter_ = 0;
+		return;
+	}
+	// Last time we couldn't get under, don't sort everything again each frame.
+	if (budgetRetryCounter_ > 0) {
+		--budgetRetryCounter_;
+		return;
+	}
+
+	// Pairs of (lastFrame, key), sorted oldest first.  The secondary cache is only a fallback, so it goes first.
+	std::vector<std::pair<int, u64>> secondCandidates;
+	secondCache_.Iterate([&](u64 secondKey, TexCacheEntry *entry) {
+		secondCandidates.push_back(std::make_pair(entry->lastFrame, secondKey));
+	});
+	std::vector<std::pair<int, u64>> candidates;
+	cache_.Iterate([&](u64 cachekey, TexCacheEntry *entry) {
+		// Framebuffer textures aren't part of the estimate, and current ones must stay.
+		if (!entry->framebuffer && entry->lastFrame != gpuStats.numFlips && entry != nextTexture_) {
+			candidates.push_back(std::make_pair(entry->lastFrame, cachekey));
+		}
+	});
+	if (secondCandidates.empty() && candidates.empty()) {
+		budgetRetryCounter_ = TEXCACHE_BUDGET_RETRY_INTERVAL;
+		return;
+	}
+
+	const u32 had = cacheSizeEstimate_ + secondCacheSizeEstimate_;
+	ForgetLastTexture();
+
+	std::sort(secondCandidates.begin(), secondCandidates.end());
+	for (const auto &candidate : secondCandidates) {
+		if (cacheSizeEstimate_ + secondCacheSizeEstimate_ <= budget) {
+			break;
+		}
+		TexCacheEntry *entry = secondCache_.Get(candidate.second);
+		ReleaseTexture(entry, true);
+		secondCacheSizeEstimate_ -= EstimateTexMemoryUsage(entry);
+		secondCache_.Erase(candidate.second);
+	}
+	secondCache_.Maintain();
+
+	if (cacheSizeEstimate_ + secondCacheSizeEstimate_ > budget) {
+		std::sort(candidates.begin(), candidates.end());
+		for (const auto &candidate : candidates) {
+			if (cacheSizeEstimate_ + secondCacheSizeEstimate_ <= budget) {
+				break;
+			}
+			DeleteTexture(candidate.second);
+		}
+		cache_.Maintain();
+	}
+
+	if (cacheSizeEstimate_ + secondCacheSizeEstimate_ > budget) {
+		budgetRetryCounter_ = TEXCACHE_BUDGET_RETRY_INTERVAL;
+	}
+
+	VERBOSE_LOG(G3D, "Decimated texture cache to budget, saved %d estimated bytes - now %d bytes", had - (cacheSizeEstimate_ + secondCacheSizeEstimate_), cacheSizeEstimate_ + secondCacheSizeEstimate_);
 }
 
 void TextureCacheCommon::DecimateVideos() {
@@ -614,13 +690,11 @@ void TextureCacheCommon::HandleTextureChange(TexCacheEntry *const entry, const c
 
 	// Also, mark any textures with the same address but different clut.  They need rechecking.
 	if (entry->cluthash != 0) {
-		const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
-		const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-		for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
-			if (it->second->cluthash != entry->cluthash) {
-				it->second->status |= TexCacheEntry::STATUS_CLUT_RECHECK;
+		cache_.IterateAddress(entry->addr, [&](u64 cachekey, TexCacheEntry *other) {
+			if (other->cluthash != entry->cluthash) {
+				other->status |= TexCacheEntry::STATUS_CLUT_RECHECK;
 			}
-		}
+		});
 	}
 
 	entry->status |= TexCacheEntry::STATUS_UNRELIABLE;
@@ -639,14 +713,12 @@ void TextureCacheCommon::NotifyFramebuffer(u32 address, VirtualFramebuffer *fram
 	// These checks are mainly to reduce scanning all textures.
 	const u32 addr = (address | 0x04000000) & 0x3F9FFFFF;
 	const u32 bpp = framebuffer->format == GE_FORMAT_8888 ? 4 : 2;
-	const u64 cacheKey = (u64)addr << 32;
-	// If it has a clut, those are the low 32 bits, so it'll be inside this range.
-	// Also, if it's a subsample of the buffer, it'll also be within the FBO.
-	const u64 cacheKeyEnd = cacheKey + ((u64)(framebuffer->fb_stride * framebuffer->height * bpp) << 32);
+	// If it's a subsample of the buffer, it'll also be within the FBO.
+	const u32 addrEnd = addr + framebuffer->fb_stride * framebuffer->height * bpp;
 
 	// The first mirror starts at 0x04200000 and there are 3.  We search all for framebuffers.
-	const u64 mirrorCacheKey = (u64)0x04200000 << 32;
-	const u64 mirrorCacheKeyEnd = (u64)0x04800000 << 32;
+	const u32 mirrorAddr = 0x04200000;
+	const u32 mirrorAddrEnd = 0x04800000;
 
 	switch (msg) {
 	case NOTIFY_FB_CREATED:
@@ -655,17 +727,17 @@ void TextureCacheCommon::NotifyFramebuffer(u32 address, VirtualFramebuffer *fram
 		if (std::find(fbCache_.begin(), fbCache_.end(), framebuffer) == fbCache_.end()) {
 			fbCache_.push_back(framebuffer);
 		}
-		for (auto it = cache_.lower_bound(cacheKey), end = cache_.upper_bound(cacheKeyEnd); it != end; ++it) {
-			AttachFramebuffer(it->second.get(), addr, framebuffer);
-		}
+		cache_.IterateRange(addr, addrEnd, [&](u64 cachekey, TexCacheEntry *entry) {
+			AttachFramebuffer(entry, addr, framebuffer);
+		});
 		// Let's assume anything in mirrors is fair game to check.
-		for (auto it = cache_.lower_bound(mirrorCacheKey), end = cache_.upper_bound(mirrorCacheKeyEnd); it != end; ++it) {
-			const u64 mirrorlessKey = it->first & ~0x0060000000000000ULL;
+		cache_.IterateRange(mirrorAddr, mirrorAddrEnd, [&](u64 cachekey, TexCacheEntry *entry) {
+			const u32 mirrorlessAddr = (u32)(cachekey >> 32) & ~0x00600000;
 			// Let's still make sure it's in the cache range.
-			if (mirrorlessKey >= cacheKey && mirrorlessKey <= cacheKeyEnd) {
-				AttachFramebuffer(it->second.get(), addr, framebuffer);
+			if (mirrorlessAddr >= addr && mirrorlessAddr <= addrEnd) {
+				AttachFramebuffer(entry, addr, framebuffer);
 			}
-		}
+		});
 		break;
 
 	case NOTIFY_FB_DESTROYED:
@@ -678,7 +750,10 @@ void TextureCacheCommon::NotifyFramebuffer(u32 address, VirtualFramebuffer *fram
 			// We might erase, so move to the next one already (which won't become invalid.)
 			++it;
 
-			DetachFramebuffer(cache_[cachekey].get(), addr, framebuffer);
+			TexCacheEntry *entry = cache_.Get(cachekey);
+			if (entry) {
+				DetachFramebuffer(entry, addr, framebuffer);
+			}
 		}
 		break;
 	}
@@ -911,11 +986,10 @@ bool TextureCacheCommon::SetOffsetTexture(u32 offset) {
 
 	const u16 dim = gstate.getTextureDimension(0);
 	u64 cachekey = TexCacheEntry::CacheKey(texaddr, gstate.getTextureFormat(), dim, 0);
-	TexCache::iterator iter = cache_.find(cachekey);
-	if (iter == cache_.end()) {
+	TexCacheEntry *entry = cache_.Get(cachekey);
+	if (!entry) {
 		return false;
 	}
-	TexCacheEntry *entry = iter->second.get();
 
 	bool success = false;
 	for (size_t i = 0, n = fbCache_.size(); i < n; ++i) {
@@ -1501,10 +1575,17 @@ void TextureCacheCommon::ApplyTexture() {
 	if (entry == nullptr) {
 		return;
 	}
+	DebugStatsTimer timer(&gpuStats.msDecodingTextures);
 	nextTexture_ = nullptr;
 
 	UpdateMaxSeenV(entry, gstate.isModeThrough());
 
+	if ((nextNeedsRebuild_ || nextNeedsRehash_) && !entry->framebuffer) {
+		// Hashing and decoding read RAM, so framebuffer downloads into it must land first.
+		const u32 bytes = (textureBitsPerPixel[entry->format] * entry->bufw * gstate.getTextureHeight(0)) / 8;
+		framebufferManager_->FlushPendingReadbacks(entry->addr, bytes);
+	}
+
 	if (nextNeedsRebuild_) {
 		// Regardless of hash fails or otherwise, if this is a video, mark it frequently changing.
 		// This prevents temporary scaling perf hits on the first second of video.
@@ -1560,13 +1641,13 @@ void TextureCacheCommon::ApplyTexture() {
 
 void TextureCacheCommon::Clear(bool delete_them) {
 	ForgetLastTexture();
-	for (TexCache::iterator iter = cache_.begin(); iter != cache_.end(); ++iter) {
-		ReleaseTexture(iter->second.get(), delete_them);
-	}
+	cache_.Iterate([&](u64 cachekey, TexCacheEntry *entry) {
+		ReleaseTexture(entry, delete_them);
+	});
 	// In case the setting was changed, we ALWAYS clear the secondary cache (enabled or not.)
-	for (TexCache::iterator iter = secondCache_.begin(); iter != secondCache_.end(); ++iter) {
-		ReleaseTexture(iter->second.get(), delete_them);
-	}
+	secondCache_.Iterate([&](u64 secondKey, TexCacheEntry *entry) {
+		ReleaseTexture(entry, delete_them);
+	});
 	if (cache_.size() + secondCache_.size()) {
 		INFO_LOG(G3D, "Texture cached cleared from %i textures", (int)(cache_.size() + secondCache_.size()));
 		cache_.clear();
@@ -1576,16 +1657,20 @@ void TextureCacheCommon::Clear(bool delete_them) {
 	}
 	fbTexInfo_.clear();
 	videos_.clear();
+	if (asyncScaler_) {
+		asyncScaler_->Clear();
+	}
 }
 
-void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
-	ReleaseTexture(it->second.get(), true);
-	auto fbInfo = fbTexInfo_.find(it->first);
+void TextureCacheCommon::DeleteTexture(u64 cachekey) {
+	TexCacheEntry *entry = cache_.Get(cachekey);
+	ReleaseTexture(entry, true);
+	auto fbInfo = fbTexInfo_.find(cachekey);
 	if (fbInfo != fbTexInfo_.end()) {
 		fbTexInfo_.erase(fbInfo);
 	}
-	cacheSizeEstimate_ -= EstimateTexMemoryUsage(it->second.get());
-	cache_.erase(it);
+	cacheSizeEstimate_ -= EstimateTexMemoryUsage(entry);
+	cache_.Erase(cachekey);
 }
 
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
@@ -1621,10 +1706,9 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 		if (entry->numInvalidated > 2 && entry->numInvalidated < 128 && !lowMemoryMode_) {
 			// We have a new hash: look for that hash in the secondary cache.
 			u64 secondKey = fullhash | (u64)entry->cluthash << 32;
-			TexCache::iterator secondIter = secondCache_.find(secondKey);
-			if (secondIter != secondCache_.end()) {
+			TexCacheEntry *secondEntry = secondCache_.Get(secondKey);
+			if (secondEntry) {
 				// Found it, but does it match our current params?  If not, abort.
-				TexCacheEntry *secondEntry = secondIter->second.get();
 				if (secondEntry->Matches(entry->dim, entry->format, entry->maxLevel)) {
 					// Reset the numInvalidated value lower, we got a match.
 					if (entry->numInvalidated > 8) {
@@ -1642,14 +1726,16 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 				secondCacheSizeEstimate_ += EstimateTexMemoryUsage(entry);
 
 				// If the entry already exists in the secondary texture cache, drop it nicely.
-				auto oldIter = secondCache_.find(secondKey);
-				if (oldIter != secondCache_.end()) {
-					ReleaseTexture(oldIter->second.get(), true);
+				TexCacheEntry *oldEntry = secondCache_.Get(secondKey);
+				if (oldEntry) {
+					ReleaseTexture(oldEntry, true);
+					secondCache_.Erase(secondKey);
 				}
 
 				// Archive the entire texture entry as is, since we'll use its params if it is seen again.
 				// We keep parameters on the current entry, since we are STILL building a new texture here.
-				secondCache_[secondKey].reset(new TexCacheEntry(*entry));
+				secondCache_.Insert(secondKey, new TexCacheEntry(*entry));
+				secondCache_.Maintain();
 
 				// Make sure we don't delete the texture we just archived.
 				entry->texturePtr = nullptr;
@@ -1670,6 +1756,9 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 	addr &= 0x3FFFFFFF;
 	const u32 addr_end = addr + size;
 
+	// The range was written after any downloads into it were queued, so they mustn't land over it.
+	framebufferManager_->FlushPendingReadbacks(addr, size, true);
+
 	if (type == GPU_INVALIDATE_ALL) {
 		// This is an active signal from the game that something in the texture cache may have changed.
 		gstate_c.Dirty(DIRTY_TEXTURE_IMAGE);
@@ -1686,37 +1775,37 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 		return;
 	}
 
-	const u64 startKey = (u64)(addr - LARGEST_TEXTURE_SIZE) << 32;
-	u64 endKey = (u64)(addr + size + LARGEST_TEXTURE_SIZE) << 32;
-	if (endKey < startKey) {
-		endKey = (u64)-1;
+	const u32 startAddr = addr > (u32)LARGEST_TEXTURE_SIZE ? addr - LARGEST_TEXTURE_SIZE : 0;
+	u32 endAddr = addr + size + LARGEST_TEXTURE_SIZE;
+	if (endAddr < addr) {
+		endAddr = 0xFFFFFFFF;
 	}
 
-	for (TexCache::iterator iter = cache_.lower_bound(startKey), end = cache_.upper_bound(endKey); iter != end; ++iter) {
-		u32 texAddr = iter->second->addr;
-		u32 texEnd = iter->second->addr + iter->second->sizeInRAM;
+	cache_.IterateRange(startAddr, endAddr, [&](u64 cachekey, TexCacheEntry *entry) {
+		u32 texAddr = entry->addr;
+		u32 texEnd = entry->addr + entry->sizeInRAM;
 
 		if (texAddr < addr_end && addr < texEnd) {
-			if (iter->second->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
-				iter->second->SetHashStatus(TexCacheEntry::STATUS_HASHING);
+			if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
+				entry->SetHashStatus(TexCacheEntry::STATUS_HASHING);
 			}
 			if (type != GPU_INVALIDATE_ALL) {
 				gpuStats.numTextureInvalidations++;
 				// Start it over from 0 (unless it's safe.)
-				iter->second->numFrames = type == GPU_INVALIDATE_SAFE ? 256 : 0;
+				entry->numFrames = type == GPU_INVALIDATE_SAFE ? 256 : 0;
 				if (type == GPU_INVALIDATE_SAFE) {
-					u32 diff = gpuStats.numFlips - iter->second->lastFrame;
+					u32 diff = gpuStats.numFlips - entry->lastFrame;
 					// We still need to mark if the texture is frequently changing, even if it's safely changing.
 					if (diff < TEXCACHE_FRAME_CHANGE_FREQUENT) {
-						iter->second->status |= TexCacheEntry::STATUS_CHANGE_FREQUENT;
+						entry->status |= TexCacheEntry::STATUS_CHANGE_FREQUENT;
 					}
 				}
-				iter->second->framesUntilNextFullHash = 0;
-			} else if (!iter->second->framebuffer) {
-				iter->second->invalidHint++;
+				entry->framesUntilNextFullHash = 0;
+			} else if (!entry->framebuffer) {
+				entry->invalidHint++;
 			}
 		}
-	}
+	});
 }
 
 void TextureCacheCommon::InvalidateAll(GPUInvalidationType /*unused*/) {
@@ -1730,16 +1819,133 @@ void TextureCacheCommon::InvalidateAll(GPUInvalidationType /*unused*/) {
 	}
 	timesInvalidatedAllThisFrame_++;
 
-	for (TexCache::iterator iter = cache_.begin(), end = cache_.end(); iter != end; ++iter) {
-		if (iter->second->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
-			iter->second->SetHashStatus(TexCacheEntry::STATUS_HASHING);
+	cache_.Iterate([&](u64 cachekey, TexCacheEntry *entry) {
+		if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
+			entry->SetHashStatus(TexCacheEntry::STATUS_HASHING);
+		}
+		if (!entry->framebuffer) {
+			entry->invalidHint++;
+		}
+	});
+}
+
+int TextureCacheCommon::ScaleFactorForBuild(TexCacheEntry *entry, int scaleFactor, int w, int h) {
+	asyncScaleFactor_ = 0;
+	if (scaleFactor == 1) {
+		return 1;
+	}
+
+	if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0) {
+		// Remember for later that we /wanted/ to scale this texture.
+		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
+		return 1;
+	}
+
+	if (asyncScaler_ && g_Config.bTexScalingAsync) {
+		if (asyncScaler_->IsReady(entry->CacheKey(), entry->fullhash)) {
+			entry->status &= ~TexCacheEntry::STATUS_TO_SCALE;
+			entry->status |= TexCacheEntry::STATUS_IS_SCALED;
+			return scaleFactor;
 		}
-		if (!iter->second->framebuffer) {
-			iter->second->invalidHint++;
+
+		// Upload it unscaled for now, that's our placeholder until the worker is done.
+		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
+		if (texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED && !asyncScaler_->IsQueued(entry->CacheKey(), entry->fullhash) && !asyncScaler_->IsFull()) {
+			asyncScaleFactor_ = scaleFactor;
 		}
+		return 1;
 	}
+
+	if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED) {
+		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
+		return 1;
+	}
+
+	entry->status &= ~TexCacheEntry::STATUS_TO_SCALE;
+	entry->status |= TexCacheEntry::STATUS_IS_SCALED;
+	texelsScaledThisFrame_ += w * h;
+	return scaleFactor;
+}
+
+void TextureCacheCommon::QueueAsyncScale(TexCacheEntry &entry, const u8 *pixels, int pitch, u32 fmt, int w, int h, int bpp) {
+	if (asyncScaleFactor_ <= 1) {
+		return;
+	}
+
+	// Still counts against the budget, since copying and scaling large textures isn't free.
+	// If the queue was full, we paid for the rebuild anyway.  The entry stays STATUS_TO_SCALE,
+	// and AsyncScalePending() holds off the retry until the worker has made room.
+	asyncScaler_->Queue(entry.CacheKey(), entry.fullhash, pixels, pitch, fmt, w, h, bpp, asyncScaleFactor_);
+	texelsScaledThisFrame_ += w * h;
+	asyncScaleFactor_ = 0;
+}
+
+void TextureCacheCommon::ScaleLevel(TextureScalerCommon &scaler, TexCacheEntry &entry, u32 *out, u32 *src, u32 &dstFmt, int &w, int &h, int factor) {
+	if (asyncScaler_ && asyncScaler_->Take(entry.CacheKey(), entry.fullhash, factor, out, dstFmt, w, h)) {
+		return;
+	}
+	scaler.ScaleAlways(out, src, dstFmt, w, h, factor);
+}
+
+bool TextureCacheCommon::AsyncScaleReady(TexCacheEntry &entry, int factor, int w, int h) {
+	return factor > 1 && asyncScaler_ && asyncScaler_->CanTake(entry.CacheKey(), entry.fullhash, factor, w, h);
+}
+
+bool TextureCacheCommon::AsyncScalePending(TexCacheEntry *entry) {
+	if (!asyncScaler_ || !g_Config.bTexScalingAsync) {
+		return false;
+	}
+	// If it was never queued (or the result expired), rebuild so it gets queued - but only once it can be.
+	u64 cachekey = entry->CacheKey();
+	if (asyncScaler_->IsReady(cachekey, entry->fullhash)) {
+		return false;
+	}
+	return asyncScaler_->IsQueued(cachekey, entry->fullhash) || asyncScaler_->IsFull();
 }
 
 void TextureCacheCommon::ClearNextFrame() {
 	clearCacheNextFrame_ = true;
 }
+
+void TexCache::Insert(u64 cachekey, TexCacheEntry *entry) {
+	entries_.Insert(cachekey, entry);
+	if (addressIndex_) {
+		std::vector<u64> &keys = pages_[(u32)(cachekey >> 32) >> PAGE_SHIFT];
+		entry->pageSlot = (u32)keys.size();
+		keys.push_back(cachekey);
+	}
+}
+
+void TexCache::Erase(u64 cachekey) {
+	TexCacheEntry *entry = entries_.Get(cachekey);
+	if (!entry) {
+		return;
+	}
+	const u32 slot = entry->pageSlot;
+	entries_.Remove(cachekey);
+	delete entry;
+
+	if (addressIndex_) {
+		auto bucket = pages_.find((u32)(cachekey >> 32) >> PAGE_SHIFT);
+		if (bucket != pages_.end()) {
+			std::vector<u64> &keys = bucket->second;
+			_dbg_assert_msg_(G3D, slot < keys.size() && keys[slot] == cachekey, "Texture cache page index out of sync");
+			if (slot + 1 < keys.size()) {
+				keys[slot] = keys.back();
+				entries_.Get(keys[slot])->pageSlot = slot;
+			}
+			keys.pop_back();
+			if (keys.empty()) {
+				pages_.erase(bucket);
+			}
+		}
+	}
+}
+
+void TexCache::clear() {
+	entries_.Iterate([](u64 cachekey, TexCacheEntry *entry) {
+		delete entry;
+	});
+	entries_.Clear();
+	pages_.clear();
+}
@@ -18,15 +18,19 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
 #include "Common/CommonTypes.h"
+#include "Common/Hashmaps.h"
 #include "Common/MemoryUtil.h"
 #include "Core/TextureReplacer.h"
 #include "Core/System.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/TextureScalerAsync.h"
+#include "GPU/Common/TextureScratchPool.h"
 
 enum TextureFiltering {
 	TEX_FILTER_AUTO = 1,
@@ -147,6 +151,8 @@ struct TexCacheEntry {
 	u32 fullhash;
 	u32 cluthash;
 	u16 maxSeenV;
+	// Where TexCache keeps our key in its page bucket, so erasing doesn't search for it.
+	u32 pageSlot;
 
 	TexStatus GetHashStatus() {
 		return TexStatus(status & STATUS_MASK);
@@ -172,10 +178,87 @@ struct TexCacheEntry {
 	static u64 CacheKey(u32 addr, u8 format, u16 dim, u32 cluthash);
 };
 
+// Owns texture cache entries by cache key.  Exact lookups (every SetTexture) go through an
+// open addressed hash map, while range queries by address (invalidation, framebuffer attachment,
+// CLUT variants) use a separate index of keys bucketed by address page.
+class TexCache {
+public:
+	// Without the address index, IterateRange falls back to a full scan (for hash keyed caches.)
+	explicit TexCache(bool addressIndex = true) : entries_(1024), addressIndex_(addressIndex) {}
+	~TexCache() {
+		clear();
+	}
+
+	TexCacheEntry *Get(u64 cachekey) {
+		return entries_.Get(cachekey);
+	}
+	// Takes ownership.  The key must not already be present.
+	void Insert(u64 cachekey, TexCacheEntry *entry);
+	// Deletes the entry, so release its texture first.
+	void Erase(u64 cachekey);
+	void clear();
+	void Maintain() {
+		entries_.Maintain();
+	}
+
+	size_t size() const {
+		return entries_.size();
+	}
+
+	// func(u64 cachekey, TexCacheEntry *entry).  Must not insert or erase.
+	template <typename F>
+	void Iterate(F func) const {
+		entries_.Iterate(func);
+	}
+
+	// Visits entries whose address (the top half of the key) is within [startAddr, endAddr].
+	// func(u64 cachekey, TexCacheEntry *entry).  Must not insert or erase.
+	template <typename F>
+	void IterateRange(u32 startAddr, u32 endAddr, F func) const {
+		const u32 startPage = startAddr >> PAGE_SHIFT;
+		const u32 endPage = endAddr >> PAGE_SHIFT;
+		if (!addressIndex_ || endPage - startPage >= (u32)pages_.size()) {
+			// Fewer buckets than pages in the range, scanning them all is cheaper.
+			entries_.Iterate([&](u64 cachekey, TexCacheEntry *entry) {
+				const u32 addr = (u32)(cachekey >> 32);
+				if (addr >= startAddr && addr <= endAddr) {
+					func(cachekey, entry);
+				}
+			});
+			return;
+		}
+		for (u32 page = startPage; page <= endPage; ++page) {
+			auto bucket = pages_.find(page);
+			if (bucket == pages_.end()) {
+				continue;
+			}
+			for (u64 cachekey : bucket->second) {
+				const u32 addr = (u32)(cachekey >> 32);
+				if (addr >= startAddr && addr <= endAddr) {
+					func(cachekey, entries_.Get(cachekey));
+				}
+			}
+		}
+	}
+
+	// Entries with this address, i.e. all CLUT variants of the same texture.
+	template <typename F>
+	void IterateAddress(u32 addr, F func) const {
+		addr &= 0x3FFFFFFF;
+		IterateRange(addr, addr, func);
+	}
+
+private:
+	// 64KB pages.  Most games keep textures in a few MB, so this keeps buckets short.
+	enum { PAGE_SHIFT = 16 };
+
+	// Get() isn't const on DenseHashMap, but doesn't modify.
+	mutable DenseHashMap<u64, TexCacheEntry *, nullptr> entries_;
+	std::unordered_map<u32, std::vector<u64>> pages_;
+	bool addressIndex_;
+};
+
 class FramebufferManagerCommon;
-// Can't be unordered_map, we use lower_bound ... although for some reason that compiles on MSVC.
-// Would really like to replace this with DenseHashMap but can't as long as we need lower_bound.
-typedef std::map<u64, std::unique_ptr<TexCacheEntry>> TexCache;
 
 class TextureCacheCommon {
 public:
@@ -219,8 +302,9 @@ class TextureCacheCommon {
 	virtual void BindTexture(TexCacheEntry *entry) = 0;
 	virtual void Unbind() = 0;
 	virtual void ReleaseTexture(TexCacheEntry *entry, bool delete_them) = 0;
-	void DeleteTexture(TexCache::iterator it);
+	void DeleteTexture(u64 cachekey);
 	void Decimate(bool forcePressure = false);
+	void DecimateToBudget(u64 budget);
 
 	virtual void ApplyTextureFramebuffer(TexCacheEntry *entry, VirtualFramebuffer *framebuffer) = 0;
 	void HandleTextureChange(TexCacheEntry *const entry, const char *reason, bool initialMatch, bool doDelete);
@@ -228,6 +312,16 @@ class TextureCacheCommon {
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
 
+	// Decides the scale factor to build the entry at, deferring or queueing the scaling as needed.
+	int ScaleFactorForBuild(TexCacheEntry *entry, int scaleFactor, int w, int h);
+	// Hands the first decoded level to the async scaler, if ScaleFactorForBuild asked for it.
+	void QueueAsyncScale(TexCacheEntry &entry, const u8 *pixels, int pitch, u32 fmt, int w, int h, int bpp);
+	// Uses a finished async result when there is one, otherwise scales inline.
+	void ScaleLevel(TextureScalerCommon &scaler, TexCacheEntry &entry, u32 *out, u32 *src, u32 &dstFmt, int &w, int &h, int factor);
+	// Whether ScaleLevel() will use a finished async result, so the level needn't be decoded again.
+	bool AsyncScaleReady(TexCacheEntry &entry, int factor, int w, int h);
+	bool AsyncScalePending(TexCacheEntry *entry);
+
 	// Separate to keep main texture cache size down.
 	struct AttachedFramebufferInfo {
 		u32 xOffset;
@@ -288,6 +382,7 @@ class TextureCacheCommon {
 	bool lowMemoryMode_;
 
 	int decimationCounter_;
+	int budgetRetryCounter_;
 	int texelsScaledThisFrame_;
 	int timesInvalidatedAllThisFrame_;
 
@@ -305,6 +400,13 @@ class TextureCacheCommon {
 	SimpleBuf<u32> tmpTexBuf32_;
 	SimpleBuf<u16> tmpTexBuf16_;
 	SimpleBuf<u32> tmpTexBufRearrange_;
+	// For short lived per-level decode and upload buffers.
+	TextureScratchPool scratchPool_;
+
+	// Created by the backends, since it needs a scaler producing their formats.
+	std::unique_ptr<TextureScalerAsync> asyncScaler_;
+	// Scale factor to queue the next decoded level at, or 0.
+	int asyncScaleFactor_ = 0;
 
 	TexCacheEntry *nextTexture_;
 
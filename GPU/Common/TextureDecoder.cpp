@@ -24,6 +24,7 @@
 #include "GPU/Common/TextureDecoder.h"
 // NEON is in a separate file so that it can be compiled with a runtime check.
 #include "GPU/Common/TextureDecoderNEON.h"
+#include "GPU/Common/TextureDecoderAVX2.h"
 
 // TODO: Move some common things into here.
 
@@ -307,6 +308,10 @@ void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32
 	}
 }
 
+#ifdef _M_SSE
+UnswizzleTex16Func DoUnswizzleTex16 = &DoUnswizzleTex16Basic;
+#endif
+
 #if !PPSSPP_ARCH(ARM64) && !defined(_M_SSE)
 QuickTexHashFunc DoQuickTexHash = &QuickTexHashBasic;
 QuickTexHashFunc StableQuickTexHash = &QuickTexHashNonSSE;
@@ -317,6 +322,13 @@ ReliableHash64Func DoReliableHash64 = &XXH64;
 
 // This has to be done after CPUDetect has done its magic.
 void SetupTextureDecoder() {
+#ifdef _M_SSE
+	// QuickTexHash stays SSE2: its lanes form one serial chain, so wider vectors don't help,
+	// and the result must not change.
+	if (cpu_info.bAVX2) {
+		DoUnswizzleTex16 = &DoUnswizzleTex16AVX2;
+	}
+#endif
 #if PPSSPP_ARCH(ARM_NEON) && !PPSSPP_ARCH(ARM64)
 	if (cpu_info.bNEON) {
 		DoQuickTexHash = &QuickTexHashNEON;
@@ -613,6 +625,9 @@ CheckAlphaResult CheckAlphaRGBA8888Basic(const u32 *pixelData, int stride, int w
 	// Use SIMD if aligned to 16 bytes / 4 pixels (almost always the case.)
 	if ((w & 3) == 0 && (stride & 3) == 0) {
 #ifdef _M_SSE
+		if (cpu_info.bAVX2 && (w & 7) == 0 && (stride & 7) == 0) {
+			return CheckAlphaRGBA8888AVX2(pixelData, stride, w, h);
+		}
 		return CheckAlphaRGBA8888SSE2(pixelData, stride, w, h);
 #elif PPSSPP_ARCH(ARMV7) || PPSSPP_ARCH(ARM64)
 		if (cpu_info.bNEON) {
@@ -643,6 +658,9 @@ CheckAlphaResult CheckAlphaABGR4444Basic(const u32 *pixelData, int stride, int w
 	// Use SIMD if aligned to 16 bytes / 8 pixels (usually the case.)
 	if ((w & 7) == 0 && (stride & 7) == 0) {
 #ifdef _M_SSE
+		if (cpu_info.bAVX2 && (w & 15) == 0 && (stride & 15) == 0) {
+			return CheckAlphaABGR4444AVX2(pixelData, stride, w, h);
+		}
 		return CheckAlphaABGR4444SSE2(pixelData, stride, w, h);
 #elif PPSSPP_ARCH(ARMV7) || PPSSPP_ARCH(ARM64)
 		if (cpu_info.bNEON) {
@@ -676,6 +694,9 @@ CheckAlphaResult CheckAlphaABGR1555Basic(const u32 *pixelData, int stride, int w
 	// Use SIMD if aligned to 16 bytes / 8 pixels (usually the case.)
 	if ((w & 7) == 0 && (stride & 7) == 0) {
 #ifdef _M_SSE
+		if (cpu_info.bAVX2 && (w & 15) == 0 && (stride & 15) == 0) {
+			return CheckAlphaABGR1555AVX2(pixelData, stride, w, h);
+		}
 		return CheckAlphaABGR1555SSE2(pixelData, stride, w, h);
 #elif PPSSPP_ARCH(ARMV7) || PPSSPP_ARCH(ARM64)
 		if (cpu_info.bNEON) {
@@ -708,6 +729,9 @@ CheckAlphaResult CheckAlphaRGBA4444Basic(const u32 *pixelData, int stride, int w
 	// Use SSE if aligned to 16 bytes / 8 pixels (usually the case.)
 	if ((w & 7) == 0 && (stride & 7) == 0) {
 #ifdef _M_SSE
+		if (cpu_info.bAVX2 && (w & 15) == 0 && (stride & 15) == 0) {
+			return CheckAlphaRGBA4444AVX2(pixelData, stride, w, h);
+		}
 		return CheckAlphaRGBA4444SSE2(pixelData, stride, w, h);
 #elif PPSSPP_ARCH(ARMV7) || PPSSPP_ARCH(ARM64)
 		if (cpu_info.bNEON) {
@@ -741,6 +765,9 @@ CheckAlphaResult CheckAlphaRGBA5551Basic(const u32 *pixelData, int stride, int w
 	// Use SSE if aligned to 16 bytes / 8 pixels (usually the case.)
 	if ((w & 7) == 0 && (stride & 7) == 0) {
 #ifdef _M_SSE
+		if (cpu_info.bAVX2 && (w & 15) == 0 && (stride & 15) == 0) {
+			return CheckAlphaRGBA5551AVX2(pixelData, stride, w, h);
+		}
 		return CheckAlphaRGBA5551SSE2(pixelData, stride, w, h);
 #elif PPSSPP_ARCH(ARMV7) || PPSSPP_ARCH(ARM64)
 		if (cpu_info.bNEON) {
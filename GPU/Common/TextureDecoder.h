@@ -43,7 +43,9 @@ u32 QuickTexHashSSE2(const void *checkp, u32 size);
 
 // Pitch must be aligned to 16 bytes (as is the case on a PSP)
 void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
-#define DoUnswizzleTex16 DoUnswizzleTex16Basic
+// Upgraded to AVX2 by SetupTextureDecoder() when available.
+typedef void (*UnswizzleTex16Func)(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
+extern UnswizzleTex16Func DoUnswizzleTex16;
 
 #include "ext/xxhash.h"
 #define DoReliableHash32 XXH32
@@ -0,0 +1,114 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "GPU/Common/TextureDecoderAVX2.h"
+
+#ifdef _M_SSE
+#include <immintrin.h>
+
+// Like NEON, AVX2 is selected at runtime.  Rather than compiling the whole file with -mavx2
+// (which would let the compiler use it anywhere), only these functions are marked.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_FUNC __attribute__((target("avx2")))
+#else
+#define AVX2_FUNC
+#endif
+
+AVX2_FUNC void DoUnswizzleTex16AVX2(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch) {
+	// Each block is 16 bytes wide and 8 rows tall, stored contiguously.
+	// We do two blocks at a time, so each destination row is a single 32-byte store.
+	const __m128i *src = (const __m128i *)texptr;
+	u8 *ydest = (u8 *)ydestp;
+	for (int by = 0; by < byc; by++) {
+		u8 *xdest = ydest;
+		int bx = 0;
+		for (; bx + 1 < bxc; bx += 2) {
+			u8 *dest = xdest;
+			for (int n = 0; n < 8; n++) {
+				__m256i row = _mm256_castsi128_si256(_mm_loadu_si128(src + n));
+				row = _mm256_inserti128_si256(row, _mm_loadu_si128(src + 8 + n), 1);
+				_mm256_storeu_si256((__m256i *)dest, row);
+				dest += pitch;
+			}
+			src += 16;
+			xdest += 32;
+		}
+		if (bx < bxc) {
+			u8 *dest = xdest;
+			for (int n = 0; n < 8; n++) {
+				_mm_storeu_si128((__m128i *)dest, _mm_loadu_si128(src + n));
+				dest += pitch;
+			}
+			src += 8;
+		}
+		ydest += pitch * 8;
+	}
+}
+
+// All the alpha checks are the same: AND everything together and see if the mask survived.
+// For 16-bit formats, the mask is repeated in both halves of each u32.
+AVX2_FUNC static CheckAlphaResult CheckAlphaMaskAVX2(const u32 *pixelData, int stride32, int w32, int h, u32 mask32) {
+	const __m256i mask = _mm256_set1_epi32(mask32);
+	const int w8 = w32 / 8;
+
+	__m256i bits = mask;
+	for (int y = 0; y < h; ++y) {
+		const __m256i *p = (const __m256i *)pixelData;
+		int i = 0;
+		// Two accumulators to keep the loads flowing.
+		__m256i bits2 = mask;
+		for (; i + 1 < w8; i += 2) {
+			bits = _mm256_and_si256(bits, _mm256_loadu_si256(&p[i]));
+			bits2 = _mm256_and_si256(bits2, _mm256_loadu_si256(&p[i + 1]));
+		}
+		if (i < w8) {
+			bits = _mm256_and_si256(bits, _mm256_loadu_si256(&p[i]));
+		}
+		bits = _mm256_and_si256(bits, bits2);
+
+		// Any cleared mask bit means we're done.
+		if (!_mm256_testc_si256(bits, mask)) {
+			return CHECKALPHA_ANY;
+		}
+
+		pixelData += stride32;
+	}
+
+	return CHECKALPHA_FULL;
+}
+
+CheckAlphaResult CheckAlphaRGBA8888AVX2(const u32 *pixelData, int stride, int w, int h) {
+	return CheckAlphaMaskAVX2(pixelData, stride, w, h, 0xFF000000);
+}
+
+CheckAlphaResult CheckAlphaABGR4444AVX2(const u32 *pixelData, int stride, int w, int h) {
+	return CheckAlphaMaskAVX2(pixelData, stride / 2, w / 2, h, 0x000F000F);
+}
+
+CheckAlphaResult CheckAlphaABGR1555AVX2(const u32 *pixelData, int stride, int w, int h) {
+	return CheckAlphaMaskAVX2(pixelData, stride / 2, w / 2, h, 0x00010001);
+}
+
+CheckAlphaResult CheckAlphaRGBA4444AVX2(const u32 *pixelData, int stride, int w, int h) {
+	return CheckAlphaMaskAVX2(pixelData, stride / 2, w / 2, h, 0xF000F000);
+}
+
+CheckAlphaResult CheckAlphaRGBA5551AVX2(const u32 *pixelData, int stride, int w, int h) {
+	return CheckAlphaMaskAVX2(pixelData, stride / 2, w / 2, h, 0x80008000);
+}
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "GPU/Common/TextureDecoder.h"
+
+// These are only compiled in for x86, and must only be called if cpu_info.bAVX2 is set.
+#ifdef _M_SSE
+// Pitch must be aligned to 16 bytes (as is the case on a PSP)
+void DoUnswizzleTex16AVX2(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
+
+// w and stride must be multiples of 8 (8888) or 16 (16-bit) pixels.
+CheckAlphaResult CheckAlphaRGBA8888AVX2(const u32 *pixelData, int stride, int w, int h);
+CheckAlphaResult CheckAlphaABGR4444AVX2(const u32 *pixelData, int stride, int w, int h);
+CheckAlphaResult CheckAlphaABGR1555AVX2(const u32 *pixelData, int stride, int w, int h);
+CheckAlphaResult CheckAlphaRGBA4444AVX2(const u32 *pixelData, int stride, int w, int h);
+CheckAlphaResult CheckAlphaRGBA5551AVX2(const u32 *pixelData, int stride, int w, int h);
+#endif
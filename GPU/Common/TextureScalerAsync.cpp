@@ -0,0 +1,202 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstring>
+
+#include "thread/threadutil.h"
+#include "GPU/Common/TextureScalerAsync.h"
+#include "GPU/Common/TextureScalerCommon.h"
+
+TextureScalerAsync::TextureScalerAsync(TextureScalerCommon *scaler) : scaler_(scaler) {
+	scaler_->SetHighPriority(false);
+	thread_ = std::thread([this] { WorkFunc(); });
+}
+
+TextureScalerAsync::~TextureScalerAsync() {
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		active_ = false;
+		queue_.clear();
+	}
+	signal_.notify_one();
+	thread_.join();
+}
+
+bool TextureScalerAsync::Queue(u64 cachekey, u32 fullhash, const u8 *pixels, int pitch, u32 fmt, int w, int h, int bpp, int factor) {
+	std::unique_ptr<Job> job(new Job());
+	job->cachekey = cachekey;
+	job->fullhash = fullhash;
+	job->fmt = fmt;
+	job->w = w;
+	job->h = h;
+	job->factor = factor;
+	job->data.resize((w * h * bpp + 3) / 4);
+	u8 *dst = (u8 *)job->data.data();
+	for (int y = 0; y < h; ++y) {
+		memcpy(dst + y * w * bpp, pixels + y * pitch, w * bpp);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		if (queue_.size() >= MAX_QUEUED_JOBS) {
+			return false;
+		}
+		// A newer version of the same texture replaces any older queued one.
+		for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+			if ((*it)->cachekey == cachekey) {
+				queue_.erase(it);
+				break;
+			}
+		}
+		finished_.erase(cachekey);
+		if (running_ && runningKey_ == cachekey) {
+			running_ = false;
+		}
+		queue_.push_back(std::move(job));
+	}
+	ready_.erase(cachekey);
+	signal_.notify_one();
+	return true;
+}
+
+void TextureScalerAsync::PublishFinished(int frame) {
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		for (auto &it : finished_) {
+			it.second->frame = frame;
+			ready_[it.first] = std::move(it.second);
+		}
+		finished_.clear();
+	}
+
+	for (auto it = ready_.begin(); it != ready_.end(); ) {
+		if (it->second->frame + RESULT_MAX_AGE_FRAMES < frame) {
+			it = ready_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+bool TextureScalerAsync::IsQueued(u64 cachekey, u32 fullhash) {
+	if (IsReady(cachekey, fullhash)) {
+		return true;
+	}
+
+	std::lock_guard<std::mutex> guard(mutex_);
+	if (running_ && runningKey_ == cachekey && runningHash_ == fullhash) {
+		return true;
+	}
+	auto fin = finished_.find(cachekey);
+	if (fin != finished_.end() && fin->second->fullhash == fullhash) {
+		return true;
+	}
+	for (const auto &job : queue_) {
+		if (job->cachekey == cachekey && job->fullhash == fullhash) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TextureScalerAsync::IsFull() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	return queue_.size() >= MAX_QUEUED_JOBS;
+}
+
+bool TextureScalerAsync::IsReady(u64 cachekey, u32 fullhash) {
+	auto it = ready_.find(cachekey);
+	return it != ready_.end() && it->second->fullhash == fullhash;
+}
+
+bool TextureScalerAsync::CanTake(u64 cachekey, u32 fullhash, int factor, int w, int h) {
+	auto it = ready_.find(cachekey);
+	if (it == ready_.end()) {
+		return false;
+	}
+	const Result &result = *it->second;
+	return result.fullhash == fullhash && result.factor == factor && result.w == w * factor && result.h == h * factor;
+}
+
+bool TextureScalerAsync::Take(u64 cachekey, u32 fullhash, int factor, u32 *out, u32 &dstFmt, int &w, int &h) {
+	auto it = ready_.find(cachekey);
+	if (it == ready_.end()) {
+		return false;
+	}
+
+	const Result &result = *it->second;
+	if (result.fullhash != fullhash || result.factor != factor || result.w != w * factor || result.h != h * factor) {
+		ready_.erase(it);
+		return false;
+	}
+
+	memcpy(out, result.data.data(), result.w * result.h * sizeof(u32));
+	dstFmt = result.fmt;
+	w = result.w;
+	h = result.h;
+	ready_.erase(it);
+	return true;
+}
+
+void TextureScalerAsync::Clear() {
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		queue_.clear();
+		finished_.clear();
+		// If a job is running, its result is dropped when it finishes.
+		runningKey_ = 0;
+		runningHash_ = 0;
+		running_ = false;
+	}
+	ready_.clear();
+}
+
+void TextureScalerAsync::WorkFunc() {
+	setCurrentThreadName("TexScaler");
+
+	std::unique_lock<std::mutex> guard(mutex_);
+	while (true) {
+		signal_.wait(guard, [this] { return !active_ || !queue_.empty(); });
+		if (!active_) {
+			break;
+		}
+
+		std::unique_ptr<Job> job = std::move(queue_.front());
+		queue_.pop_front();
+		runningKey_ = job->cachekey;
+		runningHash_ = job->fullhash;
+		running_ = true;
+		guard.unlock();
+
+		std::unique_ptr<Result> result(new Result());
+		result->fullhash = job->fullhash;
+		result->fmt = job->fmt;
+		result->w = job->w;
+		result->h = job->h;
+		result->factor = job->factor;
+		result->frame = 0;
+		result->data.resize(job->w * job->factor * job->h * job->factor);
+		scaler_->ScaleAlways(result->data.data(), job->data.data(), result->fmt, result->w, result->h, job->factor);
+
+		guard.lock();
+		// Skip if cleared or superseded while we were scaling.
+		if (running_ && runningKey_ == job->cachekey && runningHash_ == job->fullhash) {
+			finished_[job->cachekey] = std::move(result);
+		}
+		running_ = false;
+	}
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+class TextureScalerCommon;
+
+// Runs texture upscaling on a background thread.
+// The texture cache uploads the unscaled texture right away and uses it as a placeholder,
+// queueing the decoded level here.  Once the scaled result is published (at a frame boundary),
+// the texture cache rebuilds the entry and picks it up with Take() instead of decoding and scaling again.
+// Decoding itself stays on the emu thread, since it depends on GE state and PSP memory.
+class TextureScalerAsync {
+public:
+	// Takes ownership of scaler, which must produce the same formats as the backend's own scaler.
+	explicit TextureScalerAsync(TextureScalerCommon *scaler);
+	~TextureScalerAsync();
+
+	// Copies the level data (pitch in bytes.)  Returns false if the queue is full.
+	bool Queue(u64 cachekey, u32 fullhash, const u8 *pixels, int pitch, u32 fmt, int w, int h, int bpp, int factor);
+	// Makes results finished since the last call visible, and drops ones nobody picked up.
+	void PublishFinished(int frame);
+	// Whether a job for this texture is queued, running, or finished.
+	bool IsQueued(u64 cachekey, u32 fullhash);
+	bool IsReady(u64 cachekey, u32 fullhash);
+	// When full, Queue() will fail, so there's no point rebuilding textures to queue them.
+	bool IsFull();
+	// Whether Take() would succeed, w and h being the unscaled size.
+	bool CanTake(u64 cachekey, u32 fullhash, int factor, int w, int h);
+	// Like TextureScalerCommon::ScaleAlways, but copies a published result.  Returns false if none matches.
+	bool Take(u64 cachekey, u32 fullhash, int factor, u32 *out, u32 &dstFmt, int &w, int &h);
+	void Clear();
+
+private:
+	struct Job {
+		u64 cachekey;
+		u32 fullhash;
+		u32 fmt;
+		int w;
+		int h;
+		int factor;
+		std::vector<u32> data;
+	};
+	struct Result {
+		u32 fullhash;
+		u32 fmt;
+		int w;
+		int h;
+		int factor;
+		int frame;
+		std::vector<u32> data;
+	};
+
+	enum {
+		MAX_QUEUED_JOBS = 32,
+		// Results not picked up after this many frames are dropped.
+		RESULT_MAX_AGE_FRAMES = 60,
+	};
+
+	void WorkFunc();
+
+	std::unique_ptr<TextureScalerCommon> scaler_;
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable signal_;
+	bool active_ = true;
+
+	std::deque<std::unique_ptr<Job>> queue_;
+	u64 runningKey_ = 0;
+	u32 runningHash_ = 0;
+	bool running_ = false;
+	// Finished on the worker, but not yet visible to the texture cache.
+	std::map<u64, std::unique_ptr<Result>> finished_;
+	// Only touched on the emu thread.
+	std::map<u64, std::unique_ptr<Result>> ready_;
+};
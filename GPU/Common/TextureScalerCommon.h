@@ -20,20 +20,31 @@
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
 
+#include <functional>
 #include <vector>
 
 class TextureScalerCommon {
 public:
 	TextureScalerCommon();
-	~TextureScalerCommon();
+	virtual ~TextureScalerCommon();
 
 	void ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor);
 	bool Scale(u32 *&data, u32 &dstfmt, int &width, int &height, int factor);
 	bool ScaleInto(u32 *out, u32 *src, u32 &dstfmt, int &width, int &height, int factor);
 
+	// Background scalers (not needed for the current frame) yield to everyone else's tiles.
+	void SetHighPriority(bool highPriority) {
+		highPriority_ = highPriority;
+	}
+
 	enum { XBRZ = 0, HYBRID = 1, BICUBIC = 2, HYBRID_BICUBIC = 3 };
 
 protected:
+	// Rows per tile when splitting work.  Small enough to balance, large enough to not matter.
+	enum { TILE_ROWS = 16 };
+
+	void ParallelRows(const std::function<void(int, int)> &loop, int lower, int upper);
+
 	virtual void ConvertTo8888(u32 format, u32 *source, u32 *&dest, int width, int height) = 0;
 	virtual int BytesPerPixel(u32 format) = 0;
 	virtual u32 Get8888Format() = 0;
@@ -52,4 +63,5 @@ class TextureScalerCommon {
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
 	// of course, scaling factor 5 is totally silly anyway
 	SimpleBuf<u32> bufInput, bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+	bool highPriority_ = true;
 };
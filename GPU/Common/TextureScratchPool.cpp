@@ -0,0 +1,89 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "GPU/Common/TextureScratchPool.h"
+
+TextureScratchPool::~TextureScratchPool() {
+	Clear();
+}
+
+int TextureScratchPool::SizeClass(size_t size) {
+	int shift = MIN_CLASS_SHIFT;
+	while (((size_t)1 << shift) < size) {
+		shift++;
+	}
+	return shift <= MAX_CLASS_SHIFT ? shift - MIN_CLASS_SHIFT : -1;
+}
+
+void *TextureScratchPool::Allocate(size_t size) {
+	int sizeClass = SizeClass(size);
+	u8 *block = nullptr;
+	if (sizeClass >= 0) {
+		std::lock_guard<std::mutex> guard(lock_);
+		std::vector<u8 *> &freeList = free_[sizeClass];
+		if (!freeList.empty()) {
+			block = freeList.back();
+			freeList.pop_back();
+			cachedBytes_ -= (size_t)1 << (sizeClass + MIN_CLASS_SHIFT);
+			return block + HEADER_SIZE;
+		}
+	}
+
+	size_t blockSize = sizeClass >= 0 ? (size_t)1 << (sizeClass + MIN_CLASS_SHIFT) : size;
+	block = (u8 *)AllocateAlignedMemory(blockSize + HEADER_SIZE, 16);
+	if (!block) {
+		return nullptr;
+	}
+
+	Header *header = (Header *)block;
+	header->sizeClass = sizeClass;
+	header->magic = HEADER_MAGIC;
+	return block + HEADER_SIZE;
+}
+
+void TextureScratchPool::Release(void *ptr) {
+	if (!ptr) {
+		return;
+	}
+
+	u8 *block = (u8 *)ptr - HEADER_SIZE;
+	const Header *header = (const Header *)block;
+	_dbg_assert_msg_(G3D, header->magic == HEADER_MAGIC, "Releasing a buffer that isn't from this pool");
+	int sizeClass = header->sizeClass;
+	if (sizeClass < 0) {
+		FreeAlignedMemory(block);
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	free_[sizeClass].push_back(block);
+	cachedBytes_ += (size_t)1 << (sizeClass + MIN_CLASS_SHIFT);
+}
+
+void TextureScratchPool::Trim(size_t maxCachedBytes) {
+	std::lock_guard<std::mutex> guard(lock_);
+	for (int i = NUM_CLASSES - 1; i >= 0 && cachedBytes_ > maxCachedBytes; --i) {
+		std::vector<u8 *> &freeList = free_[i];
+		while (!freeList.empty() && cachedBytes_ > maxCachedBytes) {
+			FreeAlignedMemory(freeList.back());
+			freeList.pop_back();
+			cachedBytes_ -= (size_t)1 << (i + MIN_CLASS_SHIFT);
+		}
+	}
+}
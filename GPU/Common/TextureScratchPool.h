@@ -0,0 +1,72 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Recycles temporary texture decode / upload buffers in power-of-two size classes.
+// Texture heavy scenes decode many similarly sized levels per frame, and going to the
+// system allocator for each one shows up as a lot of churn.
+// Buffers are 16-byte aligned. Thread safe, so buffers may be released on another thread.
+class TextureScratchPool {
+public:
+	TextureScratchPool() {}
+	~TextureScratchPool();
+
+	void *Allocate(size_t size);
+	void Release(void *ptr);
+
+	// Frees cached (unused) slabs until at most maxCachedBytes remain, largest first.
+	void Trim(size_t maxCachedBytes);
+	void Clear() {
+		Trim(0);
+	}
+
+	size_t CachedBytes() {
+		std::lock_guard<std::mutex> guard(lock_);
+		return cachedBytes_;
+	}
+
+private:
+	enum {
+		// In front of each buffer, holding its class.  Not counted in the class size, so a power of
+		// two sized request still fits its class exactly.
+		HEADER_SIZE = 16,
+		HEADER_MAGIC = 0x53435450,
+		MIN_CLASS_SHIFT = 12,  // 4 KB
+		MAX_CLASS_SHIFT = 24,  // 16 MB, larger requests aren't recycled.
+		NUM_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1,
+	};
+
+	static int SizeClass(size_t size);
+
+	struct Header {
+		// -1 if too large to recycle.
+		int sizeClass;
+		u32 magic;
+	};
+
+	std::mutex lock_;
+	// Blocks, including their header.
+	std::vector<u8 *> free_[NUM_CLASSES];
+	size_t cachedBytes_ = 0;
+};
@@ -0,0 +1,448 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Common.h"
+#include "Common/MemoryUtil.h"
+#include "GPU/GPUState.h"
+#include "GPU/Common/VertexDecoderCommon.h"
+#include "GPU/Common/VertexDecoderBatch.h"
+
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#elif PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// The vertex data is strided and the PSP formats are mostly small integers, so each
+// group of four vertices is gathered into registers with plain loads and then converted
+// and scaled four at a time. Conversions are done in the same order as the decoder
+// steps so the results are identical.
+
+#if defined(_M_SSE)
+
+typedef __m128i Vec4I;
+typedef __m128 Vec4F;
+
+static inline Vec4I Set4I(s32 a, s32 b, s32 c, s32 d) { return _mm_setr_epi32(a, b, c, d); }
+static inline Vec4F Set4F(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline Vec4F Load4F(const float *src) { return _mm_load_ps(src); }
+static inline Vec4F ToFloat4(Vec4I v) { return _mm_cvtepi32_ps(v); }
+static inline Vec4F Mul4(Vec4F v, float s) { return _mm_mul_ps(v, _mm_set1_ps(s)); }
+static inline Vec4F Add4(Vec4F v, float s) { return _mm_add_ps(v, _mm_set1_ps(s)); }
+static inline void Store4F(float *dst, Vec4F v) { _mm_store_ps(dst, v); }
+static inline void Store4I(u32 *dst, Vec4I v) { _mm_store_si128((__m128i *)dst, v); }
+static inline Vec4I And4(Vec4I a, u32 mask) { return _mm_and_si128(a, _mm_set1_epi32(mask)); }
+static inline Vec4I AndV4(Vec4I a, Vec4I b) { return _mm_and_si128(a, b); }
+static inline Vec4I Or4(Vec4I a, Vec4I b) { return _mm_or_si128(a, b); }
+static inline Vec4I Shl4(Vec4I v, int n) { return _mm_slli_epi32(v, n); }
+static inline Vec4I Shr4(Vec4I v, int n) { return _mm_srli_epi32(v, n); }
+static inline Vec4I Full4() { return _mm_set1_epi32(-1); }
+static inline u32 AllAnd4(Vec4I v) {
+	v = _mm_and_si128(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_and_si128(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (u32)_mm_cvtsi128_si32(v);
+}
+
+#elif PPSSPP_ARCH(ARM_NEON)
+
+typedef uint32x4_t Vec4I;
+typedef float32x4_t Vec4F;
+
+static inline Vec4I Set4I(s32 a, s32 b, s32 c, s32 d) {
+	const u32 v[4] = { (u32)a, (u32)b, (u32)c, (u32)d };
+	return vld1q_u32(v);
+}
+static inline Vec4F Set4F(float a, float b, float c, float d) {
+	const float v[4] = { a, b, c, d };
+	return vld1q_f32(v);
+}
+static inline Vec4F Load4F(const float *src) { return vld1q_f32(src); }
+static inline Vec4F ToFloat4(Vec4I v) { return vcvtq_f32_s32(vreinterpretq_s32_u32(v)); }
+// Keep the multiply and add separate (no vmla/fma) to match the interpreted steps.
+static inline Vec4F Mul4(Vec4F v, float s) { return vmulq_f32(v, vdupq_n_f32(s)); }
+static inline Vec4F Add4(Vec4F v, float s) { return vaddq_f32(v, vdupq_n_f32(s)); }
+static inline void Store4F(float *dst, Vec4F v) { vst1q_f32(dst, v); }
+static inline void Store4I(u32 *dst, Vec4I v) { vst1q_u32(dst, v); }
+static inline Vec4I And4(Vec4I a, u32 mask) { return vandq_u32(a, vdupq_n_u32(mask)); }
+static inline Vec4I AndV4(Vec4I a, Vec4I b) { return vandq_u32(a, b); }
+static inline Vec4I Or4(Vec4I a, Vec4I b) { return vorrq_u32(a, b); }
+static inline Vec4I Shl4(Vec4I v, int n) { return vshlq_u32(v, vdupq_n_s32(n)); }
+static inline Vec4I Shr4(Vec4I v, int n) { return vshlq_u32(v, vdupq_n_s32(-n)); }
+static inline Vec4I Full4() { return vdupq_n_u32(0xFFFFFFFF); }
+static inline u32 AllAnd4(Vec4I v) {
+	uint32x2_t h = vand_u32(vget_low_u32(v), vget_high_u32(v));
+	return vget_lane_u32(h, 0) & vget_lane_u32(h, 1);
+}
+
+#else
+
+struct Vec4I {
+	u32 v[4];
+};
+struct Vec4F {
+	float v[4];
+};
+
+static inline Vec4I Set4I(s32 a, s32 b, s32 c, s32 d) { return Vec4I{ { (u32)a, (u32)b, (u32)c, (u32)d } }; }
+static inline Vec4F Set4F(float a, float b, float c, float d) { return Vec4F{ { a, b, c, d } }; }
+static inline Vec4F Load4F(const float *src) { return Set4F(src[0], src[1], src[2], src[3]); }
+static inline Vec4F ToFloat4(Vec4I v) {
+	Vec4F r;
+	for (int i = 0; i < 4; i++)
+		r.v[i] = (float)(s32)v.v[i];
+	return r;
+}
+static inline Vec4F Mul4(Vec4F v, float s) {
+	for (int i = 0; i < 4; i++)
+		v.v[i] *= s;
+	return v;
+}
+static inline Vec4F Add4(Vec4F v, float s) {
+	for (int i = 0; i < 4; i++)
+		v.v[i] += s;
+	return v;
+}
+static inline void Store4F(float *dst, Vec4F v) { memcpy(dst, v.v, sizeof(v.v)); }
+static inline void Store4I(u32 *dst, Vec4I v) { memcpy(dst, v.v, sizeof(v.v)); }
+static inline Vec4I And4(Vec4I a, u32 mask) {
+	for (int i = 0; i < 4; i++)
+		a.v[i] &= mask;
+	return a;
+}
+static inline Vec4I AndV4(Vec4I a, Vec4I b) {
+	for (int i = 0; i < 4; i++)
+		a.v[i] &= b.v[i];
+	return a;
+}
+static inline Vec4I Or4(Vec4I a, Vec4I b) {
+	for (int i = 0; i < 4; i++)
+		a.v[i] |= b.v[i];
+	return a;
+}
+static inline Vec4I Shl4(Vec4I v, int n) {
+	for (int i = 0; i < 4; i++)
+		v.v[i] <<= n;
+	return v;
+}
+static inline Vec4I Shr4(Vec4I v, int n) {
+	for (int i = 0; i < 4; i++)
+		v.v[i] >>= n;
+	return v;
+}
+static inline Vec4I Full4() { return Set4I(-1, -1, -1, -1); }
+static inline u32 AllAnd4(Vec4I v) { return v.v[0] & v.v[1] & v.v[2] & v.v[3]; }
+
+#endif
+
+SoAVertexData::~SoAVertexData() {
+	if (buffer_)
+		FreeAlignedMemory(buffer_);
+}
+
+void SoAVertexData::Resize(int c) {
+	int padded = (c + 3) & ~3;
+	if (padded > capacity_) {
+		if (buffer_)
+			FreeAlignedMemory(buffer_);
+		// Grow a bit extra so we don't reallocate for every slightly larger draw.
+		capacity_ = std::max(padded + padded / 2, 256);
+		capacity_ = (capacity_ + 3) & ~3;
+		buffer_ = (u8 *)AllocateAlignedMemory(capacity_ * (8 * sizeof(float) + sizeof(u32)), 16);
+		float *f = (float *)buffer_;
+		posX = f; f += capacity_;
+		posY = f; f += capacity_;
+		posZ = f; f += capacity_;
+		u = f; f += capacity_;
+		v = f; f += capacity_;
+		nrmX = f; f += capacity_;
+		nrmY = f; f += capacity_;
+		nrmZ = f; f += capacity_;
+		color0 = (u32 *)f;
+	}
+	count = c;
+}
+
+// Calls func(i, a, b, c, d) for each group of four vertices starting at i.
+// The last group repeats the last vertex rather than reading past the end of the
+// source; the outputs are padded to a multiple of four so it can be stored anyway.
+template <typename Func>
+static inline void ForEachQuad(const u8 *src, int stride, int count, Func func) {
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const u8 *p = src + i * stride;
+		func(i, p, p + stride, p + stride * 2, p + stride * 3);
+	}
+	if (i < count) {
+		const u8 *p[4];
+		for (int k = 0; k < 4; k++)
+			p[k] = src + std::min(i + k, count - 1) * stride;
+		func(i, p[0], p[1], p[2], p[3]);
+	}
+}
+
+template <typename T>
+static inline Vec4F Gather4(const u8 *a, const u8 *b, const u8 *c, const u8 *d, int off) {
+	return ToFloat4(Set4I(*(const T *)(a + off), *(const T *)(b + off), *(const T *)(c + off), *(const T *)(d + off)));
+}
+
+template <>
+inline Vec4F Gather4<float>(const u8 *a, const u8 *b, const u8 *c, const u8 *d, int off) {
+	return Set4F(*(const float_le *)(a + off), *(const float_le *)(b + off), *(const float_le *)(c + off), *(const float_le *)(d + off));
+}
+
+template <typename T>
+static void DecodeComponents(const u8 *src, int stride, int count, int off, int n, float scale, float *const out[3]) {
+	ForEachQuad(src, stride, count, [&](int i, const u8 *a, const u8 *b, const u8 *c, const u8 *d) {
+		for (int j = 0; j < n; j++) {
+			Vec4F f = Gather4<T>(a, b, c, d, off + j * (int)sizeof(T));
+			Store4F(out[j] + i, scale == 1.0f ? f : Mul4(f, scale));
+		}
+	});
+}
+
+static void DecodeComponentsOfType(BatchSrcType type, const u8 *src, int stride, int count, int off, int n, float scale, float *const out[3]) {
+	switch (type) {
+	case BatchSrcType::S8: DecodeComponents<s8>(src, stride, count, off, n, scale, out); break;
+	case BatchSrcType::U8: DecodeComponents<u8>(src, stride, count, off, n, scale, out); break;
+	case BatchSrcType::S16: DecodeComponents<s16_le>(src, stride, count, off, n, scale, out); break;
+	case BatchSrcType::U16: DecodeComponents<u16_le>(src, stride, count, off, n, scale, out); break;
+	case BatchSrcType::FLOAT: DecodeComponents<float>(src, stride, count, off, n, scale, out); break;
+	default: break;
+	}
+}
+
+template <typename T>
+static void UpdateThroughBounds(const u8 *src, int stride, int count, int off) {
+	u16 minU = gstate_c.vertBounds.minU, maxU = gstate_c.vertBounds.maxU;
+	u16 minV = gstate_c.vertBounds.minV, maxV = gstate_c.vertBounds.maxV;
+	for (int i = 0; i < count; i++) {
+		const T *uv = (const T *)(src + i * stride + off);
+		u16 u = (u16)uv[0];
+		u16 v = (u16)uv[1];
+		minU = std::min(minU, u);
+		maxU = std::max(maxU, u);
+		minV = std::min(minV, v);
+		maxV = std::max(maxV, v);
+	}
+	gstate_c.vertBounds.minU = minU;
+	gstate_c.vertBounds.maxU = maxU;
+	gstate_c.vertBounds.minV = minV;
+	gstate_c.vertBounds.maxV = maxV;
+}
+
+// Expands four 16-bit or 32-bit colors to RGBA8888, and returns the AND of the outputs
+// so the caller can tell if all alpha values were full.
+static u32 DecodeColors(u8 colFmt, const u8 *src, int stride, int count, int off, u32 *out) {
+	Vec4I alpha = Full4();
+	ForEachQuad(src, stride, count, [&](int i, const u8 *a, const u8 *b, const u8 *c, const u8 *d) {
+		Vec4I rgba;
+		if (colFmt == GE_VTYPE_COL_8888 >> GE_VTYPE_COL_SHIFT) {
+			rgba = Set4I(*(const u32_le *)(a + off), *(const u32_le *)(b + off), *(const u32_le *)(c + off), *(const u32_le *)(d + off));
+		} else {
+			Vec4I col = Set4I(*(const u16_le *)(a + off), *(const u16_le *)(b + off), *(const u16_le *)(c + off), *(const u16_le *)(d + off));
+			Vec4I r, g, bl, al;
+			switch (colFmt) {
+			case GE_VTYPE_COL_565 >> GE_VTYPE_COL_SHIFT:
+				r = And4(col, 0x1F);
+				g = And4(Shr4(col, 5), 0x3F);
+				bl = Shr4(col, 11);
+				r = Or4(Shl4(r, 3), Shr4(r, 2));
+				g = Or4(Shl4(g, 2), Shr4(g, 4));
+				bl = Or4(Shl4(bl, 3), Shr4(bl, 2));
+				al = Set4I(0xFF, 0xFF, 0xFF, 0xFF);
+				break;
+			case GE_VTYPE_COL_5551 >> GE_VTYPE_COL_SHIFT:
+				r = And4(col, 0x1F);
+				g = And4(Shr4(col, 5), 0x1F);
+				bl = And4(Shr4(col, 10), 0x1F);
+				r = Or4(Shl4(r, 3), Shr4(r, 2));
+				g = Or4(Shl4(g, 3), Shr4(g, 2));
+				bl = Or4(Shl4(bl, 3), Shr4(bl, 2));
+				// 1 -> 0xFF, 0 -> 0.
+				al = Shr4(Shl4(col, 16), 31);
+				al = Or4(Or4(al, Shl4(al, 1)), Or4(Shl4(al, 2), Shl4(al, 3)));
+				al = Or4(al, Shl4(al, 4));
+				break;
+			default:  // 4444
+				r = And4(col, 0xF);
+				g = And4(Shr4(col, 4), 0xF);
+				bl = And4(Shr4(col, 8), 0xF);
+				al = Shr4(col, 12);
+				r = Or4(Shl4(r, 4), r);
+				g = Or4(Shl4(g, 4), g);
+				bl = Or4(Shl4(bl, 4), bl);
+				al = Or4(Shl4(al, 4), al);
+				break;
+			}
+			rgba = Or4(Or4(r, Shl4(g, 8)), Or4(Shl4(bl, 16), Shl4(al, 24)));
+		}
+		alpha = AndV4(alpha, rgba);
+		Store4I(out + i, rgba);
+	});
+	return AllAnd4(alpha);
+}
+
+void VertexDecoder::SetupBatchPlan() {
+	VertexBatchPlan &plan = batch_;
+	memset(&plan, 0, sizeof(plan));
+	plan.posScale = 1.0f;
+	plan.tcScale = 1.0f;
+	plan.nrmScale = 1.0f;
+
+	if (morphcount != 1 || weighttype != 0) {
+		return;
+	}
+
+	struct StepInfo {
+		StepFunction func;
+		BatchSrcType type;
+		float scale;
+	};
+	static const StepInfo posSteps[] = {
+		{ &VertexDecoder::Step_PosS8, BatchSrcType::S8, 1.0f / 128.0f },
+		{ &VertexDecoder::Step_PosS16, BatchSrcType::S16, 1.0f / 32768.0f },
+		{ &VertexDecoder::Step_PosFloat, BatchSrcType::FLOAT, 1.0f },
+		{ &VertexDecoder::Step_PosS8Through, BatchSrcType::S8, 1.0f },
+		{ &VertexDecoder::Step_PosS16Through, BatchSrcType::S16, 1.0f },
+		{ &VertexDecoder::Step_PosFloatThrough, BatchSrcType::FLOAT, 1.0f },
+	};
+	static const StepInfo tcSteps[] = {
+		{ &VertexDecoder::Step_TcU8ToFloat, BatchSrcType::U8, 1.0f / 128.0f },
+		{ &VertexDecoder::Step_TcU16ToFloat, BatchSrcType::U16, 1.0f / 32768.0f },
+		{ &VertexDecoder::Step_TcU16DoubleToFloat, BatchSrcType::U16, 1.0f / 16384.0f },
+		{ &VertexDecoder::Step_TcFloat, BatchSrcType::FLOAT, 1.0f },
+		{ &VertexDecoder::Step_TcU16ThroughToFloat, BatchSrcType::U16, 1.0f },
+		{ &VertexDecoder::Step_TcU16ThroughDoubleToFloat, BatchSrcType::U16, 2.0f },
+		{ &VertexDecoder::Step_TcFloatThrough, BatchSrcType::FLOAT, 1.0f },
+		{ &VertexDecoder::Step_TcU8Prescale, BatchSrcType::U8, 1.0f / 128.0f },
+		{ &VertexDecoder::Step_TcU16Prescale, BatchSrcType::U16, 1.0f / 32768.0f },
+		{ &VertexDecoder::Step_TcU16DoublePrescale, BatchSrcType::U16, 1.0f / 16384.0f },
+		{ &VertexDecoder::Step_TcFloatPrescale, BatchSrcType::FLOAT, 1.0f },
+	};
+	static const StepInfo nrmSteps[] = {
+		// These match VertexReader::ReadNrm() for DEC_S8_3 and DEC_S16_3.
+		{ &VertexDecoder::Step_NormalS8, BatchSrcType::S8, 1.0f / 127.0f },
+		{ &VertexDecoder::Step_NormalS8ToFloat, BatchSrcType::S8, 1.0f / 128.0f },
+		{ &VertexDecoder::Step_NormalS16, BatchSrcType::S16, 1.0f / 32767.0f },
+		{ &VertexDecoder::Step_NormalFloat, BatchSrcType::FLOAT, 1.0f },
+	};
+
+	auto lookup = [](StepFunction func, const StepInfo *infos, size_t n) -> const StepInfo * {
+		for (size_t i = 0; i < n; i++) {
+			if (infos[i].func == func)
+				return &infos[i];
+		}
+		return nullptr;
+	};
+
+	for (int i = 0; i < numSteps_; i++) {
+		StepFunction func = steps_[i];
+		if (const StepInfo *info = lookup(func, posSteps, ARRAY_SIZE(posSteps))) {
+			plan.posType = info->type;
+			plan.posScale = info->scale;
+			plan.posZUnsigned = func == &VertexDecoder::Step_PosS16Through;
+		} else if (const StepInfo *info = lookup(func, tcSteps, ARRAY_SIZE(tcSteps))) {
+			plan.tcType = info->type;
+			plan.tcScale = info->scale;
+			plan.tcPrescale = func == &VertexDecoder::Step_TcU8Prescale || func == &VertexDecoder::Step_TcU16Prescale ||
+				func == &VertexDecoder::Step_TcU16DoublePrescale || func == &VertexDecoder::Step_TcFloatPrescale;
+			plan.tcThroughBounds = func == &VertexDecoder::Step_TcU16ThroughToFloat || func == &VertexDecoder::Step_TcFloatThrough;
+		} else if (const StepInfo *info = lookup(func, nrmSteps, ARRAY_SIZE(nrmSteps))) {
+			plan.nrmType = info->type;
+			plan.nrmScale = info->scale;
+		} else if (func == &VertexDecoder::Step_Color565 || func == &VertexDecoder::Step_Color5551 ||
+			func == &VertexDecoder::Step_Color4444 || func == &VertexDecoder::Step_Color8888) {
+			plan.colFmt = col;
+		} else {
+			// Something we don't handle, like an invalid color format.
+			return;
+		}
+	}
+
+	plan.supported = plan.posType != BatchSrcType::NONE;
+}
+
+bool VertexDecoder::DecodeVertsSoA(SoAVertexData &out, const void *verts, int indexLowerBound, int indexUpperBound) const {
+	const VertexBatchPlan &plan = batch_;
+	if (!plan.supported)
+		return false;
+
+	int count = indexUpperBound - indexLowerBound + 1;
+	out.Resize(count);
+	out.hasUV = plan.tcType != BatchSrcType::NONE;
+	out.hasNormal = plan.nrmType != BatchSrcType::NONE;
+	out.hasColor0 = plan.colFmt != 0;
+
+	const u8 *src = (const u8 *)verts + indexLowerBound * size;
+	if (((uintptr_t)verts & (biggest - 1)) != 0) {
+		// Bad alignment, same as DecodeVerts() - zero the verts to be safe.
+		int padded = (count + 3) & ~3;
+		float *const arrays[] = { out.posX, out.posY, out.posZ, out.u, out.v, out.nrmX, out.nrmY, out.nrmZ };
+		for (float *f : arrays)
+			memset(f, 0, padded * sizeof(float));
+		memset(out.color0, 0, padded * sizeof(u32));
+		return true;
+	}
+
+	float *const pos[3] = { out.posX, out.posY, out.posZ };
+	if (plan.posZUnsigned) {
+		// Through mode S16: x and y are signed, z is unsigned.
+		float *const xy[3] = { out.posX, out.posY };
+		float *const z[3] = { out.posZ };
+		DecodeComponents<s16_le>(src, size, count, posoff, 2, plan.posScale, xy);
+		DecodeComponents<u16_le>(src, size, count, posoff + 4, 1, plan.posScale, z);
+	} else {
+		DecodeComponentsOfType(plan.posType, src, size, count, posoff, 3, plan.posScale, pos);
+	}
+
+	if (plan.tcType != BatchSrcType::NONE) {
+		float *const uv[3] = { out.u, out.v };
+		DecodeComponentsOfType(plan.tcType, src, size, count, tcoff, 2, plan.tcScale, uv);
+		if (plan.tcPrescale) {
+			const float uScale = gstate_c.uv.uScale, vScale = gstate_c.uv.vScale;
+			const float uOff = gstate_c.uv.uOff, vOff = gstate_c.uv.vOff;
+			for (int i = 0; i < count; i += 4) {
+				Store4F(out.u + i, Add4(Mul4(Load4F(out.u + i), uScale), uOff));
+				Store4F(out.v + i, Add4(Mul4(Load4F(out.v + i), vScale), vOff));
+			}
+		}
+		if (plan.tcThroughBounds) {
+			if (plan.tcType == BatchSrcType::U16)
+				UpdateThroughBounds<u16_le>(src, size, count, tcoff);
+			else
+				UpdateThroughBounds<float>(src, size, count, tcoff);
+		}
+	}
+
+	if (plan.colFmt != 0) {
+		u32 all = DecodeColors(plan.colFmt, src, size, count, coloff, out.color0);
+		if ((all >> 24) != 0xFF)
+			gstate_c.vertexFullAlpha = false;
+	}
+
+	if (plan.nrmType != BatchSrcType::NONE) {
+		float *const nrm[3] = { out.nrmX, out.nrmY, out.nrmZ };
+		DecodeComponentsOfType(plan.nrmType, src, size, count, nrmoff, 3, plan.nrmScale, nrm);
+	}
+
+	return true;
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Decoded vertices with one array per component, for consumers that work across many
+// vertices at once (like the software renderer's TransformUnit) and would otherwise
+// go through VertexReader for every attribute of every vertex.
+//
+// Values are what VertexReader returns for the interleaved decode: ReadPos() except
+// that through mode z is left as the raw integer value, ReadUV(), and ReadNrm().
+// color0 is packed RGBA8888, like DEC_U8_4.
+//
+// Arrays are 16-byte aligned and padded to a multiple of 4 vertices.
+struct SoAVertexData {
+	SoAVertexData() {}
+	~SoAVertexData();
+
+	void Resize(int count);
+
+	float *posX = nullptr;
+	float *posY = nullptr;
+	float *posZ = nullptr;
+	float *u = nullptr;
+	float *v = nullptr;
+	float *nrmX = nullptr;
+	float *nrmY = nullptr;
+	float *nrmZ = nullptr;
+	u32 *color0 = nullptr;
+
+	int count = 0;
+	bool hasUV = false;
+	bool hasNormal = false;
+	bool hasColor0 = false;
+
+private:
+	SoAVertexData(const SoAVertexData &) = delete;
+	void operator =(const SoAVertexData &) = delete;
+
+	u8 *buffer_ = nullptr;
+	int capacity_ = 0;
+};
+
+enum class BatchSrcType : u8 {
+	NONE,
+	S8,
+	U8,
+	S16,
+	U16,
+	FLOAT,
+};
+
+// How the batch decoder handles a vertex type, derived from the decoder's steps.
+// Formats with weights, morphing or skinning in decode are not supported, and
+// use the regular decoder.
+struct VertexBatchPlan {
+	bool supported;
+
+	BatchSrcType posType;
+	bool posZUnsigned;
+	float posScale;
+
+	BatchSrcType tcType;
+	bool tcPrescale;
+	bool tcThroughBounds;
+	float tcScale;
+
+	u8 colFmt;
+
+	BatchSrcType nrmType;
+	float nrmScale;
+};
@@ -175,7 +175,7 @@ void PrintDecodedVertex(VertexReader &vtx) {
 	printf("P: %f %f %f\n", pos[0], pos[1], pos[2]);
 }
 
-VertexDecoder::VertexDecoder() : decoded_(nullptr), ptr_(nullptr), jitted_(0), jittedSize_(0) {
+VertexDecoder::VertexDecoder() : decoded_(nullptr), ptr_(nullptr), jitted_(0), jittedSize_(0), batch_() {
 }
 
 void VertexDecoder::Step_WeightsU8() const
@@ -1258,6 +1258,8 @@ void VertexDecoder::SetVertexType(u32 fmt, const VertexDecoderOptions &options,
 	size *= morphcount;
 	DEBUG_LOG(G3D, "SVT : size = %i, aligned to biggest %i", size, biggest);
 
+	SetupBatchPlan();
+
 	if (reportNoPos) {
 		char temp[256]{};
 		ToString(temp);
@@ -1276,9 +1278,7 @@ void VertexDecoder::SetVertexType(u32 fmt, const VertexDecoderOptions &options,
 
 void VertexDecoder::DecodeVerts(u8 *decodedptr, const void *verts, int indexLowerBound, int indexUpperBound) const {
 	// Decode the vertices within the found bounds, once each
-	// decoded_ and ptr_ are used in the steps, so can't be turned into locals for speed.
-	decoded_ = decodedptr;
-	ptr_ = (const u8*)verts + indexLowerBound * size;
+	const u8 *startPtr = (const u8*)verts + indexLowerBound * size;
 
 	int count = indexUpperBound - indexLowerBound + 1;
 	int stride = decFmt.stride;
@@ -1292,9 +1292,13 @@ void VertexDecoder::DecodeVerts(u8 *decodedptr, const void *verts, int indexLowe
 
 	if (jitted_) {
 		// We've compiled the steps into optimized machine code, so just jump!
-		jitted_(ptr_, decoded_, count);
+		// Doesn't touch decoded_ and ptr_, see CanDecodeInParallel().
+		jitted_(startPtr, decodedptr, count);
 	} else {
 		// Interpret the decode steps
+		// decoded_ and ptr_ are used in the steps, so can't be turned into locals for speed.
+		decoded_ = decodedptr;
+		ptr_ = startPtr;
 		for (; count; count--) {
 			for (int i = 0; i < numSteps_; i++) {
 				((*this).*steps_[i])();
@@ -26,6 +26,7 @@
 #include "Core/Reporting.h"
 #include "GPU/ge_constants.h"
 #include "GPU/Common/ShaderCommon.h"
+#include "GPU/Common/VertexDecoderBatch.h"
 #include "GPU/GPUCommon.h"
 
 #if PPSSPP_ARCH(ARM)
@@ -455,6 +456,20 @@ class VertexDecoder {
 
 	void DecodeVerts(u8 *decoded, const void *verts, int indexLowerBound, int indexUpperBound) const;
 
+	// Decodes several vertices per iteration into separate component arrays.
+	// Returns false if this vertex type isn't supported, see VertexBatchPlan.
+	bool DecodeVertsSoA(SoAVertexData &out, const void *verts, int indexLowerBound, int indexUpperBound) const;
+	bool CanDecodeSoA() const { return batch_.supported; }
+
+	// Whether DecodeVerts() may run on several threads at once, on different ranges.
+	// The interpreter keeps its position in the decoder, and the jitted code updates shared
+	// state for through mode texcoord bounds and software skinning.  Writes to
+	// gstate_c.vertexFullAlpha only ever clear it, so they don't matter.
+	bool CanDecodeInParallel() const {
+		bool skinInDecode = weighttype != 0 && decFmt.w0fmt == 0;
+		return jitted_ != nullptr && !(throughmode && tc != 0) && !skinInDecode;
+	}
+
 	bool hasColor() const { return col != 0; }
 	bool hasTexcoord() const { return tc != 0; }
 	int VertexSize() const { return size; }  // PSP format size
@@ -586,6 +601,9 @@ class VertexDecoder {
 
 	u8 biggest;  // in practice, alignment.
 
+	VertexBatchPlan batch_;
+	void SetupBatchPlan();
+
 	friend class VertexDecoderJitCache;
 };
 
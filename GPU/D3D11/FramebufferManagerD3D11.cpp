@@ -699,6 +699,8 @@ void FramebufferManagerD3D11::DeviceLost() {
 }
 
 void FramebufferManagerD3D11::DestroyAllFBOs() {
+	// Memory is about to be replaced or the device is going away.
+	DiscardPendingReadbacks();
 	currentRenderVfb_ = nullptr;
 	displayFramebuf_ = nullptr;
 	prevDisplayFramebuf_ = nullptr;
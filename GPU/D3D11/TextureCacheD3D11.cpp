@@ -117,6 +117,7 @@ TextureCacheD3D11::TextureCacheD3D11(Draw::DrawContext *draw)
 	HRESULT result = 0;
 
 	SetupTextureDecoder();
+	asyncScaler_.reset(new TextureScalerAsync(new TextureScalerD3D11()));
 
 	nextTexture_ = nullptr;
 }
@@ -190,6 +191,7 @@ void TextureCacheD3D11::StartFrame() {
 		// INFO_LOG(G3D, "Scaled %i texels", texelsScaledThisFrame_);
 	}
 	texelsScaledThisFrame_ = 0;
+	asyncScaler_->PublishFinished(gpuStats.numFlips);
 	if (clearCacheNextFrame_) {
 		Clear(true);
 		clearCacheNextFrame_ = false;
@@ -501,22 +503,7 @@ void TextureCacheD3D11::BuildTexture(TexCacheEntry *const entry) {
 	// Don't scale the PPGe texture.
 	if (entry->addr > 0x05000000 && entry->addr < PSP_GetKernelMemoryEnd())
 		scaleFactor = 1;
-	if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0 && scaleFactor != 1) {
-		// Remember for later that we /wanted/ to scale this texture.
-		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
-		scaleFactor = 1;
-	}
-
-	if (scaleFactor != 1) {
-		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED) {
-			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
-			scaleFactor = 1;
-		} else {
-			entry->status &= ~TexCacheEntry::STATUS_TO_SCALE;
-			entry->status |= TexCacheEntry::STATUS_IS_SCALED;
-			texelsScaledThisFrame_ += w * h;
-		}
-	}
+	scaleFactor = ScaleFactorForBuild(entry, scaleFactor, w, h);
 
 	// Seems to cause problems in Tactics Ogre.
 	if (badMipSizes) {
@@ -679,7 +666,7 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 	u32 *mapData = nullptr;
 	int mapRowPitch = 0;
 	if (replaced.GetSize(level, w, h)) {
-		mapData = (u32 *)AllocateAlignedMemory(w * h * sizeof(u32), 16);
+		mapData = (u32 *)scratchPool_.Allocate(w * h * sizeof(u32));
 		mapRowPitch = w * 4;
 		replaced.Load(level, mapData, mapRowPitch);
 		dstFmt = ToDXGIFormat(replaced.Format(level));
@@ -696,12 +683,12 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 			pixelData = tmpTexBufRearrange_.data();
 			// We want to end up with a neatly packed texture for scaling.
 			decPitch = w * bpp;
-			mapData = (u32 *)AllocateAlignedMemory(sizeof(u32) * (w * scaleFactor) * (h * scaleFactor), 16);
+			mapData = (u32 *)scratchPool_.Allocate(sizeof(u32) * (w * scaleFactor) * (h * scaleFactor));
 			mapRowPitch = w * scaleFactor * 4;
 		} else {
 			mapRowPitch = std::max(w * bpp, 16);
 			size_t bufSize = sizeof(u32) * (mapRowPitch / bpp) * h;
-			mapData = (u32 *)AllocateAlignedMemory(bufSize, 16);
+			mapData = (u32 *)scratchPool_.Allocate(bufSize);
 			if (!mapData) {
 				ERROR_LOG(G3D, "Ran out of RAM trying to allocate a temporary texture upload buffer (alloc size: %d, %dx%d)", bufSize, mapRowPitch / sizeof(u32), h);
 				return;
@@ -711,19 +698,24 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 		}
 
 		bool expand32 = !gstate_c.Supports(GPU_SUPPORTS_16BIT_FORMATS);
-		DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, expand32);
+		// If the worker already scaled this level, it was decoded for the placeholder and ScaleLevel() takes it.
+		if (!AsyncScaleReady(entry, scaleFactor, w, h)) {
+			DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, expand32);
+
+			// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
+			if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+				TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
+				entry.SetAlphaStatus(alphaStatus, level);
+			} else {
+				entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			}
 
-		// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
-		if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
-			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
-			entry.SetAlphaStatus(alphaStatus, level);
-		} else {
-			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			QueueAsyncScale(entry, (const u8 *)pixelData, decPitch, (u32)dstFmt, w, h, bpp);
 		}
 
 		if (scaleFactor > 1) {
 			u32 scaleFmt = (u32)dstFmt;
-			scaler.ScaleAlways((u32 *)mapData, pixelData, scaleFmt, w, h, scaleFactor);
+			ScaleLevel(scaler, entry, (u32 *)mapData, pixelData, scaleFmt, w, h, scaleFactor);
 			pixelData = (u32 *)mapData;
 
 			// We always end up at 8888.  Other parts assume this.
@@ -760,7 +752,7 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 		context_->UpdateSubresource(texture, 0, nullptr, mapData, mapRowPitch, 0);
 	else
 		context_->UpdateSubresource(texture, level, nullptr, mapData, mapRowPitch, 0);
-	FreeAlignedMemory(mapData);
+	scratchPool_.Release(mapData);
 }
 
 bool TextureCacheD3D11::GetCurrentTextureDebug(GPUDebugBuffer &buffer, int level) {
@@ -94,7 +94,6 @@ class TextureCacheD3D11 : public TextureCacheCommon {
 	ID3D11ShaderResourceView *lastBoundTexture;
 
 	int decimationCounter_;
-	int texelsScaledThisFrame_;
 	int timesInvalidatedAllThisFrame_;
 
 	FramebufferManagerD3D11 *framebufferManagerD3D11_;
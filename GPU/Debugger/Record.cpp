@@ -23,6 +23,7 @@
 #include "base/stringutil.h"
 #include "Common/Common.h"
 #include "Common/FileUtil.h"
+#include "Common/Hashmaps.h"
 #include "Common/Log.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -39,15 +40,32 @@
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/Debugger/Record.h"
+#include "ext/xxhash.h"
 
 namespace GPURecord {
 
 static const char *HEADER = "PPSSPPGE";
-static const int VERSION = 2;
+static const char *INDEX_MAGIC = "PPGEINDX";
+// Version 3 streams chunks to disk while recording.  Version 2 (a single frame) still replays.
+static const int VERSION = 3;
+static const int MIN_VERSION = 2;
+
+enum {
+	// Uncompressed data per chunk, roughly.  Recording and replay only keep a few in memory.
+	CHUNK_DATA_SIZE = 4 * 1024 * 1024,
+	CHUNK_CACHE_SIZE = 4,
+	// Past this many unique uploads, we forget the old ones rather than growing forever.
+	MAX_DEDUP_ENTRIES = 256 * 1024,
+	// Positions in the data stream are u32, stop recording well before they would overflow.
+	MAX_STREAM_SIZE = 0xF0000000,
+};
 
 static bool active = false;
 static bool nextFrame = false;
 static bool writePending = false;
+static bool stopPending = false;
+// Frames to record.
+static int framesToRecord = 1;
 static std::function<void(const std::string &)> writeCallback;
 
 enum class CommandType : u8 {
@@ -77,26 +95,112 @@ enum class CommandType : u8 {
 struct Command {
 	CommandType type;
 	u32 sz;
+	// Position in the data stream, which may be in an earlier chunk.
 	u32 ptr;
 };
 
+// Each chunk is a header followed by its commands and then its data, compressed together.
+struct ChunkHeader {
+	u32 frame;
+	u32 numCommands;
+	// Position of the chunk's data in the data stream.
+	u32 bufBase;
+	u32 bufSize;
+	u32 compressedSize;
+};
+
+// After the chunks, there's one of these for each chunk and then an IndexTrailer.
+struct ChunkIndexEntry {
+	u64 offset;
+	ChunkHeader header;
+};
+
+struct IndexTrailer {
+	u64 indexOffset;
+	u32 numChunks;
+	u32 numFrames;
+	char magic[8];
+};
+
 #pragma pack(pop)
 
+// Data and commands of the chunk being recorded.
 static std::vector<u8> pushbuf;
+static u32 pushbufBase = 0;
 static std::vector<Command> commands;
 static std::vector<u32> lastRegisters;
-static std::vector<u32> lastTextures;
+
+static FILE *recordFile = nullptr;
+static std::string recordFilename;
+static u64 recordFileOffset = 0;
+static u32 recordFrame = 0;
+static std::vector<ChunkIndexEntry> recordChunks;
+static std::vector<u8> chunkScratch;
+static std::vector<u8> chunkCompressed;
+// Hash of previously recorded uploads -> position in the data stream.
+static DenseHashMap<u64, u32, 0xFFFFFFFF> recordedData(1024);
+
+// Reads the chunks of a dump, keeping the most recently used ones decompressed.
+class DumpReader {
+public:
+	~DumpReader() {
+		Close();
+	}
+
+	bool Open(const std::string &filename);
+	void Close();
+
+	bool IsOpen() const {
+		return open_;
+	}
+	int NumFrames() const {
+		return (int)frameStarts_.size();
+	}
+	// Copies the commands of the chunks recorded for this frame, in order.
+	bool FrameCommands(int frame, std::vector<Command> &cmds);
+
+	// Returns a pointer to sz bytes of data at pos, valid until the next call.
+	const u8 *Data(u32 pos, u32 sz);
+	// Copies up to sz bytes from pos, possibly across chunks.  Returns the bytes copied.
+	u32 CopyToMemory(u32 dest, u32 pos, u32 sz);
+
+private:
+	struct LoadedChunk {
+		int index = -1;
+		int lastUsed = 0;
+		u32 commandBytes = 0;
+		std::vector<u8> buf;
+	};
+
+	bool LoadVersion2();
+	bool ReadIndex(s64 fileSize);
+	bool ScanChunks(s64 fileSize);
+	int FindChunk(u32 pos) const;
+	LoadedChunk *Load(int index);
+
+	u32 fp_ = 0;
+	bool open_ = false;
+	std::vector<ChunkIndexEntry> chunks_;
+	std::vector<int> frameStarts_;
+	LoadedChunk cache_[CHUNK_CACHE_SIZE];
+	int generation_ = 0;
+	std::vector<u8> compressed_;
+};
+
+static DumpReader replayReader;
+static std::string replayFilename;
+static int replayFrame = 0;
 
 // TODO: Maybe move execute to another file?
 class DumpExecute {
 public:
 	~DumpExecute();
 
-	bool Run();
+	bool Run(int frame);
 
 private:
 	void SyncStall();
-	bool SubmitCmds(void *p, u32 sz);
+	bool SubmitCmds(const void *p, u32 sz);
 	void SubmitListEnd();
 
 	void Init(u32 ptr, u32 sz);
@@ -312,8 +416,7 @@ bool BufMapping::ExtraInfo::Alloc(u32 bufpos, u32 sz) {
 
 	buf_pointer_ = bufpos;
 	size_ = sz;
-	Memory::MemcpyUnchecked(psp_pointer_, pushbuf.data() + bufpos, sz);
-	return true;
+	return replayReader.CopyToMemory(psp_pointer_, bufpos, sz) == sz;
 }
 
 void BufMapping::ExtraInfo::Free() {
@@ -333,8 +436,7 @@ bool BufMapping::SlabInfo::Setup(u32 bufpos) {
 	}
 
 	buf_pointer_ = bufpos;
-	u32 sz = std::min((u32)SLAB_SIZE, (u32)pushbuf.size() - bufpos);
-	Memory::MemcpyUnchecked(psp_pointer_, pushbuf.data() + bufpos, sz);
+	replayReader.CopyToMemory(psp_pointer_, bufpos, SLAB_SIZE);
 
 	slabGeneration_++;
 	last_used_ = slabGeneration_;
@@ -343,19 +445,77 @@ bool BufMapping::SlabInfo::Setup(u32 bufpos) {
 
 int BufMapping::slabGeneration_ = 0;
 
+static u32 StreamPos() {
+	return pushbufBase + (u32)pushbuf.size();
+}
+
+// Appends to the chunk being recorded, returning the position in the data stream.
+static u32 PushData(const void *p, u32 sz, bool align) {
+	u32 pad = align ? (0x10 - (StreamPos() & 0xF)) & 0xF : 0;
+	size_t start = pushbuf.size();
+	pushbuf.resize(start + pad + sz);
+	if (pad) {
+		memset(pushbuf.data() + start, 0, pad);
+	}
+	memcpy(pushbuf.data() + start + pad, p, sz);
+	return pushbufBase + (u32)(start + pad);
+}
+
 static void FlushRegisters() {
 	if (!lastRegisters.empty()) {
 		Command last{CommandType::REGISTERS};
-		last.ptr = (u32)pushbuf.size();
 		last.sz = (u32)(lastRegisters.size() * sizeof(u32));
-		pushbuf.resize(pushbuf.size() + last.sz);
-		memcpy(pushbuf.data() + last.ptr, lastRegisters.data(), last.sz);
+		last.ptr = PushData(lastRegisters.data(), last.sz, false);
 		lastRegisters.clear();
 
 		commands.push_back(last);
 	}
 }
 
+static void FlushChunk() {
+	if (commands.empty() && pushbuf.empty()) {
+		return;
+	}
+
+	const u32 commandBytes = (u32)(commands.size() * sizeof(Command));
+	chunkScratch.resize(commandBytes + pushbuf.size());
+	memcpy(chunkScratch.data(), commands.data(), commandBytes);
+	if (!pushbuf.empty()) {
+		memcpy(chunkScratch.data() + commandBytes, pushbuf.data(), pushbuf.size());
+	}
+
+	size_t compressed_size = snappy_max_compressed_length(chunkScratch.size());
+	chunkCompressed.resize(compressed_size);
+	snappy_compress((const char *)chunkScratch.data(), chunkScratch.size(), (char *)chunkCompressed.data(), &compressed_size);
+
+	ChunkIndexEntry entry;
+	entry.offset = recordFileOffset;
+	entry.header.frame = recordFrame;
+	entry.header.numCommands = (u32)commands.size();
+	entry.header.bufBase = pushbufBase;
+	entry.header.bufSize = (u32)pushbuf.size();
+	entry.header.compressedSize = (u32)compressed_size;
+	fwrite(&entry.header, sizeof(entry.header), 1, recordFile);
+	fwrite(chunkCompressed.data(), compressed_size, 1, recordFile);
+	recordFileOffset += sizeof(entry.header) + compressed_size;
+	recordChunks.push_back(entry);
+
+	// Keep the capacity, so long recordings don't keep reallocating.
+	pushbufBase += (u32)pushbuf.size();
+	pushbuf.clear();
+	commands.clear();
+}
+
+static void MaybeFlushChunk() {
+	if (pushbuf.size() >= CHUNK_DATA_SIZE) {
+		FlushChunk();
+	}
+	if (StreamPos() >= MAX_STREAM_SIZE && !stopPending) {
+		WARN_LOG(G3D, "GE dump too large, stopping at the end of this frame");
+		stopPending = true;
+	}
+}
+
 static std::string GenRecordingFilename() {
 	const std::string dumpDir = GetSysDirectory(DIRECTORY_DUMP);
 	const std::string prefix = dumpDir + "/" + g_paramSFO.GetDiscID();
@@ -381,58 +541,63 @@ static void EmitDisplayBuf() {
 	DisplayBufData disp{};
 	__DisplayGetFramebuf(&disp.topaddr, &disp.linesize, &disp.pixelFormat, 0);
 
-	u32 ptr = (u32)pushbuf.size();
 	u32 sz = (u32)sizeof(disp);
-	pushbuf.resize(pushbuf.size() + sz);
-	memcpy(pushbuf.data() + ptr, &disp, sz);
+	u32 ptr = PushData(&disp, sz, false);
 
 	commands.push_back({CommandType::DISPLAY, sz, ptr});
 }
 
-static void BeginRecording() {
-	u32 ptr = (u32)pushbuf.size();
-	u32 sz = 512 * 4;
-	pushbuf.resize(pushbuf.size() + sz);
-	gstate.Save((u32_le *)(pushbuf.data() + ptr));
+static void BeginFrame() {
+	// Every frame starts with the full state, so it can be replayed on its own.
+	u32_le state[512];
+	gstate.Save(state);
+	u32 sz = (u32)sizeof(state);
+	u32 ptr = PushData(state, sz, false);
 
 	commands.push_back({CommandType::INIT, sz, ptr});
 }
 
-static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
-	size_t compressed_size = snappy_max_compressed_length(sz);
-	u8 *compressed = new u8[compressed_size];
-	snappy_compress((const char *)p, sz, (char *)compressed, &compressed_size);
+static bool BeginRecording() {
+	recordFilename = GenRecordingFilename();
+	NOTICE_LOG(G3D, "Recording filename: %s", recordFilename.c_str());
 
-	u32 write_size = (u32)compressed_size;
-	fwrite(&write_size, sizeof(write_size), 1, fp);
-	fwrite(compressed, compressed_size, 1, fp);
-
-	delete [] compressed;
+	recordFile = File::OpenCFile(recordFilename, "wb");
+	if (!recordFile) {
+		ERROR_LOG(G3D, "Unable to open %s for GE dump", recordFilename.c_str());
+		return false;
+	}
+	fwrite(HEADER, 8, 1, recordFile);
+	fwrite(&VERSION, sizeof(VERSION), 1, recordFile);
+	recordFileOffset = 8 + sizeof(VERSION);
+
+	pushbufBase = 0;
+	recordFrame = 0;
+	recordChunks.clear();
+	recordedData.Clear();
+	BeginFrame();
+	return true;
 }
 
 static std::string WriteRecording() {
 	FlushRegisters();
-	EmitDisplayBuf();
-
-	const std::string filename = GenRecordingFilename();
-
-	NOTICE_LOG(G3D, "Recording filename: %s", filename.c_str());
+	FlushChunk();
 
-	FILE *fp = File::OpenCFile(filename, "wb");
-	fwrite(HEADER, 8, 1, fp);
-	fwrite(&VERSION, sizeof(VERSION), 1, fp);
-
-	u32 sz = (u32)commands.size();
-	fwrite(&sz, sizeof(sz), 1, fp);
-	u32 bufsz = (u32)pushbuf.size();
-	fwrite(&bufsz, sizeof(bufsz), 1, fp);
+	const u64 indexOffset = recordFileOffset;
+	if (!recordChunks.empty()) {
+		fwrite(recordChunks.data(), sizeof(ChunkIndexEntry), recordChunks.size(), recordFile);
+	}
 
-	WriteCompressed(fp, commands.data(), commands.size() * sizeof(Command));
-	WriteCompressed(fp, pushbuf.data(), bufsz);
+	IndexTrailer trailer{};
+	trailer.indexOffset = indexOffset;
+	trailer.numChunks = (u32)recordChunks.size();
+	trailer.numFrames = recordFrame;
+	memcpy(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic));
+	fwrite(&trailer, sizeof(trailer), 1, recordFile);
 
-	fclose(fp);
+	fclose(recordFile);
+	recordFile = nullptr;
 
-	return filename;
+	return recordFilename;
 }
 
 static void GetVertDataSizes(int vcount, const void *indices, u32 &vbytes, u32 &ibytes) {
@@ -488,6 +653,15 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz) {
 	Command cmd{t, sz, 0};
 
 	if (sz) {
+		// Most uploads (textures especially) repeat every frame, and earlier chunks are already
+		// written out, so look those up by hash.
+		const u64 hash = XXH64(p, sz, sz);
+		u32 prevPos = recordedData.Get(hash);
+		if (prevPos != 0xFFFFFFFF) {
+			commands.push_back({t, sz, prevPos});
+			return commands.back();
+		}
+
 		// If at all possible, try to find it already in the buffer.
 		const u8 *prev = nullptr;
 		const size_t NEAR_WINDOW = std::max((int)sz * 2, 1024 * 10);
@@ -500,20 +674,15 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz) {
 		}
 
 		if (prev) {
-			cmd.ptr = (u32)(prev - pushbuf.data());
+			cmd.ptr = pushbufBase + (u32)(prev - pushbuf.data());
 		} else {
-			cmd.ptr = (u32)pushbuf.size();
-			int pad = 0;
-			if (cmd.ptr & 0xF) {
-				pad = 0x10 - (cmd.ptr & 0xF);
-				cmd.ptr += pad;
-			}
-			pushbuf.resize(pushbuf.size() + sz + pad);
-			if (pad) {
-				memset(pushbuf.data() + cmd.ptr - pad, 0, pad);
-			}
-			memcpy(pushbuf.data() + cmd.ptr, p, sz);
+			cmd.ptr = PushData(p, sz, true);
+		}
+
+		if (recordedData.size() >= MAX_DEDUP_ENTRIES) {
+			recordedData.Clear();
 		}
+		recordedData.Insert(hash, cmd.ptr);
 	}
 
 	commands.push_back(cmd);
@@ -536,22 +705,8 @@ static void EmitTextureData(int level, u32 texaddr) {
 		CommandType type = CommandType((int)CommandType::TEXTURE0 + level);
 		const u8 *p = Memory::GetPointerUnchecked(texaddr);
 
-		// Dumps are huge - let's try to find this already emitted.
-		for (u32 prevptr : lastTextures) {
-			if (pushbuf.size() < prevptr + bytes) {
-				continue;
-			}
-
-			if (memcmp(pushbuf.data() + prevptr, p, bytes) == 0) {
-				commands.push_back({type, bytes, prevptr});
-				// Okay, that was easy.  Bail out.
-				return;
-			}
-		}
-
-		// Not there, gotta emit anew.
-		Command cmd = EmitCommandWithRAM(type, p, bytes);
-		lastTextures.push_back(cmd.ptr);
+		// Dumps are huge, but this will reuse the texture if it was already emitted.
+		EmitCommandWithRAM(type, p, bytes);
 	}
 }
 
@@ -644,9 +799,11 @@ bool IsActivePending() {
 	return nextFrame || active;
 }
 
-bool Activate() {
-	if (!nextFrame) {
+bool Activate(int frames) {
+	if (!nextFrame && !active) {
 		nextFrame = true;
+		framesToRecord = std::max(frames, 1);
+		stopPending = false;
 		return true;
 	}
 	return false;
@@ -661,9 +818,17 @@ static void FinishRecording() {
 	std::string filename = WriteRecording();
 	commands.clear();
 	pushbuf.clear();
+	pushbuf.shrink_to_fit();
+	recordChunks.clear();
+	recordedData.Clear();
+	chunkScratch.clear();
+	chunkScratch.shrink_to_fit();
+	chunkCompressed.clear();
+	chunkCompressed.shrink_to_fit();
 
 	NOTICE_LOG(SYSTEM, "Recording finished");
 	writePending = false;
+	stopPending = false;
 	active = false;
 
 	if (writeCallback)
@@ -671,14 +836,32 @@ static void FinishRecording() {
 	writeCallback = nullptr;
 }
 
+// Returns false if that was the last frame.
+static bool FinishFrame() {
+	FlushRegisters();
+	EmitDisplayBuf();
+	FlushChunk();
+	recordFrame++;
+	writePending = false;
+
+	bool more = (int)recordFrame < framesToRecord;
+	if (!more || stopPending) {
+		FinishRecording();
+		return false;
+	}
+
+	BeginFrame();
+	return true;
+}
+
 void NotifyCommand(u32 pc) {
 	if (!active) {
 		return;
 	}
-	if (writePending) {
-		FinishRecording();
+	if (writePending && !FinishFrame()) {
 		return;
 	}
+	MaybeFlushChunk();
 
 	const u32 op = Memory::Read_U32(pc);
 	const GECommand cmd = GECommand(op >> 24);
@@ -734,12 +917,12 @@ void NotifyMemcpy(u32 dest, u32 src, u32 sz) {
 	}
 	if (Memory::IsVRAMAddress(dest)) {
 		FlushRegisters();
-		Command cmd{CommandType::MEMCPYDEST, sizeof(dest), (u32)pushbuf.size()};
-		pushbuf.resize(pushbuf.size() + sizeof(dest));
-		memcpy(pushbuf.data() + cmd.ptr, &dest, sizeof(dest));
+		Command cmd{CommandType::MEMCPYDEST, sizeof(dest), PushData(&dest, sizeof(dest), false)};
+		commands.push_back(cmd);
 
 		sz = Memory::ValidSize(dest, sz);
 		EmitCommandWithRAM(CommandType::MEMCPYDATA, Memory::GetPointer(dest), sz);
+		MaybeFlushChunk();
 	}
 }
 
@@ -758,9 +941,8 @@ void NotifyMemset(u32 dest, int v, u32 sz) {
 		MemsetCommand data{dest, v, sz};
 
 		FlushRegisters();
-		Command cmd{CommandType::MEMSET, sizeof(data), (u32)pushbuf.size()};
-		pushbuf.resize(pushbuf.size() + sizeof(data));
-		memcpy(pushbuf.data() + cmd.ptr, &data, sizeof(data));
+		Command cmd{CommandType::MEMSET, sizeof(data), PushData(&data, sizeof(data), false)};
+		commands.push_back(cmd);
 	}
 }
 
@@ -772,17 +954,15 @@ void NotifyUpload(u32 dest, u32 sz) {
 }
 
 void NotifyFrame() {
-	if (active && !writePending && !commands.empty()) {
-		// Delay write until the first command of the next frame, so we get the right display buf.
-		NOTICE_LOG(SYSTEM, "Recording complete - waiting to get display buffer");
+	if (active && !writePending) {
+		// Delay the end of the frame until its first command, so we get the right display buf.
+		DEBUG_LOG(SYSTEM, "Recorded frame - waiting to get display buffer");
 		writePending = true;
 	}
 	if (nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0) {
 		NOTICE_LOG(SYSTEM, "Recording starting...");
-		active = true;
+		active = BeginRecording();
 		nextFrame = false;
-		lastTextures.clear();
-		BeginRecording();
 	}
 }
 
@@ -797,7 +977,7 @@ void DumpExecute::SyncStall() {
 	CoreTiming::ForceCheck();
 }
 
-bool DumpExecute::SubmitCmds(void *p, u32 sz) {
+bool DumpExecute::SubmitCmds(const void *p, u32 sz) {
 	if (execListBuf == 0) {
 		u32 allocSize = LIST_BUF_SIZE;
 		execListBuf = userMemory.Alloc(allocSize, "List buf");
@@ -882,12 +1062,22 @@ void DumpExecute::SubmitListEnd() {
 }
 
 void DumpExecute::Init(u32 ptr, u32 sz) {
-	gstate.Restore((u32_le *)(pushbuf.data() + ptr));
+	const u8 *data = replayReader.Data(ptr, sz);
+	if (!data || sz < 512 * 4) {
+		ERROR_LOG(SYSTEM, "Bad GE dump init data");
+		return;
+	}
+	gstate.Restore((u32_le *)data);
 	gpu->ReapplyGfxState();
 }
 
 void DumpExecute::Registers(u32 ptr, u32 sz) {
-	SubmitCmds(pushbuf.data() + ptr, sz);
+	const u8 *data = replayReader.Data(ptr, sz);
+	if (!data) {
+		ERROR_LOG(SYSTEM, "Bad GE dump register data");
+		return;
+	}
+	SubmitCmds(data, sz);
 }
 
 void DumpExecute::Vertices(u32 ptr, u32 sz) {
@@ -944,22 +1134,25 @@ void DumpExecute::Memset(u32 ptr, u32 sz) {
 		u32 sz;
 	};
 
-	const MemsetCommand *data = (const MemsetCommand *)(pushbuf.data() + ptr);
+	const MemsetCommand *data = (const MemsetCommand *)replayReader.Data(ptr, sizeof(MemsetCommand));
 
-	if (Memory::IsVRAMAddress(data->dest)) {
+	if (data && Memory::IsVRAMAddress(data->dest)) {
 		SyncStall();
 		gpu->PerformMemorySet(data->dest, (u8)data->value, data->sz);
 	}
 }
 
 void DumpExecute::MemcpyDest(u32 ptr, u32 sz) {
-	execMemcpyDest = *(const u32 *)(pushbuf.data() + ptr);
+	const u8 *data = replayReader.Data(ptr, sizeof(u32));
+	execMemcpyDest = data ? *(const u32 *)data : 0;
 }
 
 void DumpExecute::Memcpy(u32 ptr, u32 sz) {
 	if (Memory::IsVRAMAddress(execMemcpyDest)) {
 		SyncStall();
-		Memory::MemcpyUnchecked(execMemcpyDest, pushbuf.data() + ptr, sz);
+		if (replayReader.CopyToMemory(execMemcpyDest, ptr, sz) != sz) {
+			ERROR_LOG(SYSTEM, "Bad GE dump memcpy data");
+		}
 		gpu->PerformMemoryUpload(execMemcpyDest, sz);
 	}
 }
@@ -983,7 +1176,11 @@ void DumpExecute::Display(u32 ptr, u32 sz) {
 		u32 linesize, pixelFormat;
 	};
 
-	DisplayBufData *disp = (DisplayBufData *)(pushbuf.data() + ptr);
+	const DisplayBufData *disp = (const DisplayBufData *)replayReader.Data(ptr, sizeof(DisplayBufData));
+	if (!disp) {
+		ERROR_LOG(SYSTEM, "Bad GE dump display data");
+		return;
+	}
 
 	// Sync up drawing.
 	SyncStall();
@@ -1000,13 +1197,15 @@ DumpExecute::~DumpExecute() {
 	}
 	execListPos = 0;
 	execMapping.Reset();
-
-	commands.clear();
-	pushbuf.clear();
 }
 
-bool DumpExecute::Run() {
-	for (const Command &cmd : commands) {
+bool DumpExecute::Run(int frame) {
+	std::vector<Command> frameCommands;
+	if (!replayReader.FrameCommands(frame, frameCommands)) {
+		return false;
+	}
+
+	for (const Command &cmd : frameCommands) {
 		switch (cmd.type) {
 		case CommandType::INIT:
 			Init(cmd.ptr, cmd.sz);
@@ -1088,42 +1287,280 @@ static bool ReadCompressed(u32 fp, void *dest, size_t sz) {
 	return real_size == sz;
 }
 
-bool RunMountedReplay(const std::string &filename) {
-	_assert_msg_(SYSTEM, !active && !nextFrame, "Cannot run replay while recording.");
+static void SeekTo(u32 fp, u64 pos) {
+	// SeekFile only takes s32, and long recordings can be larger.
+	pspFileSystem.SeekFile(fp, 0, FILEMOVE_BEGIN);
+	while (pos > 0) {
+		s32 step = (s32)std::min(pos, (u64)0x40000000);
+		pspFileSystem.SeekFile(fp, step, FILEMOVE_CURRENT);
+		pos -= step;
+	}
+}
+
+bool DumpReader::Open(const std::string &filename) {
+	Close();
+
+	const s64 fileSize = pspFileSystem.GetFileInfo(filename).size;
+	fp_ = pspFileSystem.OpenFile(filename, FILEACCESS_READ);
+	open_ = true;
 
-	u32 fp = pspFileSystem.OpenFile(filename, FILEACCESS_READ);
 	u8 header[8]{};
 	int version = 0;
-	pspFileSystem.ReadFile(fp, header, sizeof(header));
-	pspFileSystem.ReadFile(fp, (u8 *)&version, sizeof(version));
+	pspFileSystem.ReadFile(fp_, header, sizeof(header));
+	pspFileSystem.ReadFile(fp_, (u8 *)&version, sizeof(version));
 
-	if (memcmp(header, HEADER, sizeof(header)) != 0 || version != VERSION) {
+	if (memcmp(header, HEADER, sizeof(header)) != 0 || version < MIN_VERSION || version > VERSION) {
 		ERROR_LOG(SYSTEM, "Invalid GE dump or unsupported version");
-		pspFileSystem.CloseFile(fp);
+		Close();
+		return false;
+	}
+
+	bool success;
+	if (version == 2) {
+		success = LoadVersion2();
+	} else {
+		success = ReadIndex(fileSize) || ScanChunks(fileSize);
+	}
+	if (!success) {
+		ERROR_LOG(SYSTEM, "Truncated GE dump");
+		Close();
 		return false;
 	}
 
+	for (size_t i = 0; i < chunks_.size(); ++i) {
+		if (i == 0 || chunks_[i].header.frame != chunks_[i - 1].header.frame) {
+			frameStarts_.push_back((int)i);
+		}
+	}
+	return true;
+}
+
+void DumpReader::Close() {
+	if (open_) {
+		pspFileSystem.CloseFile(fp_);
+		open_ = false;
+	}
+	chunks_.clear();
+	frameStarts_.clear();
+	for (int i = 0; i < CHUNK_CACHE_SIZE; ++i) {
+		cache_[i].index = -1;
+		cache_[i].buf.clear();
+		cache_[i].buf.shrink_to_fit();
+	}
+	compressed_.clear();
+	compressed_.shrink_to_fit();
+}
+
+bool DumpReader::LoadVersion2() {
 	u32 sz = 0;
-	pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
+	pspFileSystem.ReadFile(fp_, (u8 *)&sz, sizeof(sz));
 	u32 bufsz = 0;
-	pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
+	pspFileSystem.ReadFile(fp_, (u8 *)&bufsz, sizeof(bufsz));
 
-	commands.resize(sz);
-	pushbuf.resize(bufsz);
+	// The whole thing is a single chunk, always in the cache.
+	LoadedChunk &chunk = cache_[0];
+	chunk.commandBytes = (u32)(sizeof(Command) * sz);
+	chunk.buf.resize(chunk.commandBytes + bufsz);
 
 	bool truncated = false;
-	truncated = truncated || !ReadCompressed(fp, commands.data(), sizeof(Command) * sz);
-	truncated = truncated || !ReadCompressed(fp, pushbuf.data(), bufsz);
+	truncated = truncated || !ReadCompressed(fp_, chunk.buf.data(), chunk.commandBytes);
+	truncated = truncated || !ReadCompressed(fp_, chunk.buf.data() + chunk.commandBytes, bufsz);
+	if (truncated) {
+		return false;
+	}
 
-	pspFileSystem.CloseFile(fp);
+	ChunkIndexEntry entry{};
+	entry.header.numCommands = sz;
+	entry.header.bufSize = bufsz;
+	chunks_.push_back(entry);
+	chunk.index = 0;
+	return true;
+}
 
-	if (truncated) {
-		ERROR_LOG(SYSTEM, "Truncated GE dump");
+bool DumpReader::ReadIndex(s64 fileSize) {
+	if (fileSize < (s64)(12 + sizeof(IndexTrailer))) {
+		return false;
+	}
+
+	IndexTrailer trailer{};
+	SeekTo(fp_, fileSize - sizeof(IndexTrailer));
+	if (pspFileSystem.ReadFile(fp_, (u8 *)&trailer, sizeof(trailer)) != sizeof(trailer)) {
+		return false;
+	}
+	if (memcmp(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic)) != 0) {
+		return false;
+	}
+	if (trailer.indexOffset + (u64)trailer.numChunks * sizeof(ChunkIndexEntry) + sizeof(IndexTrailer) != (u64)fileSize) {
+		return false;
+	}
+
+	chunks_.resize(trailer.numChunks);
+	SeekTo(fp_, trailer.indexOffset);
+	size_t bytes = trailer.numChunks * sizeof(ChunkIndexEntry);
+	if (pspFileSystem.ReadFile(fp_, (u8 *)chunks_.data(), bytes) != bytes) {
+		chunks_.clear();
+		return false;
+	}
+	return !chunks_.empty();
+}
+
+bool DumpReader::ScanChunks(s64 fileSize) {
+	// No index, probably the recording didn't finish.  Walk the chunks that did get written.
+	WARN_LOG(SYSTEM, "GE dump has no index, scanning chunks");
+	u64 pos = 12;
+	u32 bufBase = 0;
+	while (pos + sizeof(ChunkHeader) <= (u64)fileSize) {
+		ChunkIndexEntry entry;
+		entry.offset = pos;
+		SeekTo(fp_, pos);
+		if (pspFileSystem.ReadFile(fp_, (u8 *)&entry.header, sizeof(ChunkHeader)) != sizeof(ChunkHeader)) {
+			break;
+		}
+		pos += sizeof(ChunkHeader) + entry.header.compressedSize;
+		if (pos > (u64)fileSize || entry.header.bufBase != bufBase) {
+			break;
+		}
+		bufBase += entry.header.bufSize;
+		chunks_.push_back(entry);
+	}
+	return !chunks_.empty();
+}
+
+int DumpReader::FindChunk(u32 pos) const {
+	// The last chunk starting at or before pos.  Chunks without data share bufBase with the next.
+	auto it = std::upper_bound(chunks_.begin(), chunks_.end(), pos, [](u32 p, const ChunkIndexEntry &entry) {
+		return p < entry.header.bufBase;
+	});
+	if (it == chunks_.begin()) {
+		return -1;
+	}
+	return (int)(it - chunks_.begin()) - 1;
+}
+
+DumpReader::LoadedChunk *DumpReader::Load(int index) {
+	int oldest = 0;
+	for (int i = 0; i < CHUNK_CACHE_SIZE; ++i) {
+		if (cache_[i].index == index) {
+			cache_[i].lastUsed = ++generation_;
+			return &cache_[i];
+		}
+		if (cache_[i].lastUsed < cache_[oldest].lastUsed) {
+			oldest = i;
+		}
+	}
+
+	const ChunkHeader &header = chunks_[index].header;
+	LoadedChunk &chunk = cache_[oldest];
+	chunk.index = -1;
+	chunk.commandBytes = (u32)(header.numCommands * sizeof(Command));
+
+	compressed_.resize(header.compressedSize);
+	SeekTo(fp_, chunks_[index].offset + sizeof(ChunkHeader));
+	if (pspFileSystem.ReadFile(fp_, compressed_.data(), header.compressedSize) != header.compressedSize) {
+		ERROR_LOG(SYSTEM, "Truncated GE dump chunk");
+		return nullptr;
+	}
+
+	size_t real_size = 0;
+	const char *src = (const char *)compressed_.data();
+	if (snappy_uncompressed_length(src, compressed_.size(), &real_size) != SNAPPY_OK || real_size != (size_t)chunk.commandBytes + header.bufSize) {
+		ERROR_LOG(SYSTEM, "Corrupt GE dump chunk");
+		return nullptr;
+	}
+	chunk.buf.resize(real_size);
+	if (snappy_uncompress(src, compressed_.size(), (char *)chunk.buf.data(), &real_size) != SNAPPY_OK) {
+		ERROR_LOG(SYSTEM, "Corrupt GE dump chunk");
+		return nullptr;
+	}
+
+	chunk.index = index;
+	chunk.lastUsed = ++generation_;
+	return &chunk;
+}
+
+bool DumpReader::FrameCommands(int frame, std::vector<Command> &cmds) {
+	if (frame < 0 || frame >= NumFrames()) {
 		return false;
 	}
 
+	int start = frameStarts_[frame];
+	int end = frame + 1 < NumFrames() ? frameStarts_[frame + 1] : (int)chunks_.size();
+	for (int i = start; i < end; ++i) {
+		const LoadedChunk *chunk = Load(i);
+		if (!chunk) {
+			return false;
+		}
+		const Command *first = (const Command *)chunk->buf.data();
+		cmds.insert(cmds.end(), first, first + chunks_[i].header.numCommands);
+	}
+	return true;
+}
+
+const u8 *DumpReader::Data(u32 pos, u32 sz) {
+	int index = FindChunk(pos);
+	if (index < 0) {
+		return nullptr;
+	}
+	const ChunkHeader &header = chunks_[index].header;
+	if ((u64)pos + sz > (u64)header.bufBase + header.bufSize) {
+		return nullptr;
+	}
+
+	const LoadedChunk *chunk = Load(index);
+	if (!chunk) {
+		return nullptr;
+	}
+	return chunk->buf.data() + chunk->commandBytes + (pos - header.bufBase);
+}
+
+u32 DumpReader::CopyToMemory(u32 dest, u32 pos, u32 sz) {
+	u32 copied = 0;
+	while (copied < sz) {
+		int index = FindChunk(pos + copied);
+		if (index < 0) {
+			break;
+		}
+		const ChunkHeader &header = chunks_[index].header;
+		u32 offset = pos + copied - header.bufBase;
+		if (offset >= header.bufSize) {
+			break;
+		}
+
+		u32 n = std::min(sz - copied, header.bufSize - offset);
+		const u8 *data = Data(pos + copied, n);
+		if (!data) {
+			break;
+		}
+		Memory::MemcpyUnchecked(dest + copied, data, n);
+		copied += n;
+	}
+	return copied;
+}
+
+bool RunMountedReplay(const std::string &filename) {
+	_assert_msg_(SYSTEM, !active && !nextFrame, "Cannot run replay while recording.");
+
+	// Each call replays the next frame, looping back at the end.
+	if (filename != replayFilename || !replayReader.IsOpen()) {
+		replayFilename.clear();
+		if (!replayReader.Open(filename)) {
+			return false;
+		}
+		replayFilename = filename;
+		replayFrame = 0;
+	}
+	if (replayFrame >= replayReader.NumFrames()) {
+		replayFrame = 0;
+	}
+
 	DumpExecute executor;
-	return executor.Run();
+	return executor.Run(replayFrame++);
+}
+
+void CloseMountedReplay() {
+	replayReader.Close();
+	replayFilename.clear();
+	replayFrame = 0;
 }
 
 };
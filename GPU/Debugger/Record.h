@@ -25,7 +25,8 @@ namespace GPURecord {
 
 bool IsActive();
 bool IsActivePending();
-bool Activate();
+// Starts recording on the next frame, for this many frames.
+bool Activate(int frames = 1);
 // Call only if Activate() returns true.
 void SetCallback(const std::function<void(const std::string &)> callback);
 
@@ -35,6 +36,9 @@ void NotifyMemset(u32 dest, int v, u32 sz);
 void NotifyUpload(u32 dest, u32 sz);
 void NotifyFrame();
 
+// Replays the next frame of the dump each time it's called, looping at the end.
+// The dump stays open between calls, until CloseMountedReplay().
 bool RunMountedReplay(const std::string &filename);
+void CloseMountedReplay();
 
 };
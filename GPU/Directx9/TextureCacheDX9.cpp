@@ -71,6 +71,7 @@ TextureCacheDX9::TextureCacheDX9(Draw::DrawContext *draw)
 		maxAnisotropyLevel = pCaps.MaxAnisotropy;
 	}
 	SetupTextureDecoder();
+	asyncScaler_.reset(new TextureScalerAsync(new TextureScalerDX9()));
 
 	nextTexture_ = nullptr;
 	device_->CreateVertexDeclaration(g_FramebufferVertexElements, &pFramebufferVertexDecl);
@@ -226,6 +227,7 @@ void TextureCacheDX9::StartFrame() {
 		// INFO_LOG(G3D, "Scaled %i texels", texelsScaledThisFrame_);
 	}
 	texelsScaledThisFrame_ = 0;
+	asyncScaler_->PublishFinished(gpuStats.numFlips);
 	if (clearCacheNextFrame_) {
 		Clear(true);
 		clearCacheNextFrame_ = false;
@@ -545,22 +547,7 @@ void TextureCacheDX9::BuildTexture(TexCacheEntry *const entry) {
 	// Don't scale the PPGe texture.
 	if (entry->addr > 0x05000000 && entry->addr < PSP_GetKernelMemoryEnd())
 		scaleFactor = 1;
-	if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0 && scaleFactor != 1) {
-		// Remember for later that we /wanted/ to scale this texture.
-		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
-		scaleFactor = 1;
-	}
-
-	if (scaleFactor != 1) {
-		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED) {
-			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
-			scaleFactor = 1;
-		} else {
-			entry->status &= ~TexCacheEntry::STATUS_TO_SCALE;
-			entry->status |= TexCacheEntry::STATUS_IS_SCALED;
-			texelsScaledThisFrame_ += w * h;
-		}
-	}
+	scaleFactor = ScaleFactorForBuild(entry, scaleFactor, w, h);
 
 	// Seems to cause problems in Tactics Ogre.
 	if (badMipSizes) {
@@ -725,18 +712,23 @@ void TextureCacheDX9::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &re
 			decPitch = w * bpp;
 		}
 
-		DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, false);
+		// If the worker already scaled this level, it was decoded for the placeholder and ScaleLevel() takes it.
+		if (!AsyncScaleReady(entry, scaleFactor, w, h)) {
+			DecodeTextureLevel((u8 *)pixelData, decPitch, tfmt, clutformat, texaddr, level, bufw, false, false, false);
 
-		// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
-		if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
-			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
-			entry.SetAlphaStatus(alphaStatus, level);
-		} else {
-			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
+			if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+				TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / bpp, w, h);
+				entry.SetAlphaStatus(alphaStatus, level);
+			} else {
+				entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			}
+
+			QueueAsyncScale(entry, (const u8 *)pixelData, decPitch, dstFmt, w, h, bpp);
 		}
 
 		if (scaleFactor > 1) {
-			scaler.ScaleAlways((u32 *)rect.pBits, pixelData, dstFmt, w, h, scaleFactor);
+			ScaleLevel(scaler, entry, (u32 *)rect.pBits, pixelData, dstFmt, w, h, scaleFactor);
 			pixelData = (u32 *)rect.pBits;
 
 			// We always end up at 8888.  Other parts assume this.
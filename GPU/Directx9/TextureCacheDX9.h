@@ -86,7 +86,6 @@ class TextureCacheDX9 : public TextureCacheCommon {
 	float maxAnisotropyLevel;
 
 	int decimationCounter_;
-	int texelsScaledThisFrame_;
 	int timesInvalidatedAllThisFrame_;
 
 	FramebufferManagerDX9 *framebufferManagerDX9_;
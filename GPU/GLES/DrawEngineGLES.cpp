@@ -66,9 +66,7 @@ enum {
 #define VERTEXCACHE_NAME_CACHE_FULL_BYTES (1024 * 1024)
 #define VERTEXCACHE_NAME_CACHE_MAX_AGE 120
 
-enum { VAI_KILL_AGE = 120, VAI_UNRELIABLE_KILL_AGE = 240, VAI_UNRELIABLE_KILL_MAX = 4 };
-
-DrawEngineGLES::DrawEngineGLES(Draw::DrawContext *draw) : vai_(256), draw_(draw), inputLayoutMap_(16) {
+DrawEngineGLES::DrawEngineGLES(Draw::DrawContext *draw) : draw_(draw), inputLayoutMap_(16) {
 	render_ = (GLRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
 
 	decOptions_.expandAllWeightsToFloat = false;
@@ -239,62 +237,25 @@ void DrawEngineGLES::DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindO
 	DecodeVerts(dest);
 }
 
-void DrawEngineGLES::MarkUnreliable(VertexArrayInfo *vai) {
-	vai->status = VertexArrayInfo::VAI_UNRELIABLE;
-	if (vai->vbo) {
-		render_->DeleteBuffer(vai->vbo);
-		vai->vbo = 0;
-	}
-	if (vai->ebo) {
-		render_->DeleteBuffer(vai->ebo);
-		vai->ebo = 0;
-	}
-}
-
 void DrawEngineGLES::ClearTrackedVertexArrays() {
-	vai_.Iterate([&](uint32_t hash, VertexArrayInfo *vai){
-		FreeVertexArray(vai);
-		delete vai;
-	});
-	vai_.Clear();
-}
-
-void DrawEngineGLES::DecimateTrackedVertexArrays() {
-	if (--decimationCounter_ <= 0) {
-		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
-	} else {
-		return;
+	geometryCache_.Clear();
+	if (geometryBuffer_) {
+		render_->DeleteBuffer(geometryBuffer_);
+		geometryBuffer_ = nullptr;
 	}
-
-	const int threshold = gpuStats.numFlips - VAI_KILL_AGE;
-	const int unreliableThreshold = gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE;
-	int unreliableLeft = VAI_UNRELIABLE_KILL_MAX;
-	vai_.Iterate([&](uint32_t hash, VertexArrayInfo *vai) {
-		bool kill;
-		if (vai->status == VertexArrayInfo::VAI_UNRELIABLE) {
-			// We limit killing unreliable so we don't rehash too often.
-			kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
-		} else {
-			kill = vai->lastFrame < threshold;
-		}
-		if (kill) {
-			FreeVertexArray(vai);
-			delete vai;
-			vai_.Remove(hash);
-		}
-	});
-	vai_.Maintain();
 }
 
-void DrawEngineGLES::FreeVertexArray(VertexArrayInfo *vai) {
-	if (vai->vbo) {
-		render_->DeleteBuffer(vai->vbo);
-		vai->vbo = nullptr;
-	}
-	if (vai->ebo) {
-		render_->DeleteBuffer(vai->ebo);
-		vai->ebo = nullptr;
+// Mirrors what's new in the geometry cache's ring into geometryBuffer_.
+void DrawEngineGLES::UploadGeometry() {
+	if (!geometryBuffer_) {
+		geometryBuffer_ = render_->CreateBuffer(GL_ARRAY_BUFFER, DecodedGeometryCache::RING_SIZE, GL_STATIC_DRAW);
 	}
+	geometryCache_.FlushUploads([&](u32 offset, u32 size, const u8 *data) {
+		// The ring may be written again before the render thread gets to this.
+		u8 *copy = new u8[size];
+		memcpy(copy, data, size);
+		render_->BufferSubdata(geometryBuffer_, offset, size, copy);
+	});
 }
 
 void DrawEngineGLES::DoFlush() {
@@ -303,7 +264,6 @@ void DrawEngineGLES::DoFlush() {
 	FrameData &frameData = frameData_[render_->GetCurFrame()];
 	
 	gpuStats.numFlushes++;
-	gpuStats.numTrackedVertexArrays = (int)vai_.size();
 
 	bool textureNeedsApply = false;
 	if (gstate_c.IsDirty(DIRTY_TEXTURE_IMAGE | DIRTY_TEXTURE_PARAMS) && !gstate.isModeClear() && gstate.isTextureMapEnabled()) {
@@ -329,152 +289,19 @@ void DrawEngineGLES::DoFlush() {
 		int vertexCount = 0;
 		bool useElements = true;
 
-		// Cannot cache vertex data with morph enabled.
-		bool useCache = g_Config.bVertexCache && !(lastVType_ & GE_VTYPE_MORPHCOUNT_MASK);
-		// Also avoid caching when software skinning.
-		if (g_Config.bSoftwareSkinning && (lastVType_ & GE_VTYPE_WEIGHT_MASK))
-			useCache = false;
-
-		// TEMPORARY
-		useCache = false;
-
-		if (useCache) {
-			u32 id = dcid_ ^ gstate.getUVGenMode();  // This can have an effect on which UV decoder we need to use! And hence what the decoded data will look like. See #9263
-			VertexArrayInfo *vai = vai_.Get(id);
-			if (!vai) {
-				vai = new VertexArrayInfo();
-				vai_.Insert(id, vai);
-			}
-
-			switch (vai->status) {
-			case VertexArrayInfo::VAI_NEW:
-				{
-					// Haven't seen this one before.
-					ReliableHashType dataHash = ComputeHash();
-					vai->hash = dataHash;
-					vai->minihash = ComputeMiniHash();
-					vai->status = VertexArrayInfo::VAI_HASHING;
-					vai->drawsUntilNextFullHash = 0;
-					DecodeVerts(decoded); // writes to indexGen
-					vai->numVerts = indexGen.VertexCount();
-					vai->prim = indexGen.Prim();
-					vai->maxIndex = indexGen.MaxIndex();
-					vai->flags = gstate_c.vertexFullAlpha ? VAI_FLAG_VERTEXFULLALPHA : 0;
-
-					goto rotateVBO;
-				}
-
-				// Hashing - still gaining confidence about the buffer.
-				// But if we get this far it's likely to be worth creating a vertex buffer.
-			case VertexArrayInfo::VAI_HASHING:
-				{
-					vai->numDraws++;
-					if (vai->lastFrame != gpuStats.numFlips) {
-						vai->numFrames++;
-					}
-					if (vai->drawsUntilNextFullHash == 0) {
-						// Let's try to skip a full hash if mini would fail.
-						const u32 newMiniHash = ComputeMiniHash();
-						ReliableHashType newHash = vai->hash;
-						if (newMiniHash == vai->minihash) {
-							newHash = ComputeHash();
-						}
-						if (newMiniHash != vai->minihash || newHash != vai->hash) {
-							MarkUnreliable(vai);
-							DecodeVerts(decoded);
-							goto rotateVBO;
-						}
-						if (vai->numVerts > 64) {
-							// exponential backoff up to 16 draws, then every 32
-							vai->drawsUntilNextFullHash = std::min(32, vai->numFrames);
-						} else {
-							// Lower numbers seem much more likely to change.
-							vai->drawsUntilNextFullHash = 0;
-						}
-						// TODO: tweak
-						//if (vai->numFrames > 1000) {
-						//	vai->status = VertexArrayInfo::VAI_RELIABLE;
-						//}
-					} else {
-						vai->drawsUntilNextFullHash--;
-						u32 newMiniHash = ComputeMiniHash();
-						if (newMiniHash != vai->minihash) {
-							MarkUnreliable(vai);
-							DecodeVerts(decoded);
-							goto rotateVBO;
-						}
-					}
-
-					if (vai->vbo == 0) {
-						DecodeVerts(decoded);
-						vai->numVerts = indexGen.VertexCount();
-						vai->prim = indexGen.Prim();
-						vai->maxIndex = indexGen.MaxIndex();
-						vai->flags = gstate_c.vertexFullAlpha ? VAI_FLAG_VERTEXFULLALPHA : 0;
-						useElements = !indexGen.SeenOnlyPurePrims();
-						if (!useElements && indexGen.PureCount()) {
-							vai->numVerts = indexGen.PureCount();
-						}
-
-						_dbg_assert_msg_(G3D, gstate_c.vertBounds.minV >= gstate_c.vertBounds.maxV, "Should not have checked UVs when caching.");
-
-						size_t vsz = dec_->GetDecVtxFmt().stride * indexGen.MaxIndex();
-						vai->vbo = render_->CreateBuffer(GL_ARRAY_BUFFER, vsz, GL_STATIC_DRAW);
-						render_->BufferSubdata(vai->vbo, 0, vsz, decoded);
-						// If there's only been one primitive type, and it's either TRIANGLES, LINES or POINTS,
-						// there is no need for the index buffer we built. We can then use glDrawArrays instead
-						// for a very minor speed boost.
-						if (useElements) {
-							size_t esz = sizeof(short) * indexGen.VertexCount();
-							vai->ebo = render_->CreateBuffer(GL_ARRAY_BUFFER, esz, GL_STATIC_DRAW);
-							render_->BufferSubdata(vai->ebo, 0, esz, (uint8_t *)decIndex, false);
-						} else {
-							vai->ebo = 0;
-							render_->BindIndexBuffer(vai->ebo);
-						}
-					} else {
-						gpuStats.numCachedDrawCalls++;
-						useElements = vai->ebo ? true : false;
-						gpuStats.numCachedVertsDrawn += vai->numVerts;
-						gstate_c.vertexFullAlpha = vai->flags & VAI_FLAG_VERTEXFULLALPHA;
-					}
-					vertexBuffer = vai->vbo;
-					indexBuffer = vai->ebo;
-					vertexCount = vai->numVerts;
-					prim = static_cast<GEPrimitiveType>(vai->prim);
-					break;
-				}
-
-				// Reliable - we don't even bother hashing anymore. Right now we don't go here until after a very long time.
-			case VertexArrayInfo::VAI_RELIABLE:
-				{
-					vai->numDraws++;
-					if (vai->lastFrame != gpuStats.numFlips) {
-						vai->numFrames++;
-					}
-					gpuStats.numCachedDrawCalls++;
-					gpuStats.numCachedVertsDrawn += vai->numVerts;
-					vertexBuffer = vai->vbo;
-					indexBuffer = vai->ebo;
-					vertexCount = vai->numVerts;
-					prim = static_cast<GEPrimitiveType>(vai->prim);
-
-					gstate_c.vertexFullAlpha = vai->flags & VAI_FLAG_VERTEXFULLALPHA;
-					break;
-				}
-
-			case VertexArrayInfo::VAI_UNRELIABLE:
-				{
-					vai->numDraws++;
-					if (vai->lastFrame != gpuStats.numFlips) {
-						vai->numFrames++;
-					}
-					DecodeVerts(decoded);
-					goto rotateVBO;
-				}
+		// Vertex caching used to be disabled outright on GL, so this is opt in for now.
+		const CachedGeometry *geom = g_Config.bVertexCache && g_Config.bGeometryCache ? DecodeVertsCached() : nullptr;
+		if (geom) {
+			UploadGeometry();
+			vertexBuffer = geometryBuffer_;
+			vertexBufferOffset = geom->vertexOffset;
+			if (geom->useElements) {
+				indexBuffer = geometryBuffer_;
+				indexBufferOffset = geom->indexOffset;
 			}
-
-			vai->lastFrame = gpuStats.numFlips;
+			useElements = geom->useElements;
+			vertexCount = geom->vertexCount;
+			prim = static_cast<GEPrimitiveType>(geom->prim);
 		} else {
 			if (g_Config.bSoftwareSkinning && (lastVType_ & GE_VTYPE_WEIGHT_MASK)) {
 				// If software skinning, we've already predecoded into "decoded". So push that content.
@@ -486,7 +313,6 @@ void DrawEngineGLES::DoFlush() {
 				DecodeVertsToPushBuffer(frameData.pushVertex, &vertexBufferOffset, &vertexBuffer);
 			}
 
-rotateVBO:
 			gpuStats.numUncachedVertsDrawn += indexGen.VertexCount();
 			useElements = !indexGen.SeenOnlyPurePrims();
 			vertexCount = indexGen.VertexCount();
@@ -517,8 +343,8 @@ void DrawEngineGLES::DoFlush() {
 		if (useElements) {
 			if (!indexBuffer) {
 				indexBufferOffset = (uint32_t)frameData.pushIndex->Push(decIndex, sizeof(uint16_t) * indexGen.VertexCount(), &indexBuffer);
-				render_->BindIndexBuffer(indexBuffer);
 			}
+			render_->BindIndexBuffer(indexBuffer);
 			render_->DrawIndexed(glprim[prim], vertexCount, GL_UNSIGNED_SHORT, (GLvoid*)(intptr_t)indexBufferOffset);
 		} else {
 			render_->Draw(glprim[prim], 0, vertexCount);
@@ -52,64 +52,6 @@ enum {
 };
 
 
-// States transitions:
-// On creation: DRAWN_NEW
-// DRAWN_NEW -> DRAWN_HASHING
-// DRAWN_HASHING -> DRAWN_RELIABLE
-// DRAWN_HASHING -> DRAWN_UNRELIABLE
-// DRAWN_ONCE -> UNRELIABLE
-// DRAWN_RELIABLE -> DRAWN_SAFE
-// UNRELIABLE -> death
-// DRAWN_ONCE -> death
-// DRAWN_RELIABLE -> death
-
-enum {
-	VAI_FLAG_VERTEXFULLALPHA = 1,
-};
-
-// Try to keep this POD.
-class VertexArrayInfo {
-public:
-	VertexArrayInfo() {
-		status = VAI_NEW;
-		vbo = nullptr;
-		ebo = nullptr;
-		prim = GE_PRIM_INVALID;
-		numDraws = 0;
-		numFrames = 0;
-		lastFrame = gpuStats.numFlips;
-		numVerts = 0;
-		drawsUntilNextFullHash = 0;
-		flags = 0;
-	}
-
-	enum Status : uint8_t {
-		VAI_NEW,
-		VAI_HASHING,
-		VAI_RELIABLE,  // cache, don't hash
-		VAI_UNRELIABLE,  // never cache
-	};
-
-	ReliableHashType hash;
-	u32 minihash;
-
-	GLRBuffer *vbo;
-	GLRBuffer *ebo;
-
-	// Precalculated parameter for drawRangeElements
-	u16 numVerts;
-	u16 maxIndex;
-	s8 prim;
-	Status status;
-
-	// ID information
-	int numDraws;
-	int numFrames;
-	int lastFrame;  // So that we can forget.
-	u16 drawsUntilNextFullHash;
-	u8 flags;
-};
-
 class TessellationDataTransferGLES : public TessellationDataTransfer {
 private:
 	GLRTexture *data_tex[3]{};
@@ -150,7 +92,6 @@ class DrawEngineGLES : public DrawEngineCommon {
 	void DeviceRestore(Draw::DrawContext *draw);
 
 	void ClearTrackedVertexArrays() override;
-	void DecimateTrackedVertexArrays();
 
 	void BeginFrame();
 	void EndFrame();
@@ -195,9 +136,7 @@ class DrawEngineGLES : public DrawEngineCommon {
 
 	void DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindOffset, GLRBuffer **buf);
 
-	void FreeVertexArray(VertexArrayInfo *vai);
-
-	void MarkUnreliable(VertexArrayInfo *vai);
+	void UploadGeometry();
 
 	struct FrameData {
 		GLPushBuffer *pushVertex;
@@ -205,7 +144,8 @@ class DrawEngineGLES : public DrawEngineCommon {
 	};
 	FrameData frameData_[GLRenderManager::MAX_INFLIGHT_FRAMES];
 
-	PrehashMap<VertexArrayInfo *, nullptr> vai_;
+	// GPU copy of geometryCache_'s ring.
+	GLRBuffer *geometryBuffer_ = nullptr;
 
 	DenseHashMap<uint32_t, GLRInputLayout *, nullptr> inputLayoutMap_;
 
@@ -707,6 +707,8 @@ void FramebufferManagerGLES::DeviceRestore(Draw::DrawContext *draw) {
 }
 
 void FramebufferManagerGLES::DestroyAllFBOs() {
+	// Memory is about to be replaced or the device is going away.
+	DiscardPendingReadbacks();
 	currentRenderVfb_ = 0;
 	displayFramebuf_ = 0;
 	prevDisplayFramebuf_ = 0;
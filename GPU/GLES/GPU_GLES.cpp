@@ -435,7 +435,6 @@ void GPU_GLES::BeginFrame() {
 	resized_ = false;
 
 	textureCacheGL_->StartFrame();
-	drawEngine_.DecimateTrackedVertexArrays();
 	depalShaderCache_.Decimate();
 	fragmentTestCache_.Decimate();
 
@@ -525,7 +524,7 @@ void GPU_GLES::GetStats(char *buffer, size_t bufsize) {
 		"Cached, Uncached Vertices Drawn: %i, %i\n"
 		"FBOs active: %i\n"
 		"Textures active: %i, decoded: %i  invalidated: %i\n"
-		"Readbacks: %d, uploads: %d\n"
+		"Readbacks: %d (stalled: %d), uploads: %d (merged: %d)\n"
 		"Vertex, Fragment, Programs loaded: %i, %i, %i\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
 		gpuStats.numDrawCalls,
@@ -544,7 +543,9 @@ void GPU_GLES::GetStats(char *buffer, size_t bufsize) {
 		gpuStats.numTexturesDecoded,
 		gpuStats.numTextureInvalidations,
 		gpuStats.numReadbacks,
+		gpuStats.numReadbackStalls,
 		gpuStats.numUploads,
+		gpuStats.numMergedUploads,
 		shaderManagerGL_->GetNumVertexShaders(),
 		shaderManagerGL_->GetNumFragmentShaders(),
 		shaderManagerGL_->GetNumPrograms());
@@ -22,6 +22,8 @@
 #include <cmath>
 #include <cstdio>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "math/dataconv.h"
 #include "base/logging.h"
@@ -34,6 +36,7 @@
 #include "math/lin/matrix4x4.h"
 #include "profiler/profiler.h"
 
+#include "ext/xxhash.h"
 #include "Common/FileUtil.h"
 #include "Core/Config.h"
 #include "Core/Host.h"
@@ -66,7 +69,7 @@ Shader::~Shader() {
 	render_->DeleteShader(shader);
 }
 
-LinkedShader::LinkedShader(GLRenderManager *render, VShaderID VSID, Shader *vs, FShaderID FSID, Shader *fs, bool useHWTransform, bool preloading)
+LinkedShader::LinkedShader(GLRenderManager *render, VShaderID VSID, Shader *vs, FShaderID FSID, Shader *fs, bool useHWTransform, bool preloading, const GLRProgram::Binary *binary)
 		: render_(render), useHWTransform_(useHWTransform) {
 	PROFILE_THIS_SCOPE("shaderlink");
 
@@ -177,7 +180,8 @@ LinkedShader::LinkedShader(GLRenderManager *render, VShaderID VSID, Shader *vs,
 	initialize.push_back({ &u_tess_weights_u, 0, 5 });
 	initialize.push_back({ &u_tess_weights_v, 0, 6 });
 
-	program = render->CreateProgram(shaders, semantics, queries, initialize, gstate_c.featureFlags & GPU_SUPPORTS_DUALSOURCE_BLEND);
+	// Always ask for the binary (if supported), so the next run can skip linking.
+	program = render->CreateProgram(shaders, semantics, queries, initialize, gstate_c.featureFlags & GPU_SUPPORTS_DUALSOURCE_BLEND, true, binary);
 
 	// The rest, use the "dirty" mechanism.
 	dirtyUniforms = DIRTY_ALL_UNIFORMS;
@@ -814,29 +818,42 @@ std::string ShaderManagerGLES::DebugGetShaderString(std::string id, DebugShaderT
 	}
 }
 
-// Shader pseudo-cache.
+// Shader cache.
 //
-// We simply store the IDs of the shaders used during gameplay. On next startup of
-// the same game, we simply compile all the shaders from the start, so we don't have to
-// compile them on the fly later. Ideally we would store the actual compiled shaders
-// rather than just their IDs, but OpenGL does not support this, except for a few obscure
-// vendor-specific extensions.
+// We store the IDs of the shaders used during gameplay, in the order they were first used.
+// On next startup of the same game, we compile all the shaders from the start (the ones the game
+// needs first, first), so we don't have to compile them on the fly later.
+//
+// Where the driver supports program binaries (ES 3.0, GL 4.1 or ARB_get_program_binary), we also
+// store those, and create the programs from them instead of linking, which is where most drivers
+// spend their time. They're only valid for the same driver, so they're skipped if that changed.
 //
 // If things like GPU supported features have changed since the last time, we discard the cache
 // as sometimes these features might have an effect on the ID bits.
 
 #define CACHE_HEADER_MAGIC 0x83277592
-#define CACHE_VERSION 12
+#define CACHE_VERSION 13
 struct CacheHeader {
 	uint32_t magic;
 	uint32_t version;
 	uint32_t featureFlags;
-	uint32_t reserved;
+	uint32_t driverHash;
 	int numVertexShaders;
 	int numFragmentShaders;
 	int numLinkedPrograms;
 };
 
+// Follows the IDs, one for each linked program.
+struct CacheBinaryHeader {
+	uint32_t format;
+	uint32_t size;
+};
+
+uint32_t ShaderManagerGLES::DriverHash() const {
+	std::string driver = render_->GetGLString(GL_VENDOR) + "|" + render_->GetGLString(GL_RENDERER) + "|" + render_->GetGLString(GL_VERSION);
+	return XXH32(driver.data(), driver.size(), 0x5ADE5ADE);
+}
+
 void ShaderManagerGLES::Load(const std::string &filename) {
 	File::IOFile f(filename, "rb");
 	u64 sz = f.GetSize();
@@ -865,8 +882,9 @@ void ShaderManagerGLES::Load(const std::string &filename) {
 	expectedSize += header.numVertexShaders * sizeof(VShaderID);
 	expectedSize += header.numFragmentShaders * sizeof(FShaderID);
 	expectedSize += header.numLinkedPrograms * (sizeof(VShaderID) + sizeof(FShaderID));
-	if (sz != expectedSize) {
-		ERROR_LOG(G3D, "Shader cache file is wrong size: %lld instead of %lld", sz, expectedSize);
+	u64 binariesSize = sz < expectedSize ? 0 : sz - expectedSize;
+	if (sz < expectedSize || binariesSize < header.numLinkedPrograms * sizeof(CacheBinaryHeader)) {
+		ERROR_LOG(G3D, "Shader cache file is wrong size: %lld, expected at least %lld", sz, expectedSize + header.numLinkedPrograms * sizeof(CacheBinaryHeader));
 		return;
 	}
 
@@ -895,6 +913,32 @@ void ShaderManagerGLES::Load(const std::string &filename) {
 		diskCachePending_.link.push_back(std::make_pair(vsid, fsid));
 	}
 
+	// The IDs are still useful without the binaries, so just skip them if anything's off.
+	if (gl_extensions.ARB_get_program_binary && header.driverHash == DriverHash()) {
+		std::vector<GLRProgram::Binary> &binaries = diskCachePending_.binary;
+		binaries.resize(header.numLinkedPrograms);
+		for (int i = 0; i < header.numLinkedPrograms; i++) {
+			CacheBinaryHeader binaryHeader;
+			if (!f.ReadArray(&binaryHeader, 1)) {
+				binaries.clear();
+				break;
+			}
+			binariesSize -= sizeof(binaryHeader);
+			if (binaryHeader.size > binariesSize) {
+				ERROR_LOG(G3D, "Corrupt program binary in shader cache, ignoring binaries.");
+				binaries.clear();
+				break;
+			}
+			binariesSize -= binaryHeader.size;
+			binaries[i].format = binaryHeader.format;
+			binaries[i].data.resize(binaryHeader.size);
+			if (binaryHeader.size != 0 && !f.ReadBytes(binaries[i].data.data(), binaryHeader.size)) {
+				binaries.clear();
+				break;
+			}
+		}
+	}
+
 	// Actual compilation happens in ContinuePrecompile(), called by GPU_GLES's IsReady.
 	NOTICE_LOG(G3D, "Precompiling the shader cache from '%s'", filename.c_str());
 	diskCacheDirty_ = false;
@@ -967,7 +1011,15 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 		Shader *vs = vsCache_.Get(vsid);
 		Shader *fs = fsCache_.Get(fsid);
 		if (vs && fs) {
-			LinkedShader *ls = new LinkedShader(render_, vsid, vs, fsid, fs, vs->UseHWTransform(), true);
+			const GLRProgram::Binary *binary = nullptr;
+			if (i < pending.binary.size() && !pending.binary[i].data.empty())
+				binary = &pending.binary[i];
+			LinkedShader *ls = new LinkedShader(render_, vsid, vs, fsid, fs, vs->UseHWTransform(), true, binary);
+			if (binary) {
+				pending.numBinaries++;
+				// It's been copied, no need to hold onto it.
+				pending.binary[i] = GLRProgram::Binary();
+			}
 			LinkedShaderCacheEntry entry(vs, fs, ls);
 			linkedShaderCache_.push_back(entry);
 		}
@@ -977,7 +1029,7 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 	time_update();
 	double finish = time_now_d();
 
-	NOTICE_LOG(G3D, "Compiled and linked %d programs (%d vertex, %d fragment) in %0.1f milliseconds", (int)pending.link.size(), (int)pending.vert.size(), (int)pending.frag.size(), 1000 * (finish - pending.start));
+	NOTICE_LOG(G3D, "Compiled and linked %d programs (%d vertex, %d fragment, %d from binaries) in %0.1f milliseconds", (int)pending.link.size(), (int)pending.vert.size(), (int)pending.frag.size(), pending.numBinaries, 1000 * (finish - pending.start));
 	pending.Clear();
 
 	return true;
@@ -1001,34 +1053,67 @@ void ShaderManagerGLES::Save(const std::string &filename) {
 		diskCacheDirty_ = false;
 		return;
 	}
+
+	std::unordered_map<const Shader *, ShaderID> vsIDs, fsIDs;
+	vsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
+		vsIDs[shader] = id;
+	});
+	fsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
+		fsIDs[shader] = id;
+	});
+
+	// Programs are in first use order, so write the shaders in the order they were first linked.
+	// That way the ones needed first also get compiled first next time.
+	std::vector<ShaderID> vsOrder, fsOrder;
+	std::unordered_set<const Shader *> seen;
+	for (const auto &iter : linkedShaderCache_) {
+		if (seen.insert(iter.vs).second)
+			vsOrder.push_back(vsIDs[iter.vs]);
+		if (seen.insert(iter.fs).second)
+			fsOrder.push_back(fsIDs[iter.fs]);
+	}
+	vsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
+		if (!seen.count(shader))
+			vsOrder.push_back(id);
+	});
+	fsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
+		if (!seen.count(shader))
+			fsOrder.push_back(id);
+	});
+
 	CacheHeader header;
 	header.magic = CACHE_HEADER_MAGIC;
 	header.version = CACHE_VERSION;
-	header.reserved = 0;
 	header.featureFlags = gstate_c.featureFlags;
-	header.numVertexShaders = GetNumVertexShaders();
-	header.numFragmentShaders = GetNumFragmentShaders();
+	header.driverHash = DriverHash();
+	header.numVertexShaders = (int)vsOrder.size();
+	header.numFragmentShaders = (int)fsOrder.size();
 	header.numLinkedPrograms = GetNumPrograms();
 	fwrite(&header, 1, sizeof(header), f);
-	vsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
+	for (const ShaderID &id : vsOrder) {
 		fwrite(&id, 1, sizeof(id), f);
-	});
-	fsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
+	}
+	for (const ShaderID &id : fsOrder) {
 		fwrite(&id, 1, sizeof(id), f);
-	});
-	for (auto iter : linkedShaderCache_) {
-		ShaderID vsid, fsid;
-		vsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
-			if (iter.vs == shader)
-				vsid = id;
-		});
-		fsCache_.Iterate([&](const ShaderID &id, Shader *shader) {
-			if (iter.fs == shader)
-				fsid = id;
-		});
+	}
+	for (const auto &iter : linkedShaderCache_) {
+		ShaderID vsid = vsIDs[iter.vs];
+		ShaderID fsid = fsIDs[iter.fs];
 		fwrite(&vsid, 1, sizeof(vsid), f);
 		fwrite(&fsid, 1, sizeof(fsid), f);
 	}
+	for (const auto &iter : linkedShaderCache_) {
+		// Programs still waiting on the render thread (or that failed) are written without one.
+		const GLRProgram *program = iter.ls->program;
+		CacheBinaryHeader binaryHeader{};
+		if (program->binaryReady_) {
+			binaryHeader.format = program->binary_.format;
+			binaryHeader.size = (uint32_t)program->binary_.data.size();
+		}
+		fwrite(&binaryHeader, 1, sizeof(binaryHeader), f);
+		if (binaryHeader.size != 0)
+			fwrite(program->binary_.data.data(), 1, binaryHeader.size, f);
+	}
 	fclose(f);
 	diskCacheDirty_ = false;
 }
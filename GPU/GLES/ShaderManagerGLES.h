@@ -44,7 +44,7 @@ enum {
 
 class LinkedShader {
 public:
-	LinkedShader(GLRenderManager *render, VShaderID VSID, Shader *vs, FShaderID FSID, Shader *fs, bool useHWTransform, bool preloading = false);
+	LinkedShader(GLRenderManager *render, VShaderID VSID, Shader *vs, FShaderID FSID, Shader *fs, bool useHWTransform, bool preloading = false, const GLRProgram::Binary *binary = nullptr);
 	~LinkedShader();
 
 	void use(const ShaderID &VSID);
@@ -182,6 +182,7 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 
 private:
 	void Clear();
+	uint32_t DriverHash() const;
 	Shader *CompileFragmentShader(FShaderID id);
 	Shader *CompileVertexShader(VShaderID id);
 
@@ -218,19 +219,24 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 		std::vector<VShaderID> vert;
 		std::vector<FShaderID> frag;
 		std::vector<std::pair<VShaderID, FShaderID>> link;
+		// Program binaries for link, if the driver hasn't changed. May be empty.
+		std::vector<GLRProgram::Binary> binary;
 
 		size_t vertPos = 0;
 		size_t fragPos = 0;
 		size_t linkPos = 0;
+		int numBinaries = 0;
 		double start;
 
 		void Clear() {
 			vert.clear();
 			frag.clear();
 			link.clear();
+			binary.clear();
 			vertPos = 0;
 			fragPos = 0;
 			linkPos = 0;
+			numBinaries = 0;
 		}
 
 		bool Done() {
@@ -51,6 +51,7 @@ TextureCacheGLES::TextureCacheGLES(Draw::DrawContext *draw)
 	render_ = (GLRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
 
 	SetupTextureDecoder();
+	asyncScaler_.reset(new TextureScalerAsync(new TextureScalerGLES()));
 
 	nextTexture_ = nullptr;
 
@@ -231,6 +232,7 @@ void TextureCacheGLES::StartFrame() {
 		// INFO_LOG(G3D, "Scaled %i texels", texelsScaledThisFrame_);
 	}
 	texelsScaledThisFrame_ = 0;
+	asyncScaler_->PublishFinished(gpuStats.numFlips);
 	if (clearCacheNextFrame_) {
 		Clear(true);
 		clearCacheNextFrame_ = false;
@@ -618,22 +620,7 @@ void TextureCacheGLES::BuildTexture(TexCacheEntry *const entry) {
 	if (entry->addr > 0x05000000 && entry->addr < PSP_GetKernelMemoryEnd())
 		scaleFactor = 1;
 
-	if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0 && scaleFactor != 1) {
-		// Remember for later that we /wanted/ to scale this texture.
-		entry->status |= TexCacheEntry::STATUS_TO_SCALE;
-		scaleFactor = 1;
-	}
-
-	if (scaleFactor != 1) {
-		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED) {
-			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
-			scaleFactor = 1;
-		} else {
-			entry->status &= ~TexCacheEntry::STATUS_TO_SCALE;
-			entry->status |= TexCacheEntry::STATUS_IS_SCALED;
-			texelsScaledThisFrame_ += w * h;
-		}
-	}
+	scaleFactor = ScaleFactorForBuild(entry, scaleFactor, w, h);
 
 	// glBindTexture(GL_TEXTURE_2D, entry->textureName);
 	lastBoundTexture = entry->textureName;
@@ -772,21 +759,31 @@ void TextureCacheGLES::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &r
 		// We leave GL_UNPACK_ALIGNMENT at 4, so this must be at least 4.
 		decPitch = std::max(w * pixelSize, 4);
 
-		pixelData = (uint8_t *)AllocateAlignedMemory(decPitch * h * pixelSize, 16);
-		DecodeTextureLevel(pixelData, decPitch, GETextureFormat(entry.format), clutformat, texaddr, level, bufw, true, false, false);
-
-		// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
-		if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
-			TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / pixelSize, w, h);
-			entry.SetAlphaStatus(alphaStatus, level);
+		// When scaling, the decoded level is only an intermediate, so it can come from the scratch pool.
+		if (scaleFactor > 1) {
+			pixelData = (uint8_t *)scratchPool_.Allocate(decPitch * h * pixelSize);
 		} else {
-			entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			pixelData = (uint8_t *)AllocateAlignedMemory(decPitch * h * pixelSize, 16);
+		}
+		// If the worker already scaled this level, it was decoded for the placeholder and ScaleLevel() takes it.
+		if (!AsyncScaleReady(entry, scaleFactor, w, h)) {
+			DecodeTextureLevel(pixelData, decPitch, GETextureFormat(entry.format), clutformat, texaddr, level, bufw, true, false, false);
+
+			// We check before scaling since scaling shouldn't invent alpha from a full alpha texture.
+			if ((entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+				TexCacheEntry::TexStatus alphaStatus = CheckAlpha(pixelData, dstFmt, decPitch / pixelSize, w, h);
+				entry.SetAlphaStatus(alphaStatus, level);
+			} else {
+				entry.SetAlphaStatus(TexCacheEntry::STATUS_ALPHA_UNKNOWN);
+			}
+
+			QueueAsyncScale(entry, pixelData, decPitch, dstFmt, w, h, pixelSize);
 		}
 
 		if (scaleFactor > 1) {
 			uint8_t *rearrange = (uint8_t *)AllocateAlignedMemory(w * scaleFactor * h * scaleFactor * 4, 16);
-			scaler.ScaleAlways((u32 *)rearrange, (u32 *)pixelData, dstFmt, w, h, scaleFactor);
-			FreeAlignedMemory(pixelData);
+			ScaleLevel(scaler, entry, (u32 *)rearrange, (u32 *)pixelData, dstFmt, w, h, scaleFactor);
+			scratchPool_.Release(pixelData);
 			pixelData = rearrange;
 			decPitch = w * 4;
 		}
@@ -68,9 +68,15 @@ struct GPUStatistics {
 		numFlushes = 0;
 		numTexturesDecoded = 0;
 		numReadbacks = 0;
+		numReadbackStalls = 0;
 		numUploads = 0;
+		numMergedUploads = 0;
 		numClears = 0;
 		msProcessingDisplayLists = 0;
+		msDecodingVertices = 0;
+		msDecodingTextures = 0;
+		msTransforming = 0;
+		msRasterizing = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 		memset(gpuCommandsAtCallLevel, 0, sizeof(gpuCommandsAtCallLevel));
@@ -89,9 +95,19 @@ struct GPUStatistics {
 	int numShaderSwitches;
 	int numTexturesDecoded;
 	int numReadbacks;
+	// Async readbacks that had to be waited for early.
+	int numReadbackStalls;
 	int numUploads;
+	// Block transfer uploads folded into an earlier one.
+	int numMergedUploads;
 	int numClears;
+	// Despite the name, in seconds.
 	double msProcessingDisplayLists;
+	// Parts of the display list time, but in milliseconds.  See DebugStatsTimer.
+	double msDecodingVertices;
+	double msDecodingTextures;
+	double msTransforming;
+	double msRasterizing;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 	int gpuCommandsAtCallLevel[4];
@@ -24,6 +24,7 @@
 #include "Core/HLE/sceGe.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/MemMapHelpers.h"
+#include "GPU/Common/BlockTransfer.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/FramebufferCommon.h"
 #include "GPU/Common/SplineCommon.h"
@@ -429,6 +430,12 @@ void GPUCommon::UpdateCmdInfo() {
 		cmdInfo_[GE_CMD_JUMP].func = &GPUCommon::Execute_Jump;
 		cmdInfo_[GE_CMD_CALL].func = &GPUCommon::Execute_Call;
 	}
+
+	u64 flags[256];
+	for (int i = 0; i < 256; i++) {
+		flags[i] = cmdInfo_[i].flags;
+	}
+	displayListCache_.SetCommandFlags(flags);
 }
 
 void GPUCommon::BeginHostFrame() {
@@ -912,6 +919,8 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 	if (list.state == PSP_GE_DL_STATE_PAUSED)
 		return false;
 	currentList = &list;
+	// The CPU has run since the last list, and may have rewritten any of them.
+	displayListCache_.Invalidate();
 
 	if (!list.started && list.context.IsValid()) {
 		gstate.Save(list.context);
@@ -981,6 +990,11 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 
 // Maybe should write this in ASM...
 void GPUCommon::FastRunLoop(DisplayList &list) {
+	if (g_Config.bDisplayListCache) {
+		CachedRunLoop(list);
+		return;
+	}
+
 	PROFILE_THIS_SCOPE("gpuloop");
 	const CommandInfo *cmdInfo = cmdInfo_;
 	int dc = downcount;
@@ -1019,8 +1033,99 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 	downcount = 0;
 }
 
+void GPUCommon::CachedRunLoop(DisplayList &list) {
+	PROFILE_THIS_SCOPE("gpuloop");
+	const CommandInfo *cmdInfo = cmdInfo_;
+	const int frame = gpuStats.numFlips;
+	int dc = downcount;
+	while (dc > 0) {
+		const DisplayListBlock *block = displayListCache_.Get(list.pc, dc, frame);
+		if (!block) {
+			// Same as FastRunLoop, for a single command.
+			const u32 op = *(const u32 *)(Memory::base + list.pc);
+			const u32 cmd = op >> 24;
+			const CommandInfo &info = cmdInfo[cmd];
+			const u32 diff = op ^ gstate.cmdmem[cmd];
+			if (diff == 0) {
+				if (info.flags & FLAG_EXECUTE) {
+					downcount = dc;
+					(this->*info.func)(op, diff);
+					dc = downcount;
+				}
+			} else {
+				uint64_t flags = info.flags;
+				if (flags & FLAG_FLUSHBEFOREONCHANGE) {
+					if (drawEngineCommon_->GetNumDrawCalls()) {
+						drawEngineCommon_->DispatchFlush();
+					}
+				}
+				gstate.cmdmem[cmd] = op;
+				if (flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE)) {
+					downcount = dc;
+					(this->*info.func)(op, diff);
+					dc = downcount;
+				} else {
+					uint64_t dirty = flags >> 8;
+					if (dirty)
+						gstate_c.Dirty(dirty);
+				}
+			}
+			list.pc += 4;
+			--dc;
+			continue;
+		}
+
+		const u32 startPC = list.pc;
+		bool leftBlock = false;
+		for (const DisplayListCommand &c : block->commands) {
+			const u32 op = c.op;
+			const u32 cmd = op >> 24;
+			const CommandInfo &info = cmdInfo[cmd];
+			const u32 diff = op ^ gstate.cmdmem[cmd];
+			uint64_t flags = info.flags;
+			if (diff == 0) {
+				if (!(flags & FLAG_EXECUTE))
+					continue;
+			} else {
+				if (flags & FLAG_FLUSHBEFOREONCHANGE) {
+					if (drawEngineCommon_->GetNumDrawCalls()) {
+						drawEngineCommon_->DispatchFlush();
+					}
+				}
+				gstate.cmdmem[cmd] = op;
+				if (!(flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE))) {
+					uint64_t dirty = flags >> 8;
+					if (dirty)
+						gstate_c.Dirty(dirty);
+					continue;
+				}
+			}
+
+			// Handlers see the list as if it was interpreted.
+			const u32 pc = startPC + c.index * 4;
+			const int opDowncount = dc - (int)c.index;
+			list.pc = pc;
+			downcount = opDowncount;
+			(this->*info.func)(op, diff);
+			if (list.pc != pc || downcount != opDowncount) {
+				// Jumped, read ahead, stalled or ended. Continue after wherever it left off.
+				dc = downcount - 1;
+				list.pc += 4;
+				leftBlock = true;
+				break;
+			}
+		}
+		if (!leftBlock) {
+			list.pc = startPC + block->numOps * 4;
+			dc -= block->numOps;
+		}
+	}
+	downcount = 0;
+}
+
 void GPUCommon::BeginFrame() {
 	immCount_ = 0;
+	displayListCache_.Decimate(gpuStats.numFlips);
 	if (dumpNextFrame_) {
 		NOTICE_LOG(G3D, "DUMPING THIS FRAME");
 		dumpThisFrame_ = true;
@@ -2330,6 +2435,15 @@ struct DisplayList_v2 {
 	bool bboxResult;
 };
 
+void GPUCommon::SyncPendingReadbacks(bool discard) {
+	if (!framebufferManager_)
+		return;
+	if (discard)
+		framebufferManager_->DiscardPendingReadbacks();
+	else
+		framebufferManager_->FlushAllPendingReadbacks();
+}
+
 void GPUCommon::DoState(PointerWrap &p) {
 	auto s = p.Section("GPUCommon", 1, 4);
 	if (!s)
@@ -2598,25 +2712,11 @@ void GPUCommon::DoBlockTransfer(u32 skipDrawReason) {
 	// Tell the framebuffer manager to take action if possible. If it does the entire thing, let's just return.
 	if (!framebufferManager_->NotifyBlockTransferBefore(dstBasePtr, dstStride, dstX, dstY, srcBasePtr, srcStride, srcX, srcY, width, height, bpp, skipDrawReason)) {
 		// Do the copy! (Hm, if we detect a drawn video frame (see below) then we could maybe skip this?)
-		// Can use GetPointerUnchecked because we checked the addresses above. We could also avoid them
-		// entirely by walking a couple of pointers...
-		if (srcStride == dstStride && (u32)width == srcStride) {
-			// Common case in God of War, let's do it all in one chunk.
-			u32 srcLineStartAddr = srcBasePtr + (srcY * srcStride + srcX) * bpp;
-			u32 dstLineStartAddr = dstBasePtr + (dstY * dstStride + dstX) * bpp;
-			const u8 *src = Memory::GetPointerUnchecked(srcLineStartAddr);
-			u8 *dst = Memory::GetPointerUnchecked(dstLineStartAddr);
-			memcpy(dst, src, width * height * bpp);
-		} else {
-			for (int y = 0; y < height; y++) {
-				u32 srcLineStartAddr = srcBasePtr + ((y + srcY) * srcStride + srcX) * bpp;
-				u32 dstLineStartAddr = dstBasePtr + ((y + dstY) * dstStride + dstX) * bpp;
-
-				const u8 *src = Memory::GetPointerUnchecked(srcLineStartAddr);
-				u8 *dst = Memory::GetPointerUnchecked(dstLineStartAddr);
-				memcpy(dst, src, width * bpp);
-			}
-		}
+		// Can use GetPointerUnchecked because we checked the addresses above.
+		const u8 *src = Memory::GetPointerUnchecked(srcBasePtr + (srcY * srcStride + srcX) * bpp);
+		u8 *dst = Memory::GetPointerUnchecked(dstBasePtr + (dstY * dstStride + dstX) * bpp);
+		CopyBlockRows(dst, dstStride * bpp, src, srcStride * bpp, width * bpp, height);
+		displayListCache_.Invalidate();
 
 		// Fixes Gran Turismo's funky text issue, since it overwrites the current texture.
 		textureCache_->Invalidate(dstBasePtr + (dstY * dstStride + dstX) * bpp, height * dstStride * bpp, GPU_INVALIDATE_HINT);
@@ -2685,6 +2785,7 @@ bool GPUCommon::PerformMemoryUpload(u32 dest, int size) {
 }
 
 void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
+	displayListCache_.Invalidate();
 	if (size > 0)
 		textureCache_->Invalidate(addr, size, type);
 	else
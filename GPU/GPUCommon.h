@@ -4,6 +4,7 @@
 #include "Common/MemoryUtil.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
+#include "GPU/Common/DisplayListCache.h"
 #include "GPU/Common/GPUDebugInterface.h"
 
 #if defined(__ANDROID__)
@@ -106,6 +107,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	u32  DrawSync(int mode) override;
 	int  GetStack(int index, u32 stackPtr) override;
 	void DoState(PointerWrap &p) override;
+	void SyncPendingReadbacks(bool discard) override;
 	bool BusyDrawing() override;
 	u32  Continue() override;
 	u32  Break(int mode) override;
@@ -278,6 +280,8 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	void BeginFrame() override;
 
 	virtual void FastRunLoop(DisplayList &list);
+	// FastRunLoop, but running pre-decoded blocks from displayListCache_.
+	void CachedRunLoop(DisplayList &list);
 
 	void SlowRunLoop(DisplayList &list);
 	void UpdatePC(u32 currentPC, u32 newPC);
@@ -345,6 +349,8 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 	int vertexCost_ = 0;
 
+	DisplayListCache displayListCache_;
+
 	// No idea how big this buffer needs to be.
 	enum {
 		MAX_IMMBUFFER_SIZE = 32,
@@ -226,6 +226,8 @@ class GPUInterface {
 	virtual void DeviceRestore() = 0;
 	virtual void ReapplyGfxState() = 0;
 	virtual void DoState(PointerWrap &p) = 0;
+	// Lands async framebuffer downloads before memory is saved, or drops them before it's replaced.
+	virtual void SyncPendingReadbacks(bool discard) = 0;
 
 	// Called by the window system if the window size changed. This will be reflected in PSPCoreParam.pixel*.
 	virtual void Resized() = 0;
@@ -24,6 +24,7 @@
 #include "Common/ThreadPools.h"
 #include "Common/ColorConv.h"
 #include "Core/Config.h"
+#include "Core/DebugStatsTimer.h"
 #include "Core/MemMap.h"
 #include "Core/Reporting.h"
 #include "GPU/GPUState.h"
@@ -1342,6 +1343,7 @@ void DrawTriangleSlice(
 void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData& v2)
 {
 	PROFILE_THIS_SCOPE("draw_tri");
+	DebugStatsTimer timer(&gpuStats.msRasterizing);
 
 	Vec2<int> d01((int)v0.screenpos.x - (int)v1.screenpos.x, (int)v0.screenpos.y - (int)v1.screenpos.y);
 	Vec2<int> d02((int)v0.screenpos.x - (int)v2.screenpos.x, (int)v0.screenpos.y - (int)v2.screenpos.y);
@@ -1401,6 +1403,7 @@ void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData&
 
 void DrawPoint(const VertexData &v0)
 {
+	DebugStatsTimer timer(&gpuStats.msRasterizing);
 	ScreenCoords pos = v0.screenpos;
 	Vec4<int> prim_color = v0.color0;
 	Vec3<int> sec_color = v0.color1;
@@ -1477,6 +1480,7 @@ void DrawPoint(const VertexData &v0)
 
 void ClearRectangle(const VertexData &v0, const VertexData &v1)
 {
+	DebugStatsTimer timer(&gpuStats.msRasterizing);
 	int minX = std::min(v0.screenpos.x, v1.screenpos.x) & ~0xF;
 	int minY = std::min(v0.screenpos.y, v1.screenpos.y) & ~0xF;
 	int maxX = (std::max(v0.screenpos.x, v1.screenpos.x) + 0xF) & ~0xF;
@@ -1612,6 +1616,7 @@ void ClearRectangle(const VertexData &v0, const VertexData &v1)
 
 void DrawLine(const VertexData &v0, const VertexData &v1)
 {
+	DebugStatsTimer timer(&gpuStats.msRasterizing);
 	// TODO: Use a proper line drawing algorithm that handles fractional endpoints correctly.
 	Vec3<int> a(v0.screenpos.x, v0.screenpos.y, v0.screenpos.z);
 	Vec3<int> b(v1.screenpos.x, v1.screenpos.y, v0.screenpos.z);
@@ -19,6 +19,7 @@
 #include "math/math_util.h"
 #include "Common/MemoryUtil.h"
 #include "Core/Config.h"
+#include "Core/DebugStatsTimer.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -210,6 +211,49 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 		vertex.color1 = Vec3<int>(0, 0, 0);
 	}
 
+	TransformVertex(vertex, pos, vreader.hasNormal(), vreader.hasColor0());
+	return vertex;
+}
+
+VertexData TransformUnit::ReadVertex(const SoAVertexData &soa, int index)
+{
+	VertexData vertex;
+
+	float pos[3] = { soa.posX[index], soa.posY[index], soa.posZ[index] };
+	if (gstate.isModeThrough()) {
+		// Same as ReadPosThroughZ16: integer value passed in a float, clamped to 0, 65535.
+		const float z = (int)pos[2];
+		pos[2] = z > 65535.0f ? 65535.0f : (z < 0.0f ? 0.0f : z);
+	}
+
+	if (!gstate.isModeClear() && gstate.isTextureMapEnabled() && soa.hasUV) {
+		vertex.texturecoords = Vec2<float>(soa.u[index], soa.v[index]);
+	}
+
+	if (soa.hasNormal) {
+		vertex.normal = Vec3<float>(soa.nrmX[index], soa.nrmY[index], soa.nrmZ[index]);
+
+		if (gstate.areNormalsReversed())
+			vertex.normal = -vertex.normal;
+	}
+
+	// The batch decoder doesn't handle weights, so no skinning here.
+
+	if (soa.hasColor0) {
+		const u32 c = soa.color0[index];
+		// Same math as VertexReader::ReadColor0() and the conversion above.
+		vertex.color0 = Vec4<int>((c & 0xFF) * (1.f / 255.f) * 255, ((c >> 8) & 0xFF) * (1.f / 255.f) * 255, ((c >> 16) & 0xFF) * (1.f / 255.f) * 255, (c >> 24) * (1.f / 255.f) * 255);
+	} else {
+		vertex.color0 = Vec4<int>(gstate.getMaterialAmbientR(), gstate.getMaterialAmbientG(), gstate.getMaterialAmbientB(), gstate.getMaterialAmbientA());
+	}
+	vertex.color1 = Vec3<int>(0, 0, 0);
+
+	TransformVertex(vertex, pos, soa.hasNormal, soa.hasColor0);
+	return vertex;
+}
+
+void TransformUnit::TransformVertex(VertexData &vertex, const float pos[3], bool hasNormal, bool hasColor0)
+{
 	if (!gstate.isModeThrough()) {
 		vertex.modelpos = ModelCoords(pos[0], pos[1], pos[2]);
 		vertex.worldpos = WorldCoords(TransformUnit::ModelToWorld(vertex.modelpos));
@@ -232,7 +276,7 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 		}
 		vertex.screenpos = ClipToScreenInternal(vertex.clippos, &outside_range_flag);
 
-		if (vreader.hasNormal()) {
+		if (hasNormal) {
 			vertex.worldnormal = TransformUnit::ModelToWorldNormal(vertex.normal);
 			// TODO: Isn't there a flag that controls whether to normalize the normal?
 			vertex.worldnormal /= vertex.worldnormal.Length();
@@ -240,7 +284,7 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 			vertex.worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
 		}
 
-		Lighting::Process(vertex, vreader.hasColor0());
+		Lighting::Process(vertex, hasColor0);
 	} else {
 		vertex.screenpos.x = (int)(pos[0] * 16) + gstate.getOffsetX16();
 		vertex.screenpos.y = (int)(pos[1] * 16) + gstate.getOffsetY16();
@@ -248,8 +292,6 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 		vertex.clippos.w = 1.f;
 		vertex.fogdepth = 1.f;
 	}
-
-	return vertex;
 }
 
 #define START_OPEN_U 1
@@ -276,15 +318,35 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 		return;
 	}
 
+	// Transform time is what's left after decoding and rasterizing.
+	const bool collectStats = coreCollectDebugStats;
+	const double startTime = collectStats ? real_time_now() : 0.0;
+	const double startDecodeMs = gpuStats.msDecodingVertices;
+	const double startRasterMs = gpuStats.msRasterizing;
+
 	u16 index_lower_bound = 0;
 	u16 index_upper_bound = vertex_count - 1;
 	IndexConverter ConvertIndex(vertex_type, indices);
 
 	if (indices)
 		GetIndexBounds(indices, vertex_count, vertex_type, &index_lower_bound, &index_upper_bound);
-	vdecoder.DecodeVerts(buf, vertices, index_lower_bound, index_upper_bound);
+	bool useSoA;
+	{
+		DebugStatsTimer timer(&gpuStats.msDecodingVertices);
+		// Decode to separate arrays when we can, it's faster to decode and read back.
+		useSoA = vdecoder.DecodeVertsSoA(soaverts, vertices, index_lower_bound, index_upper_bound);
+		if (!useSoA)
+			vdecoder.DecodeVerts(buf, vertices, index_lower_bound, index_upper_bound);
+	}
 
 	VertexReader vreader(buf, vtxfmt, vertex_type);
+	auto readVertex = [&](int vtx) {
+		const int index = indices ? ConvertIndex(vtx) - index_lower_bound : vtx;
+		if (useSoA)
+			return ReadVertex(soaverts, index);
+		vreader.Goto(index);
+		return ReadVertex(vreader);
+	};
 
 	const int max_vtcs_per_prim = 3;
 	static VertexData data[max_vtcs_per_prim];
@@ -318,13 +380,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	case GE_PRIM_RECTANGLES:
 		{
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[data_index++] = ReadVertex(vreader);
+				data[data_index++] = readVertex(vtx);
 				if (data_index < vtcs_per_prim) {
 					// Keep reading.  Note: an incomplete prim will stay read for GE_PRIM_KEEP_PREVIOUS.
 					continue;
@@ -377,13 +433,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			// If data_index is 1 or 2, etc., it means we're continuing a line strip.
 			int skip_count = data_index == 0 ? 1 : 0;
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) & 1] = ReadVertex(vreader);
+				data[(data_index++) & 1] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -407,13 +457,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			int skip_count = data_index >= 2 ? 0 : 2 - data_index;
 
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) % 3] = ReadVertex(vreader);
+				data[(data_index++) % 3] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -449,24 +493,13 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 			// Only read the central vertex if we're not continuing.
 			if (data_index == 0) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(0) - index_lower_bound);
-				} else {
-					vreader.Goto(0);
-				}
-				data[0] = ReadVertex(vreader);
+				data[0] = readVertex(0);
 				data_index++;
 				start_vtx = 1;
 			}
 
 			for (int vtx = start_vtx; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[2 - ((data_index++) % 2)] = ReadVertex(vreader);
+				data[2 - ((data_index++) % 2)] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -498,6 +531,11 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 		break;
 	}
 
+	if (collectStats) {
+		double totalMs = (real_time_now() - startTime) * 1000.0;
+		gpuStats.msTransforming += totalMs - (gpuStats.msDecodingVertices - startDecodeMs) - (gpuStats.msRasterizing - startRasterMs);
+	}
+
 	GPUDebug::NotifyDraw();
 }
 
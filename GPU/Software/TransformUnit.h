@@ -20,6 +20,7 @@
 #include "CommonTypes.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/GPUDebugInterface.h"
+#include "GPU/Common/VertexDecoderBatch.h"
 #include "GPU/Math3D.h"
 
 using namespace Math3D;
@@ -133,9 +134,14 @@ class TransformUnit {
 
 	bool GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices);
 	VertexData ReadVertex(VertexReader& vreader);
+	VertexData ReadVertex(const SoAVertexData &soa, int index);
 
 	bool outside_range_flag = false;
 	u8 *buf;
+	SoAVertexData soaverts;
+
+private:
+	void TransformVertex(VertexData &vertex, const float pos[3], bool hasNormal, bool hasColor0);
 };
 
 class SoftwareDrawEngine : public DrawEngineCommon {
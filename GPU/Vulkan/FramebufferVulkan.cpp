@@ -541,6 +541,8 @@ void FramebufferManagerVulkan::DeviceRestore(VulkanContext *vulkan, Draw::DrawCo
 }
 
 void FramebufferManagerVulkan::DestroyAllFBOs() {
+	// Memory is about to be replaced or the device is going away.
+	DiscardPendingReadbacks();
 	currentRenderVfb_ = 0;
 	displayFramebuf_ = 0;
 	prevDisplayFramebuf_ = 0;
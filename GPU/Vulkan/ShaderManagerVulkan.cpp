@@ -21,6 +21,7 @@
 
 #include "base/logging.h"
 #include "base/stringutil.h"
+#include "base/timeutil.h"
 #include "math/lin/matrix4x4.h"
 #include "math/math_util.h"
 #include "math/dataconv.h"
@@ -30,6 +31,7 @@
 #include "Common/Vulkan/VulkanMemory.h"
 #include "Common/Log.h"
 #include "Common/Common.h"
+#include "Common/ThreadPools.h"
 #include "Core/Config.h"
 #include "Core/Reporting.h"
 #include "GPU/Math3D.h"
@@ -357,6 +359,9 @@ VulkanFragmentShader *ShaderManagerVulkan::GetFragmentShaderFromModule(VkShaderM
 // compile them on the fly later. We also store the Vulkan pipeline cache, so if it contains
 // pipelines compiled from SPIR-V matching these shaders, pipeline creation will be practically
 // instantaneous.
+//
+// Loading still blocks boot until every shader is compiled, just spread over the worker threads.
+// vsCache_ and fsCache_ are used unlocked on every draw, so they can't be filled in the background.
 
 #define CACHE_HEADER_MAGIC 0xff51f420 
 #define CACHE_VERSION 14
@@ -379,28 +384,67 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 	if (header.featureFlags != gstate_c.featureFlags)
 		return false;
 
+	std::vector<VShaderID> vsIDs;
 	for (int i = 0; i < header.numVertexShaders; i++) {
 		VShaderID id;
 		if (fread(&id, sizeof(id), 1, f) != 1) {
 			ERROR_LOG(G3D, "Vulkan shader cache truncated");
 			break;
 		}
-		bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
-		GenerateVulkanGLSLVertexShader(id, codeBuffer_);
-		VulkanVertexShader *vs = new VulkanVertexShader(vulkan_, id, codeBuffer_, useHWTransform);
-		vsCache_.Insert(id, vs);
+		vsIDs.push_back(id);
+	}
+	std::vector<FShaderID> fsIDs;
+	if ((int)vsIDs.size() == header.numVertexShaders) {
+		for (int i = 0; i < header.numFragmentShaders; i++) {
+			FShaderID id;
+			if (fread(&id, sizeof(id), 1, f) != 1) {
+				ERROR_LOG(G3D, "Vulkan shader cache truncated");
+				break;
+			}
+			fsIDs.push_back(id);
+		}
 	}
+
+	// GLSL to SPIR-V is the slow part and glslang is fine with several compiles at once, so
+	// spread the shaders over the worker threads. Each task needs its own code buffer.
+	const int numVS = (int)vsIDs.size();
+	const int total = numVS + (int)fsIDs.size();
+	std::vector<VulkanVertexShader *> vertexShaders(vsIDs.size());
+	std::vector<VulkanFragmentShader *> fragmentShaders(fsIDs.size());
 	uint32_t vendorID = vulkan_->GetPhysicalDeviceProperties(vulkan_->GetCurrentPhysicalDevice()).vendorID;
-	for (int i = 0; i < header.numFragmentShaders; i++) {
-		FShaderID id;
-		if (fread(&id, sizeof(id), 1, f) != 1) {
-			ERROR_LOG(G3D, "Vulkan shader cache truncated");
-			break;
+	auto compile = [&](int lower, int upper) {
+		char *codeBuffer = new char[16384];
+		for (int i = lower; i < upper; i++) {
+			if (i < numVS) {
+				const VShaderID &id = vsIDs[i];
+				bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
+				GenerateVulkanGLSLVertexShader(id, codeBuffer);
+				vertexShaders[i] = new VulkanVertexShader(vulkan_, id, codeBuffer, useHWTransform);
+			} else {
+				const FShaderID &id = fsIDs[i - numVS];
+				GenerateVulkanGLSLFragmentShader(id, codeBuffer, vendorID);
+				fragmentShaders[i - numVS] = new VulkanFragmentShader(vulkan_, id, codeBuffer);
+			}
 		}
-		GenerateVulkanGLSLFragmentShader(id, codeBuffer_, vendorID);
-		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan_, id, codeBuffer_);
-		fsCache_.Insert(id, fs);
+		delete[] codeBuffer;
+	};
+
+	time_update();
+	double start = time_now_d();
+	if (g_Config.iNumWorkerThreads > 1 && total > 1) {
+		GlobalThreadPool::TiledLoop(compile, 0, total, 4, true);
+	} else {
+		compile(0, total);
+	}
+
+	for (size_t i = 0; i < vsIDs.size(); i++) {
+		vsCache_.Insert(vsIDs[i], vertexShaders[i]);
+	}
+	for (size_t i = 0; i < fsIDs.size(); i++) {
+		fsCache_.Insert(fsIDs[i], fragmentShaders[i]);
 	}
+	time_update();
+	NOTICE_LOG(G3D, "Compiled %d cached shaders in %0.1f milliseconds", total, (time_now_d() - start) * 1000.0);
 
 	NOTICE_LOG(G3D, "Loaded %d vertex and %d fragment shaders", header.numVertexShaders, header.numFragmentShaders);
 	return true;
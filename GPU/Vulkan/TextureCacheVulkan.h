@@ -133,7 +133,6 @@ class TextureCacheVulkan : public TextureCacheCommon {
 	VulkanTexture *lastBoundTexture = nullptr;
 
 	int decimationCounter_ = 0;
-	int texelsScaledThisFrame_ = 0;
 	int timesInvalidatedAllThisFrame_ = 0;
 
 	FramebufferManagerVulkan *framebufferManagerVulkan_;
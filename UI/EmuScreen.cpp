@@ -1120,11 +1120,13 @@ static void DrawAudioDebugStats(DrawBuffer *draw2d) {
 	const AudioDebugStats *stats = __AudioGetDebugStats();
 	snprintf(statbuf, sizeof(statbuf),
 		"Audio buffer: %d/%d (low watermark: %d)\n"
+		"Fill: %d min, %d avg, %d max\n"
 		"Underruns: %d\n"
 		"Overruns: %d\n"
 		"Sample rate: %d\n"
 		"Push size: %d\n",
 		stats->buffered, stats->bufsize, stats->watermark,
+		stats->minBuffered, stats->avgBuffered, stats->maxBuffered,
 		stats->underrunCount,
 		stats->overrunCount,
 		stats->instantSampleRate,
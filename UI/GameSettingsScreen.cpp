@@ -437,6 +437,15 @@ void GameSettingsScreen::CreateViews() {
 	});
 	deposterize->SetDisabledPtr(&g_Config.bSoftwareRendering);
 
+	CheckBox *texScalingAsync = graphicsSettings->Add(new CheckBox(&g_Config.bTexScalingAsync, gr->T("Upscale in background")));
+	texScalingAsync->OnClick.Add([=](EventParams &e) {
+		if (g_Config.bTexScalingAsync) {
+			settingInfo_->Show(gr->T("UpscaleInBackground Tip", "Avoids stutter, but textures show unscaled for a few frames"), e.v);
+		}
+		return UI::EVENT_CONTINUE;
+	});
+	texScalingAsync->SetDisabledPtr(&g_Config.bSoftwareRendering);
+
 	graphicsSettings->Add(new ItemHeader(gr->T("Texture Filtering")));
 	static const char *anisoLevels[] = { "Off", "2x", "4x", "8x", "16x" };
 	PopupMultiChoice *anisoFiltering = graphicsSettings->Add(new PopupMultiChoice(&g_Config.iAnisotropyLevel, gr->T("Anisotropic Filtering"), anisoLevels, 0, ARRAY_SIZE(anisoLevels), gr->GetName(), screenManager()));
@@ -523,6 +532,8 @@ void GameSettingsScreen::CreateViews() {
 		CheckBox *resampling = audioSettings->Add(new CheckBox(&g_Config.bAudioResampler, a->T("Audio sync", "Audio sync (resampling)")));
 		resampling->SetEnabledPtr(&g_Config.bEnableSound);
 	}
+	CheckBox *highQualityResampling = audioSettings->Add(new CheckBox(&g_Config.bHighQualityResampler, a->T("High quality resampling")));
+	highQualityResampling->SetEnabledPtr(&g_Config.bEnableSound);
 
 	audioSettings->Add(new ItemHeader(a->T("Audio hacks")));
 	audioSettings->Add(new CheckBox(&g_Config.bSoundSpeedHack, a->T("Sound speed hack (DOA etc.)")));
@@ -359,6 +359,7 @@ void CheckGLExtensions() {
 	gl_extensions.EXT_draw_instanced = g_set_gl_extensions.count("GL_EXT_draw_instanced") != 0;
 	gl_extensions.ARB_draw_instanced = g_set_gl_extensions.count("GL_ARB_draw_instanced") != 0;
 	gl_extensions.ARB_cull_distance = g_set_gl_extensions.count("GL_ARB_cull_distance") != 0;
+	gl_extensions.ARB_get_program_binary = g_set_gl_extensions.count("GL_ARB_get_program_binary") != 0;
 
 	if (gl_extensions.IsGLES) {
 		gl_extensions.OES_texture_npot = g_set_gl_extensions.count("GL_OES_texture_npot") != 0;
@@ -516,7 +517,7 @@ void CheckGLExtensions() {
 			// ARB_gpu_shader5 = true;
 		}
 		if (gl_extensions.VersionGEThan(4, 1)) {
-			// ARB_get_program_binary = true;
+			gl_extensions.ARB_get_program_binary = true;
 			// ARB_separate_shader_objects = true;
 			// ARB_shader_precision = true;
 			// ARB_viewport_array = true;
@@ -550,6 +551,17 @@ void CheckGLExtensions() {
 	}
 #endif
 
+	if (gl_extensions.IsGLES) {
+		// OES_get_program_binary has its own entry points, we only use the ES3 ones.
+		gl_extensions.ARB_get_program_binary = gl_extensions.GLES3;
+	}
+	if (gl_extensions.ARB_get_program_binary) {
+		// Drivers may support the API but no formats, which makes it useless.
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		gl_extensions.ARB_get_program_binary = numFormats > 0;
+	}
+
 	ProcessGPUFeatures();
 
 	int error = glGetError();
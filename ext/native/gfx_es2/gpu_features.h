@@ -64,6 +64,7 @@ struct GLExtensions {
 	bool ARB_draw_instanced;
 	bool ARB_buffer_storage;
 	bool ARB_cull_distance;
+	bool ARB_get_program_binary;  // always supported on ES3, but only if the driver has at least one format
 
 	// EXT
 	bool EXT_swap_control_tear;
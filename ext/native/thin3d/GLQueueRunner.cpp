@@ -1,3 +1,6 @@
+#include <algorithm>
+
+#include "ppsspp_config.h"
 #include "Common/MemoryUtil.h"
 #include "Core/Reporting.h"
 #include "GLQueueRunner.h"
@@ -65,6 +68,15 @@ void GLQueueRunner::DestroyDeviceObjects() {
 	if (gl_extensions.ARB_vertex_array_object) {
 		glDeleteVertexArrays(1, &globalVAO_);
 	}
+	// Readbacks still in flight are lost with the device, let them fail.
+	for (GLRReadback *readback : pendingReadbacks_) {
+		glDeleteSync(readback->fence);
+		readback->fence = 0;
+		glDeleteBuffers(1, &readback->buffer);
+		readback->buffer = 0;
+		readback->ready = true;
+	}
+	pendingReadbacks_.clear();
 	delete[] readbackBuffer_;
 	readbackBufferSize_ = 0;
 	delete[] tempBuffer_;
@@ -90,6 +102,73 @@ static std::string GetInfoLog(GLuint name, Getiv getiv, GetLog getLog) {
 	return infoLog;
 }
 
+// Returns true if the program was created from a binary saved by an earlier run.
+static bool LoadProgramBinary(GLRProgram *program) {
+#if !PPSSPP_PLATFORM(UWP)
+	GLRProgram::Binary &binary = program->binary_;
+	if (!program->wantBinary_ || binary.data.empty())
+		return false;
+
+	program->program = glCreateProgram();
+	glProgramBinary(program->program, binary.format, binary.data.data(), (GLsizei)binary.data.size());
+	GLint linkStatus = GL_FALSE;
+	glGetProgramiv(program->program, GL_LINK_STATUS, &linkStatus);
+	if (linkStatus == GL_TRUE) {
+		program->binaryReady_ = true;
+		return true;
+	}
+
+	// Normal, the driver may have been updated. We'll just link and save a new binary.
+	INFO_LOG(G3D, "Program binary rejected by the driver, linking from source");
+	glDeleteProgram(program->program);
+	program->program = 0;
+	binary.data.clear();
+	// Clear the error that some drivers raise for an unknown format.
+	glGetError();
+#endif
+	return false;
+}
+
+static void SaveProgramBinary(GLRProgram *program) {
+#if !PPSSPP_PLATFORM(UWP)
+	GLint length = 0;
+	glGetProgramiv(program->program, GL_PROGRAM_BINARY_LENGTH, &length);
+	GLRProgram::Binary &binary = program->binary_;
+	if (length > 0) {
+		binary.data.resize(length);
+		GLsizei written = 0;
+		GLenum format = 0;
+		glGetProgramBinary(program->program, length, &written, &format, binary.data.data());
+		binary.data.resize(written > 0 ? written : 0);
+		binary.format = format;
+	}
+	program->binaryReady_ = true;
+#endif
+}
+
+static void InitProgramUniforms(GLRProgram *program) {
+	glUseProgram(program->program);
+
+	// Query all the uniforms.
+	for (size_t j = 0; j < program->queries_.size(); j++) {
+		auto &x = program->queries_[j];
+		assert(x.name);
+		*x.dest = glGetUniformLocation(program->program, x.name);
+	}
+
+	// Run initializers.
+	for (size_t j = 0; j < program->initialize_.size(); j++) {
+		auto &init = program->initialize_[j];
+		GLint uniform = *init.uniform;
+		if (uniform != -1) {
+			switch (init.type) {
+			case 0:
+				glUniform1i(uniform, init.value);
+			}
+		}
+	}
+}
+
 void GLQueueRunner::RunInitSteps(const std::vector<GLRInitStep> &steps, bool skipGLCalls) {
 	if (skipGLCalls) {
 		// Some bookkeeping still needs to be done.
@@ -169,6 +248,12 @@ void GLQueueRunner::RunInitSteps(const std::vector<GLRInitStep> &steps, bool ski
 		{
 			CHECK_GL_ERROR_IF_DEBUG();
 			GLRProgram *program = step.create_program.program;
+			if (LoadProgramBinary(program)) {
+				InitProgramUniforms(program);
+				CHECK_GL_ERROR_IF_DEBUG();
+				break;
+			}
+
 			program->program = glCreateProgram();
 			_assert_msg_(G3D, step.create_program.num_shaders > 0, "Can't create a program with zero shaders");
 			for (int j = 0; j < step.create_program.num_shaders; j++) {
@@ -193,6 +278,11 @@ void GLQueueRunner::RunInitSteps(const std::vector<GLRInitStep> &steps, bool ski
 				glBindFragDataLocationIndexedEXT(program->program, 0, 0, "fragColor0");
 				glBindFragDataLocationIndexedEXT(program->program, 0, 1, "fragColor1");
 			}
+#endif
+#if !PPSSPP_PLATFORM(UWP)
+			if (program->wantBinary_) {
+				glProgramParameteri(program->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
 #endif
 			glLinkProgram(program->program);
 
@@ -227,26 +317,10 @@ void GLQueueRunner::RunInitSteps(const std::vector<GLRInitStep> &steps, bool ski
 				break;
 			}
 
-			glUseProgram(program->program);
-
-			// Query all the uniforms.
-			for (size_t j = 0; j < program->queries_.size(); j++) {
-				auto &x = program->queries_[j];
-				assert(x.name);
-				*x.dest = glGetUniformLocation(program->program, x.name);
-			}
-
-			// Run initializers.
-			for (size_t j = 0; j < program->initialize_.size(); j++) {
-				auto &init = program->initialize_[j];
-				GLint uniform = *init.uniform;
-				if (uniform != -1) {
-					switch (init.type) {
-					case 0:
-						glUniform1i(uniform, init.value);
-					}
-				}
+			if (program->wantBinary_) {
+				SaveProgramBinary(program);
 			}
+			InitProgramUniforms(program);
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
 		}
@@ -1219,6 +1293,24 @@ void GLQueueRunner::PerformReadback(const GLRStep &pass) {
 
 	GLRect2D rect = pass.readback.srcRect;
 
+	GLRReadback *async = pass.readback.async;
+	if (async) {
+		// Only color is supported here, converted when the pixels are copied out.
+		if (!async->buffer)
+			glGenBuffers(1, &async->buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, async->buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, srcAlignment * rect.w * rect.h, nullptr, GL_STREAM_READ);
+		glReadPixels(rect.x, rect.y, rect.w, rect.h, format, type, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (!gl_extensions.IsGLES || gl_extensions.GLES3) {
+			glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+		}
+		async->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		pendingReadbacks_.push_back(async);
+		CHECK_GL_ERROR_IF_DEBUG();
+		return;
+	}
+
 	bool convert = internalFormat == GL_RGBA && pass.readback.dstFormat != DataFormat::R8G8B8A8_UNORM;
 
 	int tempSize = srcAlignment * rect.w * rect.h;
@@ -1306,6 +1398,58 @@ void GLQueueRunner::CopyReadbackBuffer(int width, int height, Draw::DataFormat s
 	}
 }
 
+void GLQueueRunner::PollAsyncReadbacks(bool wait) {
+	for (size_t i = 0; i < pendingReadbacks_.size(); ) {
+		GLRReadback *readback = pendingReadbacks_[i];
+		// A second is plenty, if it's not done by then something is very wrong and we give up on it.
+		GLbitfield flags = wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+		GLenum status = glClientWaitSync(readback->fence, flags, wait ? 1000000000ULL : 0);
+		if (status == GL_TIMEOUT_EXPIRED && !wait) {
+			i++;
+			continue;
+		}
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			FinishAsyncReadback(readback);
+		} else {
+			ELOG("Async readback fence failed: %04x", status);
+		}
+		glDeleteSync(readback->fence);
+		readback->fence = 0;
+		glDeleteBuffers(1, &readback->buffer);
+		readback->buffer = 0;
+		readback->ready = true;
+		pendingReadbacks_.erase(pendingReadbacks_.begin() + i);
+	}
+	CHECK_GL_ERROR_IF_DEBUG();
+}
+
+void GLQueueRunner::FinishAsyncReadback(GLRReadback *readback) {
+	const int srcSize = 4 * readback->width * readback->height;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+	const uint8_t *src = (const uint8_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, srcSize, GL_MAP_READ_BIT);
+	if (src) {
+		readback->data.resize(Draw::DataFormatSizeInBytes(readback->dstFormat) * readback->width * readback->height);
+		ConvertFromRGBA8888(readback->data.data(), src, readback->width, readback->width, readback->width, readback->height, readback->dstFormat);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	} else {
+		ELOG("Failed to map async readback buffer");
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void GLQueueRunner::DeleteAsyncReadback(GLRReadback *readback, bool skipGLCalls) {
+	auto it = std::find(pendingReadbacks_.begin(), pendingReadbacks_.end(), readback);
+	if (it != pendingReadbacks_.end())
+		pendingReadbacks_.erase(it);
+	if (!skipGLCalls) {
+		if (readback->fence)
+			glDeleteSync(readback->fence);
+		if (readback->buffer)
+			glDeleteBuffers(1, &readback->buffer);
+	}
+	delete readback;
+}
+
 GLuint GLQueueRunner::AllocTextureName() {
 	if (nameCache_.empty()) {
 		nameCache_.resize(TEXCACHE_NAME_CACHE_SIZE);
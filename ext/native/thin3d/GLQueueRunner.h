@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <unordered_map>
@@ -28,6 +29,7 @@ enum class GLRAllocType {
 class GLRShader;
 class GLRTexture;
 class GLRBuffer;
+struct GLRReadback;
 class GLRFramebuffer;
 class GLRProgram;
 class GLRInputLayout;
@@ -323,6 +325,8 @@ struct GLRStep {
 			GLRFramebuffer *src;
 			GLRect2D srcRect;
 			Draw::DataFormat dstFormat;
+			// If set, reads into its pack buffer instead of readbackBuffer_, without waiting.
+			GLRReadback *async;
 		} readback;
 		struct {
 			GLRTexture *texture;
@@ -332,6 +336,19 @@ struct GLRStep {
 	};
 };
 
+// Target of an asynchronous READBACK step. The pixels go to a pack buffer, and the render thread
+// copies them out once the fence has passed.
+struct GLRReadback {
+	GLuint buffer = 0;
+	GLsync fence = 0;
+	int width = 0;
+	int height = 0;
+	Draw::DataFormat dstFormat = Draw::DataFormat::UNDEFINED;
+	// Tightly packed, in dstFormat. Only touch once ready is set, empty if the readback failed.
+	std::vector<uint8_t> data;
+	std::atomic<bool> ready{ false };
+};
+
 class GLQueueRunner {
 public:
 	GLQueueRunner() {}
@@ -350,6 +367,10 @@ class GLQueueRunner {
 
 	void CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels);
 
+	// Copies out async readbacks whose fences have passed, or all of them if wait is set.
+	void PollAsyncReadbacks(bool wait);
+	void DeleteAsyncReadback(GLRReadback *readback, bool skipGLCalls);
+
 	void Resize(int width, int height) {
 		targetWidth_ = width;
 		targetHeight_ = height;
@@ -381,6 +402,7 @@ class GLQueueRunner {
 	void LogReadbackImage(const GLRStep &pass);
 
 	void ResizeReadbackBuffer(size_t requiredSize);
+	void FinishAsyncReadback(GLRReadback *readback);
 
 	void fbo_ext_create(const GLRInitStep &step);
 	void fbo_bind_fb_target(bool read, GLuint name);
@@ -400,6 +422,8 @@ class GLQueueRunner {
 	// We size it generously.
 	uint8_t *readbackBuffer_ = nullptr;
 	int readbackBufferSize_ = 0;
+	// Async readbacks waiting for their fence.
+	std::vector<GLRReadback *> pendingReadbacks_;
 	// Temp buffer for color conversion
 	uint8_t *tempBuffer_ = nullptr;
 	int tempBufferSize_ = 0;
@@ -30,6 +30,10 @@ void GLDeleter::Perform(GLRenderManager *renderManager, bool skipGLCalls) {
 		delete pushBuffer;
 	}
 	pushBuffers.clear();
+	for (auto readback : readbacks) {
+		renderManager->queueRunner_.DeleteAsyncReadback(readback, skipGLCalls);
+	}
+	readbacks.clear();
 	for (auto shader : shaders) {
 		if (skipGLCalls)
 			shader->shader = 0;  // prevent the glDeleteShader
@@ -341,6 +345,7 @@ bool GLRenderManager::CopyFramebufferToMemorySync(GLRFramebuffer *src, int aspec
 	step->readback.srcRect = { x, y, w, h };
 	step->readback.aspectMask = aspectBits;
 	step->readback.dstFormat = destFormat;
+	step->readback.async = nullptr;
 	steps_.push_back(step);
 
 	// Every step clears this state.
@@ -365,6 +370,52 @@ bool GLRenderManager::CopyFramebufferToMemorySync(GLRFramebuffer *src, int aspec
 	return true;
 }
 
+GLRReadback *GLRenderManager::CopyFramebufferToMemoryAsync(GLRFramebuffer *src, int x, int y, int w, int h, Draw::DataFormat destFormat) {
+	if (!gl_extensions.GLES3 && (gl_extensions.IsGLES || !gl_extensions.VersionGEThan(3, 2))) {
+		// Needs pixel pack buffers, glMapBufferRange, and fences.
+		return nullptr;
+	}
+
+	GLRReadback *readback = new GLRReadback();
+	readback->width = w;
+	readback->height = h;
+	readback->dstFormat = destFormat;
+
+	GLRStep *step = new GLRStep{ GLRStepType::READBACK };
+	step->readback.src = src;
+	step->readback.srcRect = { x, y, w, h };
+	step->readback.aspectMask = GL_COLOR_BUFFER_BIT;
+	step->readback.dstFormat = destFormat;
+	step->readback.async = readback;
+	steps_.push_back(step);
+
+	// Every step clears this state.
+	gstate_c.Dirty(DIRTY_BLEND_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_RASTER_STATE);
+
+	curRenderStep_ = nullptr;
+	return readback;
+}
+
+bool GLRenderManager::ReadAsyncReadback(GLRReadback *readback, bool wait, uint8_t *pixels, int pixelStride) {
+	if (!readback->ready) {
+		if (!wait)
+			return false;
+		// Sync frames wait for all pending readbacks on the render thread.
+		FlushSync();
+		_dbg_assert_msg_(G3D, readback->ready, "Async readback not done after FlushSync");
+		if (!readback->ready)
+			return false;
+	}
+	if (readback->data.empty())
+		return false;
+
+	const int bpp = (int)Draw::DataFormatSizeInBytes(readback->dstFormat);
+	for (int y = 0; y < readback->height; y++) {
+		memcpy(pixels + y * pixelStride * bpp, readback->data.data() + y * readback->width * bpp, readback->width * bpp);
+	}
+	return true;
+}
+
 void GLRenderManager::CopyImageToMemorySync(GLRTexture *texture, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride) {
 	_assert_(texture);
 	_assert_(pixels);
@@ -517,6 +568,11 @@ void GLRenderManager::Run(int frame) {
 	queueRunner_.RunSteps(stepsOnThread, skipGLCalls_);
 	stepsOnThread.clear();
 
+	if (!skipGLCalls_) {
+		// A sync means someone's waiting on the GPU anyway, so that's when to wait for readbacks too.
+		queueRunner_.PollAsyncReadbacks(frameData.type == GLRRunType::SYNC);
+	}
+
 	if (!skipGLCalls_) {
 		for (auto iter : frameData.activePushBuffers) {
 			iter->MapDevice(bufferStrategy_);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -12,6 +13,7 @@
 
 #include "base/logging.h"
 #include "gfx/gl_common.h"
+#include "gfx_es2/gpu_features.h"
 #include "math/dataconv.h"
 #include "Common/Log.h"
 #include "GLQueueRunner.h"
@@ -106,11 +108,24 @@ class GLRProgram {
 		int value;
 	};
 
+	struct Binary {
+		uint32_t format = 0;
+		std::vector<uint8_t> data;
+	};
+
 	GLuint program = 0;
 	std::vector<Semantic> semantics_;
 	std::vector<UniformLocQuery> queries_;
 	std::vector<Initializer> initialize_;
 
+	// If set, GLQueueRunner tries binary_ (if any) before linking, and otherwise fills it in after linking.
+	// Only touch binary_ from outside once binaryReady_ is set.  It's read back right after linking
+	// since only the render thread has the context, and kept for as long as the program lives, since
+	// every SaveCache rewrites all of them.
+	bool wantBinary_ = false;
+	Binary binary_;
+	std::atomic<bool> binaryReady_{ false };
+
 	struct UniformInfo {
 		int loc_;
 	};
@@ -311,7 +326,7 @@ class GLDeleter {
 	void Perform(GLRenderManager *renderManager, bool skipGLCalls);
 
 	bool IsEmpty() const {
-		return shaders.empty() && programs.empty() && buffers.empty() && textures.empty() && inputLayouts.empty() && framebuffers.empty() && pushBuffers.empty();
+		return shaders.empty() && programs.empty() && buffers.empty() && textures.empty() && inputLayouts.empty() && framebuffers.empty() && pushBuffers.empty() && readbacks.empty();
 	}
 
 	void Take(GLDeleter &other) {
@@ -323,6 +338,7 @@ class GLDeleter {
 		inputLayouts = std::move(other.inputLayouts);
 		framebuffers = std::move(other.framebuffers);
 		pushBuffers = std::move(other.pushBuffers);
+		readbacks = std::move(other.readbacks);
 		other.shaders.clear();
 		other.programs.clear();
 		other.buffers.clear();
@@ -330,6 +346,7 @@ class GLDeleter {
 		other.inputLayouts.clear();
 		other.framebuffers.clear();
 		other.pushBuffers.clear();
+		other.readbacks.clear();
 	}
 
 	std::vector<GLRShader *> shaders;
@@ -339,6 +356,7 @@ class GLDeleter {
 	std::vector<GLRInputLayout *> inputLayouts;
 	std::vector<GLRFramebuffer *> framebuffers;
 	std::vector<GLPushBuffer *> pushBuffers;
+	std::vector<GLRReadback *> readbacks;
 };
 
 class GLRInputLayout {
@@ -419,13 +437,18 @@ class GLRenderManager {
 	// not be an active render pass.
 	GLRProgram *CreateProgram(
 		std::vector<GLRShader *> shaders, std::vector<GLRProgram::Semantic> semantics, std::vector<GLRProgram::UniformLocQuery> queries,
-		std::vector<GLRProgram::Initializer> initalizers, bool supportDualSource) {
+		std::vector<GLRProgram::Initializer> initalizers, bool supportDualSource, bool wantBinary = false, const GLRProgram::Binary *binary = nullptr) {
 		GLRInitStep step{ GLRInitStepType::CREATE_PROGRAM };
 		assert(shaders.size() <= ARRAY_SIZE(step.create_program.shaders));
 		step.create_program.program = new GLRProgram();
 		step.create_program.program->semantics_ = semantics;
 		step.create_program.program->queries_ = queries;
 		step.create_program.program->initialize_ = initalizers;
+		if (wantBinary && gl_extensions.ARB_get_program_binary) {
+			step.create_program.program->wantBinary_ = true;
+			if (binary)
+				step.create_program.program->binary_ = *binary;
+		}
 		step.create_program.support_dual_source = supportDualSource;
 		_assert_msg_(G3D, shaders.size() > 0, "Can't create a program with zero shaders");
 		for (size_t i = 0; i < shaders.size(); i++) {
@@ -467,6 +490,9 @@ class GLRenderManager {
 	void DeleteProgram(GLRProgram *program) {
 		deleter_.programs.push_back(program);
 	}
+	void DeleteReadback(GLRReadback *readback) {
+		deleter_.readbacks.push_back(readback);
+	}
 	void DeleteBuffer(GLRBuffer *buffer) {
 		deleter_.buffers.push_back(buffer);
 	}
@@ -494,6 +520,11 @@ class GLRenderManager {
 	void BindFramebufferAsRenderTarget(GLRFramebuffer *fb, GLRRenderPassAction color, GLRRenderPassAction depth, GLRRenderPassAction stencil, uint32_t clearColor, float clearDepth, uint8_t clearStencil);
 	void BindFramebufferAsTexture(GLRFramebuffer *fb, int binding, int aspectBit, int attachment);
 	bool CopyFramebufferToMemorySync(GLRFramebuffer *src, int aspectBits, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride);
+	// Queues a color readback that can be read a few frames later without stalling. Returns nullptr if
+	// the driver lacks pixel buffers or fences. Free with DeleteReadback().
+	GLRReadback *CopyFramebufferToMemoryAsync(GLRFramebuffer *src, int x, int y, int w, int h, Draw::DataFormat destFormat);
+	// Returns false if the readback failed, or isn't done yet and wait is false.
+	bool ReadAsyncReadback(GLRReadback *readback, bool wait, uint8_t *pixels, int pixelStride);
 	void CopyImageToMemorySync(GLRTexture *texture, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride);
 
 	void CopyFramebuffer(GLRFramebuffer *src, GLRect2D srcRect, GLRFramebuffer *dst, GLOffset2D dstPos, int aspectMask);
@@ -910,6 +941,8 @@ class GLRenderManager {
 	}
 
 private:
+	friend class GLDeleter;
+
 	void BeginSubmitFrame(int frame);
 	void EndSubmitFrame(int frame);
 	void Submit(int frame, bool triggerFence);
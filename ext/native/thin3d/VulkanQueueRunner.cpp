@@ -1183,7 +1183,13 @@ void VulkanQueueRunner::SetupTransitionToTransferDst(VKRImage &img, VkImageMemor
 }
 
 void VulkanQueueRunner::PerformReadback(const VKRStep &step, VkCommandBuffer cmd) {
-	ResizeReadbackBuffer(sizeof(uint32_t) * step.readback.srcRect.extent.width * step.readback.srcRect.extent.height);
+	VkBuffer dstBuffer;
+	if (step.readback.async) {
+		dstBuffer = step.readback.async->buffer;
+	} else {
+		ResizeReadbackBuffer(sizeof(uint32_t) * step.readback.srcRect.extent.width * step.readback.srcRect.extent.height);
+		dstBuffer = readbackBuffer_;
+	}
 
 	VkBufferImageCopy region{};
 	region.imageOffset = { step.readback.srcRect.offset.x, step.readback.srcRect.offset.y, 0 };
@@ -1227,7 +1233,7 @@ void VulkanQueueRunner::PerformReadback(const VKRStep &step, VkCommandBuffer cmd
 		copyLayout = srcImage->layout;
 	}
 
-	vkCmdCopyImageToBuffer(cmd, image, copyLayout, readbackBuffer_, 1, &region);
+	vkCmdCopyImageToBuffer(cmd, image, copyLayout, dstBuffer, 1, &region);
 
 	// NOTE: Can't read the buffer using the CPU here - need to sync first.
 
@@ -1277,34 +1283,50 @@ void VulkanQueueRunner::PerformReadbackImage(const VKRStep &step, VkCommandBuffe
 	// NOTE: Can't read the buffer using the CPU here - need to sync first.
 }
 
-void VulkanQueueRunner::CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
-	// Read back to the requested address in ram from buffer.
-	void *mappedData;
+static void CopyReadbackPixels(const uint8_t *src, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
 	const size_t srcPixelSize = DataFormatSizeInBytes(srcFormat);
-
-	VkResult res = vkMapMemory(vulkan_->GetDevice(), readbackMemory_, 0, width * height * srcPixelSize, 0, &mappedData);
-	if (res != VK_SUCCESS) {
-		ELOG("CopyReadbackBuffer: vkMapMemory failed! result=%d", (int)res);
-		return;
-	}
 	if (srcFormat == Draw::DataFormat::R8G8B8A8_UNORM) {
-		ConvertFromRGBA8888(pixels, (const uint8_t *)mappedData, pixelStride, width, width, height, destFormat);
+		ConvertFromRGBA8888(pixels, src, pixelStride, width, width, height, destFormat);
 	} else if (srcFormat == Draw::DataFormat::B8G8R8A8_UNORM) {
-		ConvertFromBGRA8888(pixels, (const uint8_t *)mappedData, pixelStride, width, width, height, destFormat);
+		ConvertFromBGRA8888(pixels, src, pixelStride, width, width, height, destFormat);
 	} else if (srcFormat == destFormat) {
 		uint8_t *dst = pixels;
-		const uint8_t *src = (const uint8_t *)mappedData;
 		for (int y = 0; y < height; ++y) {
 			memcpy(dst, src, width * srcPixelSize);
 			src += width * srcPixelSize;
 			dst += pixelStride * srcPixelSize;
 		}
 	} else if (destFormat == Draw::DataFormat::D32F) {
-		ConvertToD32F(pixels, (const uint8_t *)mappedData, pixelStride, width, width, height, srcFormat);
+		ConvertToD32F(pixels, src, pixelStride, width, width, height, srcFormat);
 	} else {
 		// TODO: Maybe a depth conversion or something?
 		ELOG("CopyReadbackBuffer: Unknown format");
 		assert(false);
 	}
+}
+
+void VulkanQueueRunner::CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
+	// Read back to the requested address in ram from buffer.
+	void *mappedData;
+	const size_t srcPixelSize = DataFormatSizeInBytes(srcFormat);
+
+	VkResult res = vkMapMemory(vulkan_->GetDevice(), readbackMemory_, 0, width * height * srcPixelSize, 0, &mappedData);
+	if (res != VK_SUCCESS) {
+		ELOG("CopyReadbackBuffer: vkMapMemory failed! result=%d", (int)res);
+		return;
+	}
+	CopyReadbackPixels((const uint8_t *)mappedData, width, height, srcFormat, destFormat, pixelStride, pixels);
 	vkUnmapMemory(vulkan_->GetDevice(), readbackMemory_);
 }
+
+void VulkanQueueRunner::CopyAsyncReadback(const VKRReadback *readback, int pixelStride, uint8_t *pixels) {
+	void *mappedData;
+	const size_t srcPixelSize = DataFormatSizeInBytes(readback->srcFormat);
+	VkResult res = vkMapMemory(vulkan_->GetDevice(), readback->memory, 0, readback->width * readback->height * srcPixelSize, 0, &mappedData);
+	if (res != VK_SUCCESS) {
+		ELOG("CopyAsyncReadback: vkMapMemory failed! result=%d", (int)res);
+		return;
+	}
+	CopyReadbackPixels((const uint8_t *)mappedData, readback->width, readback->height, readback->srcFormat, readback->dstFormat, pixelStride, pixels);
+	vkUnmapMemory(vulkan_->GetDevice(), readback->memory);
+}
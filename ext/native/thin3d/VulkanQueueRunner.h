@@ -10,6 +10,18 @@
 class VKRFramebuffer;
 struct VKRImage;
 
+// Target of an asynchronous READBACK step. Readable once the fence of the frame it was submitted
+// in has passed, which VulkanRenderManager tracks.
+struct VKRReadback {
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	int width = 0;
+	int height = 0;
+	Draw::DataFormat srcFormat = Draw::DataFormat::UNDEFINED;
+	Draw::DataFormat dstFormat = Draw::DataFormat::UNDEFINED;
+	bool ready = false;
+};
+
 enum {
 	QUEUE_HACK_MGS2_ACID = 1,
 	QUEUE_HACK_SONIC = 2,
@@ -145,6 +157,8 @@ struct VKRStep {
 			int aspectMask;
 			VKRFramebuffer *src;
 			VkRect2D srcRect;
+			// If set, copies into its buffer instead of readbackBuffer_.
+			VKRReadback *async;
 		} readback;
 		struct {
 			VkImage image;
@@ -184,6 +198,7 @@ class VulkanQueueRunner {
 	}
 
 	void CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels);
+	void CopyAsyncReadback(const VKRReadback *readback, int pixelStride, uint8_t *pixels);
 
 	struct RPKey {
 		VKRRenderPassAction colorLoadAction;
@@ -359,6 +359,10 @@ void VulkanRenderManager::BeginFrame() {
 	VLOG("PUSH: Fencing %d", curFrame);
 	vkWaitForFences(device, 1, &frameData.fence, true, UINT64_MAX);
 	vkResetFences(device, 1, &frameData.fence);
+	for (VKRReadback *readback : frameData.readbacks) {
+		readback->ready = true;
+	}
+	frameData.readbacks.clear();
 
 	// Must be after the fence - this performs deletes.
 	VLOG("PUSH: BeginFrame %d", curFrame);
@@ -438,6 +442,7 @@ bool VulkanRenderManager::CopyFramebufferToMemorySync(VKRFramebuffer *src, int a
 	step->readback.src = src;
 	step->readback.srcRect.offset = { x, y };
 	step->readback.srcRect.extent = { (uint32_t)w, (uint32_t)h };
+	step->readback.async = nullptr;
 	steps_.push_back(step);
 
 	curRenderStep_ = nullptr;
@@ -484,6 +489,79 @@ bool VulkanRenderManager::CopyFramebufferToMemorySync(VKRFramebuffer *src, int a
 	return true;
 }
 
+VKRReadback *VulkanRenderManager::CopyFramebufferToMemoryAsync(VKRFramebuffer *src, int x, int y, int w, int h, Draw::DataFormat destFormat) {
+	// Not worth it for the backbuffer, that's only read for screenshots.
+	if (!src || src->color.format != VK_FORMAT_R8G8B8A8_UNORM)
+		return nullptr;
+
+	VkDevice device = vulkan_->GetDevice();
+	VKRReadback *readback = new VKRReadback();
+	readback->width = w;
+	readback->height = h;
+	readback->srcFormat = Draw::DataFormat::R8G8B8A8_UNORM;
+	readback->dstFormat = destFormat;
+
+	VkBufferCreateInfo buf{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	buf.size = sizeof(uint32_t) * w * h;
+	buf.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	vkCreateBuffer(device, &buf, nullptr, &readback->buffer);
+
+	VkMemoryRequirements reqs{};
+	vkGetBufferMemoryRequirements(device, readback->buffer, &reqs);
+	VkMemoryAllocateInfo alloc{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	alloc.allocationSize = reqs.size;
+	VkFlags typeReqs = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	if (!vulkan_->MemoryTypeFromProperties(reqs.memoryTypeBits, typeReqs, &alloc.memoryTypeIndex) || vkAllocateMemory(device, &alloc, nullptr, &readback->memory) != VK_SUCCESS) {
+		vkDestroyBuffer(device, readback->buffer, nullptr);
+		delete readback;
+		return nullptr;
+	}
+	vkBindBufferMemory(device, readback->buffer, readback->memory, 0);
+
+	for (int i = (int)steps_.size() - 1; i >= 0; i--) {
+		if (steps_[i]->stepType == VKRStepType::RENDER && steps_[i]->render.framebuffer == src) {
+			steps_[i]->render.numReads++;
+			break;
+		}
+	}
+
+	VKRStep *step = new VKRStep{ VKRStepType::READBACK };
+	step->readback.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	step->readback.src = src;
+	step->readback.srcRect.offset = { x, y };
+	step->readback.srcRect.extent = { (uint32_t)w, (uint32_t)h };
+	step->readback.async = readback;
+	steps_.push_back(step);
+
+	curRenderStep_ = nullptr;
+
+	// Submitted with this frame, so done once its fence is.
+	frameData_[vulkan_->GetCurFrame()].readbacks.push_back(readback);
+	return readback;
+}
+
+bool VulkanRenderManager::ReadAsyncReadback(VKRReadback *readback, bool wait, uint8_t *pixels, int pixelStride) {
+	if (!readback->ready) {
+		if (!wait)
+			return false;
+		// Waits for everything, including the frames still in flight.
+		FlushSync();
+	}
+	queueRunner_.CopyAsyncReadback(readback, pixelStride, pixels);
+	return true;
+}
+
+void VulkanRenderManager::DeleteReadback(VKRReadback *readback) {
+	for (int i = 0; i < vulkan_->GetInflightFrames(); i++) {
+		auto &readbacks = frameData_[i].readbacks;
+		readbacks.erase(std::remove(readbacks.begin(), readbacks.end(), readback), readbacks.end());
+	}
+	// The GPU may still be writing to it, so this has to wait for the frame.
+	vulkan_->Delete().QueueDeleteBuffer(readback->buffer);
+	vulkan_->Delete().QueueDeleteDeviceMemory(readback->memory);
+	delete readback;
+}
+
 void VulkanRenderManager::CopyImageToMemorySync(VkImage image, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride) {
 	VKRStep *step = new VKRStep{ VKRStepType::READBACK_IMAGE };
 	step->readback_image.image = image;
@@ -1042,4 +1120,12 @@ void VulkanRenderManager::FlushSync() {
 		}
 		frameData.readyForFence = false;
 	}
+
+	// The queue is in order, so everything submitted before is done too.
+	for (int i = 0; i < vulkan_->GetInflightFrames(); i++) {
+		for (VKRReadback *readback : frameData_[i].readbacks) {
+			readback->ready = true;
+		}
+		frameData_[i].readbacks.clear();
+	}
 }
@@ -103,6 +103,11 @@ class VulkanRenderManager {
 	void BindFramebufferAsRenderTarget(VKRFramebuffer *fb, VKRRenderPassAction color, VKRRenderPassAction depth, VKRRenderPassAction stencil, uint32_t clearColor, float clearDepth, uint8_t clearStencil);
 	VkImageView BindFramebufferAsTexture(VKRFramebuffer *fb, int binding, int aspectBit, int attachment);
 	bool CopyFramebufferToMemorySync(VKRFramebuffer *src, int aspectBits, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride);
+	// Queues a color readback that can be read a few frames later without stalling. Free with DeleteReadback().
+	VKRReadback *CopyFramebufferToMemoryAsync(VKRFramebuffer *src, int x, int y, int w, int h, Draw::DataFormat destFormat);
+	// Returns false if the readback isn't done yet and wait is false.
+	bool ReadAsyncReadback(VKRReadback *readback, bool wait, uint8_t *pixels, int pixelStride);
+	void DeleteReadback(VKRReadback *readback);
 	void CopyImageToMemorySync(VkImage image, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride);
 
 	void CopyFramebuffer(VKRFramebuffer *src, VkRect2D srcRect, VKRFramebuffer *dst, VkOffset2D dstPos, int aspectMask);
@@ -277,6 +282,8 @@ class VulkanRenderManager {
 		VkCommandBuffer mainCmd;
 		bool hasInitCommands = false;
 		std::vector<VKRStep *> steps;
+		// Async readbacks that will be done when fence is.
+		std::vector<VKRReadback *> readbacks;
 
 		// Swapchain.
 		bool hasBegun = false;
@@ -353,6 +353,11 @@ class Buffer : public RefCountedObject {
 public:
 };
 
+// A framebuffer copy queued with CopyFramebufferToMemoryAsync. Release it when done, read or not.
+class AsyncReadback : public RefCountedObject {
+public:
+};
+
 class Texture : public RefCountedObject {
 public:
 	int Width() { return width_; }
@@ -568,6 +573,15 @@ class DrawContext {
 	virtual bool CopyFramebufferToMemorySync(Framebuffer *src, int channelBits, int x, int y, int w, int h, Draw::DataFormat format, void *pixels, int pixelStride) {
 		return false;
 	}
+	// Queues a color copy like CopyFramebufferToMemorySync without waiting for the GPU. Returns nullptr
+	// if the backend can't, in which case use the sync version.
+	virtual AsyncReadback *CopyFramebufferToMemoryAsync(Framebuffer *src, int x, int y, int w, int h, Draw::DataFormat format) {
+		return nullptr;
+	}
+	// Returns false if the copy failed, or the GPU isn't done with it yet and wait is false.
+	virtual bool ReadAsyncReadback(AsyncReadback *readback, bool wait, void *pixels, int pixelStride) {
+		return false;
+	}
 	virtual DataFormat PreferredFramebufferReadbackFormat(Framebuffer *src) {
 		return DataFormat::R8G8B8A8_UNORM;
 	}
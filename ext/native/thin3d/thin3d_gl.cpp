@@ -373,6 +373,8 @@ class OpenGLContext : public DrawContext {
 	void CopyFramebufferImage(Framebuffer *src, int level, int x, int y, int z, Framebuffer *dst, int dstLevel, int dstX, int dstY, int dstZ, int width, int height, int depth, int channelBits) override;
 	bool BlitFramebuffer(Framebuffer *src, int srcX1, int srcY1, int srcX2, int srcY2, Framebuffer *dst, int dstX1, int dstY1, int dstX2, int dstY2, int channelBits, FBBlitFilter filter) override;
 	bool CopyFramebufferToMemorySync(Framebuffer *src, int channelBits, int x, int y, int w, int h, Draw::DataFormat format, void *pixels, int pixelStride) override;
+	AsyncReadback *CopyFramebufferToMemoryAsync(Framebuffer *src, int x, int y, int w, int h, Draw::DataFormat format) override;
+	bool ReadAsyncReadback(AsyncReadback *readback, bool wait, void *pixels, int pixelStride) override;
 
 	// These functions should be self explanatory.
 	void BindFramebufferAsRenderTarget(Framebuffer *fbo, const RenderPassInfo &rp) override;
@@ -654,6 +656,17 @@ class OpenGLFramebuffer : public Framebuffer {
 	FBColorDepth colorDepth;
 };
 
+class OpenGLAsyncReadback : public AsyncReadback {
+public:
+	OpenGLAsyncReadback(GLRenderManager *render, GLRReadback *readback) : render_(render), readback_(readback) {}
+	~OpenGLAsyncReadback() {
+		render_->DeleteReadback(readback_);
+	}
+
+	GLRenderManager *render_;
+	GLRReadback *readback_;
+};
+
 void OpenGLTexture::SetImageData(int x, int y, int z, int width, int height, int depth, int level, int stride, const uint8_t *data) {
 	if (width != width_ || height != height_ || depth != depth_) {
 		// When switching to texStorage we need to handle this correctly.
@@ -734,6 +747,16 @@ bool OpenGLContext::CopyFramebufferToMemorySync(Framebuffer *src, int channelBit
 	return true;
 }
 
+AsyncReadback *OpenGLContext::CopyFramebufferToMemoryAsync(Framebuffer *src, int x, int y, int w, int h, Draw::DataFormat dataFormat) {
+	OpenGLFramebuffer *fb = (OpenGLFramebuffer *)src;
+	GLRReadback *readback = renderManager_.CopyFramebufferToMemoryAsync(fb ? fb->framebuffer : nullptr, x, y, w, h, dataFormat);
+	return readback ? new OpenGLAsyncReadback(&renderManager_, readback) : nullptr;
+}
+
+bool OpenGLContext::ReadAsyncReadback(AsyncReadback *readback, bool wait, void *pixels, int pixelStride) {
+	OpenGLAsyncReadback *glReadback = (OpenGLAsyncReadback *)readback;
+	return renderManager_.ReadAsyncReadback(glReadback->readback_, wait, (uint8_t *)pixels, pixelStride);
+}
 
 Texture *OpenGLContext::CreateTexture(const TextureDesc &desc) {
 	return new OpenGLTexture(&renderManager_, desc);
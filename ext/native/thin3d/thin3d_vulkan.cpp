@@ -379,6 +379,8 @@ class VKContext : public DrawContext {
 	void CopyFramebufferImage(Framebuffer *src, int level, int x, int y, int z, Framebuffer *dst, int dstLevel, int dstX, int dstY, int dstZ, int width, int height, int depth, int channelBits) override;
 	bool BlitFramebuffer(Framebuffer *src, int srcX1, int srcY1, int srcX2, int srcY2, Framebuffer *dst, int dstX1, int dstY1, int dstX2, int dstY2, int channelBits, FBBlitFilter filter) override;
 	bool CopyFramebufferToMemorySync(Framebuffer *src, int channelBits, int x, int y, int w, int h, Draw::DataFormat format, void *pixels, int pixelStride) override;
+	AsyncReadback *CopyFramebufferToMemoryAsync(Framebuffer *src, int x, int y, int w, int h, Draw::DataFormat format) override;
+	bool ReadAsyncReadback(AsyncReadback *readback, bool wait, void *pixels, int pixelStride) override;
 	DataFormat PreferredFramebufferReadbackFormat(Framebuffer *src) override;
 
 	// These functions should be self explanatory.
@@ -1407,6 +1409,28 @@ bool VKContext::CopyFramebufferToMemorySync(Framebuffer *srcfb, int channelBits,
 	return renderManager_.CopyFramebufferToMemorySync(src ? src->GetFB() : nullptr, aspectMask, x, y, w, h, format, (uint8_t *)pixels, pixelStride);
 }
 
+class VKAsyncReadback : public AsyncReadback {
+public:
+	VKAsyncReadback(VulkanRenderManager *render, VKRReadback *readback) : render_(render), readback_(readback) {}
+	~VKAsyncReadback() {
+		render_->DeleteReadback(readback_);
+	}
+
+	VulkanRenderManager *render_;
+	VKRReadback *readback_;
+};
+
+AsyncReadback *VKContext::CopyFramebufferToMemoryAsync(Framebuffer *srcfb, int x, int y, int w, int h, Draw::DataFormat format) {
+	VKFramebuffer *src = (VKFramebuffer *)srcfb;
+	VKRReadback *readback = renderManager_.CopyFramebufferToMemoryAsync(src ? src->GetFB() : nullptr, x, y, w, h, format);
+	return readback ? new VKAsyncReadback(&renderManager_, readback) : nullptr;
+}
+
+bool VKContext::ReadAsyncReadback(AsyncReadback *readback, bool wait, void *pixels, int pixelStride) {
+	VKAsyncReadback *vkReadback = (VKAsyncReadback *)readback;
+	return renderManager_.ReadAsyncReadback(vkReadback->readback_, wait, (uint8_t *)pixels, pixelStride);
+}
+
 DataFormat VKContext::PreferredFramebufferReadbackFormat(Framebuffer *src) {
 	if (src) {
 		return DrawContext::PreferredFramebufferReadbackFormat(src);
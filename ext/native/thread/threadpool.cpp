@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "base/logging.h"
 #include "thread/threadpool.h"
 #include "thread/threadutil.h"
@@ -125,3 +127,130 @@ void ThreadPool::ParallelLoop(const std::function<void(int,int)> &loop, int lowe
 	}
 }
 
+///////////////////////////// WorkStealingPool
+
+WorkStealingPool::WorkStealingPool(int numThreads) : nextQueue_(0), pending_(0) {
+	if (numThreads <= 0) {
+		numThreads_ = 1;
+		ILOG("WorkStealingPool: Bad number of threads %i", numThreads);
+	} else if (numThreads > 8) {
+		ILOG("WorkStealingPool: Capping number of threads to 8 (was %i)", numThreads);
+		numThreads_ = 8;
+	} else {
+		numThreads_ = numThreads;
+	}
+
+	// The callers work too, so one less worker keeps the same amount of parallelism as ThreadPool.
+	int numWorkers = numThreads_ - 1;
+	for (int i = 0; i < numWorkers; ++i) {
+		queues_.push_back(std::unique_ptr<TileQueue>(new TileQueue()));
+	}
+	for (int i = 0; i < numWorkers; ++i) {
+		threads_.push_back(std::thread(std::bind(&WorkStealingPool::WorkFunc, this, i)));
+	}
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	{
+		std::lock_guard<std::mutex> guard(sleepLock_);
+		active_ = false;
+		wake_.notify_all();
+	}
+	for (auto &thread : threads_) {
+		thread.join();
+	}
+}
+
+void WorkStealingPool::TiledLoop(const std::function<void(int, int)> &loop, int lower, int upper, int tileSize, bool highPriority) {
+	int range = upper - lower;
+	if (queues_.empty() || range <= tileSize) {
+		loop(lower, upper);
+		return;
+	}
+
+	LoopState state;
+	state.loop = &loop;
+	int numTiles = (range + tileSize - 1) / tileSize;
+	state.remaining = numTiles;
+
+	int priority = highPriority ? 0 : 1;
+	int q = nextQueue_++;
+	for (int s = lower; s < upper; s += tileSize) {
+		TileQueue &queue = *queues_[q++ % queues_.size()];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		queue.tiles[priority].push_back(Tile{ &state, s, std::min(s + tileSize, upper) });
+	}
+	{
+		std::lock_guard<std::mutex> guard(sleepLock_);
+		pending_ += numTiles;
+		wake_.notify_all();
+	}
+
+	// Help out until our own loop is done, whoever's tiles we end up running.
+	Tile tile;
+	while (state.remaining > 0) {
+		if (PopTile(-1, tile)) {
+			RunTile(tile);
+		} else {
+			std::unique_lock<std::mutex> guard(sleepLock_);
+			wake_.wait(guard, [&] { return state.remaining == 0 || pending_ > 0; });
+		}
+	}
+}
+
+bool WorkStealingPool::PopTile(int self, Tile &tile) {
+	int count = (int)queues_.size();
+	for (int priority = 0; priority < 2; ++priority) {
+		if (self >= 0) {
+			TileQueue &queue = *queues_[self];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			if (!queue.tiles[priority].empty()) {
+				tile = queue.tiles[priority].front();
+				queue.tiles[priority].pop_front();
+				pending_--;
+				return true;
+			}
+		}
+		for (int i = 1; i <= count; ++i) {
+			int victim = (self + i + count) % count;
+			if (victim == self) {
+				continue;
+			}
+			TileQueue &queue = *queues_[victim];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			if (!queue.tiles[priority].empty()) {
+				tile = queue.tiles[priority].back();
+				queue.tiles[priority].pop_back();
+				pending_--;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::RunTile(const Tile &tile) {
+	(*tile.state->loop)(tile.start, tile.end);
+	// The state lives on the caller's stack, don't touch it after this.
+	if (--tile.state->remaining == 0) {
+		std::lock_guard<std::mutex> guard(sleepLock_);
+		wake_.notify_all();
+	}
+}
+
+void WorkStealingPool::WorkFunc(int index) {
+	setCurrentThreadName("TileWorker");
+	Tile tile;
+	while (true) {
+		if (PopTile(index, tile)) {
+			RunTile(tile);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock_);
+		wake_.wait(guard, [&] { return !active_ || pending_ > 0; });
+		if (!active_) {
+			break;
+		}
+	}
+}
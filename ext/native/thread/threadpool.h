@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -75,3 +77,50 @@ class ThreadPool {
 	void operator =(const ThreadPool &other);
 };
 
+// Runs loops split into fixed size tiles on a set of workers that steal tiles from each other.
+// Unlike ThreadPool, loops from different threads can be in flight at once, so e.g. the emu thread
+// doesn't wait behind the background texture scaler's barrier.  Each call still blocks its caller,
+// which helps out until its own loop is done.  High priority tiles always go first.
+class WorkStealingPool {
+public:
+	WorkStealingPool(int numThreads);
+	~WorkStealingPool();
+
+	void TiledLoop(const std::function<void(int, int)> &loop, int lower, int upper, int tileSize, bool highPriority);
+
+private:
+	struct LoopState {
+		const std::function<void(int, int)> *loop;
+		std::atomic<int> remaining;
+	};
+	struct Tile {
+		LoopState *state;
+		int start;
+		int end;
+	};
+	struct TileQueue {
+		std::mutex lock;
+		// Index 0 is high priority.
+		std::deque<Tile> tiles[2];
+	};
+
+	// Own queue first (from the front), then steal from the back of the others.  self is -1 for callers.
+	bool PopTile(int self, Tile &tile);
+	void RunTile(const Tile &tile);
+	void WorkFunc(int index);
+
+	int numThreads_;
+	std::vector<std::unique_ptr<TileQueue>> queues_;
+	std::vector<std::thread> threads_;
+	std::atomic<int> nextQueue_;
+	// Tiles queued but not yet picked up.  Only incremented with sleepLock_ held.
+	std::atomic<int> pending_;
+
+	std::mutex sleepLock_;
+	// Signaled both for new tiles and for finished loops.
+	std::condition_variable wake_;
+	bool active_ = true;
+
+	WorkStealingPool(const WorkStealingPool &other); // prevent copies
+	void operator =(const WorkStealingPool &other);
+};
@@ -0,0 +1,127 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+
+#include "base/timeutil.h"
+#include "thread/threadutil.h"
+#include "Core/HLE/__sceAudio.h"
+
+#include "AudioSink.h"
+
+enum {
+	// Like a typical device callback, around 10ms.
+	SINK_PERIOD_MS = 10,
+	SINK_MAX_FRAMES = 1024,
+};
+
+HeadlessAudioSink::~HeadlessAudioSink() {
+	Stop();
+}
+
+void HeadlessAudioSink::Start(int sampleRate) {
+	if (running_)
+		return;
+	sampleRate_ = sampleRate;
+	running_ = true;
+	thread_ = std::thread([this] { Run(); });
+}
+
+void HeadlessAudioSink::Stop() {
+	if (!running_)
+		return;
+	running_ = false;
+	thread_.join();
+}
+
+void HeadlessAudioSink::Run() {
+	setCurrentThreadName("AudioSink");
+
+	short buffer[SINK_MAX_FRAMES * 2];
+	const double start = real_time_now();
+	int64_t played = 0;
+	// Throw away whatever stats were collected before we started.
+	__AudioGetDebugStats();
+
+	while (running_) {
+		sleep_ms(SINK_PERIOD_MS);
+
+		// Catch up with the wall clock, even if we overslept.
+		const int64_t due = (int64_t)((real_time_now() - start) * sampleRate_);
+		while (played < due) {
+			const int frames = (int)std::min(due - played, (int64_t)SINK_MAX_FRAMES);
+			const int got = __AudioMix(buffer, frames, sampleRate_);
+			framesRequested_ += frames;
+			framesMissing_ += frames - got;
+			callbacks_++;
+			if (got < frames)
+				shortCallbacks_++;
+			played += frames;
+		}
+
+		const AudioDebugStats *stats = __AudioGetDebugStats();
+		if (samplesBuffered_ == 0 || stats->minBuffered < minBuffered_)
+			minBuffered_ = stats->minBuffered;
+		maxBuffered_ = std::max(maxBuffered_, stats->maxBuffered);
+		sumBuffered_ += stats->avgBuffered;
+		samplesBuffered_++;
+		overruns_ = stats->overrunCount;
+	}
+
+	seconds_ = real_time_now() - start;
+}
+
+void HeadlessAudioSink::PrintReport(FILE *fp) const {
+	const int avgBuffered = samplesBuffered_ == 0 ? 0 : (int)(sumBuffered_ / samplesBuffered_);
+	fprintf(fp, "Audio sink: %.2f s at %d Hz, %lld frames requested, %lld missing (%d of %d callbacks short)\n",
+		seconds_, sampleRate_, (long long)framesRequested_, (long long)framesMissing_, shortCallbacks_, callbacks_);
+	fprintf(fp, "Audio sink: buffered frames min %d, avg %d, max %d, %d overruns\n",
+		minBuffered_, avgBuffered, maxBuffered_, overruns_);
+}
+
+bool HeadlessAudioRender::Start(const std::string &filename) {
+	if (running_)
+		return false;
+	if (!__AudioStartOfflineRender(filename))
+		return false;
+	__AudioResetStageStats();
+	running_ = true;
+	start_ = real_time_now();
+	return true;
+}
+
+void HeadlessAudioRender::Stop() {
+	if (!running_)
+		return;
+	running_ = false;
+	seconds_ = real_time_now() - start_;
+	frames_ = (int64_t)__AudioStopOfflineRender();
+
+	sasMs_ = g_AudioStageStats.usSas / 1000.0;
+	atracMs_ = g_AudioStageStats.usAtrac / 1000.0;
+	mpegMs_ = g_AudioStageStats.usMpeg / 1000.0;
+	mixMs_ = g_AudioStageStats.usMix / 1000.0;
+}
+
+void HeadlessAudioRender::PrintReport(FILE *fp) const {
+	const double audioSeconds = frames_ / 44100.0;
+	const double speed = seconds_ > 0.0 ? audioSeconds / seconds_ : 0.0;
+	fprintf(fp, "Audio render: %.2f s of audio (%lld frames) in %.2f s, %.1fx real time\n",
+		audioSeconds, (long long)frames_, seconds_, speed);
+	fprintf(fp, "Audio render: CPU ms sas %.1f, atrac %.1f, mpeg %.1f, mix %.1f\n",
+		sasMs_, atracMs_, mpegMs_, mixMs_);
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+// Stands in for an audio device: pulls samples out of the emulator on its own thread at wall
+// clock rate, so underruns and buffering problems can be measured without any audio hardware.
+class HeadlessAudioSink {
+public:
+	~HeadlessAudioSink();
+
+	void Start(int sampleRate = 44100);
+	void Stop();
+	void PrintReport(FILE *fp) const;
+
+private:
+	void Run();
+
+	std::thread thread_;
+	std::atomic<bool> running_{ false };
+	int sampleRate_ = 44100;
+	double seconds_ = 0.0;
+
+	// In stereo frames.
+	int64_t framesRequested_ = 0;
+	int64_t framesMissing_ = 0;
+	int callbacks_ = 0;
+	int shortCallbacks_ = 0;
+
+	int minBuffered_ = 0;
+	int maxBuffered_ = 0;
+	int64_t sumBuffered_ = 0;
+	int samplesBuffered_ = 0;
+	int overruns_ = 0;
+};
+
+// Instead of playing anything, writes the game's mix to a WAV file as fast as the emulator runs.
+// The file only depends on what was run, so it can be compared against a known good render, and
+// the time spent in each audio stage is reported for measuring their CPU cost.
+class HeadlessAudioRender {
+public:
+	bool Start(const std::string &filename);
+	void Stop();
+	void PrintReport(FILE *fp) const;
+
+private:
+	bool running_ = false;
+	double start_ = 0.0;
+	double seconds_ = 0.0;
+	int64_t frames_ = 0;
+
+	// In milliseconds.
+	double sasMs_ = 0.0;
+	double atracMs_ = 0.0;
+	double mpegMs_ = 0.0;
+	double mixMs_ = 0.0;
+};
@@ -0,0 +1,224 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "base/timeutil.h"
+#include "file/file_util.h"
+#include "json/json_writer.h"
+#include "thin3d/thin3d.h"
+#include "Common/FileUtil.h"
+#include "Core/Core.h"
+#include "Core/CoreParameter.h"
+#include "Core/CoreTiming.h"
+#include "Core/Host.h"
+#include "Core/System.h"
+#include "GPU/GPU.h"
+
+#include "Benchmark.h"
+#include "StubHost.h"
+
+struct BenchmarkFrame {
+	double totalMs;
+	double displayListMs;
+	double vertexDecodeMs;
+	double textureMs;
+	double transformMs;
+	double rasterMs;
+	int drawCalls;
+	int vertices;
+};
+
+static const char *GPUCoreName(GPUCore core) {
+	switch (core) {
+	case GPUCORE_NULL: return "null";
+	case GPUCORE_GLES: return "gles";
+	case GPUCORE_SOFTWARE: return "software";
+	case GPUCORE_DIRECTX9: return "directx9";
+	case GPUCORE_DIRECTX11: return "directx11";
+	case GPUCORE_VULKAN: return "vulkan";
+	default: return "unknown";
+	}
+}
+
+static BenchmarkFrame CollectFrame(double totalMs) {
+	BenchmarkFrame frame;
+	frame.totalMs = totalMs;
+	frame.vertexDecodeMs = gpuStats.msDecodingVertices;
+	frame.textureMs = gpuStats.msDecodingTextures;
+	frame.transformMs = gpuStats.msTransforming;
+	frame.rasterMs = gpuStats.msRasterizing;
+	// The other stages happen while processing display lists, so only count what's left.
+	// msProcessingDisplayLists is actually in seconds.
+	double stagesMs = frame.vertexDecodeMs + frame.textureMs + frame.transformMs + frame.rasterMs;
+	frame.displayListMs = std::max(0.0, gpuStats.msProcessingDisplayLists * 1000.0 - stagesMs);
+	frame.drawCalls = gpuStats.numDrawCalls;
+	frame.vertices = gpuStats.numVertsSubmitted;
+	return frame;
+}
+
+static void WriteFrameTimes(json::JsonWriter &j, const BenchmarkFrame &f) {
+	j.writeFloat("total_ms", f.totalMs);
+	j.writeFloat("display_list_ms", f.displayListMs);
+	j.writeFloat("vertex_decode_ms", f.vertexDecodeMs);
+	j.writeFloat("texture_ms", f.textureMs);
+	j.writeFloat("transform_ms", f.transformMs);
+	j.writeFloat("raster_ms", f.rasterMs);
+}
+
+static bool RunDump(HeadlessHost *headlessHost, CoreParameter &coreParameter, const DumpBenchmarkOptions &options, std::vector<BenchmarkFrame> &frames, std::string &error) {
+	std::string errorString;
+	if (!PSP_Init(coreParameter, &errorString)) {
+		error = errorString;
+		return false;
+	}
+	host->BootDone();
+
+	// Turns on the stage timers, and resets the per-frame stats.
+	Core_UpdateDebugStats(true);
+
+	PSP_BeginHostFrame();
+	if (coreParameter.thin3d)
+		coreParameter.thin3d->BeginFrame();
+
+	time_update();
+	const double deadline = time_now_d() + options.timeout;
+	double frameStart = real_time_now();
+	int seenFrames = 0;
+
+	coreState = CORE_RUNNING;
+	while (coreState == CORE_RUNNING && (int)frames.size() < options.frames) {
+		PSP_RunLoopFor(usToCycles(1000000 / 10));
+
+		if (coreState == CORE_NEXTFRAME) {
+			coreState = CORE_RUNNING;
+			double now = real_time_now();
+			if (++seenFrames > options.warmupFrames) {
+				frames.push_back(CollectFrame((now - frameStart) * 1000.0));
+			}
+			Core_UpdateDebugStats(true);
+			headlessHost->SwapBuffers();
+			frameStart = real_time_now();
+		}
+
+		time_update();
+		if (time_now_d() > deadline) {
+			error = "Timed out";
+			Core_Stop();
+		}
+	}
+	PSP_EndHostFrame();
+	if (coreParameter.thin3d)
+		coreParameter.thin3d->EndFrame();
+
+	PSP_Shutdown();
+	Core_UpdateDebugStats(false);
+	headlessHost->FlushDebugOutput();
+	return !frames.empty();
+}
+
+bool RunDumpBenchmark(HeadlessHost *headlessHost, CoreParameter &coreParameter, const DumpBenchmarkOptions &options) {
+	std::vector<FileInfo> dumps;
+	getFilesInDir(options.dumpDirectory.c_str(), &dumps, "ppdmp:");
+	std::sort(dumps.begin(), dumps.end());
+	if (dumps.empty()) {
+		fprintf(stderr, "No .ppdmp files found in %s\n", options.dumpDirectory.c_str());
+		return false;
+	}
+
+	json::JsonWriter j(json::JsonWriter::PRETTY);
+	j.begin();
+	j.writeString("gpu", GPUCoreName(coreParameter.gpuCore));
+	j.writeInt("frames", options.frames);
+	j.writeInt("warmup_frames", options.warmupFrames);
+	j.pushArray("dumps");
+
+	int succeeded = 0;
+	for (const FileInfo &dump : dumps) {
+		coreParameter.fileToStart = dump.fullName;
+		fprintf(stderr, "Benchmarking %s\n", dump.name.c_str());
+
+		std::vector<BenchmarkFrame> frames;
+		std::string error;
+		bool success = RunDump(headlessHost, coreParameter, options, frames, error);
+
+		j.pushDict();
+		j.writeString("file", dump.name);
+		if (!error.empty())
+			j.writeString("error", error);
+
+		if (success) {
+			succeeded++;
+			BenchmarkFrame sum{};
+			double minTotal = frames[0].totalMs, maxTotal = frames[0].totalMs;
+			for (const BenchmarkFrame &f : frames) {
+				sum.totalMs += f.totalMs;
+				sum.displayListMs += f.displayListMs;
+				sum.vertexDecodeMs += f.vertexDecodeMs;
+				sum.textureMs += f.textureMs;
+				sum.transformMs += f.transformMs;
+				sum.rasterMs += f.rasterMs;
+				minTotal = std::min(minTotal, f.totalMs);
+				maxTotal = std::max(maxTotal, f.totalMs);
+			}
+			const double n = (double)frames.size();
+			BenchmarkFrame avg = sum;
+			avg.totalMs /= n;
+			avg.displayListMs /= n;
+			avg.vertexDecodeMs /= n;
+			avg.textureMs /= n;
+			avg.transformMs /= n;
+			avg.rasterMs /= n;
+
+			j.pushDict("average");
+			WriteFrameTimes(j, avg);
+			j.writeFloat("min_total_ms", minTotal);
+			j.writeFloat("max_total_ms", maxTotal);
+			j.pop();
+
+			j.pushArray("frames");
+			for (const BenchmarkFrame &f : frames) {
+				j.pushDict();
+				WriteFrameTimes(j, f);
+				j.writeInt("draw_calls", f.drawCalls);
+				j.writeInt("vertices", f.vertices);
+				j.pop();
+			}
+			j.pop();
+		}
+		j.pop();
+	}
+
+	j.pop();
+	j.end();
+
+	if (options.jsonFilename.empty()) {
+		printf("%s\n", j.str().c_str());
+	} else {
+		FILE *fp = File::OpenCFile(options.jsonFilename, "wb");
+		if (!fp) {
+			fprintf(stderr, "Unable to write %s\n", options.jsonFilename.c_str());
+			return false;
+		}
+		std::string str = j.str();
+		fwrite(str.data(), 1, str.size(), fp);
+		fclose(fp);
+	}
+	return succeeded != 0;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+
+struct CoreParameter;
+class HeadlessHost;
+
+struct DumpBenchmarkOptions {
+	// Directory of GE frame dumps (.ppdmp) to replay.
+	std::string dumpDirectory;
+	// Frames to measure per dump, after the warmup frames.
+	int frames = 60;
+	int warmupFrames = 1;
+	// Where to write the JSON results, or empty for stdout.
+	std::string jsonFilename;
+	// Per dump, in seconds.
+	double timeout = 60.0;
+};
+
+// Replays each dump in the directory and reports per-frame CPU time, split by GPU stage.
+// Returns false if no dump could be run.
+bool RunDumpBenchmark(HeadlessHost *headlessHost, CoreParameter &coreParameter, const DumpBenchmarkOptions &options);
@@ -2,6 +2,7 @@
 // See headless.txt.
 // To build on non-windows systems, just run CMake in the SDL directory, it will build both a normal ppsspp and the headless version.
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
@@ -24,6 +25,8 @@
 #include "base/NativeApp.h"
 #include "base/timeutil.h"
 
+#include "AudioSink.h"
+#include "Benchmark.h"
 #include "Compare.h"
 #include "StubHost.h"
 #if defined(_WIN32)
@@ -108,11 +111,19 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
+	fprintf(stderr, "  --bench-dumps=DIR     replay the GE dumps in DIR and report frame times as JSON\n");
+	fprintf(stderr, "  --bench-frames=N      frames to measure per dump (default 60)\n");
+	fprintf(stderr, "  --bench-json=FILE     write the benchmark results to FILE instead of stdout\n");
+	fprintf(stderr, "  --audio-sink          play audio into a wall clock paced sink and report underruns\n");
+	fprintf(stderr, "  --audio-render=FILE   write the mixed audio to a WAV file, unthrottled, and time the audio stages\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
 }
 
+// The audio stage timers only run while collecting debug stats.
+static bool collectAudioStats = false;
+
 static HeadlessHost *getHost(GPUCore gpuCore) {
 	switch (gpuCore) {
 	case GPUCORE_NULL:
@@ -160,7 +171,7 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	static double deadline;
 	deadline = time_now() + timeout;
 
-	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops);
+	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops || collectAudioStats);
 
 	PSP_BeginHostFrame();
 	if (coreParameter.thin3d)
@@ -231,6 +242,9 @@ int main(int argc, const char* argv[])
 	const char *mountRoot = 0;
 	const char *screenshotFilename = 0;
 	float timeout = std::numeric_limits<float>::infinity();
+	DumpBenchmarkOptions benchOptions;
+	bool audioSink = false;
+	const char *audioRenderFilename = nullptr;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -283,6 +297,16 @@ int main(int argc, const char* argv[])
 			screenshotFilename = argv[i] + strlen("--screenshot=");
 		else if (!strncmp(argv[i], "--timeout=", strlen("--timeout=")) && strlen(argv[i]) > strlen("--timeout="))
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
+		else if (!strncmp(argv[i], "--bench-dumps=", strlen("--bench-dumps=")) && strlen(argv[i]) > strlen("--bench-dumps="))
+			benchOptions.dumpDirectory = argv[i] + strlen("--bench-dumps=");
+		else if (!strncmp(argv[i], "--bench-frames=", strlen("--bench-frames=")) && strlen(argv[i]) > strlen("--bench-frames="))
+			benchOptions.frames = std::max(1, atoi(argv[i] + strlen("--bench-frames=")));
+		else if (!strncmp(argv[i], "--bench-json=", strlen("--bench-json=")) && strlen(argv[i]) > strlen("--bench-json="))
+			benchOptions.jsonFilename = argv[i] + strlen("--bench-json=");
+		else if (!strcmp(argv[i], "--audio-sink"))
+			audioSink = true;
+		else if (!strncmp(argv[i], "--audio-render=", strlen("--audio-render=")) && strlen(argv[i]) > strlen("--audio-render="))
+			audioRenderFilename = argv[i] + strlen("--audio-render=");
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -304,8 +328,13 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
-	if (testFilenames.empty())
+	const bool benchmark = !benchOptions.dumpDirectory.empty();
+	if (testFilenames.empty() && !benchmark)
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
+	if (benchmark && timeout != std::numeric_limits<float>::infinity())
+		benchOptions.timeout = timeout;
+	if (audioSink && audioRenderFilename)
+		return printUsage(argv[0], "--audio-render can't be used with --audio-sink");
 
 	HeadlessHost *headlessHost = getHost(gpuCore);
 	headlessHost->SetGraphicsCore(gpuCore);
@@ -342,9 +371,10 @@ int main(int argc, const char* argv[])
 	coreParameter.renderHeight = 272;
 	coreParameter.pixelWidth = 480;
 	coreParameter.pixelHeight = 272;
-	coreParameter.unthrottle = true;
+	// The sink consumes in real time, so the emulator has to produce in real time too.
+	coreParameter.unthrottle = !audioSink;
 
-	g_Config.bEnableSound = false;
+	g_Config.bEnableSound = audioSink;
 	g_Config.bFirstRun = false;
 	g_Config.bIgnoreBadMemAccess = true;
 	// Never report from tests.
@@ -409,6 +439,20 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(stateToLoad);
 
+	HeadlessAudioSink sink;
+	if (audioSink)
+		sink.Start();
+	HeadlessAudioRender audioRender;
+	if (audioRenderFilename && !audioRender.Start(audioRenderFilename)) {
+		fprintf(stderr, "Could not write audio to %s\n", audioRenderFilename);
+		return 1;
+	}
+	collectAudioStats = audioRenderFilename != nullptr;
+
+	bool benchmarkFailed = false;
+	if (benchmark)
+		benchmarkFailed = !RunDumpBenchmark(headlessHost, coreParameter, benchOptions);
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -442,6 +486,15 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (audioSink) {
+		sink.Stop();
+		sink.PrintReport(stderr);
+	}
+	if (audioRenderFilename) {
+		audioRender.Stop();
+		audioRender.PrintReport(stderr);
+	}
+
 	host->ShutdownGraphics();
 	delete host;
 	host = nullptr;
@@ -455,5 +508,5 @@ int main(int argc, const char* argv[])
 	moncleanup();
 #endif
 
-	return 0;
+	return benchmarkFailed ? 1 : 0;
 }
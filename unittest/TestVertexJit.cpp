@@ -19,6 +19,7 @@
 #include "Common/Common.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
+#include "GPU/Common/VertexDecoderBatch.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"
@@ -686,3 +687,108 @@ bool TestVertexJit() {
 
 	return pass;
 }
+
+// Compares decoding to SoA arrays against decoding interleaved and reading back through
+// VertexReader, which is what the software renderer's TransformUnit would do otherwise.
+bool TestVertexDecoderSoASpeed() {
+	g_Config.bVertexDecoderJit = true;
+	g_Config.iCpuCore = (int)CPUCore::JIT;
+	gstate_c.uv.uScale = 1.0f;
+	gstate_c.uv.vScale = 1.0f;
+
+	static const int COUNT = 1024;
+	static const int ROUNDS = 100;
+	u8 *src = new u8[COUNT * 64];
+	u8 *dst = new u8[COUNT * 64];
+	for (int i = 0; i < COUNT * 64; ++i) {
+		src[i] = (u8)(i * 2654435761U >> 13);
+	}
+	VertexDecoderJitCache *cache = new VertexDecoderJitCache();
+	SoAVertexData soa;
+
+	static const u32 vtypes[] = {
+		GE_VTYPE_POS_FLOAT | GE_VTYPE_TC_FLOAT | GE_VTYPE_COL_8888,
+		GE_VTYPE_POS_16BIT | GE_VTYPE_TC_16BIT | GE_VTYPE_COL_565 | GE_VTYPE_NRM_8BIT,
+		GE_VTYPE_POS_16BIT | GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_THROUGH,
+	};
+
+	bool pass = true;
+	for (u32 vtype : vtypes) {
+		VertexDecoderOptions options{};
+		VertexDecoder dec;
+		dec.SetVertexType(vtype, options, cache);
+		const DecVtxFormat &fmt = dec.GetDecVtxFmt();
+		const bool through = (vtype & GE_VTYPE_THROUGH) != 0;
+		volatile float sink = 0.0f;
+
+		auto readInterleaved = [&](int i, float p[3], float uv[2], float c[4], float n[3]) {
+			VertexReader reader(dst, fmt, vtype);
+			reader.Goto(i);
+			if (through)
+				reader.ReadPosThroughZ16(p);
+			else
+				reader.ReadPos(p);
+			reader.ReadUV(uv);
+			reader.ReadColor0(c);
+			if (reader.hasNormal())
+				reader.ReadNrm(n);
+		};
+
+		// Both paths must read back the same values.  Compared bitwise, since the random floats include NaNs.
+		dec.DecodeVerts(dst, src, 0, COUNT - 1);
+		dec.DecodeVertsSoA(soa, src, 0, COUNT - 1);
+		for (int i = 0; i < COUNT; ++i) {
+			float p[3], uv[2], c[4], n[3] = {};
+			readInterleaved(i, p, uv, c, n);
+			const float expected[5] = { soa.posX[i], soa.posY[i], soa.u[i], soa.v[i], (soa.color0[i] >> 24) * (1.0f / 255.0f) };
+			const float actual[5] = { p[0], p[1], uv[0], uv[1], c[3] };
+			if (memcmp(expected, actual, sizeof(expected)) != 0) {
+				printf("%08x: vertex %d differs\n", vtype, i);
+				pass = false;
+				break;
+			}
+		}
+
+		double st = real_time_now();
+		int total = 0;
+		do {
+			for (int j = 0; j < ROUNDS; ++j) {
+				dec.DecodeVerts(dst, src, 0, COUNT - 1);
+				float sum = 0.0f;
+				for (int i = 0; i < COUNT; ++i) {
+					float p[3], uv[2], c[4], n[3] = {};
+					readInterleaved(i, p, uv, c, n);
+					sum += p[0] + p[1] + p[2] + uv[0] + uv[1] + c[0] + c[3] + n[0];
+				}
+				sink = sum;
+				++total;
+			}
+		} while (real_time_now() - st < 0.5);
+		const double interleaved = total / (real_time_now() - st);
+
+		st = real_time_now();
+		total = 0;
+		do {
+			for (int j = 0; j < ROUNDS; ++j) {
+				dec.DecodeVertsSoA(soa, src, 0, COUNT - 1);
+				float sum = 0.0f;
+				for (int i = 0; i < COUNT; ++i) {
+					const u32 col = soa.color0[i];
+					sum += soa.posX[i] + soa.posY[i] + soa.posZ[i] + soa.u[i] + soa.v[i] + (col & 0xFF) * (1.0f / 255.0f) + (col >> 24) * (1.0f / 255.0f);
+					if (soa.hasNormal)
+						sum += soa.nrmX[i];
+				}
+				sink = sum;
+				++total;
+			}
+		} while (real_time_now() - st < 0.5);
+		const double separate = total / (real_time_now() - st);
+
+		printf("  vtype %08x: SoA %8.0f draws/s, interleaved + VertexReader %8.0f draws/s (%.2fx)\n", vtype, separate, interleaved, separate / interleaved);
+	}
+
+	delete cache;
+	delete [] src;
+	delete [] dst;
+	return pass;
+}
@@ -18,3 +18,4 @@
 #pragma once
 
 bool TestVertexJit();
+bool TestVertexDecoderSoASpeed();
@@ -32,6 +32,7 @@
 #include <sstream>
 
 #include "base/NativeApp.h"
+#include "base/timeutil.h"
 #include "base/logging.h"
 #include "input/input_state.h"
 #include "ext/disarm.h"
@@ -39,10 +40,17 @@
 #include "util/text/parsers.h"
 
 #include "Common/CPUDetect.h"
+#include "Common/Hashmaps.h"
 #include "Common/ArmEmitter.h"
 #include "Core/Config.h"
+#include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HW/SasReverb.h"
+#include "Core/HW/YUVConvert.h"
+#include "GPU/GPUCommon.h"
+#include "GPU/ge_constants.h"
+#include "GPU/Common/DisplayListCache.h"
 #include "GPU/Common/TextureDecoder.h"
 
 #include "unittest/JitHarness.h"
@@ -459,6 +467,337 @@ bool TestQuickTexHash() {
 	return false;
 }
 
+// Runs func for a short while and returns MB/s, given the bytes it processes per call.
+template <typename F>
+static double MeasureThroughput(size_t bytes, F func) {
+	int total = 0;
+	double st = real_time_now();
+	do {
+		for (int j = 0; j < 32; ++j) {
+			func();
+			++total;
+		}
+	} while (real_time_now() - st < 0.25);
+	double elapsed = real_time_now() - st;
+	return (double)bytes * total / (elapsed * 1024.0 * 1024.0);
+}
+
+// Makes sure the AVX2 unswizzle and alpha check paths agree with the narrow ones.
+bool TestTextureDecoder() {
+	const bool hasAVX2 = cpu_info.bAVX2;
+	static const int sizes[] = { 64, 256, 512 };
+
+	if (hasAVX2) {
+		for (int size : sizes) {
+			const u32 bytes = size * size * 4;
+			AlignedMem src(bytes, 16);
+			AlignedMem dst1(bytes, 16);
+			AlignedMem dst2(bytes, 16);
+			u32 *src32 = (u32 *)(char *)src;
+			for (u32 i = 0; i < bytes / 4; ++i) {
+				src32[i] = 0xFF000000 | (i * 2654435761U >> 8);
+			}
+
+			// The texture is 16 bytes per block row, 8 rows per block.
+			const u32 pitch = size * 4;
+			for (int avx2 = 0; avx2 <= 1; ++avx2) {
+				cpu_info.bAVX2 = avx2 != 0;
+				SetupTextureDecoder();
+				DoUnswizzleTex16((const u8 *)(char *)src, (u32 *)(char *)(avx2 ? dst2 : dst1), pitch / 16, size / 8, pitch);
+			}
+			cpu_info.bAVX2 = hasAVX2;
+			SetupTextureDecoder();
+
+			EXPECT_TRUE(memcmp(dst1, dst2, bytes) == 0);
+		}
+	}
+
+	// Make sure the wide alpha checks find a single transparent pixel anywhere.
+	static const int W = 64, H = 16;
+	AlignedMem pixels(W * H * 4, 16);
+	u32 *p = (u32 *)(char *)pixels;
+	for (int avx2 = 0; avx2 <= (hasAVX2 ? 1 : 0); ++avx2) {
+		cpu_info.bAVX2 = avx2 != 0;
+		for (int i = 0; i < W * H; ++i) {
+			for (int j = 0; j < W * H; ++j) {
+				p[j] = 0xFFFFFFFF;
+			}
+			p[i] = 0x7FFFFFFF;
+			EXPECT_EQ_INT(CheckAlphaRGBA8888Basic(p, W, W, H), CHECKALPHA_ANY);
+			p[i] = 0xFFFF7FFF;
+			EXPECT_EQ_INT(CheckAlphaRGBA4444Basic(p, W * 2, W * 2, H), CHECKALPHA_ANY);
+			EXPECT_EQ_INT(CheckAlphaRGBA5551Basic(p, W * 2, W * 2, H), CHECKALPHA_ANY);
+			p[i] = 0xFFFFFFFF;
+			EXPECT_EQ_INT(CheckAlphaRGBA8888Basic(p, W, W, H), CHECKALPHA_FULL);
+			EXPECT_EQ_INT(CheckAlphaRGBA4444Basic(p, W * 2, W * 2, H), CHECKALPHA_FULL);
+		}
+	}
+	cpu_info.bAVX2 = hasAVX2;
+
+	return true;
+}
+
+// Benchmark of the hash / unswizzle / alpha check paths.
+bool TestTextureDecoderSpeed() {
+	const bool hasAVX2 = cpu_info.bAVX2;
+	// Typical PSP texture sizes, at 32-bit.
+	static const int sizes[] = { 64, 256, 512 };
+
+	for (int size : sizes) {
+		const u32 bytes = size * size * 4;
+		AlignedMem src(bytes, 16);
+		AlignedMem dst(bytes, 16);
+		u32 *src32 = (u32 *)(char *)src;
+		for (u32 i = 0; i < bytes / 4; ++i) {
+			src32[i] = 0xFF000000 | (i * 2654435761U >> 8);
+		}
+		printf("%dx%d:\n", size, size);
+
+		printf("  QuickTexHash:      %8.0f MB/s\n", MeasureThroughput(bytes, [&] { DoQuickTexHash(src, bytes); }));
+		printf("  ReliableHash32:    %8.0f MB/s\n", MeasureThroughput(bytes, [&] { DoReliableHash32(src, bytes, 0); }));
+		printf("  ReliableHash64:    %8.0f MB/s\n", MeasureThroughput(bytes, [&] { DoReliableHash64(src, bytes, 0); }));
+
+		const u32 pitch = size * 4;
+		const int bxc = pitch / 16;
+		const int byc = size / 8;
+		for (int avx2 = 0; avx2 <= (hasAVX2 ? 1 : 0); ++avx2) {
+			cpu_info.bAVX2 = avx2 != 0;
+			SetupTextureDecoder();
+			const char *name = avx2 ? "AVX2" : "base";
+			printf("  Unswizzle (%s):  %8.0f MB/s\n", name, MeasureThroughput(bytes, [&] { DoUnswizzleTex16((const u8 *)(char *)src, (u32 *)(char *)dst, bxc, byc, pitch); }));
+			printf("  CheckAlpha8888 (%s): %8.0f MB/s\n", name, MeasureThroughput(bytes, [&] { CheckAlphaRGBA8888Basic(src32, size, size, size); }));
+			printf("  CheckAlpha4444 (%s): %8.0f MB/s\n", name, MeasureThroughput(bytes, [&] { CheckAlphaRGBA4444Basic(src32, size * 2, size * 2, size); }));
+		}
+		cpu_info.bAVX2 = hasAVX2;
+		SetupTextureDecoder();
+	}
+
+	return true;
+}
+
+// Checks the block based reverb against the plain one for every preset.
+bool TestSasReverb() {
+	// A grain at 22khz, stereo in, stereo 44khz out.
+	static const int SAMPLES = 256;
+	int16_t input[SAMPLES * 2];
+	int16_t output1[SAMPLES * 4];
+	int16_t output2[SAMPLES * 4];
+	u32 seed = 0x12345678;
+
+	for (int preset = -1; preset <= 8; ++preset) {
+		SasReverb fast;
+		SasReverb reference;
+		fast.SetPreset(preset);
+		reference.SetPreset(preset);
+
+		// Long enough to go around the largest buffer a few times, and odd sizes to move the blocks around.
+		for (int grain = 0; grain < 2000; ++grain) {
+			const int count = grain % 5 == 0 ? 37 : SAMPLES;
+			for (int i = 0; i < count * 2; ++i) {
+				seed = seed * 1103515245 + 12345;
+				// Let it go silent now and then, so the tail decays.
+				input[i] = grain % 300 < 250 ? (int16_t)(seed >> 12) : 0;
+			}
+			fast.ProcessReverb(output1, input, count, 0x7FFF, 0x6000);
+			reference.ProcessReverbReference(output2, input, count, 0x7FFF, 0x6000);
+			if (memcmp(output1, output2, count * 4 * sizeof(int16_t)) != 0) {
+				printf("Reverb preset %d differs in grain %d\n", preset, grain);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool TestSasReverbSpeed() {
+	static const int SAMPLES = 256;
+	int16_t input[SAMPLES * 2];
+	int16_t output[SAMPLES * 4];
+	u32 seed = 0x12345678;
+	for (int i = 0; i < SAMPLES * 2; ++i) {
+		seed = seed * 1103515245 + 12345;
+		input[i] = (int16_t)(seed >> 12);
+	}
+
+	for (int preset = -1; preset <= 8; ++preset) {
+		SasReverb fast;
+		SasReverb reference;
+		fast.SetPreset(preset);
+		reference.SetPreset(preset);
+
+		const size_t bytes = SAMPLES * 2 * sizeof(int16_t);
+		printf("  %-24s: %6.1f MB/s (reference %6.1f MB/s)\n", SasReverb::GetPresetName(preset),
+			MeasureThroughput(bytes, [&] { fast.ProcessReverb(output, input, SAMPLES, 0x7FFF, 0x7FFF); }),
+			MeasureThroughput(bytes, [&] { reference.ProcessReverbReference(output, input, SAMPLES, 0x7FFF, 0x7FFF); }));
+	}
+
+	return true;
+}
+
+bool TestYUVConvert() {
+	static const int WIDTH = 480;
+	static const int HEIGHT = 272;
+	static const int STRIDE = 512 * 4;
+	static u8 y[WIDTH * HEIGHT], u[WIDTH * HEIGHT / 4], v[WIDTH * HEIGHT / 4];
+	static u8 output1[STRIDE * HEIGHT], output2[STRIDE * HEIGHT];
+	const u8 *const planes[3] = { y, u, v };
+	const int strides[3] = { WIDTH, WIDTH / 2, WIDTH / 2 };
+
+	u32 seed = 0x12345678;
+	auto next = [&] {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	};
+	for (u8 &c : y)
+		c = (u8)next();
+	for (int i = 0; i < WIDTH * HEIGHT / 4; ++i) {
+		u[i] = (u8)next();
+		v[i] = (u8)next();
+	}
+
+	static const char *const formatNames[] = { "5650", "5551", "4444", "8888" };
+	for (int fmt = GE_CMODE_16BIT_BGR5650; fmt <= GE_CMODE_32BIT_ABGR8888; ++fmt) {
+		// Odd positions and sizes, like sceMpegAvcCsc() can ask for.
+		for (int i = 0; i < 100; ++i) {
+			int x = next() % WIDTH;
+			int yPos = next() % HEIGHT;
+			int w = next() % (WIDTH - x + 1);
+			int h = next() % (HEIGHT - yPos + 1);
+			memset(output1, 0xCC, sizeof(output1));
+			memset(output2, 0xCC, sizeof(output2));
+			ConvertYUV420ToPSP(output1, STRIDE, planes, strides, x, yPos, w, h, fmt);
+			ConvertYUV420ToPSPReference(output2, STRIDE, planes, strides, x, yPos, w, h, fmt);
+			if (memcmp(output1, output2, sizeof(output1)) != 0) {
+				printf("YUV conversion to %s differs at %d,%d %dx%d\n", formatNames[fmt], x, yPos, w, h);
+				return false;
+			}
+		}
+	}
+
+	// Black and white should come out exact.
+	y[0] = 16;
+	y[1] = 235;
+	u[0] = 128;
+	v[0] = 128;
+	ConvertYUV420ToPSP(output1, STRIDE, planes, strides, 0, 0, 2, 1, GE_CMODE_32BIT_ABGR8888);
+	EXPECT_EQ_INT(*(u32 *)output1, 0x00000000);
+	EXPECT_EQ_INT(*(u32 *)(output1 + 4), 0x00FFFFFF);
+
+	return true;
+}
+
+bool TestYUVConvertSpeed() {
+	static const int WIDTH = 480;
+	static const int HEIGHT = 272;
+	static const int STRIDE = 512 * 4;
+	static u8 y[WIDTH * HEIGHT], u[WIDTH * HEIGHT / 4], v[WIDTH * HEIGHT / 4];
+	static u8 output[STRIDE * HEIGHT];
+	const u8 *const planes[3] = { y, u, v };
+	const int strides[3] = { WIDTH, WIDTH / 2, WIDTH / 2 };
+
+	static const char *const formatNames[] = { "5650", "5551", "4444", "8888" };
+	for (int fmt = GE_CMODE_16BIT_BGR5650; fmt <= GE_CMODE_32BIT_ABGR8888; ++fmt) {
+		const size_t bytes = WIDTH * HEIGHT * 3 / 2;
+		printf("  %s: %6.1f MB/s (reference %6.1f MB/s)\n", formatNames[fmt],
+			MeasureThroughput(bytes, [&] { ConvertYUV420ToPSP(output, STRIDE, planes, strides, 0, 0, WIDTH, HEIGHT, fmt); }),
+			MeasureThroughput(bytes, [&] { ConvertYUV420ToPSPReference(output, STRIDE, planes, strides, 0, 0, WIDTH, HEIGHT, fmt); }));
+	}
+
+	return true;
+}
+
+bool TestHashMapChurn() {
+	// Erasing and inserting fresh keys every frame must not use up all FREE buckets,
+	// or a Get() on a missing key would never terminate.
+	DenseHashMap<u64, int, -1> map(16);
+	for (u64 i = 0; i < 10000; ++i) {
+		map.Insert(i, (int)i);
+		if (i >= 4) {
+			map.Remove(i - 4);
+		}
+		EXPECT_EQ_INT(map.Get(i + 1000000), -1);
+	}
+	EXPECT_EQ_INT((int)map.size(), 4);
+	EXPECT_EQ_INT(map.Get(9999), 9999);
+
+	PrehashMap<int, -1> prehash(16);
+	for (uint32_t i = 0; i < 10000; ++i) {
+		prehash.Insert(i, (int)i);
+		if (i >= 4) {
+			prehash.Remove(i - 4);
+		}
+		EXPECT_EQ_INT(prehash.Get(i + 1000000), -1);
+	}
+	EXPECT_EQ_INT((int)prehash.size(), 4);
+
+	return true;
+}
+
+bool TestDisplayListCache() {
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	Memory::Init();
+
+	u64 flags[256]{};
+	flags[GE_CMD_PRIM] = FLAG_EXECUTE;
+	flags[GE_CMD_BASE] = FLAG_EXECUTEONCHANGE;
+	DisplayListCache cache;
+	cache.SetCommandFlags(flags);
+
+	const u32 pc = 0x08800000;
+	u32 *list = (u32 *)Memory::GetPointer(pc);
+	list[0] = (GE_CMD_VADDR << 24) | 0x1000;
+	list[1] = (GE_CMD_VADDR << 24) | 0x2000;
+	list[2] = (GE_CMD_IADDR << 24) | 0x3000;
+	list[3] = (GE_CMD_PRIM << 24) | 3;
+	list[4] = (GE_CMD_VADDR << 24) | 0x4000;
+
+	// The first VADDR is overwritten before the PRIM, so it's left out.
+	const DisplayListBlock *block = cache.Get(pc, 100, 0);
+	EXPECT_TRUE(block != nullptr);
+	EXPECT_EQ_INT((int)block->numOps, 4);
+	EXPECT_EQ_INT((int)block->commands.size(), 3);
+	EXPECT_EQ_HEX(block->commands[0].op, list[1]);
+	EXPECT_EQ_INT((int)block->commands[0].index, 1);
+
+	// Hit, without rehashing, until invalidated.
+	EXPECT_TRUE(cache.Get(pc, 100, 0) == block);
+	list[2] = (GE_CMD_IADDR << 24) | 0x5000;
+	EXPECT_EQ_HEX(cache.Get(pc, 100, 0)->commands[1].op, (GE_CMD_IADDR << 24) | 0x3000);
+	cache.Invalidate();
+	block = cache.Get(pc, 100, 0);
+	EXPECT_TRUE(block != nullptr);
+	EXPECT_EQ_HEX(block->commands[1].op, list[2]);
+
+	// Unchanged memory in a new epoch is still a hit.
+	cache.Invalidate();
+	EXPECT_TRUE(cache.Get(pc, 100, 1) == block);
+
+	// Running into the stall address rebuilds it shorter.
+	block = cache.Get(pc, 2, 1);
+	EXPECT_TRUE(block != nullptr);
+	EXPECT_EQ_INT((int)block->numOps, 2);
+
+	// A register read by an EXECUTEONCHANGE command keeps earlier writes.
+	list[1] = (GE_CMD_BASE << 24) | 0;
+	cache.Invalidate();
+	block = cache.Get(pc, 100, 1);
+	EXPECT_EQ_INT((int)block->numOps, 4);
+	EXPECT_EQ_INT((int)block->commands.size(), 4);
+
+	// Rewritten every time, it stops being cached.
+	for (int i = 0; i < 8; ++i) {
+		list[0] = (GE_CMD_VADDR << 24) | i;
+		cache.Invalidate();
+		block = cache.Get(pc, 100, 2);
+	}
+	EXPECT_TRUE(block == nullptr);
+
+	cache.Clear();
+	Memory::Shutdown();
+	return true;
+}
+
 typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
@@ -491,6 +830,19 @@ TestItem availableTests[] = {
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(HashMapChurn),
+	TEST_ITEM(DisplayListCache),
+	TEST_ITEM(TextureDecoder),
+	TEST_ITEM(SasReverb),
+	TEST_ITEM(YUVConvert),
+};
+
+// These take a few seconds and only print timings, so "all" skips them.  Run them by name.
+TestItem availableBenchmarks[] = {
+	TEST_ITEM(TextureDecoderSpeed),
+	TEST_ITEM(VertexDecoderSoASpeed),
+	TEST_ITEM(SasReverbSpeed),
+	TEST_ITEM(YUVConvertSpeed),
 };
 
 int main(int argc, const char *argv[]) {
@@ -512,6 +864,12 @@ int main(int argc, const char *argv[]) {
 				break;
 			}
 		}
+		for (auto f : availableBenchmarks) {
+			if (!strcasecmp(argv[1], f.name)) {
+				testFunc = f.func;
+				break;
+			}
+		}
 	}
 
 	if (allTests) {
@@ -538,6 +896,11 @@ int main(int argc, const char *argv[]) {
 		for (auto f : availableTests) {
 			fprintf(stderr, "  * %s\n", f.name);
 		}
+		fprintf(stderr, "\n");
+		fprintf(stderr, "Available benchmarks (not run by \"all\"):\n");
+		for (auto f : availableBenchmarks) {
+			fprintf(stderr, "  * %s\n", f.name);
+		}
 		return 1;
 	} else {
 		if (!testFunc()) {